@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "graph_view.h"
+#include "numa_part.h"
 
 using std::min;
 
@@ -42,6 +43,7 @@ mem_hop1(gview_t<T>* snaph)
     vid_t v   = 0;
     delta_adjlist_t<T>* delta_adjlist;
     T* local_adjlist = 0;
+    std::vector<T> codes;
 
     //#pragma omp for reduction(+:sum) schedule (static) nowait
     for (int i = 0; i < query_count; i++) {
@@ -56,7 +58,7 @@ mem_hop1(gview_t<T>* snaph)
             delta_degree = nebr_count;
             
             while (delta_adjlist != 0 && delta_degree > 0) {
-                local_adjlist = delta_adjlist->get_adjlist();
+                local_adjlist = read_adjlist(delta_adjlist, codes);
                 local_degree = delta_adjlist->get_nebrcount();
                 degree_t i_count = min(local_degree, delta_degree);
                 for (degree_t i = 0; i < i_count; ++i) {
@@ -137,6 +139,7 @@ mem_hop1(vert_table_t<T>* graph_out, degree_t* degree_out,
     delta_adjlist_t<T>* delta_adjlist;
     vunit_t<T>* v_unit = 0;
     T* local_adjlist = 0;
+    std::vector<T> codes;
 
     #pragma omp for reduction(+:sum) schedule (static) nowait
     for (int i = 0; i < query_count; i++) {
@@ -153,7 +156,7 @@ mem_hop1(vert_table_t<T>* graph_out, degree_t* degree_out,
         delta_degree = nebr_count - durable_degree;
         
         while (delta_adjlist != 0 && delta_degree > 0) {
-            local_adjlist = delta_adjlist->get_adjlist();
+            local_adjlist = read_adjlist(delta_adjlist, codes);
             local_degree = delta_adjlist->get_nebrcount();
             degree_t i_count = min(local_degree, delta_degree);
             for (degree_t i = 0; i < i_count; ++i) {
@@ -232,6 +235,7 @@ mem_hop2(vert_table_t<T>* graph_out, degree_t* degree_out,
     vid_t v   = 0;
     vert_table_t<T>* graph  = graph_out;
     T* local_adjlist = 0;
+    std::vector<T> codes;
     delta_adjlist_t<T>* delta_adjlist;
     vunit_t<T>* v_unit = 0;
     degree_t d = 0;
@@ -255,7 +259,7 @@ mem_hop2(vert_table_t<T>* graph_out, degree_t* degree_out,
         delta_degree = nebr_count - durable_degree;
         
         while (delta_adjlist != 0 && delta_degree > 0) {
-            local_adjlist = delta_adjlist->get_adjlist();
+            local_adjlist = read_adjlist(delta_adjlist, codes);
             local_degree = delta_adjlist->get_nebrcount();
             degree_t i_count = min(local_degree, delta_degree);
             for (degree_t i = 0; i < i_count; ++i) {
@@ -309,6 +313,7 @@ mem_hop2(vert_table_t<T>* graph_out, degree_t* degree_out,
     vid_t v = 0;
     vert_table_t<T>* graph  = graph_out;
     T* local_adjlist = 0;
+    std::vector<T> codes;
     delta_adjlist_t<T>* delta_adjlist;
     vunit_t<T>* v_unit = 0;
     vid_t* vlist = 0;
@@ -332,7 +337,7 @@ mem_hop2(vert_table_t<T>* graph_out, degree_t* degree_out,
             delta_degree = nebr_count - durable_degree;
             
             while (delta_adjlist != 0 && delta_degree > 0) {
-                local_adjlist = delta_adjlist->get_adjlist();
+                local_adjlist = read_adjlist(delta_adjlist, codes);
                 local_degree = delta_adjlist->get_nebrcount();
                 degree_t i_count = min(local_degree, delta_degree);
                 for (degree_t i = 0; i < i_count; ++i) {
@@ -406,6 +411,7 @@ void mem_hop2(gview_t<T>* snaph)
     sid_t sid = 0;
     vid_t v   = 0;
     T* local_adjlist = 0;
+    std::vector<T> codes;
     delta_adjlist_t<T>* delta_adjlist;
     degree_t d = 0;
     vid_t* vlist = 0;
@@ -424,7 +430,7 @@ void mem_hop2(gview_t<T>* snaph)
         delta_degree = nebr_count;
         
         while (delta_adjlist != 0 && delta_degree > 0) {
-            local_adjlist = delta_adjlist->get_adjlist();
+            local_adjlist = read_adjlist(delta_adjlist, codes);
             local_degree = delta_adjlist->get_nebrcount();
             degree_t i_count = min(local_degree, delta_degree);
             for (degree_t i = 0; i < i_count; ++i) {
@@ -474,6 +480,7 @@ void mem_hop2(gview_t<T>* snaph)
         sid_t sid = 0;
         vid_t v = 0;
         T* local_adjlist = 0;
+        std::vector<T> codes;
         delta_adjlist_t<T>* delta_adjlist;
         vid_t* vlist = 0;
         degree_t d = 0;
@@ -492,7 +499,7 @@ void mem_hop2(gview_t<T>* snaph)
             delta_degree = nebr_count;
             
             while (delta_adjlist != 0 && delta_degree > 0) {
-                local_adjlist = delta_adjlist->get_adjlist();
+                local_adjlist = read_adjlist(delta_adjlist, codes);
                 local_degree = delta_adjlist->get_nebrcount();
                 degree_t i_count = min(local_degree, delta_degree);
                 for (degree_t i = 0; i < i_count; ++i) {
@@ -661,7 +668,7 @@ void mem_bfs_simple(gview_t<T>* snaph,
 }
 
 template<class T, class StatusType>
-void mem_bfs(gview_t<T>* snaph,
+void mem_bfs(snap_t<T>* snaph,
         StatusType* status, sid_t root)
 {
     int				level      = 1;
@@ -678,77 +685,37 @@ void mem_bfs(gview_t<T>* snaph,
 		double start = mywtime();
 		#pragma omp parallel reduction(+:frontier)
 		{
-            sid_t sid;
-            degree_t nebr_count = 0;
-            degree_t local_degree = 0;
-            degree_t delta_degree = 0;
-
-            delta_adjlist_t<T>* delta_adjlist;;
-            T* local_adjlist = 0;
-            // std::cout << "vcount: " << v_count << std::endl;
-		    
+            //NUMA mode: the static share of a thread is on its node
+            numa_pin_t pin;
             if (top_down) {
-                #pragma omp for nowait
+                #pragma omp for schedule(static) nowait
 				for (vid_t v = 0; v < v_count; v++) {
                     if (status[v] != level) continue;
                     
-					nebr_count     = snaph->get_degree_out(v);
-                    if (0 == nebr_count) continue;
-                    
-                    delta_adjlist  = snaph->get_nebrs_archived_out(v);
-                    delta_degree   = nebr_count;
-                    
-                    //traverse the delta adj list
-                    while (delta_adjlist != 0 && delta_degree > 0) {
-                        local_adjlist = delta_adjlist->get_adjlist();
-                        local_degree = delta_adjlist->get_nebrcount();
-                        degree_t i_count = min(local_degree, delta_degree);
-                        for (degree_t i = 0; i < i_count; ++i) {
-                            sid = get_sid(local_adjlist[i]);
-                            if (status[sid] == 0) {
-                                status[sid] = level + 1;
-                                ++frontier;
-                                //cout << " " << sid << endl;
-                            }
+                    //capture the shared arrays by value, so they stay in registers
+                    snaph->for_each_out(v, [&frontier, status, level](sid_t sid) {
+                        if (status[sid] == 0) {
+                            status[sid] = level + 1;
+                            ++frontier;
                         }
-                        delta_adjlist = delta_adjlist->get_next();
-                        delta_degree -= local_degree;
-                        // if(v % 13777773 ==0 && delta_degree != 0) {
-                        //     cout << v << ": delta_degree = " << delta_degree << endl;
-                        // }
-                    }
+                    });
 				}
 			} else {//bottom up
-                int done = 0;
-				
-				#pragma omp for nowait
+				#pragma omp for schedule(static) nowait
 				for (vid_t v = 0; v < v_count; v++) {
 					if (status[v] != 0 ) continue;
-					nebr_count = snaph->get_degree_in(v);
-                    if (0 == nebr_count) continue;
 
-                    delta_adjlist  = snaph->get_nebrs_archived_in(v);
-                    done = 0;
-
-                    //traverse the delta adj list
-                    delta_degree = nebr_count;
-                    while (delta_adjlist != 0 && delta_degree > 0) {
-                        local_adjlist = delta_adjlist->get_adjlist();
-                        local_degree = delta_adjlist->get_nebrcount();
-                        degree_t i_count = min(local_degree, delta_degree);
-                        for (degree_t i = 0; i < i_count; ++i) {
-                            sid = get_sid(local_adjlist[i]);
-                            if (status[sid] == level) {
+                    //stop at the first parent found
+                    snaph->for_each_in_span(v, [&frontier, status, level, v](T* adj_list, degree_t count) {
+                        for (degree_t i = 0; i < count; ++i) {
+                            if (status[get_sid(adj_list[i])] == level) {
                                 status[v] = level + 1;
                                 ++frontier;
-                                done = 1;
-                                break;
+                                return false;
                             }
                         }
-                        if (done == 1) break;
-                        delta_adjlist = delta_adjlist->get_next();
-                        delta_degree -= local_degree;
-                    }
+                        return true;
+                    });
 				}
 		    }
             
@@ -861,6 +828,7 @@ void mem_pagerank_push(gview_t<T>* snaph, int iteration_count)
 
             delta_adjlist_t<T>* delta_adjlist;
             T* local_adjlist = 0;
+            std::vector<T> codes;
 
             float rank = 0.0f; 
          
@@ -874,7 +842,7 @@ void mem_pagerank_push(gview_t<T>* snaph, int iteration_count)
                 //traverse the delta adj list
                 delta_degree = nebr_count;
                 while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
+                    local_adjlist = read_adjlist(delta_adjlist, codes);
                     local_degree = delta_adjlist->get_nebrcount();
                     degree_t i_count = min(local_degree, delta_degree);
                     for (degree_t i = 0; i < i_count; ++i) {
@@ -925,7 +893,7 @@ void mem_pagerank_push(gview_t<T>* snaph, int iteration_count)
 }
 
 template<class T>
-void mem_pagerank(gview_t<T>* snaph, int iteration_count)
+void mem_pagerank(snap_t<T>* snaph, int iteration_count)
 {
     vid_t v_count = snaph->get_vcount();
 	float* rank_array = 0 ;
@@ -964,7 +932,7 @@ void mem_pagerank(gview_t<T>* snaph, int iteration_count)
     float	inv_v_count = 0.15;//1.0f/vert_count;
     #pragma omp for
     for (vid_t v = 0; v < v_count; ++v) {
-        degree = snaph->get_degree_out(v);
+        degree = snaph->out_degree(v);
         if (degree != 0) {
             dset[v] = 1.0f/degree;
             prior_rank_array[v] = inv_v_count;//XXX
@@ -980,36 +948,14 @@ void mem_pagerank(gview_t<T>* snaph, int iteration_count)
         double start1 = mywtime();
         #pragma omp parallel 
         {
-            sid_t sid;
-            degree_t      delta_degree = 0;
-            degree_t nebr_count = 0;
-            degree_t local_degree = 0;
-
-            delta_adjlist_t<T>* delta_adjlist;
-            T* local_adjlist = 0;
-
             float rank = 0.0f; 
+            numa_pin_t pin;
             
             #pragma omp for schedule (dynamic, 4096) nowait 
             for (vid_t v = 0; v < v_count; v++) {
-                delta_adjlist = snaph->get_nebrs_archived_in(v);
-                if (0 == delta_adjlist) continue;
-                
-                nebr_count = snaph->get_degree_in(v);
                 rank = 0.0f;
-                
-                //traverse the delta adj list
-                delta_degree = nebr_count;
-                while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
-                    local_degree = delta_adjlist->get_nebrcount();
-                    degree_t i_count = min(local_degree, delta_degree);
-                    for (degree_t i = 0; i < i_count; ++i) {
-                        sid = get_sid(local_adjlist[i]);
-                        rank += prior_rank_array[sid];
-                    }
-                    delta_adjlist = delta_adjlist->get_next();
-                    delta_degree -= local_degree;
+                if (0 == snaph->for_each_in(v, [&rank, prior_rank_array](sid_t sid) { rank += prior_rank_array[sid]; })) {
+                    continue;
                 }
                 //rank_array[v] = rank;
                 qthread_dincr(rank_array + v, rank);
@@ -1232,6 +1178,7 @@ mem_pagerank_epsilon(gview_t<T>* snaph, double epsilon)
 
             delta_adjlist_t<T>* delta_adjlist;
             T* local_adjlist = 0;
+            std::vector<T> codes;
 
             double rank = 0.0; 
             
@@ -1246,7 +1193,7 @@ mem_pagerank_epsilon(gview_t<T>* snaph, double epsilon)
                 //traverse the delta adj list
                 delta_degree = nebr_count;
                 while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
+                    local_adjlist = read_adjlist(delta_adjlist, codes);
                     local_degree = delta_adjlist->get_nebrcount();
                     degree_t i_count = min(local_degree, delta_degree);
                     for (degree_t i = 0; i < i_count; ++i) {
@@ -1333,6 +1280,7 @@ void mem_bfs(vert_table_t<T>* graph_out, degree_t* degree_out,
             delta_adjlist_t<T>* delta_adjlist;;
             vunit_t<T>* v_unit = 0;
             T* local_adjlist = 0;
+            std::vector<T> codes;
 		    
             if (top_down) {
                 graph  = graph_out;
@@ -1351,7 +1299,7 @@ void mem_bfs(vert_table_t<T>* graph_out, degree_t* degree_out,
                     
                     //traverse the delta adj list
                     while (delta_adjlist != 0 && delta_degree > 0) {
-                        local_adjlist = delta_adjlist->get_adjlist();
+                        local_adjlist = read_adjlist(delta_adjlist, codes);
                         local_degree = delta_adjlist->get_nebrcount();
                         degree_t i_count = min(local_degree, delta_degree);
                         for (degree_t i = 0; i < i_count; ++i) {
@@ -1384,7 +1332,7 @@ void mem_bfs(vert_table_t<T>* graph_out, degree_t* degree_out,
                     //traverse the delta adj list
                     delta_degree = nebr_count;
                     while (delta_adjlist != 0 && delta_degree > 0) {
-                        local_adjlist = delta_adjlist->get_adjlist();
+                        local_adjlist = read_adjlist(delta_adjlist, codes);
                         local_degree = delta_adjlist->get_nebrcount();
                         degree_t i_count = min(local_degree, delta_degree);
                         for (degree_t i = 0; i < i_count; ++i) {
@@ -1672,7 +1620,7 @@ void PrintCompStats(vid_t* comp, vid_t v_count) {
 }
 
 template<class T>
-void cc_gapbs(gview_t<T>* snaph, index_t neighbor_rounds = 2, bool logging = false) {
+void cc_gapbs(snap_t<T>* snaph, index_t neighbor_rounds = 2, bool logging = false) {
     double st = mywtime();
 
     vid_t v_count = snaph->get_vcount();
@@ -1696,38 +1644,14 @@ void cc_gapbs(gview_t<T>* snaph, index_t neighbor_rounds = 2, bool logging = fal
     size_t r = neighbor_rounds;
         #pragma omp parallel for schedule(dynamic, 16384)
         for (vid_t u = 0; u < v_count; u++) {
-            degree_t      delta_degree = 0;
-            degree_t        nebr_count = 0;
-            degree_t      local_degree = 0;
-            
-            delta_adjlist_t<T>* delta_adjlist;
-            T* local_adjlist = 0;
-
+            //link only the first r neighbors
             degree_t d = 0;
-            delta_adjlist = snaph->get_nebrs_archived_out(u);
-            nebr_count = snaph->get_degree_out(u);
-
-            if (0 != delta_adjlist && nebr_count != 0) {
-                delta_degree = nebr_count;
-                while (delta_adjlist != 0 && delta_degree > 0 && d <= r) {
-                    local_adjlist = delta_adjlist->get_adjlist();
-                    local_degree = delta_adjlist->get_nebrcount();
-                    degree_t i_count = min(local_degree, delta_degree);
-                    for (degree_t i = 0; i < i_count; ++i) {
-                        if(d < r) {
-                            sid_t v = get_sid(local_adjlist[i]);
-                            // printf("Linking %d and %d\n", u, v);
-                            Link(u, v, comp);
-                            d++;
-                        }
-                        if(d == r) {
-                            break;
-                        }
-                    }
-                    delta_adjlist = delta_adjlist->get_next();
-                    delta_degree -= local_degree;
+            snaph->for_each_out_span(u, [&d, u, r, comp](T* adj_list, degree_t count) {
+                for (degree_t i = 0; i < count && d < (degree_t)r; ++i, ++d) {
+                    Link(u, get_sid(adj_list[i]), comp);
                 }
-            }
+                return (d < (degree_t)r);
+            });
         }
         Compress(v_count, comp);
     // }
@@ -1741,55 +1665,18 @@ void cc_gapbs(gview_t<T>* snaph, index_t neighbor_rounds = 2, bool logging = fal
     for (vid_t u = 0; u < v_count; u++) {
         if (comp[u] == c) continue;
 
-        degree_t      delta_degree = 0;
-        degree_t        nebr_count = 0;
-        degree_t      local_degree = 0;
-        degree_t      d = 0;
-        
-        delta_adjlist_t<T>* delta_adjlist;
-        T* local_adjlist = 0;
-
-        delta_adjlist = snaph->get_nebrs_archived_out(u);
-        nebr_count = snaph->get_degree_out(u);
-        if (0 != delta_adjlist && nebr_count != 0) {
-            delta_degree = nebr_count;
-            while (delta_adjlist != 0 && delta_degree > 0) {
-                local_adjlist = delta_adjlist->get_adjlist();
-                local_degree = delta_adjlist->get_nebrcount();
-                degree_t i_count = min(local_degree, delta_degree);
-                for (degree_t i = 0; i < i_count; ++i) {
-                    if(d > neighbor_rounds) {
-                        vid_t v = get_sid(local_adjlist[i]);
-                        Link(u, v, comp);
-                    }
-                    d++;
-                }
-                delta_adjlist = delta_adjlist->get_next();
-                delta_degree -= local_degree;
-            }
-        }
+        index_t d = 0;
+        snaph->for_each_out(u, [&d, u, neighbor_rounds, comp](sid_t v) {
+            if (d > neighbor_rounds) Link(u, v, comp);
+            d++;
+        });
 
         d = 0;
         // To support directed graphs, process reverse graph completely
-        delta_adjlist = snaph->get_nebrs_archived_in(u);
-        nebr_count = snaph->get_degree_in(u);
-        if (0 != delta_adjlist && nebr_count != 0) {
-            delta_degree = nebr_count;
-            while (delta_adjlist != 0 && delta_degree > 0) {
-                local_adjlist = delta_adjlist->get_adjlist();
-                local_degree = delta_adjlist->get_nebrcount();
-                degree_t i_count = min(local_degree, delta_degree);
-                for (degree_t i = 0; i < i_count; ++i) {
-                    if(d > neighbor_rounds) {
-                        vid_t v = get_sid(local_adjlist[i]);
-                        Link(u, v, comp);
-                    }
-                    d++;
-                }
-                delta_adjlist = delta_adjlist->get_next();
-                delta_degree -= local_degree;
-            }
-        }
+        snaph->for_each_in(u, [&d, u, neighbor_rounds, comp](sid_t v) {
+            if (d > neighbor_rounds) Link(u, v, comp);
+            d++;
+        });
     }
     // Finally, 'compress' for final convergence
     Compress(v_count, comp);
@@ -1805,7 +1692,7 @@ void cc_gapbs(gview_t<T>* snaph, index_t neighbor_rounds = 2, bool logging = fal
 
 
 template<class T>
-void pr_gapbs(gview_t<T>* snaph, int max_iters, double epsilon=0, bool logging_enabled = false)
+void pr_gapbs(snap_t<T>* snaph, int max_iters, double epsilon=0, bool logging_enabled = false)
 {
     using NodeID = vid_t;
     using ScoreT = float;
@@ -1839,7 +1726,7 @@ void pr_gapbs(gview_t<T>* snaph, int max_iters, double epsilon=0, bool logging_e
 	
     #pragma omp parallel for
     for (NodeID n=0; n < v_count; n++) {
-        outgoing_contrib[n] = init_score / snaph->get_degree_out(n);
+        outgoing_contrib[n] = init_score / snaph->out_degree(n);
     }
 
 
@@ -1850,39 +1737,16 @@ void pr_gapbs(gview_t<T>* snaph, int max_iters, double epsilon=0, bool logging_e
 
         #pragma omp parallel 
         {
-            sid_t sid;
-            degree_t delta_degree = 0;
-            degree_t nebr_count = 0;
-            degree_t local_degree = 0;
-
-            delta_adjlist_t<T>* delta_adjlist;
-            T* local_adjlist = 0;
-            
             #pragma omp for schedule (dynamic, 4096) reduction(+:error)
             for (vid_t u = 0; u < v_count; u++) {
-                delta_adjlist = snaph->get_nebrs_archived_in(u);
-                if (0 == delta_adjlist) continue;
-                
-                nebr_count = snaph->get_degree_in(u);
                 float incoming_total = 0;
-                
-                //traverse the delta adj list
-                delta_degree = nebr_count;
-                while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
-                    local_degree = delta_adjlist->get_nebrcount();
-                    degree_t i_count = min(local_degree, delta_degree);
-                    for (degree_t i = 0; i < i_count; ++i) {
-                        sid = get_sid(local_adjlist[i]);
-                        incoming_total += outgoing_contrib[sid];
-                    }
-                    delta_adjlist = delta_adjlist->get_next();
-                    delta_degree -= local_degree;
+                if (0 == snaph->for_each_in(u, [&incoming_total, outgoing_contrib](sid_t sid) { incoming_total += outgoing_contrib[sid]; })) {
+                    continue;
                 }
                 ScoreT old_score = scores[u];
                 scores[u] = base_score + kDamp * incoming_total;
                 error += fabs(scores[u] - old_score);
-                outgoing_contrib[u] = scores[u] / snaph->get_degree_out(u);
+                outgoing_contrib[u] = scores[u] / snaph->out_degree(u);
             }
         }
 
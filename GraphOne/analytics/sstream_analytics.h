@@ -427,6 +427,7 @@ void stream_pagerank_epsilon1(gview_t<T>* viewh)
             degree_t      local_degree = 0;
             delta_adjlist_t<T>* delta_adjlist;
             T* local_adjlist = 0;
+            std::vector<T> codes;
 
             double rank = 0.0; 
             
@@ -440,7 +441,7 @@ void stream_pagerank_epsilon1(gview_t<T>* viewh)
                 //traverse the delta adj list
                 delta_degree = nebr_count;
                 while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
+                    local_adjlist = read_adjlist(delta_adjlist, codes);
                     local_degree = delta_adjlist->get_nebrcount();
                     degree_t i_count = min(local_degree, delta_degree);
                     for (degree_t i = 0; i < i_count; ++i) {
@@ -526,6 +527,7 @@ stream_pagerank_epsilon(gview_t<T>* sstreamh)
 
             delta_adjlist_t<T>* delta_adjlist;
             T* local_adjlist = 0;
+            std::vector<T> codes;
 
             double rank = 0.0; 
             
@@ -541,7 +543,7 @@ stream_pagerank_epsilon(gview_t<T>* sstreamh)
                 //traverse the delta adj list
                 delta_degree = nebr_count;
                 while (delta_adjlist != 0 && delta_degree > 0) {
-                    local_adjlist = delta_adjlist->get_adjlist();
+                    local_adjlist = read_adjlist(delta_adjlist, codes);
                     local_degree = delta_adjlist->get_nebrcount();
                     degree_t i_count = min(local_degree, delta_degree);
                     for (degree_t i = 0; i < i_count; ++i) {
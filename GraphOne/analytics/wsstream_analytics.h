@@ -0,0 +1,457 @@
+#pragma once
+#include <omp.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+
+#include "type.h"
+#include "graph.h"
+#include "sgraph.h"
+#include "wtime.h"
+
+/*
+Analytics on the sliding window view (wsstream_t), driven by the deltas of
+each update: the edges that entered the window and the ones that expired.
+*/
+
+//Link-cut trees over the vertices and the edges of a spanning forest. An edge
+//is a node too, its value is its log position, so a path query finds the
+//oldest edge on the path.
+class lct_node_t {
+  public:
+    index_t val;
+    vid_t   ch[2];
+    vid_t   fa;
+    vid_t   mn;//node of the oldest edge of the splay subtree
+    vid_t   eu;//the two vertex nodes of an edge node
+    vid_t   ev;
+    uint8_t rev;
+};
+
+class lct_t {
+    lct_node_t* t;//0 is nil, 1..v_count the vertices, then the edges
+    vid_t*      free_edge;
+    vid_t       free_count;
+    std::vector<vid_t> stk;
+    std::unordered_map<index_t, vid_t> edge_node;//log position to edge node
+
+    inline bool is_root(vid_t x) {
+        vid_t f = t[x].fa;
+        return (0 == f) || (t[f].ch[0] != x && t[f].ch[1] != x);
+    }
+    inline void pull(vid_t x) {
+        vid_t m = x;
+        vid_t c = t[x].ch[0];
+        if (c && t[t[c].mn].val < t[m].val) m = t[c].mn;
+        c = t[x].ch[1];
+        if (c && t[t[c].mn].val < t[m].val) m = t[c].mn;
+        t[x].mn = m;
+    }
+    inline void flip(vid_t x) {
+        std::swap(t[x].ch[0], t[x].ch[1]);
+        t[x].rev ^= 1;
+    }
+    inline void push(vid_t x) {
+        if (0 == t[x].rev) return;
+        if (t[x].ch[0]) flip(t[x].ch[0]);
+        if (t[x].ch[1]) flip(t[x].ch[1]);
+        t[x].rev = 0;
+    }
+    void rotate(vid_t x) {
+        vid_t y = t[x].fa;
+        vid_t z = t[y].fa;
+        int k = (t[y].ch[1] == x);
+        if (!is_root(y)) t[z].ch[t[z].ch[1] == y] = x;
+        t[x].fa = z;
+        t[y].ch[k] = t[x].ch[!k];
+        if (t[x].ch[!k]) t[t[x].ch[!k]].fa = y;
+        t[x].ch[!k] = y;
+        t[y].fa = x;
+        pull(y);
+        pull(x);
+    }
+    void splay(vid_t x) {
+        vid_t y = x;
+        stk.push_back(y);
+        while (!is_root(y)) {
+            y = t[y].fa;
+            stk.push_back(y);
+        }
+        while (!stk.empty()) {
+            push(stk.back());
+            stk.pop_back();
+        }
+        while (!is_root(x)) {
+            y = t[x].fa;
+            if (!is_root(y)) {
+                vid_t z = t[y].fa;
+                rotate(((t[y].ch[0] == x) != (t[z].ch[0] == y)) ? x : y);
+            }
+            rotate(x);
+        }
+    }
+    void access(vid_t x) {
+        for (vid_t y = 0; x; y = x, x = t[x].fa) {
+            splay(x);
+            t[x].ch[1] = y;
+            pull(x);
+        }
+    }
+    void make_root(vid_t x) {
+        access(x);
+        splay(x);
+        flip(x);
+    }
+    vid_t find_root(vid_t x) {
+        access(x);
+        splay(x);
+        push(x);
+        while (t[x].ch[0]) {
+            x = t[x].ch[0];
+            push(x);
+        }
+        splay(x);
+        return x;
+    }
+    void link(vid_t x, vid_t y) {
+        make_root(x);
+        t[x].fa = y;
+    }
+    //x and y are adjacent in the tree
+    void cut(vid_t x, vid_t y) {
+        make_root(x);
+        access(y);
+        splay(y);
+        t[y].ch[0] = 0;
+        t[x].fa = 0;
+        pull(y);
+    }
+    void link_edge(vid_t x, vid_t y, index_t pos) {
+        vid_t e = free_edge[--free_count];
+        t[e].val = pos;
+        t[e].mn = e;
+        t[e].eu = x;
+        t[e].ev = y;
+        link(x, e);
+        link(e, y);
+        edge_node[pos] = e;
+    }
+    void cut_edge(vid_t e) {
+        cut(t[e].eu, e);
+        cut(e, t[e].ev);
+        edge_node.erase(t[e].val);
+        free_edge[free_count++] = e;
+    }
+
+  public:
+    inline lct_t() {
+        t = 0;
+        free_edge = 0;
+        free_count = 0;
+    }
+    inline ~lct_t() {
+        free(t);
+        free(free_edge);
+    }
+    void init(vid_t v_count) {
+        //a forest has less edges than vertices
+        t = (lct_node_t*)calloc(2*(index_t)v_count + 1, sizeof(lct_node_t));
+        free_edge = (vid_t*)calloc(v_count, sizeof(vid_t));
+        for (index_t x = 0; x <= 2*(index_t)v_count; ++x) {
+            t[x].val = (index_t)-1;
+            t[x].mn = x;
+        }
+        for (vid_t e = 0; e < v_count; ++e) {
+            free_edge[e] = 2*v_count - e;
+        }
+        free_count = v_count;
+    }
+    inline bool connected(vid_t u, vid_t v) {
+        return find_root(u + 1) == find_root(v + 1);
+    }
+    //Edge (u, v) at log position pos, newer than the whole forest. The forest
+    //keeps the newest edges: on a cycle the oldest edge of it leaves the forest.
+    //Returns the change in the tree count.
+    int insert(vid_t u, vid_t v, index_t pos) {
+        if (u == v) return 0;
+        vid_t x = u + 1;
+        vid_t y = v + 1;
+        if (find_root(x) != find_root(y)) {
+            link_edge(x, y, pos);
+            return -1;
+        }
+        make_root(x);
+        access(y);
+        splay(y);
+        cut_edge(t[y].mn);
+        link_edge(x, y, pos);
+        return 0;
+    }
+    //Edge at log position pos leaves, the oldest of the window. No older edge
+    //can replace it in the forest, so a forest edge splits its tree.
+    int expire(index_t pos) {
+        std::unordered_map<index_t, vid_t>::iterator iter = edge_node.find(pos);
+        if (iter == edge_node.end()) return 0;
+        cut_edge(iter->second);
+        return 1;
+    }
+};
+
+//WCC of the window: a spanning forest of the window that keeps the newest
+//edges. A window edge that is not in the forest has a newer path around it,
+//so only the expiry of a forest edge splits a component.
+class wswcc_t {
+  public:
+    lct_t    forest;
+    vid_t    wcc_count;//isolated vertices included
+};
+
+template <class T>
+void ws_wcc_post_reg(wsstream_t<T>* wsstreamh)
+{
+    vid_t v_count = wsstreamh->get_vcount();
+    wswcc_t* wcc = new wswcc_t;
+    wcc->forest.init(v_count);
+    wcc->wcc_count = v_count;
+    wsstreamh->set_algometa(wcc);
+}
+
+template <class T>
+void ws_stream_wcc(gview_t<T>* viewh)
+{
+    wsstream_t<T>* wsstreamh = (wsstream_t<T>*)viewh;
+    wswcc_t* wcc = (wswcc_t*)wsstreamh->get_algometa();
+    edgeT_t<T>* edges = 0;
+
+    index_t count = wsstreamh->get_new_edges(edges);
+    index_t pos = wsstreamh->get_window_end() - count;
+    for (index_t i = 0; i < count; ++i) {
+        wcc->wcc_count += wcc->forest.insert(TO_VID(edges[i].src_id),
+                                             TO_VID(get_dst(edges + i)), pos + i);
+    }
+
+    count = wsstreamh->get_expired_edges(edges);
+    pos = wsstreamh->get_window_start() - count;
+    for (index_t i = 0; i < count; ++i) {
+        wcc->wcc_count += wcc->forest.expire(pos + i);
+    }
+}
+
+/*
+Pagerank of the window by residual push: rank + the spread of residue gives
+the pagerank, PR = (1 - d)/n + d*sum(PR[u]/degree[u]) for the in-neighbors u.
+An edge u->v changes the degree of u, rank[u] is scaled by the degree change so
+that the other neighbors of u still get the same share, the difference goes to
+the residue of u, and v gets or loses its share. Only the vertices whose
+residue is above the threshold push, so an update costs about its deltas.
+The pushes stop once the queued residue is under the tolerance, it stays queued.
+*/
+#define WS_DAMP 0.85
+
+class wspr_t {
+  public:
+    double*   rank;
+    double*   residue;
+    double*   share;//per neighbor share of the vertices pushing in this round
+    degree_t* degree;//out degree in the window
+    uint8_t*  queued;
+    std::vector<vid_t> queue;
+    double    threshold;//a vertex pushes its residue above it
+    double    tolerance;//or the queue waits for the next update under it
+};
+
+template <class T>
+void ws_pagerank_post_reg(wsstream_t<T>* wsstreamh, double epsilon = 1e-3)
+{
+    vid_t v_count = wsstreamh->get_vcount();
+    wspr_t* pr = new wspr_t;
+    pr->rank = (double*)calloc(v_count, sizeof(double));
+    pr->residue = (double*)calloc(v_count, sizeof(double));
+    pr->share = (double*)calloc(v_count, sizeof(double));
+    pr->degree = (degree_t*)calloc(v_count, sizeof(degree_t));
+    pr->queued = (uint8_t*)calloc(v_count, sizeof(uint8_t));
+    //the window starts empty, teleport only
+    for (vid_t v = 0; v < v_count; ++v) {
+        pr->rank[v] = (1 - WS_DAMP)/v_count;
+    }
+    //the residue left in the vertices makes an L1 error of at most
+    //sum(residue)/(1 - d), half of epsilon each for the queue and the others
+    pr->threshold = epsilon*(1 - WS_DAMP)/(2*v_count);
+    pr->tolerance = epsilon*(1 - WS_DAMP)/2;
+    wsstreamh->set_algometa(pr);
+}
+
+inline void ws_atomic_add(double* ptr, double value)
+{
+    uint64_t old_bits, new_bits;
+    double old_val, new_val;
+    do {
+        old_val = *(volatile double*)ptr;
+        new_val = old_val + value;
+        memcpy(&old_bits, &old_val, sizeof(double));
+        memcpy(&new_bits, &new_val, sizeof(double));
+    } while (!__sync_bool_compare_and_swap((uint64_t*)ptr, old_bits, new_bits));
+}
+
+inline bool ws_to_push(wspr_t* pr, vid_t v)
+{
+    double r = pr->residue[v];
+    return (r > pr->threshold || r < -pr->threshold)
+            && __sync_bool_compare_and_swap(pr->queued + v, 0, 1);
+}
+
+inline void ws_pr_add(wspr_t* pr, vid_t u, vid_t v)
+{
+    degree_t d = pr->degree[u]++;
+    if (d) {
+        double rank = pr->rank[u]*(d + 1)/d;
+        pr->residue[u] -= rank - pr->rank[u];
+        pr->rank[u] = rank;
+    }
+    pr->residue[v] += WS_DAMP*pr->rank[u]/(d + 1);
+    if (ws_to_push(pr, u)) pr->queue.push_back(u);
+    if (ws_to_push(pr, v)) pr->queue.push_back(v);
+}
+
+inline void ws_pr_del(wspr_t* pr, vid_t u, vid_t v)
+{
+    degree_t d = pr->degree[u]--;
+    double rank = pr->rank[u];
+    if (d > 1) {
+        pr->rank[u] = rank*(d - 1)/d;
+        pr->residue[u] += rank - pr->rank[u];
+    }
+    pr->residue[v] -= WS_DAMP*rank/d;
+    if (ws_to_push(pr, u)) pr->queue.push_back(u);
+    if (ws_to_push(pr, v)) pr->queue.push_back(v);
+}
+
+template <class T>
+void ws_stream_pagerank(gview_t<T>* viewh)
+{
+    wsstream_t<T>* wsstreamh = (wsstream_t<T>*)viewh;
+    wspr_t* pr = (wspr_t*)wsstreamh->get_algometa();
+    bool undirected = wsstreamh->is_undirected();
+    vid_t v_count = wsstreamh->get_vcount();
+    edgeT_t<T>* edges = 0;
+    vid_t src, dst;
+
+    //the deltas, in log order
+    index_t count = wsstreamh->get_new_edges(edges);
+    for (index_t i = 0; i < count; ++i) {
+        src = TO_VID(edges[i].src_id);
+        dst = TO_VID(get_dst(edges + i));
+        ws_pr_add(pr, src, dst);
+        if (undirected) ws_pr_add(pr, dst, src);
+    }
+    count = wsstreamh->get_expired_edges(edges);
+    for (index_t i = 0; i < count; ++i) {
+        src = TO_VID(edges[i].src_id);
+        dst = TO_VID(get_dst(edges + i));
+        ws_pr_del(pr, src, dst);
+        if (undirected) ws_pr_del(pr, dst, src);
+    }
+
+    //the window edges not in the adjacency lists are pushed edge by edge
+    edgeT_t<T>* nonarchived = 0;
+    index_t nonarchived_count = wsstreamh->get_nonarchived_edges(nonarchived);
+    edgeT_t<T>* wedges = 0;
+    index_t wedge_count = wsstreamh->get_window_edges(wedges);
+    index_t dense_degree = (wedge_count << undirected) >> 4;
+
+    while (!pr->queue.empty()) {
+        std::vector<vid_t>& queue = pr->queue;
+        index_t q_count = queue.size();
+        index_t q_degree = 0;
+        double q_residue = 0;
+        std::vector<vid_t> next_queue;
+
+        for (index_t i = 0; i < q_count; ++i) {
+            q_residue += fabs(pr->residue[queue[i]]);
+        }
+        if (q_residue < pr->tolerance) break;
+
+        #pragma omp parallel num_threads(THD_COUNT)
+        {
+            std::vector<vid_t> next;
+            std::vector<T> nebrs;
+
+            #pragma omp for reduction(+:q_degree)
+            for (index_t i = 0; i < q_count; ++i) {
+                vid_t u = queue[i];
+                double r = pr->residue[u];
+                pr->residue[u] = 0;
+                pr->rank[u] += r;
+                pr->queued[u] = 0;
+                pr->share[u] = pr->degree[u] ? WS_DAMP*r/pr->degree[u] : 0;
+                q_degree += pr->degree[u];
+            }
+
+            //Like top-down vs bottom-up in bfs: a large frontier pushes over the
+            //window copy in one pass instead of walking the adjacency lists.
+            //Each thread scans all of it for its own range of vertices, no atomics.
+            if (q_degree > dense_degree) {
+                int thd_count = omp_get_num_threads();
+                int tid = omp_get_thread_num();
+                vid_t portion = (v_count + thd_count - 1)/thd_count;
+                vid_t v_beg = min(v_count, portion*tid);
+                vid_t v_end = min(v_count, v_beg + portion);
+                for (index_t i = 0; i < wedge_count; ++i) {
+                    vid_t s = TO_VID(wedges[i].src_id);
+                    vid_t d = TO_VID(get_dst(wedges + i));
+                    if (d >= v_beg && d < v_end && 0 != pr->share[s]) {
+                        pr->residue[d] += pr->share[s];
+                        if (ws_to_push(pr, d)) next.push_back(d);
+                    }
+                    if (undirected && s >= v_beg && s < v_end && 0 != pr->share[d]) {
+                        pr->residue[s] += pr->share[d];
+                        if (ws_to_push(pr, s)) next.push_back(s);
+                    }
+                }
+                #pragma omp barrier
+            } else {
+                #pragma omp for schedule(dynamic, 64)
+                for (index_t i = 0; i < q_count; ++i) {
+                    vid_t u = queue[i];
+                    double share = pr->share[u];
+                    if (0 == share) continue;
+                    degree_t nebr_count = wsstreamh->get_degree_out(u);
+                    if (0 == nebr_count) continue;
+                    if (nebrs.size() < (size_t)nebr_count) nebrs.resize(nebr_count);
+                    nebr_count = wsstreamh->get_nebrs_out(u, nebrs.data());
+                    for (degree_t j = 0; j < nebr_count; ++j) {
+                        vid_t w = TO_VID(get_sid(nebrs[j]));
+                        ws_atomic_add(pr->residue + w, share);
+                        if (ws_to_push(pr, w)) next.push_back(w);
+                    }
+                }
+
+                #pragma omp for
+                for (index_t i = 0; i < nonarchived_count; ++i) {
+                    vid_t s = TO_VID(nonarchived[i].src_id);
+                    vid_t d = TO_VID(get_dst(nonarchived + i));
+                    if (0 != pr->share[s]) {
+                        ws_atomic_add(pr->residue + d, pr->share[s]);
+                        if (ws_to_push(pr, d)) next.push_back(d);
+                    }
+                    if (undirected && 0 != pr->share[d]) {
+                        ws_atomic_add(pr->residue + s, pr->share[d]);
+                        if (ws_to_push(pr, s)) next.push_back(s);
+                    }
+                }
+            }
+
+            #pragma omp for
+            for (index_t i = 0; i < q_count; ++i) {
+                pr->share[queue[i]] = 0;
+            }
+
+            #pragma omp critical
+            next_queue.insert(next_queue.end(), next.begin(), next.end());
+        }
+        //a vertex whose residue went back under the threshold pushes anyway
+        pr->queue.swap(next_queue);
+    }
+}
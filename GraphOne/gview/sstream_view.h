@@ -59,6 +59,7 @@ class sstream_t : public snap_t<T> {
  private:
     void  update_degreesnap();
     void update_degreesnapd();
+    void update_bitmap(dpages_t& old_degree, dpages_t& degree, Bitmap* bitmap);
  public:
     //These two functions are for vertex centric programming
     inline bool has_vertex_changed_out(vid_t v) {return bitmap_out->get_bit(v);}
@@ -73,85 +74,61 @@ class sstream_t : public snap_t<T> {
     inline void reset_vertex_changed_out(vid_t v) {bitmap_out->reset_bit(v);;}
 };
 
+//Set the bits of the vertices whose degree differs in the two page tables. A
+//page shared by both has not changed, its bits are just cleared.
 template <class T>
-void sstream_t<T>::update_degreesnap()
+void sstream_t<T>::update_bitmap(dpages_t& old_degree, dpages_t& degree, Bitmap* bitmap)
 {
-    #pragma omp parallel num_threads(THD_COUNT)
-    {
-        sdegree_t nebr_count = 0;
-        snapid_t snap_id = 0;
-        if (snapshot) {
-            snap_id = snapshot->snap_id;
-
-            #pragma omp for 
-            for (vid_t v = 0; v < v_count; ++v) {
-                nebr_count = graph_out->get_degree(v, snap_id);
-                if (degree_out[v] != nebr_count) {
-                    degree_out[v] = nebr_count;
-                    bitmap_out->set_bit(v);
-                } else {
-                    bitmap_out->reset_bit(v);
-                }
-                //cout << v << " " << degree_out[v] << endl;
-            }
+    uint64_t* words = bitmap->get_start();
+    vid_t word_count = bitmap->get_size();
+    vid_t page_count = degree.page_count;
+    
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(THD_COUNT)
+    for (vid_t p = 0; p < page_count; ++p) {
+        vid_t v_start = (p << DPAGE_BITS);
+        vid_t v_end = min(v_start + DPAGE_SIZE, v_count);
+        dpage_t* old_page = (p < old_degree.page_count) ? old_degree.get_page(p) : 0;
+        if (old_page == degree.get_page(p)) {
+            vid_t w_start = word_offset(v_start);
+            vid_t w_end = min(word_offset(v_end - 1) + 1, (uint64_t)word_count);
+            memset(words + w_start, 0, (w_end - w_start)*sizeof(uint64_t));
+            continue;
         }
-        /*
-        if (false == IS_STALE(flag)) {
-            #pragma omp for
-            for (index_t i = 0; i < edge_count; ++i) {
-                __sync_fetch_and_add(degree_out + edges[i].src_id, 1);
-                __sync_fetch_and_add(degree_out + get_dst(edges + i), 1);
+        for (vid_t v = v_start; v < v_end; ++v) {
+            sdegree_t nebr_count = old_page ? old_page->degree[v - v_start] : 0;
+            if (degree[v] != nebr_count) {
+                bitmap->set_bit(v);
+            } else {
+                bitmap->reset_bit(v);
             }
-        }*/
+        }
     }
 }
 
 template <class T>
-void sstream_t<T>::update_degreesnapd()
+void sstream_t<T>::update_degreesnap()
 {
-    #pragma omp parallel num_threads(THD_COUNT)
-    {
-        sdegree_t      nebr_count = 0;
-        snapid_t snap_id = 0;
-        if (snapshot) {
-            snap_id = snapshot->snap_id;
-
-            vid_t   vcount_out = v_count;
-            vid_t   vcount_in  = v_count;
-
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_out; ++v) {
-                nebr_count = graph_out->get_degree(v, snap_id);
-                if (degree_out[v] != nebr_count) {
-                    degree_out[v] = nebr_count;
-                    bitmap_out->set_bit(v);
-                } else {
-                    bitmap_out->reset_bit(v);
-                }
-            }
-            
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_in; ++v) {
-                nebr_count = graph_in->get_degree(v, snap_id);;
-                if (degree_in[v] != nebr_count) {
-                    degree_in[v] = nebr_count;
-                    bitmap_in->set_bit(v);
-                } else {
-                    bitmap_in->reset_bit(v);
-                }
-            }
-        }
-        /*
-        if (false == IS_STALE(flag)) {
-            #pragma omp for
-            for (index_t i = 0; i < edge_count; ++i) {
-                __sync_fetch_and_add(degree_out + edges[i].src_id, 1);
-                __sync_fetch_and_add(degree_in + get_dst(edges+i), 1);
-            }
-        }*/
-    }
+    if (0 == snapshot) return;
+    
+    dpages_t old_out;
+    old_out.share(*degree_out);
+    graph_out->create_degree_pages(v_count, snapshot->snap_id, *degree_out);
+    update_bitmap(old_out, *degree_out, bitmap_out);
+}
 
-    return;
+template <class T>
+void sstream_t<T>::update_degreesnapd()
+{
+    if (0 == snapshot) return;
+    
+    dpages_t old_out;
+    dpages_t old_in;
+    old_out.share(*degree_out);
+    old_in.share(*degree_in);
+    graph_out->create_degree_pages(v_count, snapshot->snap_id, *degree_out);
+    graph_in->create_degree_pages(v_count, snapshot->snap_id, *degree_in);
+    update_bitmap(old_out, *degree_out, bitmap_out);
+    update_bitmap(old_in, *degree_in, bitmap_in);
 }
 
 template <class T>
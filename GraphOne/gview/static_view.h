@@ -2,13 +2,29 @@
 
 #include "view_interface.h"
 
+//Calls fn(adj_list, count) on the blocks of a delta_adjlist_t chain, up to degree
+//neighbors in total. Stops early when fn returns false. A compressed block is
+//decoded in chunks, fn may get it in several calls.
+template <class T, class F>
+inline void for_each_span(delta_adjlist_t<T>* delta_adjlist, degree_t degree, F fn)
+{
+    while (delta_adjlist != 0 && degree > 0) {
+        degree_t local_degree = delta_adjlist->get_nebrcount();
+        if (delta_adjlist->is_compressed()) {
+            if (!for_each_codes(delta_adjlist, min(local_degree, degree), fn)) return;
+        } else if (!fn(delta_adjlist->get_adjlist(), min(local_degree, degree))) return;
+        delta_adjlist = delta_adjlist->get_next();
+        degree -= local_degree;
+    }
+}
+
 template <class T>
 class snap_t : public gview_t <T> {
  protected: 
     onegraph_t<T>*   graph_out;
     onegraph_t<T>*   graph_in;
-    sdegree_t*       degree_out;
-    sdegree_t*       degree_in;
+    dpages_t*        degree_out;//shares unchanged pages with the previous view
+    dpages_t*        degree_in;
 
     edgeT_t<T>*      edges; //Non archived edges
     index_t          edge_count;//their count
@@ -35,10 +51,10 @@ class snap_t : public gview_t <T> {
     }
     inline ~snap_t() {
         if (degree_in ==  degree_out) {
-            free(degree_out);
+            delete degree_out;
         } else {
-            free(degree_out);
-            free(degree_in);
+            delete degree_out;
+            delete degree_in;
         }
     }
 
@@ -58,27 +74,68 @@ class snap_t : public gview_t <T> {
     virtual int  is_unidir() {
        return ((graph_out != graph_in) && (graph_in ==0));
     }
+
+    //Non virtual access for the analytics. The neighbors are read in place from
+    //the archived adjacency blocks, only up to the degree of the view.
+    inline degree_t out_degree(vid_t v) {
+#ifdef DEL
+        return (*degree_out)[v].add_count - (*degree_out)[v].del_count;
+#else
+        return (*degree_out)[v];
+#endif
+    }
+    inline degree_t in_degree(vid_t v) {
+#ifdef DEL
+        return (*degree_in)[v].add_count - (*degree_in)[v].del_count;
+#else
+        return (*degree_in)[v];
+#endif
+    }
+    //fn(T* adj_list, degree_t count) returns false to stop. Returns the degree.
+    template <class F>
+    inline degree_t for_each_out_span(vid_t v, F fn) {
+        degree_t degree = out_degree(v);
+        if (degree != 0) for_each_span(graph_out->get_delta_adjlist(v), degree, fn);
+        return degree;
+    }
+    template <class F>
+    inline degree_t for_each_in_span(vid_t v, F fn) {
+        degree_t degree = in_degree(v);
+        if (degree != 0) for_each_span(graph_in->get_delta_adjlist(v), degree, fn);
+        return degree;
+    }
+    //fn(sid_t nebr) for every neighbor. Returns the degree.
+    template <class F>
+    inline degree_t for_each_out(vid_t v, F fn) {
+        return for_each_out_span(v, [&fn](T* adj_list, degree_t count) {
+            for (degree_t i = 0; i < count; ++i) fn(get_sid(adj_list[i]));
+            return true;
+        });
+    }
+    template <class F>
+    inline degree_t for_each_in(vid_t v, F fn) {
+        return for_each_in_span(v, [&fn](T* adj_list, degree_t count) {
+            for (degree_t i = 0; i < count; ++i) fn(get_sid(adj_list[i]));
+            return true;
+        });
+    }
     void init_view(pgraph_t<T>* ugraph, index_t flag);
     status_t update_view();
-    void create_degreesnap(onegraph_t<T>* graph, sdegree_t* degree);
+    void create_degreesnap(onegraph_t<T>* graph, dpages_t* degree);
     void handle_flagu();
     void handle_flagd();
     void handle_flaguni();
 };
 
+//Only the degree pages changed since the last view of the graph are filled
 template <class T>
-void snap_t<T>::create_degreesnap(onegraph_t<T>* graph, sdegree_t* degree)
+void snap_t<T>::create_degreesnap(onegraph_t<T>* graph, dpages_t* degree)
 {
     snapid_t snap_id = 0;
     if (snapshot) {
         snap_id = snapshot->snap_id;
-
-        #pragma omp for 
-        for (vid_t v = 0; v < v_count; ++v) {
-            degree[v] = graph->get_degree(v, snap_id);
-            //cout << v << " " << degree_out[v] << endl;
-        }
     }
+    graph->create_degree_pages(v_count, snap_id, *degree);
 }
 
 template <class T>
@@ -90,6 +147,19 @@ void snap_t<T>::handle_flagu()
     bool is_stale = IS_STALE(flag);
     bool is_simple = IS_SIMPLE(flag);
     if (false == is_stale && (true == is_simple)) {
+        //copy the shared degree pages that the edges change
+        #pragma omp for
+        for (index_t i = 0; i < edge_count; ++i) {
+#ifndef DEL
+            if (!IS_DEL(get_src(edges[i]))) continue;
+#endif
+            src_vid = TO_VID(get_src(edges[i]));
+            dst_vid = TO_VID(get_dst(edges[i]));
+            degree_out->mark_write(src_vid);
+            degree_out->mark_write(dst_vid);
+        }
+        degree_out->own_marked();
+
         #pragma omp for
         for (index_t i = 0; i < edge_count; ++i) {
             src_vid = TO_VID(get_src(edges[i]));
@@ -97,16 +167,16 @@ void snap_t<T>::handle_flagu()
             is_del = IS_DEL(get_src(edges[i]));
 #ifdef DEL
             if (is_del) {
-            __sync_fetch_and_add(&degree_out[src_vid].del_count, 1);
-            __sync_fetch_and_add(&degree_out[dst_vid].del_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).del_count, 1);
+            __sync_fetch_and_add(&degree_out->at(dst_vid).del_count, 1);
             } else {
-            __sync_fetch_and_add(&degree_out[src_vid].add_count, 1);
-            __sync_fetch_and_add(&degree_out[dst_vid].add_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).add_count, 1);
+            __sync_fetch_and_add(&degree_out->at(dst_vid).add_count, 1);
             }
 #else
             if (is_del) {assert(0);
-            __sync_fetch_and_add(&degree_out+src_vid, 1);
-            __sync_fetch_and_add(&degree_out+dst_vid, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid), 1);
+            __sync_fetch_and_add(&degree_out->at(dst_vid), 1);
             }
 #endif
         }
@@ -122,6 +192,20 @@ void snap_t<T>::handle_flagd()
     bool is_stale = IS_STALE(flag);
     bool is_simple = IS_SIMPLE(flag);
     if ((false == is_stale) && (true == is_simple)) {
+        //copy the shared degree pages that the edges change
+        #pragma omp for
+        for (index_t i = 0; i < edge_count; ++i) {
+#ifndef DEL
+            if (!IS_DEL(get_src(edges[i]))) continue;
+#endif
+            src_vid = TO_VID(get_src(edges[i]));
+            dst_vid = TO_VID(get_dst(edges[i]));
+            degree_out->mark_write(src_vid);
+            degree_in->mark_write(dst_vid);
+        }
+        degree_out->own_marked();
+        degree_in->own_marked();
+
         #pragma omp for
         for (index_t i = 0; i < edge_count; ++i) {
             src_vid = TO_VID(get_src(edges[i]));
@@ -129,16 +213,16 @@ void snap_t<T>::handle_flagd()
             is_del = IS_DEL(get_src(edges[i]));
 #ifdef DEL
             if (is_del) {
-            __sync_fetch_and_add(&degree_out[src_vid].del_count, 1);
-            __sync_fetch_and_add(&degree_in[dst_vid].del_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).del_count, 1);
+            __sync_fetch_and_add(&degree_in->at(dst_vid).del_count, 1);
             } else {
-            __sync_fetch_and_add(&degree_out[src_vid].add_count, 1);
-            __sync_fetch_and_add(&degree_in[dst_vid].add_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).add_count, 1);
+            __sync_fetch_and_add(&degree_in->at(dst_vid).add_count, 1);
             }
 #else
             if (is_del) {assert(0);
-            __sync_fetch_and_add(&degree_out+src_vid, 1);
-            __sync_fetch_and_add(&degree_in+dst_vid, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid), 1);
+            __sync_fetch_and_add(&degree_in->at(dst_vid), 1);
             }
 #endif
         }
@@ -154,6 +238,18 @@ void snap_t<T>::handle_flaguni()
     bool is_stale = IS_STALE(flag);
     bool is_simple = IS_SIMPLE(flag);
     if (false == is_stale && (true == is_simple)) {
+        //copy the shared degree pages that the edges change
+        #pragma omp for
+        for (index_t i = 0; i < edge_count; ++i) {
+#ifndef DEL
+            if (!IS_DEL(get_src(edges[i]))) continue;
+#endif
+            src_vid = TO_VID(get_src(edges[i]));
+            dst_vid = TO_VID(get_dst(edges[i]));
+            degree_out->mark_write(src_vid);
+        }
+        degree_out->own_marked();
+
         #pragma omp for
         for (index_t i = 0; i < edge_count; ++i) {
             src_vid = TO_VID(get_src(edges[i]));
@@ -161,13 +257,13 @@ void snap_t<T>::handle_flaguni()
             is_del = IS_DEL(get_src(edges[i]));
 #ifdef DEL
             if (is_del) {
-            __sync_fetch_and_add(&degree_out[src_vid].del_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).del_count, 1);
             } else {
-            __sync_fetch_and_add(&degree_out[src_vid].del_count, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid).del_count, 1);
             }
 #else
             if (is_del) {assert(0);
-            __sync_fetch_and_add(&degree_out+src_vid, 1);
+            __sync_fetch_and_add(&degree_out->at(src_vid), 1);
             }
 #endif
         }
@@ -185,14 +281,14 @@ void snap_t<T>::init_view(pgraph_t<T>* ugraph, index_t a_flag)
     flag = a_flag;
     
     graph_out = ugraph->sgraph_out[0];
-    degree_out = (sdegree_t*) calloc(v_count, sizeof(sdegree_t));
+    degree_out = new dpages_t;
     
     if (ugraph->sgraph_in == ugraph->sgraph_out) {
         graph_in   = graph_out;
         degree_in  = degree_out;
     } else if (ugraph->sgraph_in != 0) {
         graph_in  = ugraph->sgraph_in[0];
-        degree_in = (sdegree_t*) calloc(v_count, sizeof(sdegree_t));
+        degree_in = new dpages_t;
     }
 }
 
@@ -233,12 +329,12 @@ status_t snap_t<T>::update_view()
     }
     
     //Degree and actual edge arrays
-    #pragma omp parallel num_threads(THD_COUNT)
-    {
     create_degreesnap(graph_out, degree_out);
     if (graph_in != graph_out && graph_in != 0) {
         create_degreesnap(graph_in, degree_in);
     }
+    #pragma omp parallel num_threads(THD_COUNT)
+    {
     if (graph_in != graph_out && graph_in != 0) {
         handle_flagd();
     } else if (graph_in == graph_out) {
@@ -294,9 +390,10 @@ status_t snap_t<T>::next(header_t<T>& header, T& dst)
     if (header.max_count == header.count) {
         delta_adjlist_t<T>* delta_adjlist = header.next;
         header.next = delta_adjlist->get_next();
-        header.max_count = delta_adjlist->get_maxcount();
+        header.max_count = delta_adjlist->is_compressed() ? delta_adjlist->get_nebrcount()
+                                                          : delta_adjlist->get_maxcount();
         header.count = 0;
-        header.adj_list = delta_adjlist->get_adjlist();
+        header.adj_list = read_adjlist(delta_adjlist, header.codes);
     }
     
     T* local_adjlist = header.adj_list;
@@ -315,31 +412,22 @@ index_t snap_t<T>::get_nonarchived_edges(edgeT_t<T>*& ptr)
 template <class T>
 degree_t snap_t<T>::get_degree_out(vid_t v)
 {
-#ifdef DEL
-    return degree_out[v].add_count - degree_out[v].del_count;
-#else
-    return degree_out[v];
-#endif
-    
+    return out_degree(v);
 }
 
 template <class T>
 degree_t snap_t<T>::get_degree_in(vid_t v)
 {
-#ifdef DEL
-    return degree_in[v].add_count - degree_in[v].del_count;
-#else
-    return degree_in[v];
-#endif
+    return in_degree(v);
 }
 
 template <class T>
 degree_t snap_t<T>::get_nebrs_out(vid_t v, T* adj_list)
 {
-    return graph_out->get_nebrs(v, adj_list, degree_out[v]);
+    return graph_out->get_nebrs(v, adj_list, (*degree_out)[v]);
 }
 template<class T>
 degree_t snap_t<T>::get_nebrs_in(vid_t v, T* adj_list)
 {
-    return graph_in->get_nebrs(v, adj_list, degree_in[v]);
+    return graph_in->get_nebrs(v, adj_list, (*degree_in)[v]);
 }
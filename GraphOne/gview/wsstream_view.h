@@ -1,86 +1,84 @@
 #pragma once
 
+//Window on the adjacency lists: the neighbors of v are the entries
+//[degree_out1[v], degree_out[v]) of its adjacency list, which is in log order.
 template <class T>
 struct wsnap_t : public gview_t<T> {
-    pgraph_t<T>*     pgraph;  
- protected: 
-    snapshot_t*      snapshot;//new snapshot
-    snapshot_t*      snapshot1;//old snapshot
-    
+ protected:
+    using gview_t<T>::pgraph;
+    using gview_t<T>::snapshot;
+    using gview_t<T>::v_count;
+    using gview_t<T>::flag;
+
     //The adjacency data
     onegraph_t<T>* graph_out;
     onegraph_t<T>* graph_in;
-    
+
     //ending marker of the window
     degree_t*        degree_out;
     degree_t*        degree_in;
-    
+
     //starting marker of the window
     degree_t*        degree_out1;
     degree_t*        degree_in1;
-    
-    //few edges at the end of window, 0 for stale
-    edgeT_t<T>*      edges; //new edges
-    index_t          edge_count;//their count
-    
-    //Edges at the begining of the window, 0 for stale
-    edgeT_t<T>*      edges1; //old edges
-    index_t          edge_count1; //their count
-    
+
+    //window edges not in the adjacency lists
+    edgeT_t<T>*      edges;
+    index_t          edge_count;
+
     index_t          window_sz;
-    vid_t            v_count; 
-    int              flag;
 
  public:
     inline wsnap_t() {
+        graph_out = 0;
+        graph_in = 0;
         degree_out = 0;
         degree_in = 0;
         degree_out1 = 0;
         degree_in1 = 0;
-        snapshot = 0;
         edges = 0;
-        edges1=0;
         edge_count = 0;
-        edge_count1 = 0;
-        pgraph = 0;
-        flag = 0;
-        v_count = 0;
+        window_sz = 0;
     }
     inline ~wsnap_t() {
-        if (degree_in == degree_out && degree_out != NULL) {
-            delete degree_out;
-        } else if (degree_in != degree_out) {
-            delete degree_out;
-            delete degree_in;
-        }
-        
-        if (degree_in1 == degree_out1 && degree_out1 != NULL) {
-            delete degree_out1;
-        } else if (degree_in1 != degree_out1) {
-            delete degree_out1;
-            delete degree_in1;
+        if (degree_in != degree_out) {
+            free(degree_in);
+            free(degree_in1);
         }
+        free(degree_out);
+        free(degree_out1);
     }
     degree_t get_nebrs_out(vid_t vid, T* ptr);
     degree_t get_nebrs_in (vid_t vid, T* ptr);
     degree_t get_degree_out(vid_t vid);
     degree_t get_degree_in (vid_t vid);
-    vid_t    get_vcount() { return v_count;};     
-    
+
     //Don't provide this
     delta_adjlist_t<T>* get_nebrs_archived_out(vid_t);
     delta_adjlist_t<T>* get_nebrs_archived_in(vid_t);
     index_t get_nonarchived_edges(edgeT_t<T>*& ptr);
-
-    void init_view(pgraph_t<T>* pgraph, index_t window_sz, index_t flag);
-    void create_degreesnap();
-    void create_degreesnapd();
 };
 
+/*
+Sliding window of the last window_sz edges of the log, from the registration
+of the view on. The view keeps a copy of the edges of the window, so each
+update only touches the edges that enter or leave the window, and the vertices
+of these edges: no degree array is recomputed.
+
+Log positions, all moving forward:
+ w_start, w_end: the window.
+ a_end: archived up to, end of the window in the adjacency lists (degree_out).
+ e_end: min(w_start, a_end), start of the window in the adjacency lists (degree_out1).
+ The copy holds [w_base, w_end), w_base <= e_end.
+
+The window edges [max(w_start, a_end), w_end) are not archived yet, they are
+returned by get_nonarchived_edges(). Without STALE_MASK the window ends at the
+head of the log, otherwise at the snapshot. Deletions are not supported.
+*/
 template <class T>
 class wsstream_t : public wsnap_t<T> {
  protected:
-    using wsnap_t<T>::pgraph;    
+    using wsnap_t<T>::pgraph;
     using wsnap_t<T>::degree_in;
     using wsnap_t<T>::degree_in1;
     using wsnap_t<T>::degree_out;
@@ -88,150 +86,127 @@ class wsstream_t : public wsnap_t<T> {
     using wsnap_t<T>::graph_out;
     using wsnap_t<T>::graph_in;
     using wsnap_t<T>::snapshot;
-    using wsnap_t<T>::snapshot1;
     using wsnap_t<T>::edges;
-    using wsnap_t<T>::edges1;
     using wsnap_t<T>::edge_count;
-    using wsnap_t<T>::edge_count1;
     using wsnap_t<T>::v_count;
     using wsnap_t<T>::flag;
     using wsnap_t<T>::window_sz;
- protected:   
+
+    edgeT_t<T>*      wedges;//copy of [w_base, w_end)
+    index_t          wedge_cap;
+    index_t          w_base;
+    index_t          w_start;
+    index_t          w_end;
+    index_t          a_end;
+    index_t          e_end;
+
+    //window before the last update
+    index_t          prev_start;
+    index_t          prev_end;
+ protected:
     Bitmap*          bitmap_in;
     Bitmap*          bitmap_out;
- 
+
  public:
-    void*            algo_meta;//algorithm specific data
     typename callback<T>::sfunc   wsstream_func;
 
  public:
     inline wsstream_t() {
-        algo_meta = 0;
+        wedges = 0;
+        wedge_cap = 0;
+        w_base = 0;
+        w_start = 0;
+        w_end = 0;
+        a_end = 0;
+        e_end = 0;
+        prev_start = 0;
+        prev_end = 0;
+        bitmap_in = 0;
+        bitmap_out = 0;
     }
     inline ~wsstream_t() {
+        if (bitmap_in != bitmap_out) delete bitmap_in;
+        delete bitmap_out;
+        free(wedges);
     }
  public:
-    inline void    set_algometa(void* a_meta) {algo_meta = a_meta;}
-    inline void*   get_algometa() {return algo_meta;}
-    
+    //vertices with an edge entering or leaving the window in the last update
     inline bool has_vertex_changed_out(vid_t v) {return bitmap_out->get_bit(v);}
     inline bool has_vertex_changed_in(vid_t v) {return bitmap_in->get_bit(v);}
-    
-    void init_wsstream_view(pgraph_t<T>* pgraph, index_t window_sz, index_t flag);
-    status_t update_view();
-    
-    void update_degreesnap();
-    void update_degreesnapd();
-};
 
-template <class T>
-void wsnap_t<T>::create_degreesnap()
-{
-    #pragma omp parallel
-    {
-        snapid_t snap_id = 0;
-        if (snapshot1) {
-            snap_id = snapshot1->snap_id;
-        
-            #pragma omp for 
-            for (vid_t v = 0; v < v_count; ++v) {
-                degree_out1[v] = graph_out->get_degree(v, snap_id);
-                //cout << v << " " << degree_out[v] << endl;
-            }
-        }
+    //The deltas of the last update, apply the new edges first: with a batch
+    //larger than the window, an edge may enter and leave in the same update.
+    inline index_t get_new_edges(edgeT_t<T>*& ptr) {
+        ptr = wedges + (prev_end - w_base);
+        return w_end - prev_end;
     }
-        // (false == IS_STALE(flag)) check is not required, 
-        // as this is the beginning marker of the window
-        #pragma omp for
-        for (index_t i = 0; i < edge_count1; ++i) {
-            __sync_fetch_and_add(degree_out1 + edges1[i].src_id, 1);
-            __sync_fetch_and_add(degree_out1 + get_dst(edges1 + i), 1);
-        }
-}
-
-template <class T>
-void wsnap_t<T>::create_degreesnapd()
-{
-    #pragma omp parallel
-    {
-        vid_t   vcount_out = v_count;
-        vid_t   vcount_in  = v_count;
-        
-        snapid_t snap_id = 0;
-        if (snapshot1) {
-            snap_id = snapshot1->snap_id;
-
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_out; ++v) {
-                degree_out1[v] = graph_out->get_degree(v, snap_id);
-            }
-            
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_in; ++v) {
-                degree_in1[v] = graph_in->get_degree(v, snap_id);
-            }
-        }
-        
-        if (false == IS_STALE(flag)) {
-            #pragma omp for
-            for (index_t i = 0; i < edge_count1; ++i) {
-                __sync_fetch_and_add(degree_out1 + edges1[i].src_id, 1);
-                __sync_fetch_and_add(degree_in1 + get_dst(edges1+i), 1);
-            }
-        }
+    inline index_t get_expired_edges(edgeT_t<T>*& ptr) {
+        ptr = wedges + (prev_start - w_base);
+        return w_start - prev_start;
     }
-    return;
-}
+    //all the edges of the window
+    inline index_t get_window_edges(edgeT_t<T>*& ptr) {
+        ptr = wedges + (w_start - w_base);
+        return w_end - w_start;
+    }
+    inline index_t get_window_start() { return w_start; }
+    inline index_t get_window_end() { return w_end; }
+    inline int is_unidir() { return 0 == graph_in; }
+    inline bool is_undirected() { return graph_in == graph_out; }
+
+    void init_wsstream_view(pgraph_t<T>* pgraph, index_t window_sz, index_t flag);
+    status_t update_view();
+
+ private:
+    void clear_changed();
+    void fetch_edges(index_t new_end);
+    void add_degree(degree_t* d_out, degree_t* d_in, index_t start, index_t end);
+    void set_changed(index_t start, index_t end);
+};
 
 template <class T>
-void wsnap_t<T>::init_view(pgraph_t<T>* ugraph, index_t window_sz1, index_t a_flag)
+void wsstream_t<T>::init_wsstream_view(pgraph_t<T>* ugraph, index_t window_sz1,
+                                       index_t a_flag)
 {
-    pgraph  = ugraph;
-    snapshot1 = pgraph->get_snapshot();
-
-    blog_t<T>* blog = pgraph->blog;
-    index_t  marker = blog->blog_head;
-    index_t new_marker = snapshot1->marker;
-
-    //for degree creation at the beginning marker of window
-    edges1 = blog->blog_beg + (new_marker & blog->blog_mask);
-    edge_count1 = marker - new_marker;
-    
-    snapshot = 0;
-    edges = 0;
-    edge_count = 0;
+    pgraph = ugraph;
+    snapshot = pgraph->get_snapshot();
     v_count = g->get_type_scount();
-    
     window_sz = window_sz1;
-    flag = a_flag; 
+    flag = a_flag;
+
+    //the window starts empty at the current snapshot
+    w_base = w_start = w_end = a_end = e_end = snapshot ? snapshot->marker : 0;
+    prev_start = prev_end = w_start;
+
     graph_out = ugraph->sgraph_out[0];
-    
     degree_out = (degree_t*) calloc(v_count, sizeof(degree_t));
     degree_out1 = (degree_t*) calloc(v_count, sizeof(degree_t));
-    
+    bitmap_out = new Bitmap(v_count);
+
     if (ugraph->sgraph_in == ugraph->sgraph_out) {
         graph_in   = graph_out;
         degree_in  = degree_out;
         degree_in1 = degree_out1;
-        create_degreesnap();
+        bitmap_in  = bitmap_out;
     } else if (ugraph->sgraph_in != 0) {
         graph_in   = ugraph->sgraph_in[0];
         degree_in  = (degree_t*) calloc(v_count, sizeof(degree_t));
         degree_in1 = (degree_t*) calloc(v_count, sizeof(degree_t));
-        create_degreesnapd();
+        bitmap_in  = new Bitmap(v_count);
+    } else {
+        bitmap_in  = bitmap_out;
     }
-}
 
-template <class T>
-void wsstream_t<T>::init_wsstream_view(pgraph_t<T>* ugraph, index_t window_sz1, 
-                                       index_t flag)
-{
-    this->init_view(ugraph, window_sz1, flag);
-    
-    if (graph_out == graph_in) {
-        bitmap_in = bitmap_out;
-    } else {
-        bitmap_in = new Bitmap(v_count);
+    if (0 == snapshot) return;
+    snapid_t snap_id = snapshot->snap_id;
+    #pragma omp parallel for num_threads(THD_COUNT)
+    for (vid_t v = 0; v < v_count; ++v) {
+        degree_out[v] = get_total(graph_out->get_degree(v, snap_id));
+        degree_out1[v] = degree_out[v];
+        if (graph_in && graph_in != graph_out) {
+            degree_in[v] = get_total(graph_in->get_degree(v, snap_id));
+            degree_in1[v] = degree_in[v];
+        }
     }
 }
 
@@ -239,144 +214,136 @@ template <class T>
 status_t wsstream_t<T>::update_view()
 {
     blog_t<T>* blog = pgraph->blog;
-    index_t  marker = blog->blog_head;
     snapshot_t* new_snapshot = pgraph->get_snapshot();
-    
-    if (new_snapshot == 0|| (new_snapshot == snapshot)) return eNoWork;
-    
-    index_t new_marker = new_snapshot->marker;
-    index_t old_marker = edge_count1 + snapshot1 ? snapshot1->marker : 0;
-
-    
-    //for stale
-    edges = blog->blog_beg + (new_marker & blog->blog_mask);
-    edge_count = marker - new_marker;
-    
-    if (false == IS_STALE(flag)) {
-        if(marker - old_marker < window_sz) {
-            return eNoWork;
-        } 
-    } else {
-        if(new_marker - old_marker < window_sz) {
-            return eNoWork;
-        }
-    }
-    
-    snapshot = new_snapshot;
-    
-    if (pgraph->sgraph_in == 0) {
-        update_degreesnap();
-    } else {
-        update_degreesnapd();
-    }
+    index_t new_a_end = new_snapshot ? new_snapshot->marker : 0;
+    index_t new_end = IS_STALE(flag) ? new_a_end : blog->blog_head;
+
+    new_a_end = max(new_a_end, a_end);
+    new_end = max(new_end, w_end);
+    if (new_end == w_end && new_a_end == a_end) return eNoWork;
+
+    clear_changed();
+    fetch_edges(new_end);
+
+    //the window in the adjacency lists
+    index_t new_start = max(w_start, (new_end > window_sz) ? new_end - window_sz : 0);
+    index_t new_e_end = min(new_start, new_a_end);
+    add_degree(degree_out, degree_in, a_end, new_a_end);
+    add_degree(degree_out1, degree_in1, e_end, new_e_end);
 
+    prev_start = w_start;
+    prev_end = w_end;
+    w_start = new_start;
+    w_end = new_end;
+    a_end = new_a_end;
+    e_end = new_e_end;
+    if (new_snapshot) snapshot = new_snapshot;
+
+    set_changed(prev_end, w_end);
+    set_changed(prev_start, w_start);
+
+    index_t na_start = max(w_start, a_end);
+    edges = wedges + (na_start - w_base);
+    edge_count = w_end - na_start;
     return eOK;
 }
 
+//Reset the bits of the last update, the bitmaps are not scanned
 template <class T>
-void wsstream_t<T>::update_degreesnap()
+void wsstream_t<T>::clear_changed()
 {
-    #pragma omp parallel
-    {
-        snapid_t snap_id = 0;
-        if (snapshot) {
-            snap_id = snapshot->snap_id;
-        
-            snapT_t<T>*   snap_blob = 0;
-            degree_t      nebr_count = 0;
-            
-            #pragma omp for 
-            for (vid_t v = 0; v < v_count; ++v) {
-                nebr_count = graph_out->get_degree(v, snap_id);
-                if (degree_out[v] != nebr_count) {
-                    degree_out[v] = nebr_count;
-                    bitmap_out->set_bit(v);
-                } else {
-                    bitmap_out->reset_bit(v);
-                }
-                //cout << v << " " << degree_out[v] << endl;
-            }
-        }
-        if (false == IS_STALE(flag)) {
-            #pragma omp for
-            for (index_t i = 0; i < edge_count; ++i) {
-                __sync_fetch_and_add(degree_out + edges[i].src_id, 1);
-                __sync_fetch_and_add(degree_out + get_dst(edges + i), 1);
-            }
+    edgeT_t<T>* changed = wedges + (prev_end - w_base);
+    index_t count = w_end - prev_end;
+    for (int j = 0; j < 2; ++j) {
+        #pragma omp parallel for num_threads(THD_COUNT)
+        for (index_t i = 0; i < count; ++i) {
+            bitmap_out->reset_bit(TO_VID(changed[i].src_id));
+            bitmap_in->reset_bit(TO_VID(get_dst(changed + i)));
         }
-    }
-
-    //Update the degree nodes for the starting marker of window
-    // 1. fetch the durable degree edges
-    index_t end_marker = (IS_STALE(flag) ? 0: edge_count) + snapshot->marker;
-    edges1 = pgraph->get_prior_edges(snapshot1->marker + edge_count1, end_marker);
-    index_t how_much = end_marker - snapshot1->marker - edge_count1;
-    // 2. compute the degree
-    for (index_t i = 0; i < how_much; ++i) {
-        __sync_fetch_and_add(degree_out1 + edges1[i].src_id, 1);
-        __sync_fetch_and_add(degree_out1 + get_dst(edges1 + i), 1);
+        changed = wedges + (prev_start - w_base);
+        count = w_start - prev_start;
     }
 }
 
+//Copy [w_end, new_end) of the log to the end of wedges
 template <class T>
-void wsstream_t<T>::update_degreesnapd()
+void wsstream_t<T>::fetch_edges(index_t new_end)
 {
+    blog_t<T>* blog = pgraph->blog;
+    index_t count = new_end - w_end;
 
-    #pragma omp parallel
-    {
-        vid_t   vcount_out = v_count;
-        vid_t   vcount_in  = v_count;
-        snapT_t<T>*   snap_blob = 0;
-        degree_t      nebr_count = 0;
-        
-        snapid_t snap_id = 0;
-        if (snapshot) {
-            snap_id = snapshot->snap_id;
-
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_out; ++v) {
-                nebr_count = graph_out->get_degree(v, snap_id);
-                if (degree_out[v] != nebr_count) {
-                    degree_out[v] = nebr_count;
-                    bitmap_out->set_bit(v);
-                } else {
-                    bitmap_out->reset_bit(v);
-                }
-            }
-        
-            #pragma omp for nowait 
-            for (vid_t v = 0; v < vcount_in; ++v) {
-                nebr_count = graph_in->get_degree(v, snap_id);
-                if (degree_in[v] != nebr_count) {
-                    degree_in[v] = nebr_count;
-                    bitmap_in->set_bit(v);
-                } else {
-                    bitmap_in->reset_bit(v);
-                }
+    //drop [w_base, e_end) when out of room
+    if (w_end - w_base + count > wedge_cap) {
+        index_t keep = w_end - e_end;
+        if (keep) memmove(wedges, wedges + (e_end - w_base), keep*sizeof(edgeT_t<T>));
+        w_base = e_end;
+        if (keep + count > wedge_cap) {
+            wedge_cap = max((keep + count) << 1, (index_t)(1L << 16));
+            wedges = (edgeT_t<T>*)realloc(wedges, wedge_cap*sizeof(edgeT_t<T>));
+            if (0 == wedges) {
+                perror("window edges");
+                assert(0);
             }
         }
+    }
+    edgeT_t<T>* dst_edges = wedges + (w_end - w_base);
 
-        if (false == IS_STALE(flag)) {
-            #pragma omp for
-            for (index_t i = 0; i < edge_count; ++i) {
-                __sync_fetch_and_add(degree_out + edges[i].src_id, 1);
-                __sync_fetch_and_add(degree_in + get_dst(edges+i), 1);
-            }
+    //blog_head moves before an edge is copied in, wait for the parity of its
+    //lap. Edge i is overwritten once the head passes i + blog_count.
+    #pragma omp parallel for num_threads(THD_COUNT)
+    for (index_t i = 0; i < count; ++i) {
+        index_t index = ((w_end + i) & blog->blog_mask);
+        bool rewind1 = !(((w_end + i) >> BLOG_SHIFT) & 0x1);
+        while (rewind1 != (bool)IS_DEL(get_dst(blog->blog_beg[index]))
+               && blog->blog_head <= w_end + i + blog->blog_count) {
+            usleep(10);
         }
+        dst_edges[i] = blog->blog_beg[index];
     }
 
-    //Update the degree nodes for the starting marker of window
-    // 1. fetch the durable degree edges
-    index_t end_marker = (IS_STALE(flag) ? 0: edge_count) + snapshot->marker;
-    edges1 = pgraph->get_prior_edges(snapshot1->marker + edge_count1, end_marker);
-    index_t how_much = end_marker - snapshot1->marker - edge_count1;
-    // 2. compute the degree
-    for (index_t i = 0; i < how_much; ++i) {
-        __sync_fetch_and_add(degree_out1 + edges1[i].src_id, 1);
-        __sync_fetch_and_add(degree_in1 + get_dst(edges1 + i), 1);
+    if (blog->blog_head > w_end + blog->blog_count) {
+        if (-1 == pgraph->wtf) {
+            cout << "the window view fell behind the edge log" << endl;
+            assert(0);
+        }
+        while (blog->blog_wtail < new_end) usleep(10);
+        edgeT_t<T>* prior_edges = pgraph->get_prior_edges(w_end, new_end);
+        memcpy(dst_edges, prior_edges, count*sizeof(edgeT_t<T>));
+        free(prior_edges);
     }
 
-    return;
+    //drop the lap parity
+    for (index_t i = 0; i < count; ++i) {
+        set_dst(dst_edges + i, TO_SID(get_dst(dst_edges + i)));
+    }
+}
+
+//Count the adjacency list entries of the edges [start, end)
+template <class T>
+void wsstream_t<T>::add_degree(degree_t* d_out, degree_t* d_in, index_t start, index_t end)
+{
+    edgeT_t<T>* add_edges = wedges + (start - w_base);
+    index_t count = (end > start) ? end - start : 0;
+
+    #pragma omp parallel for num_threads(THD_COUNT)
+    for (index_t i = 0; i < count; ++i) {
+        __sync_fetch_and_add(d_out + TO_VID(add_edges[i].src_id), 1);
+        if (d_in) {
+            __sync_fetch_and_add(d_in + TO_VID(get_dst(add_edges + i)), 1);
+        }
+    }
+}
+
+template <class T>
+void wsstream_t<T>::set_changed(index_t start, index_t end)
+{
+    edgeT_t<T>* changed = wedges + (start - w_base);
+
+    #pragma omp parallel for num_threads(THD_COUNT)
+    for (index_t i = 0; i < end - start; ++i) {
+        bitmap_out->set_bit_atomic(TO_VID(changed[i].src_id));
+        bitmap_in->set_bit_atomic(TO_VID(get_dst(changed + i)));
+    }
 }
 
 template <class T>
@@ -4,6 +4,7 @@
 #include <getopt.h>
 #include <stdlib.h>
 #include "graph.h"
+#include "numa_part.h"
 
 #define no_argument 0
 #define required_argument 1 
@@ -38,6 +39,9 @@ void print_usage()
     help += " --direction -d: Direction, 0 for undirected, 1 for directed, 2 for unidirected. Default: 0(undirected)\n";
     help += " --source  -s: Data source. 0 for text files, 1 for binary files. Default: text files\n";
     help += " --residue or -r: Various meanings.\n";
+    help += " --sync -y: fdatasync the persisted edge log every N edges, -1 once per snapshot. Default: 0(never)\n";
+    help += " --numa -n: Partition the vertices over N NUMA nodes for archiving and analytics. Default: 0(NUMA oblivious)\n";
+    help += " --compress -z: 1 to store the adjacency lists delta+varint encoded when compressing the graph. Default: 0(raw)\n";
 
     cout << help << endl;
 }
@@ -61,6 +65,9 @@ int main(int argc, char* argv[])
         {"edgecount",  required_argument,  0, 'e'},
         {"direction",  required_argument,  0, 'd'},
         {"source",  required_argument,  0, 's'},
+        {"sync",  required_argument,  0, 'y'},
+        {"numa",  required_argument,  0, 'n'},
+        {"compress",  required_argument,  0, 'z'},
         {0,			  0,				  0,  0},
     };
 
@@ -75,7 +82,7 @@ int main(int argc, char* argv[])
     //int i = 0;
     //while (i < 100000) { usleep(10); ++i; }
     g = new graph; 
-	while ((o = getopt_long(argc, argv, "i:c:j:o:q:t:f:r:v:e:d:s:h", longopts, &index)) != -1) {
+	while ((o = getopt_long(argc, argv, "i:c:j:o:q:t:f:r:v:e:d:s:y:n:z:h", longopts, &index)) != -1) {
 		switch(o) {
 			case 'v':
 				#ifdef B64
@@ -123,6 +130,17 @@ int main(int argc, char* argv[])
             case 's':
                 sscanf(optarg, "%d", &_source);
                 break;
+            case 'y':
+                long sync_count;
+                sscanf(optarg, "%ld", &sync_count);
+                W_SYNC = sync_count;
+                break;
+            case 'n':
+                sscanf(optarg, "%d", &NUMA_COUNT);
+                break;
+            case 'z':
+                sscanf(optarg, "%d", &ADJ_COMPRESS);
+                break;
             case 'r':
                 sscanf(optarg, "%ld", &residue);
                 cout << "residue (multi-purpose) value) = " << residue << endl;
@@ -134,6 +152,7 @@ int main(int argc, char* argv[])
 		}
 	}
     cout << "Threads Count = " << THD_COUNT << endl;
+    if (get_node_count() > 1) cout << "NUMA nodes = " << get_node_count() << endl;
     g->set_odir(odir);
     switch (category) {
         case 0:
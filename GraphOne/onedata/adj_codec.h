@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "vunit.h"
+
+//Compressed adjacency blocks (ADJ_COMPRESS): compress() replaces the chain of
+//a vertex by one block of its neighbors in log order, each as the zigzag coded
+//difference to the previous one in a varint (7 bits per byte, high bit: more
+//bytes). The order is kept, as snapshots and windows address neighbors by their
+//position. Only plain neighbors are encoded, the other edge types keep their
+//raw blocks.
+
+template <class T>
+inline bool is_codable() { return sizeof(T) == sizeof(sid_t); }
+
+inline uint8_t* put_varint(uint8_t* out, sid_t value)
+{
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+inline const uint8_t* get_varint(const uint8_t* in, sid_t& value)
+{
+    value = *in++;
+    if (value < 0x80) return in;//most gaps are one byte
+    value &= 0x7F;
+    int shift = 7;
+    uint8_t byte;
+    do {
+        byte = *in++;
+        value |= (sid_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return in;
+}
+
+//Zigzag: small differences of either sign get small codes
+inline sid_t zigzag(sid_t diff) {
+    return (diff << 1) ^ (0 - (diff >> (sizeof(sid_t)*8 - 1)));
+}
+
+inline sid_t unzigzag(sid_t code) {
+    return (code >> 1) ^ (0 - (code & 1));
+}
+
+//Upper bound of the encoded size of count neighbors
+inline index_t max_codesize(degree_t count) {
+    return count*((sizeof(sid_t)*8 + 6)/7);
+}
+
+//Encodes nebrs in codes, returns the encoded size
+template <class T>
+index_t encode_nebrs(T* nebrs, degree_t count, uint8_t* codes)
+{
+    uint8_t* out = codes;
+    sid_t prev = 0;
+    for (degree_t i = 0; i < count; ++i) {
+        sid_t sid = get_sid(nebrs[i]);
+        out = put_varint(out, zigzag(sid - prev));
+        prev = sid;
+    }
+    return out - codes;
+}
+
+//Decodes the first count neighbors of a compressed block
+template <class T>
+void decode_nebrs(delta_adjlist_t<T>* block, T* nebrs, degree_t count)
+{
+    const uint8_t* in = block->get_codes();
+    sid_t sid = 0;
+    sid_t code;
+    for (degree_t i = 0; i < count; ++i) {
+        in = get_varint(in, code);
+        sid += unzigzag(code);
+        nebrs[i] = T();
+        set_sid(nebrs[i], sid);
+    }
+}
+
+//The neighbors of a block: in place, or decoded in buf of the caller, valid
+//until buf is used again.
+template <class T>
+inline T* read_adjlist(delta_adjlist_t<T>* block, std::vector<T>& buf)
+{
+    if (!block->is_compressed()) return block->get_adjlist();
+    degree_t count = block->get_nebrcount();
+    if (buf.size() < (size_t)count) buf.resize(count);
+    decode_nebrs(block, buf.data(), count);
+    return buf.data();
+}
+
+//Calls fn(adj_list, count) on the first count neighbors of a compressed block,
+//decoded in chunks on the stack. Returns false once fn does.
+template <class T, class F>
+inline bool for_each_codes(delta_adjlist_t<T>* block, degree_t count, F& fn)
+{
+    T buf[256];
+    const uint8_t* in = block->get_codes();
+    sid_t sid = 0;
+    sid_t code;
+    while (count > 0) {
+        degree_t chunk = std::min(count, 256);
+        for (degree_t i = 0; i < chunk; ++i) {
+            in = get_varint(in, code);
+            sid += unzigzag(code);
+            buf[i] = T();
+            set_sid(buf[i], sid);
+        }
+        if (!fn(buf, chunk)) return false;
+        count -= chunk;
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "vunit.h"
+
+//The degree arrays of the views are paged by vertex range. A page is shared by
+//all the views (and the cache of onegraph_t) that see the same degrees in its
+//range, a view copies it only before changing it.
+#define DPAGE_BITS 9
+#define DPAGE_SIZE (1 << DPAGE_BITS)
+#define DPAGE_MASK (DPAGE_SIZE - 1)
+
+class dpage_t {
+ public:
+    int32_t   ref_count;
+    sdegree_t degree[DPAGE_SIZE];
+};
+
+inline dpage_t* new_dpage() {
+    dpage_t* page = (dpage_t*)malloc(sizeof(dpage_t));
+    page->ref_count = 1;
+    return page;
+}
+
+inline dpage_t* ref_dpage(dpage_t* page) {
+    __sync_fetch_and_add(&page->ref_count, 1);
+    return page;
+}
+
+inline void unref_dpage(dpage_t* page) {
+    if (page && 1 == __sync_fetch_and_sub(&page->ref_count, 1)) {
+        free(page);
+    }
+}
+
+//page table of one degree array
+class dpages_t {
+ public:
+    dpage_t** pages;
+    uint8_t*  dirty;//pages to be made private by own_marked()
+    vid_t     page_count;
+
+ public:
+    inline dpages_t() {
+        pages = 0;
+        dirty = 0;
+        page_count = 0;
+    }
+    inline ~dpages_t() {
+        reset(0);
+    }
+    static inline vid_t get_page_count(vid_t v_count) {
+        return (v_count + DPAGE_MASK) >> DPAGE_BITS;
+    }
+
+    //Drop all the pages, make room for v_count vertices
+    void reset(vid_t v_count) {
+        for (vid_t p = 0; p < page_count; ++p) {
+            unref_dpage(pages[p]);
+        }
+        free(pages);
+        free(dirty);
+        pages = 0;
+        dirty = 0;
+        page_count = get_page_count(v_count);
+        if (page_count) {
+            pages = (dpage_t**)calloc(page_count, sizeof(dpage_t*));
+            dirty = (uint8_t*)calloc(page_count, sizeof(uint8_t));
+        }
+    }
+
+    inline dpage_t* get_page(vid_t p) { return pages[p]; }
+    inline void set_page(vid_t p, dpage_t* page) {
+        unref_dpage(pages[p]);
+        pages[p] = page;
+    }
+    inline void share_page(vid_t p, dpage_t* page) {
+        if (pages[p] != page) set_page(p, ref_dpage(page));
+    }
+    //Point every page to the one of other, nothing is copied
+    void share(dpages_t& other) {
+        if (page_count != other.page_count) {
+            reset(0);
+            page_count = other.page_count;
+            pages = (dpage_t**)calloc(page_count, sizeof(dpage_t*));
+            dirty = (uint8_t*)calloc(page_count, sizeof(uint8_t));
+        }
+        for (vid_t p = 0; p < page_count; ++p) {
+            share_page(p, other.pages[p]);
+        }
+    }
+
+    inline sdegree_t operator[](vid_t v) const {
+        return pages[v >> DPAGE_BITS]->degree[v & DPAGE_MASK];
+    }
+
+    //Writes go in two steps: mark_write() the vertices, then own_marked() so that
+    //at() of a marked vertex is private to this table.
+    inline void mark_write(vid_t v) {
+        vid_t p = (v >> DPAGE_BITS);
+        if (0 == dirty[p]) dirty[p] = 1;
+    }
+    //called inside a parallel region
+    void own_marked() {
+        #pragma omp for
+        for (vid_t p = 0; p < page_count; ++p) {
+            if (0 == dirty[p]) continue;
+            dirty[p] = 0;
+            if (pages[p]->ref_count == 1) continue;
+            dpage_t* page = new_dpage();
+            memcpy(page->degree, pages[p]->degree, sizeof(page->degree));
+            set_page(p, page);
+        }
+    }
+    inline sdegree_t& at(vid_t v) {
+        return pages[v >> DPAGE_BITS]->degree[v & DPAGE_MASK];
+    }
+};
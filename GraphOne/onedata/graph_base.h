@@ -10,6 +10,8 @@
 
 #include "type.h"
 #include "vunit.h"
+#include "adj_codec.h"
+#include "degree_pages.h"
 #include "mem_pool.h"
 
 //One vertex's neighbor information
@@ -41,6 +43,14 @@ class onegraph_t {
 	//Thread local memory data structures
 	thd_mem_t<T>* thd_mem;
 
+    //degree pages for the views, see create_degree_pages()
+    snapid_t*  dpage_changed;//last snapshot that changed a degree in the page
+    dpages_t   dpage_cache;  //degrees at dpage_snap_id
+    snapid_t   dpage_snap_id;
+    vid_t      dpage_vcount;
+    bool       dpage_valid;
+    pthread_mutex_t dpage_mutex;
+
  private:
     //vertex table file related log
     write_seg_t  write_seg[3];
@@ -61,6 +71,7 @@ public:
     virtual void  setup(tid_t tid, vid_t a_max_vcount);
     virtual void  archive(edgeT_t<T>* edge, index_t count, snapid_t a_snapid);
     void  compress();
+    index_t get_adjlist_size();
     void  handle_write(bool clean = false);
     void  read_vtable();
     void  file_open(const string& filename, bool trunc);
@@ -68,6 +79,7 @@ public:
     
     inline void set_snapid(snapid_t a_snapid) { snap_id = a_snapid;}
     sdegree_t get_degree(vid_t v, snapid_t snap_id);
+    void create_degree_pages(vid_t v_count, snapid_t a_snapid, dpages_t& view);
     inline sdegree_t get_degree(vid_t vid) {
         vunit_t<T>* v_unit = get_vunit(vid);
         if (v_unit) return v_unit->get_degree();
@@ -104,11 +116,17 @@ protected:
     status_t evict_old_adjlist(vid_t vid, degree_t degree);
     
     status_t compress_nebrs(vid_t vid);
+    status_t encode_adjlist(vid_t vid, std::vector<T>& nebrs, std::vector<uint8_t>& codes);
 	
     inline vunit_t<T>* get_vunit(vid_t v) {return beg_pos[v].v_unit;}
 	inline void set_vunit(vid_t v, vunit_t<T>* v_unit) {
 		beg_pos[v].v_unit = v_unit;
 	}
+    //the degree of v changes in snap_id
+    inline void mark_degree_page(vid_t v) {
+        snapid_t* changed = dpage_changed + (v >> DPAGE_BITS);
+        if (*changed != snap_id) *changed = snap_id;
+    }
     //-----------durability thing------------
     void prepare_dvt(write_seg_t* seg, vid_t& last_vid, bool clean = false);
 	void adj_prep(write_seg_t* seg);
@@ -143,6 +161,10 @@ protected:
         return thd_mem->alloc_adjlist(count, hub);
 	}
 
+	inline delta_adjlist_t<T>* new_codes_adjlist(index_t code_size) {
+        return thd_mem->alloc_codes(code_size);
+	}
+
     inline void delete_delta_adjlist(delta_adjlist_t<T>* adj_list, bool chain = false) {
         thd_mem->free_adjlist(adj_list, chain);
     }
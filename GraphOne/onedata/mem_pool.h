@@ -2,6 +2,7 @@
 
 #include <unistd.h>
 #include <algorithm>
+#include "numa_part.h"
 using std::cout;
 using std::endl;
 using std::max;
@@ -26,6 +27,15 @@ inline void* alloc_huge(index_t size)
     return MAP_FAILED;
 }
 
+//Head of a bulk region of adjacency blocks, the regions of a thread are linked
+class adj_region_t {
+ public:
+    char*   prev;
+    index_t size;
+    int     mapped;//alloc_on_node(), else malloc()
+};
+#define ADJ_REGION_HEAD 64
+
 template <class T>
 struct mem_t {
     vunit_t<T>* vunit_beg;
@@ -42,11 +52,30 @@ struct mem_t {
 	index_t    	delta_size;
     
     char*       adjlog_beg1;
+    char*       adj_regions;//last bulk region of adjacency blocks
 };
 
 template <class T>
 class thd_mem_t {
     mem_t<T>* mem;  
+    char*     retired;//regions detached by retire_adjlist()
+    
+    //NUMA mode: the pools of a thread come from the node of its vertices
+    inline int get_thd_node() {
+        return thd_to_node(omp_get_thread_num(), THD_COUNT);
+    }
+    
+    //huge pages bound to the node if possible, else pages on the node;
+    //MAP_FAILED in oblivious mode when there are no huge pages
+    inline void* alloc_node_bulk(index_t size) {
+        void* buf = alloc_huge(size);
+        if (get_node_count() == 1) return buf;
+        if (MAP_FAILED != buf) {
+            bind_to_node(buf, size, get_thd_node());
+            return buf;
+        }
+        return alloc_on_node(size, get_thd_node());
+    }
  
  public:	
     inline vunit_t<T>* alloc_vunit() {
@@ -61,7 +90,7 @@ class thd_mem_t {
     inline status_t vunit_bulk(vid_t count) {
         mem_t<T>* mem1 = mem + omp_get_thread_num();  
         mem1->vunit_count = count;
-        mem1->vunit_beg = (vunit_t<T>*)alloc_huge(count*sizeof(vunit_t<T>));
+        mem1->vunit_beg = (vunit_t<T>*)alloc_node_bulk(count*sizeof(vunit_t<T>));
         if (MAP_FAILED == mem1->vunit_beg) {
             mem1->vunit_beg = (vunit_t<T>*)calloc(sizeof(vunit_t<T>), count);
             assert(mem1->vunit_beg);
@@ -81,7 +110,7 @@ class thd_mem_t {
     inline status_t snapdegree_bulk(vid_t count) {
         mem_t<T>* mem1 = mem + omp_get_thread_num();  
         mem1->dsnap_count = count;
-        mem1->dlog_beg = (snapT_t<T>*)alloc_huge(sizeof(snapT_t<T>)*count);
+        mem1->dlog_beg = (snapT_t<T>*)alloc_node_bulk(sizeof(snapT_t<T>)*count);
         if (MAP_FAILED == mem1->dlog_beg) {
             mem1->dlog_beg = (snapT_t<T>*)calloc(sizeof(snapT_t<T>), count);
         }
@@ -102,16 +131,7 @@ class thd_mem_t {
 		adj_list =  (delta_adjlist_t<T>*)malloc(size);
         assert(adj_list!=0);
         #else 
-        mem_t<T>* mem1 = mem + omp_get_thread_num();  
-        index_t tmp = 0;
-		if (size > mem1->delta_size) {
-			tmp = max(1UL << LOCAL_DELTA_SIZE, size);
-            delta_adjlist_bulk(tmp);
-		}
-		adj_list = (delta_adjlist_t<T>*)mem1->adjlog_beg;
-		assert(adj_list != 0);
-		mem1->adjlog_beg += size;
-		mem1->delta_size -= size;
+        adj_list = (delta_adjlist_t<T>*)adjlog_alloc(size);
         #endif
         
         adj_list->set_nebrcount(0);
@@ -120,6 +140,36 @@ class thd_mem_t {
         
 		return adj_list;
 	}
+    
+    //A compressed block for size bytes of codes
+	inline delta_adjlist_t<T>* alloc_codes(index_t code_size) {
+		delta_adjlist_t<T>* adj_list = 0;
+        index_t size = (code_size + sizeof(delta_adjlist_t<T>) + 7) & ~7UL;
+        #if defined(DEL) || defined(MALLOC) 
+		adj_list =  (delta_adjlist_t<T>*)malloc(size);
+        assert(adj_list!=0);
+        #else 
+        adj_list = (delta_adjlist_t<T>*)adjlog_alloc(size);
+        #endif
+        adj_list->set_nebrcount(0);
+        adj_list->add_next(0);
+        adj_list->set_codesize(code_size);
+		return adj_list;
+	}
+    
+    inline char* adjlog_alloc(index_t size) {
+        mem_t<T>* mem1 = mem + omp_get_thread_num();  
+        index_t tmp = 0;
+		if (size > mem1->delta_size) {
+			tmp = max(1UL << LOCAL_DELTA_SIZE, size);
+            delta_adjlist_bulk(tmp);
+		}
+		char* ptr = mem1->adjlog_beg;
+		assert(ptr != 0);
+		mem1->adjlog_beg += size;
+		mem1->delta_size -= size;
+        return ptr;
+    }
 
     void free_adjlist(delta_adjlist_t<T>* adj_list, bool chain) {
         #if defined(DEL) || defined(MALLOC)
@@ -139,17 +189,55 @@ class thd_mem_t {
     
     inline status_t delta_adjlist_bulk(index_t size) {
         mem_t<T>* mem1 = mem + omp_get_thread_num();  
-        mem1->delta_size = size;
-        mem1->adjlog_beg = (char*)alloc_huge(size);
-        if (MAP_FAILED == mem1->adjlog_beg) {
-            mem1->adjlog_beg = (char*)malloc(size);
-            assert(mem1->adjlog_beg);
+        index_t region_size = size + ADJ_REGION_HEAD;
+        int mapped = 1;
+        char* region = (char*)alloc_node_bulk(region_size);
+        if (MAP_FAILED == region) {
+            region = (char*)malloc(region_size);
+            assert(region);
+            mapped = 0;
         }
+        adj_region_t* head = (adj_region_t*)region;
+        head->prev = mem1->adj_regions;
+        head->size = region_size;
+        head->mapped = mapped;
+        mem1->adj_regions = region;
+        mem1->delta_size = size;
+        mem1->adjlog_beg = region + ADJ_REGION_HEAD;
         //cout << "alloc adj " << delta_size << endl; 
         return eOK;
     }
+    
+    //Detach the bulk regions of all the threads, the next blocks go to new
+    //ones. free_retired() once no vertex points to the old blocks.
+    void retire_adjlist() {
+        for (int i = 0; i < THD_COUNT; ++i) {
+            char* region = mem[i].adj_regions;
+            while (region) {
+                char* prev = ((adj_region_t*)region)->prev;
+                ((adj_region_t*)region)->prev = retired;
+                retired = region;
+                region = prev;
+            }
+            mem[i].adj_regions = 0;
+            mem[i].adjlog_beg = 0;
+            mem[i].delta_size = 0;
+        }
+    }
+    void free_retired() {
+        while (retired) {
+            adj_region_t* head = (adj_region_t*)retired;
+            retired = head->prev;
+            if (head->mapped) {
+                free_on_node(head, head->size);
+            } else {
+                free(head);
+            }
+        }
+    }
 
     inline thd_mem_t() {
+        retired = 0;
         if(posix_memalign((void**)&mem, 64, THD_COUNT*sizeof(mem_t<T>))) {
             cout << "posix_memalign failed()" << endl;
             mem = (mem_t<T>*)calloc(sizeof(mem_t<T>), THD_COUNT);
@@ -51,6 +51,7 @@ void onegraph_t<T>::increment_count_noatomic(vid_t vid, degree_t count /*=1*/)
 
 	snapT_t<T>* curr = v_unit->get_snapblob();
 	if (curr == 0 || curr->snap_id < snap_id) {
+        mark_degree_page(vid);
 		//allocate new snap blob 
 		snapT_t<T>* next = v_unit->recycle_snapblob(snap_id);
 		if (next == 0) {
@@ -81,6 +82,7 @@ void onegraph_t<T>::decrement_count_noatomic(vid_t vid, degree_t count /*=1*/)
     }
 	snapT_t<T>* curr = v_unit->get_snapblob();
 	if (curr == 0 || curr->snap_id < snap_id) {
+        mark_degree_page(vid);
 		//allocate new snap blob 
 		snapT_t<T>* next = v_unit->recycle_snapblob(snap_id);
 		if (next == 0) {
@@ -135,7 +137,7 @@ void onegraph_t<T>::add_nebr_bulk(vid_t vid, T* adj_list2, degree_t count)
     delta_adjlist_t<T>* adj_list1 = v_unit->adj_list;
     #ifndef BULK 
     //First add whatever spaces are left
-    if (adj_list1 != 0) {
+    if (adj_list1 != 0 && !adj_list1->is_compressed()) {
         degree_t left_space = adj_list1->get_maxcount() - adj_list1->get_nebrcount();
         if (left_space < count) { 
             adj_list1->add_nebr_bulk(adj_list2, left_space);
@@ -206,11 +208,91 @@ template <class T>
 void onegraph_t<T>::compress()
 {
     vid_t   v_count = get_vcount(tid);
+    //degrees of the latest snapshot change in place
+    dpage_valid = false;
 
-    #pragma omp for schedule (dynamic, 256) nowait
+    if (0 == ADJ_COMPRESS || !is_codable<T>()) {
+        #pragma omp for schedule (dynamic, 256) nowait
+        for (vid_t vid = 0; vid < v_count; ++vid) {
+            compress_nebrs(vid);
+        }
+        return;
+    }
+
+    //Every chain moves to a compressed block in new regions, then the old
+    //regions are released at once.
+    #pragma omp single
+    thd_mem->retire_adjlist();
+    
+    std::vector<T> nebrs;
+    std::vector<uint8_t> codes;
+    #pragma omp for schedule (dynamic, 256)
+    for (vid_t vid = 0; vid < v_count; ++vid) {
+        encode_adjlist(vid, nebrs, codes);
+    }
+    
+    #pragma omp single nowait
+    thd_mem->free_retired();
+}
+
+//The chain of vid becomes one compressed block, see adj_codec.h. Without
+//deletions the neighbors keep their positions, so the older snapshots and the
+//windows still address the same ones; deletions are compacted as by
+//compress_nebrs().
+template <class T>
+status_t onegraph_t<T>::encode_adjlist(vid_t vid, std::vector<T>& nebrs, std::vector<uint8_t>& codes)
+{
+    vunit_t<T>* v_unit = get_vunit(vid); 
+    if (v_unit == 0 || v_unit->delta_adjlist == 0) return eOK;
+    
+	sdegree_t sdegree = v_unit->get_degree();
+	degree_t nebr_count = get_actual(sdegree);
+    delta_adjlist_t<T>* adj_list = 0;
+    
+    if (nebr_count != 0) {
+        if (nebrs.size() < (size_t)nebr_count) nebrs.resize(nebr_count);
+        degree_t ret = get_nebrs(vid, nebrs.data(), sdegree);
+        assert(ret == nebr_count);
+        
+        index_t code_size = max_codesize(nebr_count);
+        if (codes.size() < code_size) codes.resize(code_size);
+        code_size = encode_nebrs(nebrs.data(), nebr_count, codes.data());
+        
+        adj_list = new_codes_adjlist(code_size);
+        memcpy(adj_list->get_codes(), codes.data(), code_size);
+        adj_list->set_nebrcount(nebr_count);
+    }
+
+    delta_adjlist_t<T>* old_adjlist = v_unit->delta_adjlist;
+    v_unit->delta_adjlist = adj_list;
+    v_unit->adj_list = adj_list;
+    v_unit->compress_degree();
+    delete_delta_adjlist(old_adjlist, true);//chain free
+    return eOK;
+}
+
+//Bytes of the adjacency blocks
+template <class T>
+index_t onegraph_t<T>::get_adjlist_size()
+{
+    vid_t   v_count = get_vcount(tid);
+    index_t size = 0;
+    
+    #pragma omp parallel for reduction(+:size) num_threads(THD_COUNT)
     for (vid_t vid = 0; vid < v_count; ++vid) {
-        compress_nebrs(vid);
+        vunit_t<T>* v_unit = get_vunit(vid);
+        if (v_unit == 0) continue;
+        delta_adjlist_t<T>* delta_adjlist = v_unit->delta_adjlist;
+        while (delta_adjlist) {
+            if (delta_adjlist->is_compressed()) {
+                size += (delta_adjlist->get_codesize() + sizeof(delta_adjlist_t<T>) + 7) & ~7UL;
+            } else {
+                size += sizeof(delta_adjlist_t<T>) + delta_adjlist->get_maxcount()*sizeof(T);
+            }
+            delta_adjlist = delta_adjlist->get_next();
+        }
     }
+    return size;
 }
 
 template <class T>
@@ -313,10 +395,14 @@ degree_t onegraph_t<T>::get_nebrs(vid_t vid, T* ptr, sdegree_t count/*,edgeT_t<T
     
     if (0 == del_count) {
         while (delta_adjlist != 0 && delta_degree > 0) {
-            local_adjlist = delta_adjlist->get_adjlist();
             local_degree = delta_adjlist->get_nebrcount();
             i_count = min(local_degree, delta_degree);
-            memcpy(ptr+total_count, local_adjlist, sizeof(T)*i_count);
+            if (delta_adjlist->is_compressed()) {
+                decode_nebrs(delta_adjlist, ptr+total_count, i_count);
+            } else {
+                local_adjlist = delta_adjlist->get_adjlist();
+                memcpy(ptr+total_count, local_adjlist, sizeof(T)*i_count);
+            }
             total_count+=i_count;
             
             delta_adjlist = delta_adjlist->get_next();
@@ -338,9 +424,10 @@ degree_t onegraph_t<T>::get_nebrs(vid_t vid, T* ptr, sdegree_t count/*,edgeT_t<T
         degree_t idel = 0;
         degree_t other_pos = 0;
         bool is_del = false;
+        std::vector<T> codes;
 
         while (delta_adjlist != 0 && delta_degree > 0) {
-            local_adjlist = delta_adjlist->get_adjlist();
+            local_adjlist = read_adjlist(delta_adjlist, codes);
             local_degree = delta_adjlist->get_nebrcount();
             i_count = min(local_degree, delta_degree);
             
@@ -406,46 +493,48 @@ degree_t onegraph_t<T>::get_nebrs(vid_t vid, T* ptr, sdegree_t count/*,edgeT_t<T
     return total_count;
 }
 
+//count neighbors of vid from position start of its adjacency list
 template <class T>
 degree_t onegraph_t<T>::get_wnebrs(vid_t vid, T* ptr, degree_t start, degree_t count)
 {
     vunit_t<T>* v_unit = get_vunit(vid); 
+    if (0 == v_unit) return 0;
     delta_adjlist_t<T>* delta_adjlist = v_unit->delta_adjlist;
     T* local_adjlist = 0;
     degree_t local_degree = 0;
     degree_t i_count = 0;
     degree_t total_count = 0;
             
-    //traverse the delta adj list
+    //skip the blocks before start
     degree_t delta_degree = start; 
+    while (delta_adjlist != 0 && delta_degree >= delta_adjlist->get_nebrcount()) {
+        delta_degree -= delta_adjlist->get_nebrcount();
+        delta_adjlist = delta_adjlist->get_next();
+    }
     
-    while (delta_adjlist != 0 && delta_degree > 0) {
-        local_adjlist = delta_adjlist->get_adjlist();
-        local_degree = delta_adjlist->get_nebrcount();
-        if (delta_degree >= local_degree) {
-            delta_adjlist = delta_adjlist->get_next();
-            delta_degree -= local_degree;
+    while (delta_adjlist != 0 && total_count < count) {
+        local_degree = delta_adjlist->get_nebrcount() - delta_degree;
+        i_count = min(local_degree, count - total_count);
+        if (delta_adjlist->is_compressed()) {
+            //decode only up to the end of the range, then skip its start
+            degree_t skip = delta_degree;
+            T* out = ptr + total_count;
+            auto fn = [&skip, &out](T* adj_list, degree_t n) {
+                degree_t first = min(skip, n);
+                skip -= first;
+                memcpy(out, adj_list + first, sizeof(T)*(n - first));
+                out += n - first;
+                return true;
+            };
+            for_each_codes(delta_adjlist, delta_degree + i_count, fn);
         } else {
-            i_count = local_degree - delta_degree;
-            memcpy(ptr, local_adjlist + delta_degree, sizeof(T)*i_count);
-            total_count += i_count;
-            delta_adjlist = delta_adjlist->get_next();
-            delta_degree = 0;
-            break;
+            local_adjlist = delta_adjlist->get_adjlist() + delta_degree;
+            memcpy(ptr + total_count, local_adjlist, sizeof(T)*i_count);
         }
-    }
-    
-    delta_degree = count;
-    while (delta_adjlist !=0 && total_count < count) {
-        local_adjlist = delta_adjlist->get_adjlist();
-        local_degree = delta_adjlist->get_nebrcount();
-        i_count = min(local_degree, delta_degree);
-        memcpy(ptr+total_count, local_adjlist, sizeof(T)*i_count);
-        total_count+=i_count;
+        total_count += i_count;
         
         delta_adjlist = delta_adjlist->get_next();
-        delta_degree -= local_degree;
-        
+        delta_degree = 0;
     }
     return total_count;
 }
@@ -461,6 +550,46 @@ sdegree_t onegraph_t<T>::get_degree(vid_t vid, snapid_t snap_id)
     return sdegree;
 }
 
+//Degree pages of the views at a_snapid. The cache keeps the pages of the last
+//call, only the pages changed since then are filled again, the others are shared.
+template <class T>
+void onegraph_t<T>::create_degree_pages(vid_t v_count, snapid_t a_snapid, dpages_t& view)
+{
+    pthread_mutex_lock(&dpage_mutex);
+    bool reuse = dpage_valid && (dpage_vcount == v_count) && (a_snapid >= dpage_snap_id);
+    dpages_t  local;
+    dpages_t* pages = &dpage_cache;
+    if (!dpage_valid || dpage_vcount != v_count) {
+        dpage_cache.reset(v_count);
+    } else if (!reuse) {
+        //an older snapshot than the cache, don't disturb the cache
+        local.reset(v_count);
+        pages = &local;
+    }
+    vid_t page_count = pages->page_count;
+    snapid_t old_snap_id = dpage_snap_id;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(THD_COUNT)
+    for (vid_t p = 0; p < page_count; ++p) {
+        if (reuse && dpage_changed[p] <= old_snap_id) continue;
+        dpage_t* page = new_dpage();
+        vid_t v_start = (p << DPAGE_BITS);
+        vid_t v_end = min(v_start + DPAGE_SIZE, v_count);
+        for (vid_t v = v_start; v < v_end; ++v) {
+            page->degree[v - v_start] = get_degree(v, a_snapid);
+        }
+        pages->set_page(p, page);
+    }
+
+    if (pages == &dpage_cache) {
+        dpage_snap_id = a_snapid;
+        dpage_vcount = v_count;
+        dpage_valid = true;
+    }
+    view.share(*pages);
+    pthread_mutex_unlock(&dpage_mutex);
+}
+
 template <class T>
 degree_t onegraph_t<T>::start(vid_t v, header_t<T>& header, degree_t offset/*=0*/)
 {
@@ -481,9 +610,10 @@ degree_t onegraph_t<T>::start(vid_t v, header_t<T>& header, degree_t offset/*=0*
     }
     
     header.next = delta_adjlist->get_next();
-    header.max_count = delta_adjlist->get_maxcount();
+    header.max_count = delta_adjlist->is_compressed() ? delta_adjlist->get_nebrcount()
+                                                      : delta_adjlist->get_maxcount();
     header.count = delta_degree;
-    header.adj_list = delta_adjlist->get_adjlist();
+    header.adj_list = read_adjlist(delta_adjlist, header.codes);
     
     return 0;
 }
@@ -494,9 +624,10 @@ status_t onegraph_t<T>::next(header_t<T>& header, T& dst)
     if (header.max_count == header.count) {
         delta_adjlist_t<T>* delta_adjlist = header.next;
         header.next = delta_adjlist->get_next();
-        header.max_count = delta_adjlist->get_maxcount();
+        header.max_count = delta_adjlist->is_compressed() ? delta_adjlist->get_nebrcount()
+                                                          : delta_adjlist->get_maxcount();
         header.count = 0;
-        header.adj_list = delta_adjlist->get_adjlist();
+        header.adj_list = read_adjlist(delta_adjlist, header.codes);
     }
     
     T* local_adjlist = header.adj_list;
@@ -591,7 +722,9 @@ void onegraph_t<T>::setup(tid_t t, vid_t a_max_vcount)
     tid = t;
     max_vcount = a_max_vcount;
     beg_pos = (vert_table_t<T>*)calloc(sizeof(vert_table_t<T>), max_vcount);
+    place_on_nodes(beg_pos, sizeof(vert_table_t<T>), max_vcount);
     thd_mem = new thd_mem_t<T>; 
+    dpage_changed = (snapid_t*)calloc(sizeof(snapid_t), dpages_t::get_page_count(max_vcount));
 
     dvt_max_count = DVT_SIZE;
     log_count = DURABLE_SIZE;
@@ -638,9 +771,10 @@ degree_t onegraph_t<T>::find_nebr(vid_t vid, sid_t sid)
     T*         local_adjlist = 0;
     delta_adjlist_t<T>* delta_adjlist = v_unit->delta_adjlist;
     delta_adjlist_t<T>* last = v_unit->adj_list;
+    std::vector<T> codes;
 
     {
-        local_adjlist = last->get_adjlist();
+        local_adjlist = read_adjlist(last, codes);
         local_degree  = last->get_nebrcount();
         for (degree_t i = local_degree; i != 0; --i) {
             nebr = get_sid(local_adjlist[i-1]);
@@ -663,7 +797,7 @@ degree_t onegraph_t<T>::find_nebr(vid_t vid, sid_t sid)
     delta_adjlist = v_unit->delta_adjlist;
     degree = 0;
     while (delta_adjlist != last) {
-        local_adjlist = delta_adjlist->get_adjlist();
+        local_adjlist = read_adjlist(delta_adjlist, codes);
         local_degree  = delta_adjlist->get_nebrcount();
         for (degree_t i = 0; i < local_degree; ++i) {
             nebr = get_sid(local_adjlist[i]);
@@ -756,10 +890,7 @@ void onegraph_t<T>::handle_write(bool clean /* = false */)
                 //Write the dvt log
                 if (seg2->dvt_count) {
                     off_t size = sizeof(disk_vtable_t)*seg2->dvt_count;
-					if (size != write(vtf_new, seg2->dvt, size)) {
-						perror("write issue in dvt");
-						assert(0);
-					}
+					write_all(vtf_new, seg2->dvt, size);
                 }
 			}
             if (2 == omp_get_thread_num())
@@ -767,10 +898,7 @@ void onegraph_t<T>::handle_write(bool clean /* = false */)
 				//Write new adj list
 				if (seg3->log_head != 0) {
 					off_t size = seg3->log_head;
-					if(size != write(etf_new, seg3->log_beg, size)) {
-						perror("pwrite issue in adj list");
-						assert(0);
-					}
+					write_all(etf_new, seg3->log_beg, size);
 				}
             }
 
@@ -794,14 +922,17 @@ void onegraph_t<T>::handle_write(bool clean /* = false */)
 		{
             if (seg3->log_head != 0) {
                 off_t size = seg3->log_head;
-                if (size != write(etf_new, seg3->log_beg, seg3->log_head)) {
-                    perror("pwrite issue");
-                    assert(0);
-                }
+                write_all(etf_new, seg3->log_beg, size);
             }
 		}
 	    //adj_update(seg3);
 	}
+    
+    //The adjacency store is durable before the snapshot record points to it
+    if (W_SYNC) {
+        sync_all(vtf_new);
+        sync_all(etf_new);
+    }
 
     //Rename the files
     if (clean) {
@@ -906,8 +1037,12 @@ void onegraph_t<T>::adj_prep(write_seg_t* seg)
         //Copy the new in-memory adj-list
 		delta_adjlist = prev_v_unit->delta_adjlist;
         while(delta_adjlist) {
-			memcpy(adj_list1, delta_adjlist->get_adjlist(),
-				   delta_adjlist->get_nebrcount()*sizeof(T));
+			if (delta_adjlist->is_compressed()) {
+				decode_nebrs(delta_adjlist, adj_list1, delta_adjlist->get_nebrcount());
+			} else {
+				memcpy(adj_list1, delta_adjlist->get_adjlist(),
+					   delta_adjlist->get_nebrcount()*sizeof(T));
+			}
 			adj_list1 += delta_adjlist->get_nebrcount();
 			delta_adjlist = delta_adjlist->get_next();
 		}
@@ -917,6 +1052,7 @@ void onegraph_t<T>::adj_prep(write_seg_t* seg)
 template <class T>
 void onegraph_t<T>::read_vtable()
 {
+    dpage_valid = false;
     off_t size = fsize(vtf);
     if (size == -1L) {
         assert(0);
@@ -1181,6 +1317,11 @@ onegraph_t<T>::onegraph_t()
     write_seg[0].reset();
     write_seg[1].reset();
     write_seg[2].reset();
+    dpage_changed = 0;
+    dpage_snap_id = 0;
+    dpage_vcount = 0;
+    dpage_valid = false;
+    pthread_mutex_init(&dpage_mutex, 0);
 
 #ifdef BULK
     nebr_count = 0;
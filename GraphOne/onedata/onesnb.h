@@ -49,6 +49,7 @@ void onesnb_t<T>::setup(tid_t t, vid_t a_max_vcount)
     this->max_vcount = (p*p << bit_shift2);
     this->beg_pos = (vert_table_t<T>*)calloc(sizeof(vert_table_t<T>), a_max_vcount);
     this->thd_mem = new thd_mem_t<T>; 
+    this->dpage_changed = (snapid_t*)calloc(sizeof(snapid_t), dpages_t::get_page_count(a_max_vcount));
 }
 
 template <class T>
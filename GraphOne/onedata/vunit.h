@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "type.h"
 
 template <class T>
@@ -28,6 +29,12 @@ class delta_adjlist_t {
     inline degree_t get_maxcount() {return max_count;}
     inline void set_maxcount(degree_t value) {max_count = value;}
 	inline T* get_adjlist() { return (T*)(&count + 1); }
+    
+    //A compressed block is full, its max_count is minus its encoded size
+    inline bool is_compressed() { return max_count < 0; }
+    inline uint8_t* get_codes() { return (uint8_t*)(&count + 1); }
+    inline index_t get_codesize() { return -max_count; }
+    inline void set_codesize(index_t size) { max_count = -(degree_t)size; }
 	inline void add_next(delta_adjlist_t<T>* ptr) {next = ptr; }
 	inline delta_adjlist_t<T>* get_next() { return next; }
     
@@ -63,6 +70,7 @@ class header_t {
     degree_t   max_count;
 	degree_t   count;
 	T*  adj_list;
+	std::vector<T> codes;//adj_list of a compressed block, decoded
 };
 
 template <class T>
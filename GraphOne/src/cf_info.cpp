@@ -3,6 +3,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <errno.h>
 
 #include "cf_info.h"
 #include "graph.h"
@@ -28,6 +29,9 @@ index_t  DURABLE_SIZE = (1L << 28);//Durable adj-list
 
 //durable data structure buffer size
 index_t  W_SIZE = (1L << 12); //Edges to write
+index_t  W_SYNC = 0; //edge log sync interval
+int      NUMA_COUNT = 0; //NUMA partitioning off
+int      ADJ_COMPRESS = 0; //compress() only coalesces
 index_t  DVT_SIZE = (1L <<24);//durable v-unit 
 
 #ifdef B64
@@ -277,6 +281,14 @@ status_t cfinfo_t::batch_update(const string& src, const string& dst, const char
     return  eOK;
 }
     
+status_t cfinfo_t::batch_update(const strview_t* src, const strview_t* dst, index_t count)
+{
+    for (index_t i = 0; i < count; ++i) {
+        batch_update(string(src[i].data(), src[i].size()), string(dst[i].data(), dst[i].size()));
+    }
+    return eOK;
+}
+
 status_t cfinfo_t::batch_update(const string& src, const string& dst, propid_t pid, 
                           propid_t count, prop_pair_t* prop_pair, int del /* = 0 */)
 {
@@ -376,3 +388,59 @@ off_t fsize(int fd)
     perror("stat issue");
     return -1L;
 }
+
+void write_all(int fd, const void* buf, index_t size)
+{
+    const char* ptr = (const char*)buf;
+    while (size != 0) {
+        ssize_t sz_write = write(fd, ptr, size);
+        if (sz_write < 0 && errno == EINTR) continue;
+        if (sz_write <= 0) {
+            perror("write issue");
+            assert(0);
+        }
+        ptr += sz_write;
+        size -= sz_write;
+    }
+}
+
+void pwrite_all(int fd, const void* buf, index_t size, index_t offset)
+{
+    const char* ptr = (const char*)buf;
+    while (size != 0) {
+        ssize_t sz_write = pwrite(fd, ptr, size, offset);
+        if (sz_write < 0 && errno == EINTR) continue;
+        if (sz_write <= 0) {
+            perror("pwrite issue");
+            assert(0);
+        }
+        ptr += sz_write;
+        offset += sz_write;
+        size -= sz_write;
+    }
+}
+
+void pread_all(int fd, void* buf, index_t size, index_t offset)
+{
+    char* ptr = (char*)buf;
+    while (size != 0) {
+        ssize_t sz_read = pread(fd, ptr, size, offset);
+        if (sz_read < 0 && errno == EINTR) continue;
+        if (sz_read <= 0) {
+            perror("pread issue");
+            assert(0);
+        }
+        ptr += sz_read;
+        offset += sz_read;
+        size -= sz_read;
+    }
+}
+
+void sync_all(int fd)
+{
+    while (0 != fdatasync(fd)) {
+        if (errno == EINTR) continue;
+        perror("fdatasync issue");
+        assert(0);
+    }
+}
@@ -3,6 +3,7 @@
 #include "type.h"
 #include "str.h"
 #include "prop_encoder.h"
+#include "str2sid.h"
 //#include "rset.h"
 
 extern void* alloc_buf();
@@ -107,6 +108,8 @@ class cfinfo_t {
     //edges and vertex properties
     virtual status_t batch_update(const string& src, const string& dst, propid_t pid = 0);
     virtual status_t batch_update(const string& src, const string& dst, const char* property_str);
+    //A batch of edges by the names of their ends
+    virtual status_t batch_update(const strview_t* src, const strview_t* dst, index_t count);
     
     //For heavy weight edges.
     virtual status_t batch_update(const string& src, const string& dst, propid_t pid, 
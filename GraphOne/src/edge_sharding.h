@@ -1,6 +1,7 @@
 #pragma once
 
 #include "type.h" 
+#include "numa_part.h"
 
 extern vid_t RANGE_COUNT;
 extern vid_t RANGE_2DSHIFT;
@@ -65,6 +66,14 @@ class thd_local_t {
       vid_t  range_end;
 };
 
+//NUMA mode: classified edges of the ranges of one node, kept across batches
+template <class T>
+class node_buf_t {
+  public:
+      index_t count;
+      edgeT_t<T>* edges;
+};
+
 template <class T>
 class edge_shard_t {
  public:
@@ -80,6 +89,12 @@ class edge_shard_t {
     
     thd_local_t* thd_local;
     thd_local_t* thd_local_in;
+    
+    //NUMA mode: owner node of each range, and the per node buffers
+    int* range_node;
+    int* range_node_in;
+    node_buf_t<T>* node_buf;
+    node_buf_t<T>* node_buf_in;
 
  public:
     ~edge_shard_t();
@@ -111,6 +126,18 @@ class edge_shard_t {
     
     void estimate_classify_snb(vid_t* vid_range, vid_t bit_shift);
     void classify_snb(vid_t* vid_range, vid_t bit_shift, global_range_t<T>* global_range);
+    
+    void classify_numa(pgraph_t<T>* pgraph, vid_t v_count, vid_t bit_shift, 
+                       vid_t v_count_in, vid_t bit_shift_in, bool is_directed);
+    void range_span(int* range_node, int node, vid_t& r_beg, vid_t& r_end);
+    void estimate_classify_node(vid_t* vid_range, vid_t* vid_range_in, vid_t bit_shift, vid_t bit_shift_in, 
+            index_t i_beg, index_t i_end);
+    void prefix_sum_node(global_range_t<T>* global_range, thd_local_t* thd_local,
+                         int* range_node, node_buf_t<T>* node_buf);
+    void classify_node(vid_t* vid_range, vid_t* vid_range_in, vid_t bit_shift, vid_t bit_shift_in, 
+            global_range_t<T>* global_range, global_range_t<T>* global_range_in, 
+            index_t i_beg, index_t i_end);
+    void work_division_node(global_range_t<T>* global_range, thd_local_t* thd_local, int* range_node);
 };
 
 template <class T>
@@ -125,6 +152,11 @@ edge_shard_t<T>::edge_shard_t(blog_t<T>* binary_log)
     
     thd_local = (thd_local_t*) calloc(THD_COUNT, sizeof(thd_local_t));  
     thd_local_in = (thd_local_t*) calloc(THD_COUNT, sizeof(thd_local_t));  
+    
+    range_node = (int*)calloc(RANGE_COUNT, sizeof(int));
+    range_node_in = (int*)calloc(RANGE_COUNT, sizeof(int));
+    node_buf = (node_buf_t<T>*)calloc(get_node_count(), sizeof(node_buf_t<T>));
+    node_buf_in = (node_buf_t<T>*)calloc(get_node_count(), sizeof(node_buf_t<T>));
 }
 
 template <class T>
@@ -135,6 +167,15 @@ edge_shard_t<T>::~edge_shard_t()
     free(thd_local);
     free(global_range_in);
     free(thd_local_in);
+    
+    for (int node = 0; node < get_node_count(); ++node) {
+        free_on_node(node_buf[node].edges, node_buf[node].count*sizeof(edgeT_t<T>));
+        free_on_node(node_buf_in[node].edges, node_buf_in[node].count*sizeof(edgeT_t<T>));
+    }
+    free(node_buf);
+    free(node_buf_in);
+    free(range_node);
+    free(range_node_in);
 }
 
 template <class T>
@@ -180,6 +221,10 @@ void edge_shard_t<T>::classify_u(pgraph_t<T>* pgraph)
     bit_shift = 64 - bit_shift; 
 #endif
     
+    if (get_node_count() > 1) {
+        return classify_numa(pgraph, v_count, bit_shift, v_count, bit_shift, false);
+    }
+    
     int tid = omp_get_thread_num();
     vid_t* vid_range = (vid_t*)calloc(RANGE_COUNT, sizeof(vid_t)); 
     thd_local[tid].vid_range = vid_range;
@@ -400,6 +445,10 @@ void edge_shard_t<T>::classify_d(pgraph_t<T>* pgraph)
     vid_t bit_shift_in = __builtin_clzl(base_vid_in);
     bit_shift_in = 64 - bit_shift_in; 
 #endif
+    
+    if (get_node_count() > 1) {
+        return classify_numa(pgraph, v_count, bit_shift, v_count_in, bit_shift_in, true);
+    }
 
     index_t total_edge_count = blog->blog_marker - blog->blog_tail;
     //alloc_edge_buf(total_edge_count);
@@ -800,3 +849,238 @@ void edge_shard_t<T>::archive(onegraph_t<T>** sgraph, global_range_t<T>* global_
         }
     }
 }
+
+//NUMA mode: the batch is split once among all the threads, and each edge goes
+//to the buffer of the node that owns its range. These ranges are then archived
+//by the threads of the same node, so the adjacency list of a vertex is
+//allocated on its node (see thd_mem_t). The threads are pinned to their node
+//for the round only.
+template <class T>
+void edge_shard_t<T>::classify_numa(pgraph_t<T>* pgraph, vid_t v_count, vid_t bit_shift, 
+                                    vid_t v_count_in, vid_t bit_shift_in, bool is_directed)
+{
+    int tid = omp_get_thread_num();
+    int node = thd_to_node(tid, THD_COUNT);
+    numa_pin_t pin;
+    
+    //the range of first vertex decides, so each node owns consecutive ranges
+    #pragma omp for schedule(static)
+    for (vid_t r = 0; r < RANGE_COUNT; ++r) {
+        index_t vid = ((index_t)r << bit_shift);
+        range_node[r] = (vid < v_count) ? vid_to_node(vid, v_count) : get_node_count() - 1;
+        vid = ((index_t)r << bit_shift_in);
+        range_node_in[r] = (vid < v_count_in) ? vid_to_node(vid, v_count_in) : get_node_count() - 1;
+    }
+    
+    //undirected: both ends go to the out ranges
+    global_range_t<T>* global_range_dst = global_range;
+    vid_t* vid_range = (vid_t*)calloc(RANGE_COUNT, sizeof(vid_t)); 
+    vid_t* vid_range_dst = vid_range;
+    thd_local[tid].vid_range = vid_range;
+    if (is_directed) {
+        global_range_dst = global_range_in;
+        vid_range_dst = (vid_t*)calloc(RANGE_COUNT, sizeof(vid_t)); 
+        thd_local_in[tid].vid_range = vid_range_dst;
+    }
+    
+    //this thread's share of the batch, every edge is read once
+    index_t total = blog->blog_marker - blog->blog_tail;
+    index_t portion = (total + THD_COUNT - 1)/THD_COUNT;
+    index_t i_beg = blog->blog_tail + std::min(total, portion*tid);
+    index_t i_end = blog->blog_tail + std::min(total, portion*(tid + 1));
+
+    //Get the count for classification
+    this->estimate_classify_node(vid_range, vid_range_dst, bit_shift, bit_shift_in, i_beg, i_end);
+    #pragma omp barrier 
+    this->prefix_sum_node(global_range, thd_local, range_node, node_buf);
+    if (is_directed) {
+        this->prefix_sum_node(global_range_in, thd_local_in, range_node_in, node_buf_in);
+    }
+    #pragma omp barrier 
+    
+    //Classify
+    this->classify_node(vid_range, vid_range_dst, bit_shift, bit_shift_in, global_range,
+                        global_range_dst, i_beg, i_end);
+    if (tid == node_thd_beg(node, THD_COUNT)) {
+        this->work_division_node(global_range, thd_local, range_node);
+        if (is_directed) {
+            this->work_division_node(global_range_in, thd_local_in, range_node_in);
+        }
+    }
+    #pragma omp barrier 
+    free(vid_range);
+    if (is_directed) free(vid_range_dst);
+    
+    //Now get the division of work, within the ranges of the node
+    vid_t r_beg, r_end;
+    vid_t j_start, j_end;
+    
+    range_span(range_node, node, r_beg, r_end);
+    j_start = (tid == node_thd_beg(node, THD_COUNT)) ? r_beg : thd_local[tid - 1].range_end;
+    j_end = thd_local[tid].range_end;
+    archive(pgraph->sgraph, global_range, j_start, j_end, pgraph->snap_id);
+    
+    if (is_directed) {
+        range_span(range_node_in, node, r_beg, r_end);
+        j_start = (tid == node_thd_beg(node, THD_COUNT)) ? r_beg : thd_local_in[tid - 1].range_end;
+        j_end = thd_local_in[tid].range_end;
+        archive(pgraph->sgraph_in, global_range_in, j_start, j_end, pgraph->snap_id);
+    }
+    #pragma omp barrier 
+    
+    //the edges stay in the node buffers for the next batch
+    #pragma omp for schedule (static)
+    for (vid_t i = 0; i < RANGE_COUNT; ++i) {
+        global_range[i].edges = 0;
+        global_range[i].count = 0;
+        global_range_in[i].edges = 0;
+        global_range_in[i].count = 0;
+    }
+    cleanup();
+}
+
+template <class T>
+void edge_shard_t<T>::range_span(int* range_node, int node, vid_t& r_beg, vid_t& r_end)
+{
+    r_beg = 0;
+    while (r_beg < RANGE_COUNT && range_node[r_beg] < node) ++r_beg;
+    r_end = r_beg;
+    while (r_end < RANGE_COUNT && range_node[r_end] == node) ++r_end;
+}
+
+template <class T>
+void edge_shard_t<T>::estimate_classify_node(vid_t* vid_range, vid_t* vid_range_in, vid_t bit_shift, 
+        vid_t bit_shift_in, index_t i_beg, index_t i_end) 
+{
+    sid_t src, dst;
+    vid_t range;
+    edgeT_t<T>* edges = blog->blog_beg;
+    index_t index;
+    bool rewind1, rewind2;
+
+    for (index_t i = i_beg; i < i_end; ++i) {
+        index = (i & blog->blog_mask);
+        rewind1 = !((i >> BLOG_SHIFT) & 0x1);
+        rewind2 = IS_DEL(get_dst(edges[index]));
+        while (rewind1 != rewind2) {
+            usleep(10);
+            rewind2 = IS_DEL(get_dst(edges[index]));
+        }
+        
+        src = edges[index].src_id;
+        dst = TO_SID(get_dst(edges[index]));
+        
+        range = (TO_VID(src) >> bit_shift);
+        assert(range < RANGE_COUNT);
+        vid_range[range] += 1;
+        
+        range = (TO_VID(dst) >> bit_shift_in);
+        assert(range < RANGE_COUNT);
+        vid_range_in[range] += 1;
+    }
+}
+
+template <class T>
+void edge_shard_t<T>::prefix_sum_node(global_range_t<T>* global_range, thd_local_t* thd_local,
+                                      int* range_node, node_buf_t<T>* node_buf)
+{
+    index_t total = 0;
+    index_t value = 0;
+
+    #pragma omp for schedule(static)
+    for (vid_t i = 0; i < RANGE_COUNT; ++i) {
+        total = 0;
+        for (int j = 0; j < THD_COUNT; ++j) {
+            value = thd_local[j].vid_range[i];
+            thd_local[j].vid_range[i] = total;
+            total += value;
+        }
+        global_range[i].count = total;
+    }
+    
+    //first thread of the node carves the node buffer
+    int tid = omp_get_thread_num();
+    int node = thd_to_node(tid, THD_COUNT);
+    if (tid != node_thd_beg(node, THD_COUNT)) return;
+    
+    vid_t r_beg, r_end;
+    range_span(range_node, node, r_beg, r_end);
+    total = 0;
+    for (vid_t i = r_beg; i < r_end; ++i) {
+        total += global_range[i].count;
+    }
+    if (total > node_buf[node].count) {
+        free_on_node(node_buf[node].edges, node_buf[node].count*sizeof(edgeT_t<T>));
+        node_buf[node].count = std::max(total, (node_buf[node].count << 1));
+        node_buf[node].edges = (edgeT_t<T>*)alloc_on_node(
+                node_buf[node].count*sizeof(edgeT_t<T>), node);
+    }
+    total = 0;
+    for (vid_t i = r_beg; i < r_end; ++i) {
+        global_range[i].edges = node_buf[node].edges + total;
+        total += global_range[i].count;
+    }
+}
+
+template <class T>
+void edge_shard_t<T>::classify_node(vid_t* vid_range, vid_t* vid_range_in, vid_t bit_shift, vid_t bit_shift_in, 
+        global_range_t<T>* global_range, global_range_t<T>* global_range_in, 
+        index_t i_beg, index_t i_end)
+{
+    sid_t src, dst;
+    vid_t range = 0;
+    edgeT_t<T>* edge;
+    edgeT_t<T>* edges = blog->blog_beg;
+    index_t index;
+
+    for (index_t i = i_beg; i < i_end; ++i) {
+        index = (i & blog->blog_mask);
+        src = edges[index].src_id;
+        dst = TO_SID(get_dst(edges[index]));
+        
+        range = (TO_VID(src) >> bit_shift);
+        edge = global_range[range].edges + vid_range[range];
+        vid_range[range] += 1;
+        edge->src_id = src;
+        set_dst(edge, dst);
+        set_weight(edge, edges[index].dst_id);
+        
+        range = (TO_VID(dst) >> bit_shift_in);
+        edge = global_range_in[range].edges + vid_range_in[range];
+        vid_range_in[range] += 1;
+        if (!IS_DEL(src)) {
+            edge->src_id = dst;
+            set_dst(edge, src);
+        } else {
+            edge->src_id = DEL_SID(dst);
+            set_dst(edge, UNDEL_SID(src));
+        }
+        set_weight(edge, edges[index].dst_id);
+    }
+    #pragma omp barrier 
+}
+
+//range_end of the threads of the node, only over the ranges of the node
+template <class T>
+void edge_shard_t<T>::work_division_node(global_range_t<T>* global_range, thd_local_t* thd_local, 
+                                         int* range_node)
+{
+    int node = thd_to_node(omp_get_thread_num(), THD_COUNT);
+    int t_beg = node_thd_beg(node, THD_COUNT);
+    int t_end = node_thd_beg(node + 1, THD_COUNT);
+    vid_t r_beg, r_end;
+    range_span(range_node, node, r_beg, r_end);
+    
+    if (r_beg != r_end) {
+        index_t total = 0;
+        for (vid_t i = r_beg; i < r_end; ++i) {
+            total += global_range[i].count;
+        }
+        index_t equal_work = (total*1.15)/(t_end - t_beg);
+        this->work_division(global_range + r_beg, thd_local + t_beg, r_end - r_beg, 
+                            t_end - t_beg, equal_work);
+    }
+    for (int t = t_beg; t < t_end; ++t) {
+        thd_local[t].range_end += r_beg;
+    }
+}
@@ -144,16 +144,21 @@ tid_t graph::get_total_types()
     return typekv->get_total_types();
 }
 
-sid_t graph::type_update(const string& src, const string& dst)
+sid_t graph::type_update(strview_t src, const string& dst)
 {
     return get_typekv()->type_update(src, dst);
 }
 
-sid_t graph::type_update(const string& src, tid_t tid/*=0*/)
+sid_t graph::type_update(strview_t src, tid_t tid/*=0*/)
 {
     return get_typekv()->type_update(src, tid);
 }
 
+void graph::type_update(const strview_t* src, index_t count, tid_t tid, sid_t* sids)
+{
+    get_typekv()->type_update(src, count, tid, sids);
+}
+
 void graph::type_store(const string& odir)
 {
     typekv = (typekv_t*) cf_info[0];
@@ -188,11 +193,16 @@ propid_t graph::get_pid(const char* predicate)
     return str2pid_iter->second;
 }
 
-sid_t graph::get_sid(const char* src)
+sid_t graph::get_sid(strview_t src)
 {
     return get_typekv()->get_sid(src);
 }
 
+void graph::get_sids(const strview_t* src, index_t count, sid_t* sids)
+{
+    get_typekv()->get_sids(src, count, sids);
+}
+
 status_t graph::batch_update(const string& src, const string& dst, const string& predicate)
 {
     map<string, propid_t>::iterator str2pid_iter;
@@ -209,6 +219,22 @@ status_t graph::batch_update(const string& src, const string& dst, const string&
     return eOK;
 }
     
+status_t graph::batch_update(const strview_t* src, const strview_t* dst, index_t count, 
+                          const string& predicate)
+{
+    map<string, propid_t>::iterator str2pid_iter;
+    str2pid_iter = str2pid.find(predicate);
+    if (str2pid_iter == g->str2pid.end()) {
+        assert(0);
+    }
+    propid_t pid = str2pid_iter->second;
+    propid_t cf_id = g->get_cfid(pid);
+    if (pid != 0) { //non-type
+      return  cf_info[cf_id]->batch_update(src, dst, count);
+    }
+    return eOK;
+}
+    
 status_t graph::batch_update(const string& src, const string& dst, const string& predicate, 
                           const char* property_str)
 {
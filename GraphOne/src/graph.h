@@ -42,9 +42,12 @@ class graph {
     vid_t get_type_vcount(tid_t type);
     tid_t get_total_types();
 	tid_t get_tid(const char* type);
-    sid_t type_update(const string& src, const string& dst);
-    sid_t type_update(const string& src, tid_t tid = 0);
-    sid_t get_sid(const char* src);
+    sid_t type_update(strview_t src, const string& dst);
+    sid_t type_update(strview_t src, tid_t tid = 0);
+    sid_t get_sid(strview_t src);
+    //Batched type_update() and get_sid(), the lookups run in parallel
+    void  type_update(const strview_t* src, index_t count, tid_t tid, sid_t* sids);
+    void  get_sids(const strview_t* src, index_t count, sid_t* sids);
     void  type_store(const string& odir);
 
 
@@ -58,6 +61,8 @@ class graph {
     //void run_query(query_clause* q);
     
     status_t batch_update(const string& src, const string& dst, const string& predicate);
+    status_t batch_update(const strview_t* src, const strview_t* dst, index_t count, 
+                          const string& predicate);
     //useful or properties
     status_t batch_update(sid_t src_id, const string& dst, const string& predicate);
     //For edges with properties.
@@ -57,6 +57,8 @@ class blog_t {
     }
 
     inline void readfrom_snapshot(snapshot_t* global_snapshot) {
+        //nothing archived yet, all of the edge log is to be replayed
+        if (0 == global_snapshot) return;
         blog_head = global_snapshot->marker;
         blog_tail = global_snapshot->marker;
         blog_marker = global_snapshot->marker;
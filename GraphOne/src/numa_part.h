@@ -0,0 +1,120 @@
+#pragma once
+
+#include <omp.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <algorithm>
+#ifdef NUMA
+#include <numa.h>
+#endif
+
+#include "type.h"
+
+//NUMA mode (NUMA_COUNT > 1): the vertex ids are split in NUMA_COUNT equal
+//ranges, range i is owned by node i. The omp threads are spread over the nodes
+//in the order of their thread id, so a static schedule over the vertices hands
+//each thread vertices of its own node. Node ids above the machine's last node
+//wrap around, so the partitioning also runs on smaller machines.
+
+inline int get_node_count() {
+    if (NUMA_COUNT <= 1) return 1;
+    return std::min(NUMA_COUNT, THD_COUNT);
+}
+
+//node of omp thread tid in a team of thd_count
+inline int thd_to_node(int tid, int thd_count) {
+    return (tid*get_node_count())/thd_count;
+}
+
+//first thread of the node, node_thd_beg(node + 1) is past its last one
+inline int node_thd_beg(int node, int thd_count) {
+    int node_count = get_node_count();
+    return (node*thd_count + node_count - 1)/node_count;
+}
+
+inline int vid_to_node(vid_t vid, vid_t v_count) {
+    int node_count = get_node_count();
+    vid_t portion = (v_count + node_count - 1)/node_count;
+    if (portion == 0) return 0;
+    return std::min((int)(vid/portion), node_count - 1);
+}
+
+inline int get_phys_node(int node) {
+#ifdef NUMA
+    return node % (numa_max_node() + 1);
+#else
+    return 0;
+#endif
+}
+
+//Zeroed memory on a node, release it with free_on_node()
+inline void* alloc_on_node(index_t size, int node) {
+    void* ptr = 0;
+#ifdef NUMA
+    if (numa_available() >= 0) {
+        ptr = numa_alloc_onnode(size, get_phys_node(node));
+        if (ptr) return ptr;
+    }
+#endif
+    ptr = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == ptr) {
+        perror("alloc on node");
+        assert(0);
+    }
+    return ptr;
+}
+
+inline void free_on_node(void* ptr, index_t size) {
+    if (ptr) munmap(ptr, size);
+}
+
+inline void pin_to_node(int node) {
+#ifdef NUMA
+    if (numa_available() >= 0) numa_run_on_node(get_phys_node(node));
+#endif
+}
+
+//Bind the pages of a mapping that are not yet touched to a node
+inline void bind_to_node(void* ptr, index_t size, int node) {
+#ifdef NUMA
+    if (numa_available() >= 0) numa_tonode_memory(ptr, size, get_phys_node(node));
+#endif
+}
+
+//Pins the calling omp thread to the node of its vertices while it lives, then
+//gives the thread back the affinity it had. No-op in oblivious mode.
+class numa_pin_t {
+    cpu_set_t saved;
+    bool      pinned;
+ public:
+    numa_pin_t() : pinned(false) {
+        if (get_node_count() == 1) return;
+        pinned = (0 == sched_getaffinity(0, sizeof(saved), &saved));
+        pin_to_node(thd_to_node(omp_get_thread_num(), omp_get_num_threads()));
+    }
+    ~numa_pin_t() {
+        if (pinned) sched_setaffinity(0, sizeof(saved), &saved);
+    }
+};
+
+//Bind the not yet touched pages of a per-vertex array to the owner nodes
+inline void place_on_nodes(void* ptr, index_t unit_size, vid_t v_count) {
+#ifdef NUMA
+    int node_count = get_node_count();
+    if (node_count == 1 || numa_available() < 0) return;
+
+    index_t page_mask = getpagesize() - 1;
+    vid_t portion = (v_count + node_count - 1)/node_count;
+    index_t beg = (index_t)ptr;
+    for (int node = 0; node < node_count; ++node) {
+        //whole pages only, a page across two nodes stays with the first toucher
+        index_t node_beg = beg + unit_size*std::min(v_count, portion*node);
+        index_t node_end = beg + unit_size*std::min(v_count, portion*(node + 1));
+        node_beg = (node_beg + page_mask) & ~page_mask;
+        if (node != node_count - 1) node_end &= ~page_mask;
+        if (node_beg < node_end) {
+            numa_tonode_memory((void*)node_beg, node_end - node_beg, get_phys_node(node));
+        }
+    }
+#endif
+}
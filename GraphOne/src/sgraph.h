@@ -33,6 +33,10 @@ class pgraph_t: public cfinfo_t {
         //edge sharding unit
         edge_shard_t<T>* edge_shard;
 
+        //header of the durable edge log, and edges synced to the disk
+        elog_header_t elog_header;
+        index_t       w_durable;
+
 #ifdef _MPI
         MPI_Datatype data_type;//For T
         MPI_Datatype edge_type;//For edgeT_t<T>
@@ -44,6 +48,8 @@ class pgraph_t: public cfinfo_t {
         sgraph_in = 0;
         edge_shard = 0;
         blog = new blog_t<T>;
+        memset(&elog_header, 0, sizeof(elog_header));
+        w_durable = 0;
 #ifdef _MPI
         T* type = 0;
         create_MPI_datatype(type, data_type, edge_type);
@@ -54,13 +60,31 @@ class pgraph_t: public cfinfo_t {
         blog->alloc_edgelog(count);
     }
     status_t write_edgelog(); 
+    void sync_edgelog(index_t w_marker);
+    index_t replay_edgelog();
+    inline index_t get_durable_marker() {
+        return w_durable;
+    }
     
     virtual status_t batch_update(const string& src, const string& dst, propid_t pid = 0) {
         edgeT_t<T> edge; 
-        edge.src_id = g->get_sid(src.c_str());
-        set_dst(&edge, g->get_sid(dst.c_str()));
+        edge.src_id = g->get_sid(src);
+        set_dst(&edge, g->get_sid(dst));
         return batch_edge(edge);
     }
+    //The names are resolved in parallel, then the edges go to the log in order
+    virtual status_t batch_update(const strview_t* src, const strview_t* dst, index_t count) {
+        std::vector<sid_t> ids(2*count);
+        g->get_sids(src, count, ids.data());
+        g->get_sids(dst, count, ids.data() + count);
+        edgeT_t<T> edge;
+        for (index_t i = 0; i < count; ++i) {
+            edge.src_id = ids[i];
+            set_dst(&edge, ids[count + i]);
+            batch_edge(edge);
+        }
+        return eOK;
+    }
     virtual status_t batch_update(const string& src, const string& dst, const char* property_str) {
         assert(0);
     } ;
@@ -276,28 +300,133 @@ status_t pgraph_t<T>::write_edgelog()
 {
     index_t w_marker = blog->blog_head;
     index_t w_tail = blog->blog_wtail;
+    
+    //blog_head moves before the edge is copied in, write only the filled
+    //edges. A filled edge has the parity of its lap in the DEL bit.
+    for (index_t i = w_tail; i < w_marker; ++i) {
+        bool rewind = !((i >> BLOG_SHIFT) & 0x1);
+        bool filled = IS_DEL(get_dst(blog->blog_beg[i & blog->blog_mask]));
+        if (rewind != filled) {
+            w_marker = i;
+            break;
+        }
+    }
     index_t w_count = w_marker - w_tail;
-    if (w_count == 0) return eNoWork;
+    
+    if (w_count != 0) {
+        index_t actual_tail = w_tail & blog->blog_mask;
+        index_t actual_marker = w_marker & blog->blog_mask;
+        //edge i of the log is at ELOG_HEADER_SIZE + i*sizeof(edgeT_t<T>)
+        index_t offset = ELOG_HEADER_SIZE + w_tail*sizeof(edgeT_t<T>);
+        
+        if (actual_tail < actual_marker) {
+            //write and update tail
+            pwrite_all(wtf, blog->blog_beg + actual_tail, sizeof(edgeT_t<T>)*w_count, offset);
+        }
+        else {
+            index_t size = sizeof(edgeT_t<T>)*(blog->blog_count - actual_tail);
+            pwrite_all(wtf, blog->blog_beg + actual_tail, size, offset);
+            pwrite_all(wtf, blog->blog_beg, sizeof(edgeT_t<T>)*actual_marker, offset + size);
+        }
+        blog->blog_wtail = w_marker;
 
-    index_t actual_tail = w_tail & blog->blog_mask;
-    index_t actual_marker = w_marker & blog->blog_mask;
+        //Write the string weights if any
+        this->mem.handle_write();
+    }
     
-    if (actual_tail < actual_marker) {
-        //write and update tail
-        //fwrite(blog->blog_beg + w_tail, sizeof(edgeT_t<T>), w_count, wtf);
-        write(wtf, blog->blog_beg + actual_tail, sizeof(edgeT_t<T>)*w_count);
+    //Without fdatasync the header still records the written edges, so that
+    //replay_edgelog() gets them back after a clean exit.
+    if (0 == W_SYNC) {
+        if (w_count == 0) return eNoWork;
+        elog_header.durable_count = w_marker;
+        pwrite_all(wtf, &elog_header, sizeof(elog_header_t), 0);
+        return eOK;
     }
-    else {
-        write(wtf, blog->blog_beg + actual_tail, sizeof(edgeT_t<T>)*(blog->blog_count - actual_tail));
-        write(wtf, blog->blog_beg, sizeof(edgeT_t<T>)*actual_marker);
+    //Batch the fdatasync: every W_SYNC edges, or when the log goes idle, or
+    //once the snap thread archived a new epoch.
+    if (w_durable == w_marker) {
+        return (w_count == 0) ? eNoWork : eOK;
     }
-    blog->blog_wtail = w_marker;
+    if (W_SYNC == W_SYNC_EPOCH) {
+        snapshot_t* snapshot = this->snapshot;
+        if (snapshot && snapshot->snap_id != elog_header.epoch 
+            && snapshot->marker <= w_marker) {
+            elog_header.epoch = snapshot->snap_id;
+            elog_header.epoch_marker = snapshot->marker;
+            sync_edgelog(w_marker);
+        }
+    } else if (w_count == 0 || w_marker - w_durable >= W_SYNC) {
+        sync_edgelog(w_marker);
+    }
+    return eOK;
+}
 
-    //Write the string weights if any
-    this->mem.handle_write();
+//Make the edge log durable up to w_marker, then record it in the header.
+//The edges are synced before the header claims them, and the header before
+//w_durable reports them durable.
+template <class T>
+void pgraph_t<T>::sync_edgelog(index_t w_marker)
+{
+    sync_all(wtf);
+    this->mem.handle_sync();
+    elog_header.durable_count = w_marker;
+    pwrite_all(wtf, &elog_header, sizeof(elog_header_t), 0);
+    sync_all(wtf);
+    w_durable = w_marker;
+}
+
+//Bring the edges of the edge log that are not in the adjacency store read back
+//by read_vtable() to the graph. The log tail is read in parallel into the edge
+//log buffer and archived one buffer at a time. Only the synced edges are
+//replayed: past durable_count the file may hold zero-filled or torn slots,
+//those edges are lost as by a power failure and get overwritten. Without
+//fdatasync (W_SYNC 0) the header may reach the disk before the edges it
+//counts, then only the edges the file holds are replayed.
+template <class T>
+index_t pgraph_t<T>::replay_edgelog()
+{
+    off_t size = fsize(wtf);
+    if (size < ELOG_HEADER_SIZE) return 0;
     
-    //fsync();
-    return eOK;
+    index_t start = blog->blog_head;
+    index_t marker = start;
+    index_t end = (size - ELOG_HEADER_SIZE)/sizeof(edgeT_t<T>);
+    if (end < elog_header.durable_count) {
+        cout << "Edge log is shorter than its synced count " 
+             << elog_header.durable_count << ", replaying " << end << endl;
+    } else {
+        end = elog_header.durable_count;
+    }
+    if (end <= marker) {
+        blog->blog_wtail = marker;
+        w_durable = marker;
+        return 0;
+    }
+    
+    index_t unit = (1L << 16);
+    while (marker < end) {
+        index_t count = std::min(end - marker, blog->blog_count);
+        
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(THD_COUNT)
+        for (index_t i = 0; i < count; i += unit) {
+            index_t n = std::min(unit, count - i);
+            index_t offset = ELOG_HEADER_SIZE + (marker + i)*sizeof(edgeT_t<T>);
+            index_t actual = (marker + i) & blog->blog_mask;
+            index_t n1 = std::min(n, blog->blog_count - actual);
+            pread_all(wtf, blog->blog_beg + actual, n1*sizeof(edgeT_t<T>), offset);
+            if (n1 < n) {
+                offset += n1*sizeof(edgeT_t<T>);
+                pread_all(wtf, blog->blog_beg, (n - n1)*sizeof(edgeT_t<T>), offset);
+            }
+        }
+        marker += count;
+        blog->blog_head = marker;
+        blog->blog_wtail = marker;
+        create_marker(marker);
+        this->create_snapshot();
+    }
+    w_durable = end;
+    return end - start;
 }
     
 template <class T>
@@ -445,6 +574,28 @@ void pgraph_t<T>::file_open_edge(const string& dir, bool trunc)
     } else {
         wtf = open(wtfile.c_str(), O_RDWR|O_CREAT, S_IRWXU);
     }
+    if (wtf == -1) {
+        perror("edge log open issue");
+        assert(0);
+    }
+    
+    if (fsize(wtf) < ELOG_HEADER_SIZE) {
+        //new log, the header block goes first
+        char block[ELOG_HEADER_SIZE];
+        memset(block, 0, ELOG_HEADER_SIZE);
+        memset(&elog_header, 0, sizeof(elog_header));
+        elog_header.magic = ELOG_MAGIC;
+        elog_header.edge_size = sizeof(edgeT_t<T>);
+        memcpy(block, &elog_header, sizeof(elog_header));
+        pwrite_all(wtf, block, ELOG_HEADER_SIZE, 0);
+    } else {
+        pread_all(wtf, &elog_header, sizeof(elog_header), 0);
+        if (elog_header.magic != ELOG_MAGIC 
+            || elog_header.edge_size != sizeof(edgeT_t<T>)) {
+            cout << "Not an edge log of this graph: " << wtfile << endl;
+            assert(0);
+        }
+    }
     
     string etfile = filename + ".str";
     this->mem.file_open(etfile.c_str(), trunc);
@@ -673,10 +824,9 @@ edgeT_t<T>* pgraph_t<T>::get_prior_edges(index_t start_offset, index_t end_offse
 {
     assert(wtf != -1);
     index_t size = (end_offset - start_offset)*sizeof(edgeT_t<T>);
-    index_t offset = start_offset*sizeof(edgeT_t<T>);
+    index_t offset = ELOG_HEADER_SIZE + start_offset*sizeof(edgeT_t<T>);
     edgeT_t<T>* edges = (edgeT_t<T>*)malloc(size);
-    index_t sz_read = pread(wtf, edges, size, offset);
-    assert(size == sz_read);
+    pread_all(wtf, edges, size, offset);
     return edges;
 }
 
@@ -686,7 +836,7 @@ void pgraph_t<T>::create_degree(degree_t* degree_out, degree_t* degree_in, index
     assert(wtf != -1);
     
     index_t size = (end_offset - start_offset)*sizeof(edgeT_t<T>);
-    index_t offset = start_offset*sizeof(edgeT_t<T>);
+    index_t offset = ELOG_HEADER_SIZE + start_offset*sizeof(edgeT_t<T>);
     index_t  total_read = 0;
     index_t  sz_read= 0; 
     index_t  count = 0;
@@ -966,6 +1116,7 @@ void dgraph<T>::read_graph_baseline()
     this->mem.handle_read();
     this->read_snapshot();
     blog->readfrom_snapshot(this->snapshot);
+    this->replay_edgelog();
 }
 
 /*******************************************/
@@ -1039,6 +1190,7 @@ void ugraph<T>::read_graph_baseline()
     this->mem.handle_read();
     this->read_snapshot();
     blog->readfrom_snapshot(this->snapshot);
+    this->replay_edgelog();
 }
 
 /***********/
@@ -1107,6 +1259,7 @@ void unigraph<T>::read_graph_baseline()
     this->mem.handle_read();
     this->read_snapshot();
     blog->readfrom_snapshot(this->snapshot);
+    this->replay_edgelog();
 }
 
 
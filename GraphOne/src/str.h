@@ -65,12 +65,15 @@ public:
         if(log_head > 1) {
             index_t wpos = log_wpos;
             log_wpos = log_head;
-            write(etf, log_beg+wpos, log_wpos-wpos);
+            write_all(etf, log_beg+wpos, log_wpos-wpos);
             //fwrite(log_beg+wpos, sizeof(char), log_head-wpos, etf);
             return eOK;
         }
         return eNoWork;
     }
+    inline void handle_sync() {
+        if (log_wpos > 1) sync_all(etf);
+    }
     inline char* alloc_str(index_t size, index_t& offset) {
         char* ptr = log_beg + log_head;
         offset = log_head;
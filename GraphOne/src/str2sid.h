@@ -1,118 +1,284 @@
 #pragma once
 
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+typedef std::string_view strview_t;
+#else
+#include <experimental/string_view>
+typedef std::experimental::string_view strview_t;
+#endif
+
 #include "type.h"
 
-#ifdef TBB
-#define TBB_PREVIEW_LOCAL_OBSERVER 1
-#define TBB_PREVIEW_TASK_ARENA 1
+//String to sid dictionary of the vertex names. The keys are spread over
+//STR2SID_SHARDS shards by the top bits of their hash, each shard is an open
+//addressing table (linear probing) of {key, hash, sid} slots whose key bytes
+//live in an arena of the shard.
+//find() takes no lock: a slot is published by its key pointer, written last,
+//and a grown table replaces the old one, which stays alive until clear().
+//insert(), update(), erase() and the growth take the spinlock of the shard.
+//erase() keeps the slot and its key, only the sid becomes INVALID_SID.
 
-#include "tbb/concurrent_hash_map.h"
-#include "tbb/blocked_range.h"
-#include "tbb/parallel_for.h"
-#include <string>
+#define STR2SID_SHARDS 64
+#define STR2SID_SHARD_BITS 6
+#define STR2SID_CHUNK (1 << 20)
+
+//wyhash style mixing: 8 bytes at a time, folded by a 64x64->128 multiply
+inline uint64_t str_mix(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a*b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
 
-using namespace tbb;
-struct MyHashCompare {
-    static size_t hash( const string& x ) {
-        size_t h = 0;
-        for( const char* s = x.c_str(); *s; ++s )
-            h = (h*17)^*s;
-        return h;
+inline uint64_t str_read64(const char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint64_t str_read32(const char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+inline uint64_t str_hash(const char* s, size_t len)
+{
+    const uint64_t p0 = 0xa0761d6478bd642full;
+    const uint64_t p1 = 0xe7037ed1a0b428dbull;
+    const uint64_t p2 = 0x8ebc6af09c88c6e3ull;
+    uint64_t seed = p0;
+    uint64_t a = 0, b = 0;
+    size_t i = len;
+
+    while (i > 16) {
+        seed = str_mix(str_read64(s) ^ p1, str_read64(s + 8) ^ seed);
+        s += 16;
+        i -= 16;
     }
-    //! True if strings are equal
-    static bool equal( const string& x, const string& y ) {
-        return x==y;
+    if (i >= 8) {
+        a = str_read64(s);
+        b = str_read64(s + i - 8);
+    } else if (i >= 4) {
+        a = str_read32(s);
+        b = str_read32(s + i - 4);
+    } else if (i > 0) {
+        const unsigned char* u = (const unsigned char*)s;
+        a = ((uint64_t)u[0] << 16) | ((uint64_t)u[i >> 1] << 8) | u[i - 1];
     }
+    return str_mix(p2 ^ len, str_mix(a ^ p1, b ^ seed));
+}
+
+inline uint64_t str_hash(strview_t key) { return str_hash(key.data(), key.size()); }
+
+struct str2sid_slot_t {
+    std::atomic<const char*> key;//0: empty
+    uint64_t    hash;
+    std::atomic<sid_t>   sid;
+    uint32_t    len;
 };
-// A concurrent hash table that maps strings to ints.
-typedef concurrent_hash_map<string, sid_t, MyHashCompare> safemap_t;
 
-class str2intmap{
-    public:
-        safemap_t safe_map;
+struct str2sid_table_t {
+    uint64_t        mask;
+    str2sid_slot_t  slots[1];
+};
 
-        inline str2intmap(){}
+class str2intmap {
+    struct shard_t {
+        std::atomic<str2sid_table_t*> table;
+        std::atomic<int>    lock;
+        index_t             used;//slots, the erased ones too
+        index_t             live;
+        char*               arena;
+        index_t             arena_left;
+        std::vector<void*>  retired;//old tables and arena chunks
+    };
+    shard_t shards[STR2SID_SHARDS];
 
-        inline void insert(std::string rnd_string, sid_t rnd_index) {
-            safemap_t::accessor a;
-            safe_map.insert(a, rnd_string);
-            a->second = rnd_index;
+    static str2sid_table_t* new_table(index_t capacity) {
+        str2sid_table_t* table = (str2sid_table_t*)calloc(1,
+                    sizeof(str2sid_table_t) + (capacity - 1)*sizeof(str2sid_slot_t));
+        if (0 == table) {
+            perror("str2sid table");
+            assert(0);
         }
+        table->mask = capacity - 1;
+        return table;
+    }
 
-        inline void erase(std::string rnd_string) {
-            //size_t erased_elements = 
-            safe_map.erase(rnd_string);
+    static inline shard_t* lock_shard(shard_t* shard) {
+        int expected = 0;
+        while (!shard->lock.compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+            expected = 0;
         }
+        return shard;
+    }
+    static inline void unlock_shard(shard_t* shard) {
+        shard->lock.store(0, std::memory_order_release);
+    }
+
+    inline shard_t* get_shard(uint64_t hash) {
+        return shards + (hash >> (64 - STR2SID_SHARD_BITS));
+    }
 
-        inline void update(std::string rnd_string, sid_t rnd_index) {
+    static inline bool is_key(str2sid_slot_t* slot, const char* key, uint64_t hash, strview_t name) {
+        return slot->hash == hash && slot->len == name.size()
+               && 0 == memcmp(key, name.data(), name.size());
+    }
+
+    //Slot of the key, or the empty one where it goes
+    static str2sid_slot_t* probe(str2sid_table_t* table, strview_t name, uint64_t hash) {
+        index_t i = hash & table->mask;
+        str2sid_slot_t* slot = table->slots + i;
+        const char* key = slot->key.load(std::memory_order_acquire);
+        while (key && !is_key(slot, key, hash, name)) {
+            i = (i + 1) & table->mask;
+            slot = table->slots + i;
+            key = slot->key.load(std::memory_order_acquire);
         }
+        return slot;
+    }
 
-        inline sid_t find(std::string rnd_string)
-        {
-            safemap_t::const_accessor a;
-            if(safe_map.find(a, rnd_string)) {
-                return a->second;
+    //Copy of the key bytes, '\0' terminated
+    char* alloc_key(shard_t* shard, strview_t name) {
+        index_t size = name.size() + 1;
+        if (size > shard->arena_left) {
+            index_t chunk = std::max((index_t)STR2SID_CHUNK, size);
+            shard->arena = (char*)malloc(chunk);
+            if (0 == shard->arena) {
+                perror("str2sid arena");
+                assert(0);
             }
-            return INVALID_SID;
+            shard->retired.push_back(shard->arena);
+            shard->arena_left = chunk;
         }
+        char* key = shard->arena;
+        memcpy(key, name.data(), name.size());
+        key[name.size()] = '\0';
+        shard->arena += size;
+        shard->arena_left -= size;
+        return key;
+    }
 
+    //Doubles the table of a locked shard
+    void grow(shard_t* shard) {
+        str2sid_table_t* table = shard->table.load(std::memory_order_relaxed);
+        str2sid_table_t* new_tab = new_table(2*(table->mask + 1));
+        for (index_t i = 0; i <= table->mask; ++i) {
+            str2sid_slot_t* slot = table->slots + i;
+            const char* key = slot->key.load(std::memory_order_relaxed);
+            if (0 == key) continue;
+            index_t j = slot->hash & new_tab->mask;
+            while (new_tab->slots[j].key.load(std::memory_order_relaxed)) {
+                j = (j + 1) & new_tab->mask;
+            }
+            new_tab->slots[j].hash = slot->hash;
+            new_tab->slots[j].len = slot->len;
+            new_tab->slots[j].sid.store(slot->sid.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            new_tab->slots[j].key.store(key, std::memory_order_relaxed);
+        }
+        shard->table.store(new_tab, std::memory_order_release);
+        shard->retired.push_back(table);
+    }
 
-        // Capacity functions
-        inline size_t size(){ return safe_map.size(); }
-        inline bool empty(){ return safe_map.empty(); }
-        inline size_t max_size(){ return safe_map.max_size(); }
-        inline void clear(){ safe_map.clear(); }
-};
-
-#else
-
-#include "bib/multithreaded_container.h"
+    void init_shards() {
+        for (int s = 0; s < STR2SID_SHARDS; ++s) {
+            shards[s].table = new_table(1024);
+            shards[s].lock = 0;
+            shards[s].used = 0;
+            shards[s].live = 0;
+            shards[s].arena = 0;
+            shards[s].arena_left = 0;
+        }
+    }
+    void free_shards() {
+        for (int s = 0; s < STR2SID_SHARDS; ++s) {
+            free(shards[s].table.load());
+            for (size_t i = 0; i < shards[s].retired.size(); ++i) {
+                free(shards[s].retired[i]);
+            }
+            shards[s].retired.clear();
+        }
+    }
 
-class str2intmap{
     public:
-        sf::contfree_safe_ptr< std::map<std::string, sid_t> > safe_map;
-
-        inline str2intmap(){}
+        inline str2intmap() { init_shards(); }
+        inline ~str2intmap() { free_shards(); }
 
-        void emplace(std::string rnd_string, sid_t rnd_index){
-            safe_map->emplace(rnd_string, rnd_index);
+        //Inserts or overwrites, returns the stored copy of the key
+        const char* insert(strview_t name, sid_t sid) {
+            uint64_t hash = str_hash(name);
+            shard_t* shard = lock_shard(get_shard(hash));
+            str2sid_table_t* table = shard->table.load(std::memory_order_relaxed);
+            str2sid_slot_t* slot = probe(table, name, hash);
+            const char* key = slot->key.load(std::memory_order_relaxed);
+            if (key) {
+                if (INVALID_SID == slot->sid.load(std::memory_order_relaxed)) ++shard->live;
+                slot->sid.store(sid, std::memory_order_relaxed);
+            } else {
+                key = alloc_key(shard, name);
+                slot->hash = hash;
+                slot->len = name.size();
+                slot->sid.store(sid, std::memory_order_relaxed);
+                slot->key.store(key, std::memory_order_release);
+                ++shard->live;
+                if (4*(++shard->used) >= 3*(table->mask + 1)) grow(shard);
+            }
+            unlock_shard(shard);
+            return key;
         }
 
-        inline void insert(std::string rnd_string, sid_t rnd_index){
-            safe_map->emplace(rnd_string, rnd_index);
+        inline void erase(strview_t name) {
+            update(name, INVALID_SID);
         }
 
-        inline void erase(std::string rnd_string){
-            //size_t erased_elements = 
-            safe_map->erase(rnd_string);
+        //Changes the sid of an existing key
+        void update(strview_t name, sid_t sid) {
+            uint64_t hash = str_hash(name);
+            shard_t* shard = lock_shard(get_shard(hash));
+            str2sid_slot_t* slot = probe(shard->table.load(std::memory_order_relaxed), name, hash);
+            if (slot->key.load(std::memory_order_relaxed)) {
+                sid_t old_sid = slot->sid.load(std::memory_order_relaxed);
+                shard->live += (INVALID_SID != sid) - (INVALID_SID != old_sid);
+                slot->sid.store(sid, std::memory_order_relaxed);
+            }
+            unlock_shard(shard);
         }
 
-        inline void update(std::string rnd_string, sid_t rnd_index){
-            auto x_safe_map = xlock_safe_ptr(safe_map);
-            auto it = x_safe_map->find(rnd_string);
-            if (it != x_safe_map->cend()){
-                it->second += rnd_index;
-            }
+        inline sid_t find(strview_t name, uint64_t hash) {
+            str2sid_table_t* table = get_shard(hash)->table.load(std::memory_order_acquire);
+            str2sid_slot_t* slot = probe(table, name, hash);
+            if (0 == slot->key.load(std::memory_order_relaxed)) return INVALID_SID;
+            return slot->sid.load(std::memory_order_relaxed);
         }
 
-        inline sid_t find(std::string rnd_string)
-        {
-            //std::string key = std::to_string(rnd_string);
-            auto s_safe_map = slock_safe_ptr(safe_map);
-            auto it = s_safe_map->find(rnd_string);
-            if(it != s_safe_map->cend()){
-                volatile sid_t sid = it->second;
-                return sid;
+        inline sid_t find(strview_t name) { return find(name, str_hash(name)); }
+
+        //Batched find, in parallel. The hashes of a group are computed and
+        //their home slots prefetched before the probes.
+        void find(const strview_t* names, index_t count, sid_t* sids) {
+            #pragma omp parallel for schedule(static, 1024)
+            for (index_t i = 0; i < count; i += 8) {
+                uint64_t hash[8];
+                index_t group = std::min((index_t)8, count - i);
+                for (index_t j = 0; j < group; ++j) {
+                    hash[j] = str_hash(names[i + j]);
+                    str2sid_table_t* table = get_shard(hash[j])->table.load(std::memory_order_acquire);
+                    __builtin_prefetch(table->slots + (hash[j] & table->mask));
+                }
+                for (index_t j = 0; j < group; ++j) {
+                    sids[i + j] = find(names[i + j], hash[j]);
+                }
             }
-            return INVALID_SID;
         }
 
-
         // Capacity functions
-        inline size_t size(){ return safe_map->size(); }
-        inline bool empty(){ return safe_map->empty(); }
-        inline size_t max_size(){ return safe_map->max_size(); }
-        inline void clear(){ safe_map->clear(); }
+        inline size_t size() {
+            size_t count = 0;
+            for (int s = 0; s < STR2SID_SHARDS; ++s) count += shards[s].live;
+            return count;
+        }
+        inline bool empty() { return 0 == size(); }
+        inline size_t max_size() { return (size_t)INVALID_SID; }
+        //Not safe against concurrent finds
+        inline void clear() { free_shards(); init_shards(); }
 };
-
-#endif
@@ -129,11 +129,14 @@ extern index_t  DELTA_SIZE;
 extern index_t  SNAP_COUNT;
 
 extern index_t  W_SIZE;//Durable edge log offset
+extern index_t  W_SYNC;//fdatasync the edge log every W_SYNC edges, 0: never
 extern index_t  DVT_SIZE;
 extern index_t  DURABLE_SIZE;//
 
 extern index_t  OFF_COUNT;
 extern int      THD_COUNT;
+extern int      NUMA_COUNT;//NUMA nodes to partition the vertices over, <= 1: oblivious
+extern int      ADJ_COMPRESS;//compress() encodes the adjacency lists, see adj_codec.h
 extern index_t  LOCAL_VUNIT_COUNT;
 extern index_t  LOCAL_DELTA_SIZE;
 
@@ -143,6 +146,12 @@ void* alloc_buf();
 off_t fsize(const string& fname);
 off_t fsize(int fd);
 
+//Checked IO for the durable files, retry partial transfers and die on errors.
+void write_all(int fd, const void* buf, index_t size);
+void pwrite_all(int fd, const void* buf, index_t size, index_t offset);
+void pread_all(int fd, void* buf, index_t size, index_t offset);
+void sync_all(int fd);
+
 enum direction_t {
     eout = 0, 
     ein
@@ -398,6 +407,25 @@ class disk_snapshot_t {
     index_t  durable_marker;
 };
 
+//W_SYNC value to fdatasync the edge log once per archive epoch (snapshot)
+#define W_SYNC_EPOCH ((index_t)-1)
+
+//Header block of the durable edge log (.elog), edges start at ELOG_HEADER_SIZE.
+//durable_count is updated after each fdatasync of the edges, so it is a lower
+//bound of what survives a power failure, and replay stops there. With W_SYNC 0
+//it counts the written edges instead.
+#define ELOG_MAGIC 0x474f4c45454e4f47UL
+#define ELOG_HEADER_SIZE 4096
+
+class elog_header_t {
+ public:
+    uint64_t magic;
+    uint32_t edge_size;
+    snapid_t epoch;         //last archive epoch synced with the log
+    index_t  epoch_marker;  //edge log position of that epoch
+    index_t  durable_count; //edges synced to the disk
+};
+
 
 class pedge_t {
  public:
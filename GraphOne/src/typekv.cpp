@@ -1,7 +1,7 @@
 #include "graph.h"
 #include "typekv.h"
 
-sid_t typekv_t::type_update(const string& src, const string& dst)
+sid_t typekv_t::type_update(strview_t src, const string& dst)
 {
     sid_t       src_id = 0;
     sid_t       super_id = 0;
@@ -14,7 +14,7 @@ sid_t typekv_t::type_update(const string& src, const string& dst)
     //    src_id = str2vid_iter->second;
         
     sid_t str2vid_iter = str2vid.find(src);
-    if (UINT64_MAX != str2vid_iter) {
+    if (INVALID_SID != str2vid_iter) {
         src_id = str2vid_iter;
         /*
         //dublicate entry 
@@ -55,19 +55,19 @@ sid_t typekv_t::type_update(const string& src, const string& dst)
 
         src_id = super_id++;
         t_info[type_id].vert_id = super_id;
-		str2vid.insert(src, src_id);
+		const char* key = str2vid.insert(src, src_id);
         // str2vid[src] = src_id;
 
         vid     = TO_VID(super_id); 
         assert(vid < t_info[type_id].max_vcount);
-        t_info[type_id].strkv.set_value(vid, src.c_str());
+        t_info[type_id].strkv.set_value(vid, key);
     }
 
 
     return src_id;
 }
 
-sid_t typekv_t::type_update(const string& src, tid_t type_id)
+sid_t typekv_t::type_update(strview_t src, tid_t type_id)
 {
     sid_t       src_id = 0;
     sid_t       super_id = 0;
@@ -107,12 +107,12 @@ sid_t typekv_t::type_update(const string& src, tid_t type_id)
     if (INVALID_SID == str2vid_iter) {
         src_id = super_id++;
         t_info[type_id].vert_id = super_id;
-        str2vid.insert(src, src_id);
+        const char* key = str2vid.insert(src, src_id);
 
         vid     = TO_VID(src_id); 
         assert(vid < t_info[type_id].max_vcount);
         
-        t_info[type_id].strkv.set_value(vid, src.c_str());
+        t_info[type_id].strkv.set_value(vid, key);
     } else {
         //dublicate entry 
         //If type mismatch, delete original //XXX
@@ -128,6 +128,18 @@ sid_t typekv_t::type_update(const string& src, tid_t type_id)
     return src_id;
 }
 
+//The known names are looked up in parallel, then the new ones get their ids
+//in the order of the batch, a name repeated in the batch gets one id.
+void typekv_t::type_update(const strview_t* src, index_t count, tid_t type_id, sid_t* sids)
+{
+    str2vid.find(src, count, sids);
+    for (index_t i = 0; i < count; ++i) {
+        if (INVALID_SID == sids[i]) {
+            sids[i] = type_update(src[i], type_id);
+        }
+    }
+}
+
 status_t typekv_t::filter(sid_t src, univ_t a_value, filter_fn_t fn)
 {
     //value is already encoded, so typecast it
@@ -68,12 +68,12 @@ class typekv_t : public cfinfo_t {
         return t_count;
     }
 
-    inline sid_t get_sid(const char* src) {
-        sid_t str2vid_iter = str2vid.find(src);
-        if (str2vid_iter == UINT64_MAX) {
-            return INVALID_SID;
-        }
-        return str2vid_iter;
+    inline sid_t get_sid(strview_t src) {
+        return str2vid.find(src);
+    }
+    //get_sid() of a batch of names, in parallel
+    inline void get_sids(const strview_t* src, index_t count, sid_t* sids) {
+        str2vid.find(src, count, sids);
     }
 
     /*
@@ -93,8 +93,9 @@ class typekv_t : public cfinfo_t {
         //return t_info[tid].log_beg + t_info[tid].vid2name[vid];
     }
     
-    sid_t type_update(const string& src, const string& dst);
-    sid_t type_update(const string& src, tid_t tid);
+    sid_t type_update(strview_t src, const string& dst);
+    sid_t type_update(strview_t src, tid_t tid);
+    void  type_update(const strview_t* src, index_t count, tid_t tid, sid_t* sids);
     
     void make_graph_baseline();
     virtual void store_graph_baseline(bool clean = false); 
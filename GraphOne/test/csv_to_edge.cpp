@@ -222,6 +222,8 @@ void csv_manager::prep_vlabel(const string& filename, string predicate, const st
 
 //XXX We are avoiding the edge properties for time being.
 //predicate here is the edge type
+#define CSV_BATCH 4096
+
 void csv_manager::prep_etable(const string& filename, const econf_t& e_conf, const string& odir)
 {
     prop_pair_t prop_pair;
@@ -239,6 +241,19 @@ void csv_manager::prep_etable(const string& filename, const econf_t& e_conf, con
     char* saveptr;
     char* token;
     vector<string> prop_token;
+    
+    //edges without property are resolved and logged by batches
+    vector<string> subjects(CSV_BATCH), objects(CSV_BATCH);
+    vector<strview_t> src_names(CSV_BATCH), dst_names(CSV_BATCH);
+    index_t batch_count = 0;
+    auto flush = [&]() {
+        for (index_t i = 0; i < batch_count; ++i) {
+            src_names[i] = subjects[i];
+            dst_names[i] = objects[i];
+        }
+        g->batch_update(src_names.data(), dst_names.data(), batch_count, predicate);
+        batch_count = 0;
+    };
     //propid_t pid = g->get_pid(predicate.c_str());
     //size_t prop_index;
 
@@ -267,18 +282,23 @@ void csv_manager::prep_etable(const string& filename, const econf_t& e_conf, con
         ++line_count;
         //First token is the subject id, which will be treated as name.
         token = strtok_r(line, delim.c_str(), &saveptr);
-        subject = e_conf.src_type + token;
+        subjects[batch_count] = e_conf.src_type;
+        subjects[batch_count] += token;
 
         //Second token is the object id, which will be treated as name.
         token = strtok_r(NULL, delim.c_str(), &saveptr);
-        object = e_conf.dst_type + token;
+        objects[batch_count] = e_conf.dst_type;
+        objects[batch_count] += token;
         
         //Third token could be the edge property, if present
         // Handling only one edge property now for ldbc
         if(NULL != (token = strtok_r(NULL, delim.c_str(), &saveptr))) {
+            subject.swap(subjects[batch_count]);
+            object.swap(objects[batch_count]);
+            flush();
             g->batch_update(subject, object, predicate, token);
-        } else {
-            g->batch_update(subject, object, predicate);
+        } else if (++batch_count == CSV_BATCH) {
+            flush();
         }
         
         /*
@@ -295,5 +315,6 @@ void csv_manager::prep_etable(const string& filename, const econf_t& e_conf, con
             }
         }*/
     }
+    flush();
     fclose(fp);
 }
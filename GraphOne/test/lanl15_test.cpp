@@ -90,198 +90,244 @@ void lanl15_setup()
     g->file_open(true);
 }
 
+#define LANL_BATCH 4096
+
+//A batch of lines of one LANL file: the names stay in the line buffers and
+//their ids come from one batched type_update() per column, then the edges go
+//to the log in the order of the file.
+template <class T>
+class lanl_batch_t {
+ public:
+    char        lines[LANL_BATCH][512];
+    edgeT_t<T>  edges[LANL_BATCH];
+    strview_t   names[4][LANL_BATCH];
+    sid_t       sids[4][LANL_BATCH];
+    index_t     count;
+
+    lanl_batch_t() : count(0) {}
+
+    inline char* get_line() { return lines[count]; }
+    inline edgeT_t<T>& get_edge() { return edges[count]; }
+    inline void set_name(int col, const char* token) { names[col][count] = token; }
+    
+    //Adds the current line, true once the batch is full
+    inline bool add() { return ++count == LANL_BATCH; }
+
+    //fill(edge, ids) sets the ends of an edge from the ids of its names
+    template <class F>
+    void flush(pgraph_t<T>* pgraph, const tid_t* tids, int col_count, F fill) {
+        sid_t ids[4];
+        for (int col = 0; col < col_count; ++col) {
+            g->type_update(names[col], count, tids[col], sids[col]);
+        }
+        for (index_t i = 0; i < count; ++i) {
+            for (int col = 0; col < col_count; ++col) ids[col] = sids[col][i];
+            fill(edges[i], ids);
+            pgraph->batch_edge(edges[i]);
+        }
+        count = 0;
+    }
+};
+
 void parse_redteam15_file(FILE* file, char* buf)
 {
     int line_count = 0;
-    char  sss[512];
-    char* line =  sss;
+    char* line = 0;
     char* token =0;
     const char* delim = ",\n"; 
     
     //FILE* file = fopen(filename.c_str(), "r");
     assert(file);
 
-    redteam15_edge_t edge;
     pgraph_t<redteam15_dst_t>* redteam15 = (pgraph_t<redteam15_dst_t>*)g->get_sgraph(5); 
-
-    while (fgets(sss, sizeof(sss), file)) {
-        line = sss;
+    lanl_batch_t<redteam15_dst_t>* batch = new lanl_batch_t<redteam15_dst_t>;
+    const tid_t tids[2] = {0, 1};//"user" are type id 0, "computer" are type id 1
+    auto fill = [](redteam15_edge_t& edge, sid_t* ids) {
+        edge.src_id = ids[0];
+        set_dst(edge, ids[1]);
+    };
+
+    while (fgets(batch->get_line(), 512, file)) {
+        line = batch->get_line();
         //timestamp
         token = strtok_r(line, delim, &line);
-        edge.dst_id.second.time = atoi(token);
+        batch->get_edge().dst_id.second.time = atoi(token);
 
-        //src and dst computer 
-        token = strtok_r(line, delim, &line);
-        edge.src_id = g->type_update(token, 0);//"user" are type id 0
-        token = strtok_r(line, delim, &line);
-        set_dst(edge, g->type_update(token, 1));//"computer" are type id 1
+        //src user and dst computer 
+        batch->set_name(0, strtok_r(line, delim, &line));
+        batch->set_name(1, strtok_r(line, delim, &line));
         
         //Some more fields are pending
-        redteam15->batch_edge(edge);
+        if (batch->add()) batch->flush(redteam15, tids, 2, fill);
         
         ++line_count;
         //if (line_count == 10000000) break;
     }
+    batch->flush(redteam15, tids, 2, fill);
+    delete batch;
     cout << "redteam=" << line_count << endl;
 }
 
 void parse_dns15_file(FILE* file, char* buf)
 {
     int line_count = 0;
-    char  sss[512];
-    char* line =  sss;
+    char* line = 0;
     char* token =0;
     const char* delim = ",\n"; 
     
     //FILE* file = fopen(filename.c_str(), "r");
     assert(file);
 
-    dns15_edge_t edge;
     pgraph_t<dns15_dst_t>* dns15 = (pgraph_t<dns15_dst_t>*)g->get_sgraph(4); 
-
-    while (fgets(sss, sizeof(sss), file)) {
-        line = sss;
+    lanl_batch_t<dns15_dst_t>* batch = new lanl_batch_t<dns15_dst_t>;
+    const tid_t tids[2] = {1, 1};//"computer" are type id 1
+    auto fill = [](dns15_edge_t& edge, sid_t* ids) {
+        edge.src_id = ids[0];
+        set_dst(edge, ids[1]);
+    };
+
+    while (fgets(batch->get_line(), 512, file)) {
+        line = batch->get_line();
         //timestamp
         token = strtok_r(line, delim, &line);
-        edge.dst_id.second.time = atoi(token);
+        batch->get_edge().dst_id.second.time = atoi(token);
 
         //src and dst computer 
-        token = strtok_r(line, delim, &line);
-        edge.src_id = g->type_update(token, 1);//"computer" are type id 1
-        token = strtok_r(line, delim, &line);
-        set_dst(edge, g->type_update(token, 1));//"computer" are type id 1
+        batch->set_name(0, strtok_r(line, delim, &line));
+        batch->set_name(1, strtok_r(line, delim, &line));
         
         //Some more fields are pending
-        dns15->batch_edge(edge);
+        if (batch->add()) batch->flush(dns15, tids, 2, fill);
         
         ++line_count;
         //if (line_count == 10000000) break;
     }
+    batch->flush(dns15, tids, 2, fill);
+    delete batch;
     cout << "dns=" << line_count << endl;
 }
 
 void parse_flow15_file(FILE* file, char* buf)
 {
     int line_count = 0;
-    char  sss[512];
-    char* line =  sss;
+    char* line = 0;
     char* token =0;
     const char* delim = ",\n"; 
     
     //FILE* file = fopen(filename.c_str(), "r");
     assert(file);
 
-    flow15_edge_t edge;
     pgraph_t<flow15_dst_t>* flow15 = (pgraph_t<flow15_dst_t>*)g->get_sgraph(3); 
-
-    while (fgets(sss, sizeof(sss), file)) {
-        line = sss;
+    lanl_batch_t<flow15_dst_t>* batch = new lanl_batch_t<flow15_dst_t>;
+    const tid_t tids[2] = {1, 1};//"computer" are type id 1
+    auto fill = [](flow15_edge_t& edge, sid_t* ids) {
+        edge.src_id = ids[0];
+        set_dst(edge, ids[1]);
+    };
+
+    while (fgets(batch->get_line(), 512, file)) {
+        line = batch->get_line();
         //timestamp
         token = strtok_r(line, delim, &line);
-        edge.dst_id.second.time = atoi(token);
+        batch->get_edge().dst_id.second.time = atoi(token);
 
         //src and dst computer 
-        token = strtok_r(line, delim, &line);
-        edge.src_id = g->type_update(token, 1);//"computer" are type id 1
-        token = strtok_r(line, delim, &line);
-        set_dst(edge, g->type_update(token, 1));//"computer" are type id 1
+        batch->set_name(0, strtok_r(line, delim, &line));
+        batch->set_name(1, strtok_r(line, delim, &line));
         
         //Some more fields are pending
-        flow15->batch_edge(edge);
+        if (batch->add()) batch->flush(flow15, tids, 2, fill);
         
         ++line_count;
         //if (line_count == 10000000) break;
     }
+    batch->flush(flow15, tids, 2, fill);
+    delete batch;
     cout << "flow=" << line_count << endl;
 }
 
 void parse_proc15_file(FILE* file, char* buf)
 {
     int line_count = 0;
-    char  sss[512];
-    char* line =  sss;
+    char* line = 0;
     char* token =0;
     const char* delim = ",\n"; 
 
-    proc15_edge_t edge;
     pgraph_t<proc15_dst_t>* proc15 = (pgraph_t<proc15_dst_t>*)g->get_sgraph(2); 
+    lanl_batch_t<proc15_dst_t>* batch = new lanl_batch_t<proc15_dst_t>;
+    const tid_t tids[2] = {0, 1};//"user" are type id 0, "computer" are type id 1
+    auto fill = [](proc15_edge_t& edge, sid_t* ids) {
+        edge.src_id = ids[0];
+        set_dst(edge, ids[1]);
+    };
 
     //FILE* file = fopen(filename.c_str(), "r");
     assert(file);
 
-    while (fgets(sss, sizeof(sss), file)) {
+    while (fgets(batch->get_line(), 512, file)) {
         //timestamp
-        line = sss;
+        line = batch->get_line();
         token = strtok_r(line, delim, &line);
-        edge.dst_id.second.time = atoi(token);
+        batch->get_edge().dst_id.second.time = atoi(token);
 
         //user and computer 
-        token = strtok_r(line, delim, &line);
-        edge.src_id = g->type_update(token, 0);//"user" are type id 0
-        token = strtok_r(line, delim, &line);
-        set_dst(edge, g->type_update(token, 1));//"computer" are type id 1
+        batch->set_name(0, strtok_r(line, delim, &line));
+        batch->set_name(1, strtok_r(line, delim, &line));
         
         //Some more fields are pending
-        proc15->batch_edge(edge);    
+        if (batch->add()) batch->flush(proc15, tids, 2, fill);
         
         ++line_count;
         //if (line_count == 10000000) break;
     }
+    batch->flush(proc15, tids, 2, fill);
+    delete batch;
     cout << "proc=" << line_count << endl;
 }
 
 void parse_auth15_file(FILE* file, char* buf1)
 {
     int line_count = 0;
-    char  sss[512];
-    char* line =  sss;
+    char* line = 0;
     char* token =0;
     const char* delim = ",\n"; 
     //FILE* file = fopen(filename.c_str(), "r");
     assert(file);
 
-    auth15_edge_t edge;
     pgraph_t<auth15_dst_t>* auth15 = (pgraph_t<auth15_dst_t>*)g->get_sgraph(1); 
-
-    /*
-    //first line is waste
-    char* buf = strchr(buf1, '\n');
-    if(!buf) return;
-
-    char* start = 0;
-    char* end = 0;
-    while (buf) {
-        start = buf + 1;
-        buf = strchr(buf+1, '\n');
-        end = buf;
-        memcpy(sss, start, end - start); 
-        sss[end-start] = '\0';
-    //}*/
-    fgets(sss, sizeof(sss), file);//first line is waste
-    while (fgets(sss, sizeof(sss), file)) {
+    lanl_batch_t<auth15_dst_t>* batch = new lanl_batch_t<auth15_dst_t>;
+    //src and dst "user" are type id 0, src and dst "computers" are type id 1
+    const tid_t tids[4] = {0, 0, 1, 1};
+    auto fill = [](auth15_edge_t& edge, sid_t* ids) {
+        edge.src_id = ids[0];
+        set_dst(edge, ids[1]);
+        edge.dst_id.second.src_computer = ids[2];
+        edge.dst_id.second.dst_computer = ids[3];
+    };
+
+    fgets(batch->get_line(), 512, file);//first line is waste
+    while (fgets(batch->get_line(), 512, file)) {
         //timestamp
-        line = sss;
+        line = batch->get_line();
         token = strtok_r(line, delim, &line);
-        edge.dst_id.second.time = atoi(token);
+        batch->get_edge().dst_id.second.time = atoi(token);
 
         //src user and dst user
-        token = strtok_r(line, delim, &line);
-        edge.src_id = g->type_update(token, 0);//"user" are type id 0
-        token = strtok_r(line, delim, &line);
-        set_dst(edge, g->type_update(token, 0));//"user" are type id 0
+        batch->set_name(0, strtok_r(line, delim, &line));
+        batch->set_name(1, strtok_r(line, delim, &line));
         
         //src computer and dst computer
-        token = strtok_r(line, delim, &line);
-        edge.dst_id.second.src_computer = g->type_update(token, 1);//"computers" are type id 1
-        token = strtok_r(line, delim, &line);
-        edge.dst_id.second.dst_computer = g->type_update(token, 1);//"computers" are type id 1
+        batch->set_name(2, strtok_r(line, delim, &line));
+        batch->set_name(3, strtok_r(line, delim, &line));
     
         //Some more fields are pending
-        auth15->batch_edge(edge);    
+        if (batch->add()) batch->flush(auth15, tids, 4, fill);
         
         ++line_count;
         //if (line_count == 10000000) break;
     }
+    batch->flush(auth15, tids, 4, fill);
+    delete batch;
     cout << "atuh=" << line_count << endl;
 }
 
@@ -526,7 +526,8 @@ void plaingraph_manager_t<T>::waitfor_archive_durable(double start)
             cout << "Make Graph Time = " << end - start << endl;
             done_making = true;
         }
-        if (blog->blog_wtail == blog->blog_head && !done_persisting) {
+        if (blog->blog_wtail == blog->blog_head && !done_persisting
+            && (0 == W_SYNC || pgraph->get_durable_marker() == blog->blog_head)) {
             end = mywtime();
             cout << "Durable Graph Time = " << end - start << endl;
             done_persisting = true;
@@ -4,6 +4,7 @@
 
 #include "stream_analytics.h"
 #include "sstream_analytics.h"
+#include "wsstream_analytics.h"
 
 using namespace std;
 
@@ -723,17 +724,46 @@ void prior_snap_test(const string& odir)
     return ;
 }
 
-//recover from durable adj list
+//recover from durable adj list, and the edge log after it
 template <class T>
 void recover_test(const string& odir)
 {
     plaingraph_manager_t<T> manager;
     manager.schema(_dir);
+    double start = mywtime();
     g->read_graph_baseline();
+    double end = mywtime();
+    pgraph_t<T>* pgraph = manager.get_plaingraph();
+    cout << EXPOUT "Recovered edges: " << pgraph->blog->blog_head << endl;
+    cout << EXPOUT "Recovery: " << end - start << endl;
     manager.run_bfs();
     return ;
 }
 
+//durable ingestion at the edge log sync interval of -y, needs -o
+template <class T>
+void test_durable_ingest(const string& idir, const string& odir)
+{
+    assert(_persist);
+    plaingraph_manager_t<T> manager;
+    manager.schema(_dir);
+    manager.setup_graph(_global_vcount);
+    
+    double start = mywtime();
+    manager.prep_graph2(idir, odir);
+    double end = mywtime();
+    
+    pgraph_t<T>* pgraph = manager.get_plaingraph();
+    if (W_SYNC == W_SYNC_EPOCH) {
+        cout << EXPOUT "Sync: per epoch" << endl;
+    } else {
+        cout << EXPOUT "Sync: " << W_SYNC << endl;
+    }
+    cout << EXPOUT "Durable edges: " << pgraph->get_durable_marker() << endl;
+    cout << EXPOUT "Durable ingest: " << end - start << endl;
+    manager.run_bfs();
+}
+
 //recover from durable edge log
 template <class T>
 void recover_test0(const string& idir, const string& odir)
@@ -1215,7 +1245,7 @@ void test_stream_wcc(const string& idir, const string& odir)
     pgraph_t<dst_id_t>* pgraph = manager.get_plaingraph();
     
     /*
-    stream_t<dst_id_t>* streamh = reg_stream_view(pgraph, stream_wcc, E_CENTRIC);
+    stream_t<dst_id_t>* streamh = reg_stream_view(pgraph, stream_wcc, STALE_MASK|E_CENTRIC);
     wcc_post_reg(streamh); 
     manager.prep_graph_and_compute(idir, odir, streamh); 
     print_wcc_summary(streamh);
@@ -1328,6 +1358,452 @@ void basic_benchmark(vid_t v_count1, const string& idir, const string& odir)
     cout << EXPOUT "RSS_BFS: " << rss_bfs << endl;
 }
 
+//Static view creation latency after every batch of (1 << residue) edges.
+//The views share the degree pages that the batch did not change.
+template <class T>
+void test_view_latency(const string& idir, const string& odir)
+{
+    plaingraph_manager_t<T> manager;
+    manager.schema(_dir);
+    manager.setup_graph(_global_vcount);
+
+    pgraph_t<T>* ugraph = (pgraph_t<T>*)manager.get_plaingraph();
+    blog_t<T>*     blog = ugraph->blog;
+
+    if (1 != _source) {//only binary files
+        cout << "this testcase expect binary input file(s)" << endl << std::flush;
+        assert(0);
+    }
+
+    free(blog->blog_beg);
+    blog->blog_beg = 0;
+    index_t total_size = alloc_mem_dir(idir, (char**)&blog->blog_beg, true);
+    index_t count = total_size/sizeof(edgeT_t<T>);
+    index_t new_count = upper_power_of_two(count);
+    blog->blog_mask = new_count -1;
+    blog->blog_count = count;
+
+    read_idir_text(idir, odir, ugraph, file_and_insert);
+
+    index_t marker = 0;
+    index_t batch_size = (1L << residue);
+    cout << "batch_size = " << batch_size << endl;
+
+    snap_t<T>* snaph = 0;
+    double first_view = 0;
+    double total_view = 0;
+    double max_view = 0;
+    index_t view_count = 0;
+
+    while (marker < blog->blog_head) {
+        marker = min(blog->blog_head, marker+batch_size);
+        ugraph->create_marker(marker);
+        ugraph->create_snapshot();
+
+        double start = mywtime();
+        snap_t<T>* new_snaph = create_static_view(ugraph, STALE_MASK|V_CENTRIC);
+        double end = mywtime();
+        if (snaph) delete_static_view(snaph);
+        snaph = new_snaph;
+
+        if (0 == view_count) {
+            first_view = end - start;
+        } else {
+            total_view += end - start;
+            max_view = max(max_view, end - start);
+        }
+        ++view_count;
+    }
+    if (snaph) delete_static_view(snaph);
+
+    cout << EXPOUT "Batch size: " << batch_size << endl;
+    cout << EXPOUT "Views: " << view_count << endl;
+    cout << EXPOUT "First view: " << first_view << "s" << endl;
+    if (view_count > 1) {
+        cout << EXPOUT "View avg: " << total_view/(view_count - 1) << "s" << endl;
+        cout << EXPOUT "View max: " << max_view << "s" << endl;
+    }
+}
+
+//WCC count of the window edges from scratch
+template <class T>
+vid_t window_wcc(edgeT_t<T>* edges, index_t count, vid_t v_count)
+{
+    vid_t* comp = (vid_t*)malloc(v_count*sizeof(vid_t));
+    for (vid_t v = 0; v < v_count; ++v) comp[v] = v;
+    vid_t wcc_count = v_count;
+    for (index_t i = 0; i < count; ++i) {
+        vid_t c1 = TO_VID(edges[i].src_id);
+        vid_t c2 = TO_VID(get_dst(edges + i));
+        while (comp[c1] != c1) c1 = comp[c1] = comp[comp[c1]];
+        while (comp[c2] != c2) c2 = comp[c2] = comp[comp[c2]];
+        if (c1 != c2) {
+            comp[max(c1, c2)] = min(c1, c2);
+            --wcc_count;
+        }
+    }
+    free(comp);
+    return wcc_count;
+}
+
+//pagerank of the window edges from scratch, same formula as ws_stream_pagerank.
+//Stops once the L1 error bound d*diff/(1 - d) is under epsilon.
+template <class T>
+void window_pagerank(edgeT_t<T>* edges, index_t count, vid_t v_count, bool undirected, 
+                     double* rank, double epsilon)
+{
+    degree_t* degree = (degree_t*)calloc(v_count, sizeof(degree_t));
+    double* next = (double*)malloc(v_count*sizeof(double));
+    for (index_t i = 0; i < count; ++i) {
+        ++degree[TO_VID(edges[i].src_id)];
+        if (undirected) ++degree[TO_VID(get_dst(edges + i))];
+    }
+    for (vid_t v = 0; v < v_count; ++v) rank[v] = (1 - WS_DAMP)/v_count;
+    
+    for (int iter = 0; iter < 200; ++iter) {
+        for (vid_t v = 0; v < v_count; ++v) next[v] = (1 - WS_DAMP)/v_count;
+        for (index_t i = 0; i < count; ++i) {
+            vid_t src = TO_VID(edges[i].src_id);
+            vid_t dst = TO_VID(get_dst(edges + i));
+            next[dst] += WS_DAMP*rank[src]/degree[src];
+            if (undirected) next[src] += WS_DAMP*rank[dst]/degree[dst];
+        }
+        double diff = 0;
+        for (vid_t v = 0; v < v_count; ++v) {
+            diff += fabs(next[v] - rank[v]);
+            rank[v] = next[v];
+        }
+        if (WS_DAMP*diff < epsilon*(1 - WS_DAMP)) break;
+    }
+    free(degree);
+    free(next);
+}
+
+//Sliding window WCC and pagerank from the deltas of each batch of 1<<residue
+//edges, checked against a recomputation over the window. -e: window size
+//in edges, default a quarter of the input.
+template <class T>
+void test_wsstream(const string& idir, const string& odir)
+{
+    plaingraph_manager_t<T> manager;
+    manager.schema(_dir);
+    manager.setup_graph(_global_vcount);
+
+    pgraph_t<T>* ugraph = (pgraph_t<T>*)manager.get_plaingraph();
+    blog_t<T>*     blog = ugraph->blog;
+
+    if (1 != _source) {//only binary files
+        cout << "this testcase expect binary input file(s)" << endl << std::flush;
+        assert(0);
+    }
+
+    free(blog->blog_beg);
+    blog->blog_beg = 0;
+    index_t total_size = alloc_mem_dir(idir, (char**)&blog->blog_beg, true);
+    index_t count = total_size/sizeof(edgeT_t<T>);
+    index_t new_count = upper_power_of_two(count);
+    blog->blog_mask = new_count -1;
+    blog->blog_count = count;
+
+    read_idir_text(idir, odir, ugraph, file_and_insert);
+
+    index_t batch_size = (1L << residue);
+    index_t window_sz = _edge_count ? _edge_count : (count >> 2);
+    
+    //one view per analytics, each keeps its algorithm data
+    wsstream_t<T>* wcch = reg_wsstream_view(ugraph, window_sz, ws_stream_wcc<T>, STALE_MASK|E_CENTRIC);
+    wsstream_t<T>* prh = reg_wsstream_view(ugraph, window_sz, ws_stream_pagerank<T>, STALE_MASK|E_CENTRIC);
+    ws_wcc_post_reg(wcch);
+    ws_pagerank_post_reg(prh);
+    wswcc_t* wcc = (wswcc_t*)wcch->get_algometa();
+    wspr_t*  pr  = (wspr_t*)prh->get_algometa();
+    vid_t v_count = wcch->get_vcount();
+    double* rank = (double*)malloc(v_count*sizeof(double));
+
+    index_t update_count = (count + batch_size - 1)/batch_size;
+    index_t check_every = max(update_count/8, (index_t)1);
+    double view_time = 0, wcc_time = 0, pr_time = 0;
+    double wcc_full = 0, pr_full = 0, max_l1 = 0;
+    index_t check_count = 0, mismatch = 0;
+    index_t marker = 0;
+    index_t updates = 0;
+    
+    while (marker < blog->blog_head) {
+        marker = min(blog->blog_head, marker + batch_size);
+        ugraph->create_marker(marker);
+        ugraph->create_snapshot();
+
+        double start = mywtime();
+        wcch->update_view();
+        prh->update_view();
+        double end = mywtime();
+        view_time += (end - start)/2;
+        
+        start = mywtime();
+        wcch->wsstream_func(wcch);
+        end = mywtime();
+        wcc_time += end - start;
+        
+        start = mywtime();
+        prh->wsstream_func(prh);
+        end = mywtime();
+        pr_time += end - start;
+        ++updates;
+
+        if (updates % check_every != 0 && marker != blog->blog_head) continue;
+        
+        //recompute over the window
+        edgeT_t<T>* edges = 0;
+        index_t edge_count = wcch->get_window_edges(edges);
+        start = mywtime();
+        vid_t wcc_count = window_wcc(edges, edge_count, v_count);
+        end = mywtime();
+        wcc_full += end - start;
+        
+        start = mywtime();
+        window_pagerank(edges, edge_count, v_count, prh->is_undirected(), rank, 1e-3);
+        end = mywtime();
+        pr_full += end - start;
+        
+        double l1 = 0;
+        for (vid_t v = 0; v < v_count; ++v) l1 += fabs(rank[v] - pr->rank[v]);
+        max_l1 = max(max_l1, l1);
+        if (wcc_count != wcc->wcc_count) {
+            cout << "WCC mismatch at " << marker << ": " << wcc->wcc_count 
+                 << " vs " << wcc_count << endl;
+            ++mismatch;
+        }
+        ++check_count;
+    }
+    
+    cout << EXPOUT "Window: " << window_sz << endl;
+    cout << EXPOUT "Batch size: " << batch_size << endl;
+    cout << EXPOUT "Updates: " << updates << endl;
+    cout << EXPOUT "View update avg: " << view_time/updates << "s" << endl;
+    cout << EXPOUT "WCC delta avg: " << wcc_time/updates << "s" << endl;
+    cout << EXPOUT "WCC recompute avg: " << wcc_full/check_count << "s" << endl;
+    cout << EXPOUT "PR delta avg: " << pr_time/updates << "s" << endl;
+    cout << EXPOUT "PR recompute avg: " << pr_full/check_count << "s" << endl;
+    cout << EXPOUT "WCC count: " << wcc->wcc_count << endl;
+    cout << EXPOUT "WCC mismatches: " << mismatch << "/" << check_count << endl;
+    cout << EXPOUT "PR max L1 diff: " << max_l1 << endl;
+    free(rank);
+}
+
+template <class T>
+index_t adjlist_size(pgraph_t<T>* pgraph)
+{
+    index_t size = pgraph->sgraph_out[0]->get_adjlist_size();
+    if (pgraph->sgraph_in && pgraph->sgraph_in != pgraph->sgraph_out) {
+        size += pgraph->sgraph_in[0]->get_adjlist_size();
+    }
+    return size;
+}
+
+//BFS levels from root, neighbor count and a hash of the neighbor lists that
+//depends on their order, and the BFS and pagerank times
+template <class T>
+void compress_probe(pgraph_t<T>* pgraph, sid_t root, uint16_t* level, 
+                    index_t& nebr_count, index_t& nebr_sum, double& bfs_time, double& pr_time)
+{
+    snap_t<T>* snaph = create_static_view(pgraph, STALE_MASK|V_CENTRIC);
+    vid_t v_count = snaph->get_vcount();
+    index_t count = 0;
+    index_t sum = 0;
+    
+    #pragma omp parallel for reduction(+:count,sum) num_threads(THD_COUNT)
+    for (vid_t v = 0; v < v_count; ++v) {
+        index_t hash = 0;
+        count += snaph->for_each_out(v, [&hash](sid_t sid) { hash = hash*31 + sid; });
+        if (pgraph->sgraph_in && pgraph->sgraph_in != pgraph->sgraph_out) {
+            count += snaph->for_each_in(v, [&hash](sid_t sid) { hash = hash*31 + sid; });
+        }
+        sum += hash;
+    }
+    nebr_count = count;
+    nebr_sum = sum;
+
+    memset(level, 0, v_count*sizeof(uint16_t));
+    double start = mywtime();
+    mem_bfs<T>(snaph, level, root);
+    bfs_time = mywtime() - start;
+    
+    start = mywtime();
+    mem_pagerank<T>(snaph, 10);
+    pr_time = mywtime() - start;
+    delete_static_view(snaph);
+}
+
+//Vertices of sgraph whose neighbors from get_wnebrs() or start()/next() at
+//an offset differ from the same range of get_nebrs()
+template <class T>
+vid_t compress_ranges(onegraph_t<T>* sgraph, vid_t v_count)
+{
+    vid_t mismatch = 0;
+    
+    #pragma omp parallel for reduction(+:mismatch) num_threads(THD_COUNT)
+    for (vid_t v = 0; v < v_count; ++v) {
+        sdegree_t sdegree = sgraph->get_degree(v);
+        degree_t degree = get_total(sdegree);
+        if (degree == 0) continue;
+        std::vector<T> nebrs(degree), window(degree);
+        sgraph->get_nebrs(v, nebrs.data(), sdegree);
+        degree_t start = degree/3;
+        degree_t count = degree - start - degree/3;
+        degree_t ret = sgraph->get_wnebrs(v, window.data(), start, count);
+        bool equal = (ret == count);
+        
+        header_t<T> header;
+        sgraph->start(v, header, start);
+        for (degree_t i = 0; i < count && equal; ++i) {
+            T dst;
+            sgraph->next(header, dst);
+            equal = get_sid(window[i]) == get_sid(nebrs[start + i])
+                 && get_sid(dst) == get_sid(nebrs[start + i]);
+        }
+        mismatch += !equal;
+    }
+    return mismatch;
+}
+
+//Bytes per stored edge and BFS/pagerank times before and after
+//compress_graph_baseline(): -z 1 stores the compressed blocks, -z 0 only
+//coalesces. BFS from -r, default 1.
+template <class T>
+void test_compress(const string& idir, const string& odir)
+{
+    plaingraph_manager_t<T> manager;
+    manager.schema(_dir);
+    manager.setup_graph(_global_vcount);
+    manager.prep_graph2(idir, odir);
+    pgraph_t<T>* pgraph = (pgraph_t<T>*)manager.get_plaingraph();
+    
+    sid_t root = residue ? residue : 1;
+    uint16_t* level = (uint16_t*)calloc(_global_vcount, sizeof(uint16_t));
+    uint16_t* level1 = (uint16_t*)calloc(_global_vcount, sizeof(uint16_t));
+    index_t nebr_count, nebr_count1, nebr_sum, nebr_sum1;
+    double bfs_time, bfs_time1, pr_time, pr_time1;
+
+    index_t size = adjlist_size(pgraph);
+    compress_probe(pgraph, root, level, nebr_count, nebr_sum, bfs_time, pr_time);
+    long rss = get_rss();
+    
+    double start = mywtime();
+    pgraph->compress_graph_baseline();
+    double compress_time = mywtime() - start;
+    
+    index_t size1 = adjlist_size(pgraph);
+    compress_probe(pgraph, root, level1, nebr_count1, nebr_sum1, bfs_time1, pr_time1);
+    long rss1 = get_rss();
+    
+    vid_t mismatch = 0;
+    for (vid_t v = 0; v < _global_vcount; ++v) {
+        mismatch += (level[v] != level1[v]);
+    }
+    vid_t range_mismatch = compress_ranges(pgraph->sgraph_out[0], _global_vcount);
+    if (pgraph->sgraph_in && pgraph->sgraph_in != pgraph->sgraph_out) {
+        range_mismatch += compress_ranges(pgraph->sgraph_in[0], _global_vcount);
+    }
+
+    cout << EXPOUT "Compress: " << ADJ_COMPRESS << endl;
+    cout << EXPOUT "Edges stored: " << nebr_count << endl;
+    cout << EXPOUT "Bytes/edge: " << (double)size/nebr_count << " -> " 
+         << (double)size1/nebr_count1 << endl;
+    cout << EXPOUT "RSS: " << rss << " -> " << rss1 << endl;
+    cout << EXPOUT "Compress time: " << compress_time << "s" << endl;
+    cout << EXPOUT "BFS: " << bfs_time << "s -> " << bfs_time1 << "s" << endl;
+    cout << EXPOUT "PR: " << pr_time << "s -> " << pr_time1 << "s" << endl;
+    cout << EXPOUT "Neighbors equal: " << (nebr_count == nebr_count1 && nebr_sum == nebr_sum1) << endl;
+    cout << EXPOUT "BFS level mismatches: " << mismatch << endl;
+    cout << EXPOUT "Range mismatches: " << range_mismatch << endl;
+    free(level);
+    free(level1);
+}
+
+//String keyed ingest of the edges of -i, a vertex has the names "U<id>" and
+//"C<id>" in two types. Compares the per name type_update()/get_sid() of the
+//loaders against the batched, parallel resolve, then ingests the edges by
+//batches of -e names (default 4096) through batch_update().
+template <class T>
+void test_str2sid(const string& idir, const string& odir)
+{
+    plaingraph_manager_t<T> manager;
+    manager.schema(_dir);
+    typekv_t* typekv = g->get_typekv();
+    tid_t tid0 = typekv->manual_setup(_global_vcount, false, "user");
+    tid_t tid1 = typekv->manual_setup(_global_vcount, false, "computer");
+    pgraph_t<T>* pgraph = (pgraph_t<T>*)manager.get_plaingraph();
+    pgraph->prep_graph_baseline();
+    g->create_threads(true, false);
+
+    edgeT_t<T>* edges = 0;
+    index_t count = read_idir(idir, &edges, true);
+    index_t batch_size = _edge_count ? _edge_count : 4096;
+
+    vector<string> names0(_global_vcount), names1(_global_vcount);
+    for (vid_t v = 0; v < _global_vcount; ++v) {
+        names0[v] = "U" + std::to_string(v);
+        names1[v] = "C" + std::to_string(v);
+    }
+    //src names, then dst names
+    vector<strview_t> ends0(2*count), ends1(2*count);
+    for (index_t i = 0; i < count; ++i) {
+        ends0[i] = names0[edges[i].src_id];
+        ends0[count + i] = names0[get_dst(edges + i)];
+        ends1[i] = names1[edges[i].src_id];
+        ends1[count + i] = names1[get_dst(edges + i)];
+    }
+    vector<sid_t> sids0(2*count), sids1(2*count);
+
+    //new names, one at a time as the loaders did, and batched
+    double start = mywtime();
+    for (index_t i = 0; i < 2*count; ++i) {
+        sids0[i] = g->type_update(ends0[i], tid0);
+    }
+    double create_time = mywtime() - start;
+    
+    start = mywtime();
+    for (index_t i = 0; i < 2*count; i += batch_size) {
+        g->type_update(ends1.data() + i, min(batch_size, 2*count - i), tid1, sids1.data() + i);
+    }
+    double create_time1 = mywtime() - start;
+
+    //known names
+    start = mywtime();
+    for (index_t i = 0; i < 2*count; ++i) {
+        sids1[i] = g->get_sid(ends1[i]);
+    }
+    double find_time = mywtime() - start;
+    
+    start = mywtime();
+    for (index_t i = 0; i < 2*count; i += batch_size) {
+        g->get_sids(ends1.data() + i, min(batch_size, 2*count - i), sids1.data() + i);
+    }
+    double find_time1 = mywtime() - start;
+
+    index_t mismatch = 0;
+    for (index_t i = 0; i < 2*count; ++i) {
+        mismatch += (TO_TID(sids1[i]) != tid1) 
+                 || (ends1[i] != typekv->get_vertex_name(sids1[i]));
+        mismatch += (ends0[i] != typekv->get_vertex_name(sids0[i]));
+    }
+    
+    start = mywtime();
+    for (index_t i = 0; i < count; i += batch_size) {
+        pgraph->batch_update(ends0.data() + i, ends0.data() + count + i, min(batch_size, count - i));
+    }
+    double ingest_time = mywtime() - start;
+    g->waitfor_archive();
+    double archive_time = mywtime() - start;
+
+    cout << EXPOUT "Names: " << 2*count << ", vertices: " << typekv->get_type_vcount(tid0) 
+         << " " << typekv->get_type_vcount(tid1) << endl;
+    cout << EXPOUT "Create: " << create_time << "s -> " << create_time1 << "s" << endl;
+    cout << EXPOUT "Find: " << find_time << "s -> " << find_time1 << "s" << endl;
+    cout << EXPOUT "Ingest: " << ingest_time << "s, archived " << archive_time << "s" << endl;
+    cout << EXPOUT "Edges logged: " << pgraph->blog->blog_head << endl;
+    cout << EXPOUT "Id mismatches: " << mismatch << endl;
+}
 
 void plain_test(vid_t v_count1, const string& idir, const string& odir, int job)
 {
@@ -1470,6 +1946,21 @@ void plain_test(vid_t v_count1, const string& idir, const string& odir, int job)
         case 59:
             estimate_IO<dst_id_t>(idir, odir);
             break; 
+        case 60://static view latency vs batch size
+            test_view_latency<dst_id_t>(idir, odir);
+            break;
+        case 61://durable edge log cost, recover with job 5
+            test_durable_ingest<dst_id_t>(idir, odir);
+            break;
+        case 62://sliding window WCC and pagerank deltas, -e window size
+            test_wsstream<dst_id_t>(idir, odir);
+            break;
+        case 63://compressed adjacency cost, -z 1
+            test_compress<dst_id_t>(idir, odir);
+            break;
+        case 64://string keyed ingest, -e batch size
+            test_str2sid<dst_id_t>(idir, odir);
+            break;
         default:
             break;
     }
@@ -11,14 +11,21 @@
 #define _GRAPHALEX_H_
 
 #include <stdlib.h>
+#include <assert.h>
 #include <algorithm>
 
 #include <set>
 #include <unordered_set>
 #include <vector>
 #include <iostream>
+#include <atomic>
+#include <thread>
 
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <parlay/io.h>
 #include <parlay/primitives.h>
@@ -45,6 +52,110 @@ namespace graphstore {
 
 
 #define PREFETCH 1
+#define REMOVE_REBUILD_FRACTION 4
+
+#define VERSION_READERS 64
+#define VERSION_FREE UINT64_MAX
+
+// Versions of graphs that are queried while the next batch goes in. A reader
+// pins the current version, a batch that starts while a reader is pinned
+// saves every vertex block it changes before changing it (copy-on-write) and
+// replaces the HITrees instead of inserting into them. A batch only starts
+// once the readers of the version before the last one are gone, so one saved
+// block per vertex is enough. One clock drives the in- and out-graph, their
+// versions advance together.
+class VersionClock {
+  public:
+    enum { IDLE, DECIDING, COW, NOCOW, WAITING };
+
+    VersionClock() {
+      for (uint32_t i = 0; i < VERSION_READERS; ++i) {
+        pins[i] = VERSION_FREE;
+      }
+    }
+
+    // Pins the current version in a free slot. A reader arriving while a
+    // batch runs without copy-on-write waits for it to end. While an exclusive
+    // batch waits for the pinned readers, new readers wait without a slot, so
+    // they cannot hold it off.
+    uint64_t pin(uint32_t &slot) {
+      while (true) {
+        while (state.load() == WAITING) {
+          std::this_thread::yield();
+        }
+        slot = 0;
+        uint64_t expected = VERSION_FREE;
+        while (!pins[slot].compare_exchange_weak(expected, version.load())) {
+          expected = VERSION_FREE;
+          slot = (slot + 1) % VERSION_READERS;
+        }
+        while (true) {
+          int s = state.load();
+          uint64_t v = version.load();
+          if ((s == IDLE || s == COW) && pins[slot].load() == v) {
+            return v;
+          }
+          if (s == WAITING) {
+            break;
+          }
+          pins[slot].store(v);
+          std::this_thread::yield();
+        }
+        pins[slot].store(VERSION_FREE);
+      }
+    }
+
+    void unpin(uint32_t slot) {
+      pins[slot].store(VERSION_FREE);
+    }
+
+    uint64_t oldest_pin() const {
+      uint64_t oldest = VERSION_FREE;
+      for (uint32_t i = 0; i < VERSION_READERS; ++i) {
+        oldest = std::min(oldest, pins[i].load());
+      }
+      return oldest;
+    }
+
+    // Waits for the readers still on the version before the last batch, then
+    // decides whether this batch saves versions.
+    void begin_batch() {
+      uint64_t v = version.load();
+      while (oldest_pin() < v) {
+        std::this_thread::yield();
+      }
+      state.store(DECIDING);
+      bool cow = cow_always || oldest_pin() != VERSION_FREE;
+      state.store(cow ? COW : NOCOW);
+    }
+
+    // For the batches that change blocks and HITrees in place (removals,
+    // add_edge_batch_1for): waits until no reader is pinned, readers arriving
+    // later wait for end_batch().
+    void begin_exclusive_batch() {
+      state.store(WAITING);
+      while (oldest_pin() != VERSION_FREE) {
+        std::this_thread::yield();
+      }
+      state.store(NOCOW);
+    }
+
+    void end_batch() {
+      version.fetch_add(1);
+      state.store(IDLE);
+    }
+
+    bool cow() const { return state.load() == COW; }
+    bool exclusive() const { return state.load() == NOCOW; }
+    uint64_t current() const { return version.load(); }
+
+    bool cow_always{false}; // copy-on-write without readers, to measure its cost
+
+  private:
+    std::atomic<uint64_t> version{0};
+    std::atomic<int> state{IDLE};
+    std::atomic<uint64_t> pins[VERSION_READERS];
+};
 
 class LSGraph {
     public:
@@ -62,10 +173,13 @@ class LSGraph {
       ~LSGraph();
 
       void serialize(std::string prefix); // write graph to disk
+      void materialize_all(); // build the HITrees a snapshot load left on disk
+      void set_versioned(VersionClock *clock); // keep versions for the readers of clock
 			int remove_edge(const vertex s, const vertex d);
 			void bulk_load(vertex *srcs,vertex *dests, uint32_t edge_count);
 			void add_edge_batch_1for(vertex *srcs,vertex *dests, uint32_t edge_count);
 			void add_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn, size_t thread_div=1);
+			void remove_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn);
       // check for the existence of the edge
       uint32_t is_edge(const vertex s, const vertex d);
 
@@ -84,13 +198,19 @@ class LSGraph {
       uint64_t get_size(void);
   
       template <class F, typename VS>
-      void map_sparse(F &f, VS &output_vs, uint32_t self_index, bool output);
+      void map_sparse(F &f, VS &output_vs, uint32_t self_index, bool output) {
+        map_sparse(vertices[self_index], f, output_vs, self_index, output);
+      }
       //template <class F, typename VS>
       //void map_dense(F &f, VS &vs, uint32_t self_index, bool output);
       template <class F, typename VS>
-      void map_dense_vs_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output);
+      void map_dense_vs_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+        map_dense_vs_all(vertices[self_index], f, vs, output_vs, self_index, output);
+      }
       template <class F, typename VS>
-      void map_dense_vs_not_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output);
+      void map_dense_vs_not_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+        map_dense_vs_not_all(vertices[self_index], f, vs, output_vs, self_index, output);
+      }
 
       uint32_t get_num_edges(void);
       uint32_t get_num_vertices(void) const;
@@ -105,8 +225,17 @@ class LSGraph {
         return vertices[s].aux_neighbors != nullptr;
       }
 
+      // aux_neighbors of a vertex loaded from a snapshot is (offset << 1) | 1,
+      // the position of its HITree keys in the mapped file, until first use.
+      inline fl_container* aux(const vertex s) const {
+        void *aux = vertices[s].aux_neighbors;
+        if (((uintptr_t)aux & 1) == 0) return (fl_container*)aux;
+        return materialize(s);
+      }
+      fl_container* materialize(const vertex s) const;
+
       void print_hitree(const vertex s, std::vector<uint32_t>& nei) const {
-		    fl_container *container = (fl_container*)(vertices[s].aux_neighbors);
+		    fl_container *container = aux(s);
         container->print_hitree(nei);  
       }
       bool check_in_place_dup(const vertex s, const vertex d) const;
@@ -121,7 +250,7 @@ class LSGraph {
       auto degree = vertices[i].degree & 0x7fffffff;
       // printf("loop %d\n", i);
       if(degree > NUM_IN_PLACE_NEIGHBORS){
-        auto container = (fl_container*)(vertices[i].aux_neighbors);
+        auto container = aux(i);
         if (container == nullptr) printf("nullptr\n");
         if (degree < 100) {
           sum[0] += container->get_ima();
@@ -158,9 +287,49 @@ class LSGraph {
         void *aux_neighbors{nullptr};  // 8 Bytes
         } vertex_block;
 
+      // HITree of a copied vertex block, see aux()
+      inline fl_container* aux(const vertex_block &block, const vertex s) const {
+        void *aux = block.aux_neighbors;
+        if (((uintptr_t)aux & 1) == 0) return (fl_container*)aux;
+        return materialize(s);
+      }
+
+      // the map functions over a vertex block, the live one or a saved version
+      template <class F, typename VS>
+      void map_sparse(const vertex_block &block, F &f, VS &output_vs, uint32_t self_index, bool output);
+      template <class F, typename VS>
+      void map_dense_vs_all(const vertex_block &block, F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output);
+      template <class F, typename VS>
+      void map_dense_vs_not_all(const vertex_block &block, F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output);
+
+      vertex_block read_block(const vertex s, uint64_t version) const;
+      void save_block(const vertex s, uint32_t batch);
+      void reclaim();
+
+      void begin_insert();
+      void begin_in_place();
+      void check_in_place() const;
+      void insert_group(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t begin, uint32_t end);
+
       vertex_block *vertices;
       uint32_t num_vertices{0};
       uint64_t inplace_size{0};
+
+      // snapshot mapping, vertices points into it when loaded from disk
+      char *snapshot_base{nullptr};
+      uint64_t snapshot_size{0};
+      vertex *snapshot_keys{nullptr};
+
+      // versioned mode: the block of every vertex as the last copy-on-write
+      // batch found it, the batch that saved it, and the HITrees that batch
+      // replaced (per worker), freed at the next batch
+      VersionClock *versions{nullptr};
+      vertex_block *shadow{nullptr};
+      uint32_t *shadow_version{nullptr};
+      std::vector<std::vector<fl_container*>> retired;
+      // the batch being inserted copies on write, as batch_version
+      bool batch_cow{false};
+      uint32_t batch_version{0};
   };
 
   LSGraph::LSGraph(uint32_t size) : num_vertices(size) {
@@ -169,7 +338,233 @@ class LSGraph {
   }
 
   LSGraph::~LSGraph() {
-    free(vertices);
+    if (snapshot_base != nullptr) {
+      munmap(snapshot_base, snapshot_size);
+    } else {
+      free(vertices);
+    }
+    reclaim();
+    free(shadow);
+    free(shadow_version);
+  }
+
+  void LSGraph::set_versioned(VersionClock *clock) {
+    // a block saved with a tagged HITree would materialize the live one
+    materialize_all();
+    versions = clock;
+    shadow = (vertex_block*)calloc(num_vertices, sizeof(vertex_block));
+    shadow_version = (uint32_t*)calloc(num_vertices, sizeof(uint32_t));
+    retired.resize(getWorkers());
+  }
+
+  // Block of s at version, for a reader pinned on it. Batch version+1 saves
+  // the block before it touches it; if it has not, the live block is still
+  // that version, unless the batch saves it during the copy, checked like a
+  // seqlock.
+  LSGraph::vertex_block LSGraph::read_block(const vertex s, uint64_t version) const {
+    vertex_block block;
+    if (shadow == nullptr) {
+      memcpy(&block, &vertices[s], sizeof(vertex_block));
+    } else {
+      uint32_t next = version + 1;
+      while (true) {
+        uint32_t batch = __atomic_load_n(&shadow_version[s], __ATOMIC_ACQUIRE);
+        if (batch == next) {
+          memcpy(&block, &shadow[s], sizeof(vertex_block));
+          break;
+        }
+        memcpy(&block, &vertices[s], sizeof(vertex_block));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shadow_version[s], __ATOMIC_RELAXED) == batch) {
+          break;
+        }
+      }
+    }
+    block.degree &= UNLOCK_MASK;
+    return block;
+  }
+
+  // Saves the block of s for the readers of the version before batch
+  inline void LSGraph::save_block(const vertex s, uint32_t batch) {
+    memcpy(&shadow[s], &vertices[s], sizeof(vertex_block));
+    __atomic_store_n(&shadow_version[s], batch, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  }
+
+  // Frees the HITrees the last copy-on-write batch replaced, the clock has
+  // waited for the readers that could still walk them
+  void LSGraph::reclaim() {
+    for (auto &trees : retired) {
+      for (fl_container *container : trees) {
+        delete container;
+      }
+      trees.clear();
+    }
+  }
+
+  // Snapshot file: header, the vertex_block array, then the HITree keys of
+  // every vertex with aux neighbors as {count, keys...} in vertex order.
+  // aux_neighbors on disk is (offset << 1) | 1, offset of the count in the
+  // keys, or nullptr. The file is mapped private, so the vertex blocks are used
+  // in place and a HITree is bulk loaded from its keys on first access.
+#define SNAPSHOT_MAGIC 0x3148505247534cULL // "LSGRPH1"
+#define SNAPSHOT_CHUNK (1U << 16) // vertices per write task
+
+  struct snapshot_header {
+    uint64_t magic;
+    uint64_t num_vertices;
+    uint64_t num_keys;
+    uint64_t keys_offset; // bytes
+    // layout of the vertex blocks, a snapshot only loads into the same build
+    uint32_t in_place_neighbors; // NUM_IN_PLACE_NEIGHBORS
+    uint32_t vertex_block_size;
+    uint32_t vertex_size;
+    uint32_t padding0;
+    uint64_t padding[2];
+  };
+
+  static void snapshot_write(int fd, const void *buf, uint64_t len, uint64_t offset) {
+    const char *p = (const char*)buf;
+    while (len > 0) {
+      ssize_t ret = pwrite(fd, p, len, offset);
+      if (ret <= 0) {
+        perror("snapshot write");
+        exit(EXIT_FAILURE);
+      }
+      p += ret;
+      len -= ret;
+      offset += ret;
+    }
+  }
+
+  LSGraph::LSGraph(std::string prefix) {
+    std::string filename = prefix + ".lsg";
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      perror(filename.c_str());
+      exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    fstat(fd, &st);
+    snapshot_size = st.st_size;
+    snapshot_base = (char*)mmap(nullptr, snapshot_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (snapshot_base == MAP_FAILED) {
+      perror("snapshot mmap");
+      exit(EXIT_FAILURE);
+    }
+    snapshot_header *header = (snapshot_header*)snapshot_base;
+    if (snapshot_size < sizeof(snapshot_header) || header->magic != SNAPSHOT_MAGIC
+        || header->keys_offset + header->num_keys * sizeof(vertex) != snapshot_size) {
+      printf("%s is not a graph snapshot\n", filename.c_str());
+      exit(EXIT_FAILURE);
+    }
+    if (header->in_place_neighbors != NUM_IN_PLACE_NEIGHBORS || header->vertex_block_size != sizeof(vertex_block)
+        || header->vertex_size != sizeof(vertex)) {
+      printf("%s was written with %u in-place neighbors, %u-byte vertex blocks and %u-byte vertices, "
+             "this build has %u, %zu and %zu\n", filename.c_str(), header->in_place_neighbors,
+             header->vertex_block_size, header->vertex_size, (uint32_t)NUM_IN_PLACE_NEIGHBORS,
+             sizeof(vertex_block), sizeof(vertex));
+      exit(EXIT_FAILURE);
+    }
+    num_vertices = header->num_vertices;
+    inplace_size = num_vertices * sizeof(vertex_block);
+    vertices = (vertex_block*)(snapshot_base + sizeof(snapshot_header));
+    snapshot_keys = (vertex*)(snapshot_base + header->keys_offset);
+  }
+
+  LSGraph::fl_container* LSGraph::materialize(const vertex s) const {
+    uintptr_t tag = (uintptr_t)vertices[s].aux_neighbors;
+    vertex *keys = snapshot_keys + (tag >> 1);
+    fl_container *container = new fl_container();
+    container->bulk_load(keys + 1, keys[0]);
+    // another reader may have won the race for this vertex
+    void *expected = (void*)tag;
+    if (!__atomic_compare_exchange_n(&vertices[s].aux_neighbors, &expected, (void*)container,
+                                     false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      delete container;
+      return (fl_container*)expected;
+    }
+    return container;
+  }
+
+  void LSGraph::materialize_all() {
+    parallel_for (uint32_t s = 0; s < num_vertices; ++s) {
+      if (degree(s) > NUM_IN_PLACE_NEIGHBORS) {
+        aux(s);
+      }
+    }
+  }
+
+  void LSGraph::serialize(std::string prefix) {
+    std::string filename = prefix + ".lsg";
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      perror(filename.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    // 1. gather {count, keys...} of the aux neighbors, per chunk of vertices
+    uint32_t chunks = (num_vertices + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK;
+    std::vector<std::vector<vertex>> keys(chunks);
+    std::vector<uint64_t> chunk_offset(chunks + 1, 0);
+    parallel_for_1 (uint32_t c = 0; c < chunks; ++c) {
+      uint32_t end = std::min(num_vertices, (c + 1) * SNAPSHOT_CHUNK);
+      for (uint32_t s = c * SNAPSHOT_CHUNK; s < end; ++s) {
+        if (degree(s) <= NUM_IN_PLACE_NEIGHBORS) continue;
+        uintptr_t tag = (uintptr_t)vertices[s].aux_neighbors;
+        if (tag & 1) { // still on disk, copy the keys as they are
+          vertex *src = snapshot_keys + (tag >> 1);
+          keys[c].insert(keys[c].end(), src, src + src[0] + 1);
+          continue;
+        }
+        size_t base = keys[c].size();
+        keys[c].push_back(0);
+        aux(s)->print_hitree(keys[c]);
+        keys[c][base] = keys[c].size() - base - 1;
+      }
+    }
+    for (uint32_t c = 0; c < chunks; ++c) {
+      chunk_offset[c + 1] = chunk_offset[c] + keys[c].size();
+    }
+
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.num_vertices = num_vertices;
+    header.num_keys = chunk_offset[chunks];
+    header.keys_offset = sizeof(snapshot_header) + inplace_size;
+    header.in_place_neighbors = NUM_IN_PLACE_NEIGHBORS;
+    header.vertex_block_size = sizeof(vertex_block);
+    header.vertex_size = sizeof(vertex);
+
+    // 2. write the vertex blocks with the aux pointers as offsets, and the keys
+    parallel_for_1 (uint32_t c = 0; c < chunks; ++c) {
+      uint32_t begin = c * SNAPSHOT_CHUNK;
+      uint32_t end = std::min(num_vertices, begin + SNAPSHOT_CHUNK);
+      std::vector<vertex_block> blocks(vertices + begin, vertices + end);
+      uint64_t cursor = 0;
+      for (uint32_t i = 0; i < end - begin; ++i) {
+        blocks[i].degree = degree(begin + i);
+        if (blocks[i].degree <= NUM_IN_PLACE_NEIGHBORS) {
+          blocks[i].aux_neighbors = nullptr;
+        } else {
+          blocks[i].aux_neighbors = (void*)(((chunk_offset[c] + cursor) << 1) | 1);
+          cursor += keys[c][cursor] + 1;
+        }
+      }
+      snapshot_write(fd, blocks.data(), (end - begin) * sizeof(vertex_block),
+                     sizeof(snapshot_header) + (uint64_t)begin * sizeof(vertex_block));
+      snapshot_write(fd, keys[c].data(), keys[c].size() * sizeof(vertex),
+                     header.keys_offset + chunk_offset[c] * sizeof(vertex));
+      std::vector<vertex>().swap(keys[c]);
+    }
+    snapshot_write(fd, &header, sizeof(header), 0);
+    if (ftruncate(fd, header.keys_offset + header.num_keys * sizeof(vertex)) != 0) {
+      perror("snapshot truncate");
+      exit(EXIT_FAILURE);
+    }
+    close(fd);
   }
 
   bool LSGraph::check_in_place_dup(const vertex s, const vertex d) const {
@@ -218,11 +613,42 @@ class LSGraph {
     }
   }
 
+  // Versioned: the clock has begun this batch, it may copy on write, and the
+  // trees the last one replaced have no readers left
+  void LSGraph::begin_insert() {
+    batch_cow = versions != nullptr && versions->cow();
+    batch_version = batch_cow ? versions->current() + 1 : 0;
+    if (versions != nullptr) {
+      reclaim();
+    }
+  }
+
+  // Versioned: the paths that change blocks and delete HITrees in place have no
+  // copy-on-write, the clock must have begun an exclusive batch
+  void LSGraph::begin_in_place() {
+    check_in_place();
+    batch_cow = false;
+    if (versions != nullptr) {
+      reclaim();
+    }
+  }
+
+  // Checked in release builds too: an in-place change under a pinned reader
+  // corrupts its view silently.
+  void LSGraph::check_in_place() const {
+    if (versions != nullptr && !versions->exclusive()) {
+      fprintf(stderr, "in-place update of a versioned graph outside begin_exclusive_batch()\n");
+      abort();
+    }
+  }
+
   void LSGraph::add_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn, size_t thread_div) {
     // struct timeval start, end;
     // struct timezone tzp;
     parlay::internal::timer t("Time");
 
+    begin_insert();
+
     uint32_t threads = getWorkers() / thread_div;
     uint32_t* oparts = new uint32_t[edge_count+1];
     uint32_t* parts = new uint32_t[edge_count+1];
@@ -318,159 +744,191 @@ class LSGraph {
     // 2. insert
 		// parallel_for (uint32_t i = 0; i < parts.size()-1; i++) {
 		parallel_for_1 (uint32_t i = 0; i < part-1; i++) {
-      vertex s = get<0>(updates[parts[i]]);
+      insert_group(updates, parts[i], parts[i+1]);
+		}
+    delete [] parts;
+  }
 
-      std::pair<uint32_t, uint32_t> range = {parts[i], parts[i+1]};
-      uint32_t size = range.second - range.first;
-      // auto [s1, d1] = updates[range.first];
-      // int tid = getWorkerNum();
-      // printf("[%d] s: %d, d: %d\n", tid, s1, d1);
+  // Merges the updates [begin, end) of one source, sorted by destination,
+  // into its in-place block and HITree
+  void LSGraph::insert_group(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t begin, uint32_t end) {
+    vertex s = get<0>(updates[begin]);
+
+    std::pair<uint32_t, uint32_t> range = {begin, end};
+    uint32_t size = range.second - range.first;
+    // auto [s1, d1] = updates[range.first];
+    // int tid = getWorkerNum();
+    // printf("[%d] s: %d, d: %d\n", tid, s1, d1);
 
 #if ENABLE_LOCK
-      lock(&vertices[s].degree);
+    lock(&vertices[s].degree);
 #endif
-      uint32_t degree = this->degree(s);
-      //pre-peprocess & remove duplicate
-      uint32_t* edge_insert_array = new uint32_t[size + degree];
-      int new_size = 0;
-      if (degree <= NUM_IN_PLACE_NEIGHBORS){ //in-cacheline
-        int m = 0, n = 0;
-        while(m < degree && n < size){
-          if(vertices[s].neighbors[m] < get<1>(updates[range.first+n])){
-            if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
-              edge_insert_array[new_size++] = vertices[s].neighbors[m];
-            }
-            m++;
-          }
-          else if(vertices[s].neighbors[m] > get<1>(updates[range.first+n])){
-            if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
-              edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
-            }
-            n++;
-          }
-          else{
-            if(new_size == 0 || edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
-              edge_insert_array[new_size++] = vertices[s].neighbors[m];
-            }
-            m++;
-            n++;
-          }
-        }
-
-        while(m < degree){
+    if (batch_cow) {
+      save_block(s, batch_version);
+    }
+    uint32_t degree = this->degree(s);
+    //pre-peprocess & remove duplicate
+    uint32_t* edge_insert_array = new uint32_t[size + degree];
+    int new_size = 0;
+    if (degree <= NUM_IN_PLACE_NEIGHBORS){ //in-cacheline
+      int m = 0, n = 0;
+      while(m < degree && n < size){
+        if(vertices[s].neighbors[m] < get<1>(updates[range.first+n])){
           if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
             edge_insert_array[new_size++] = vertices[s].neighbors[m];
           }
           m++;
         }
-
-        while(n < size){
+        else if(vertices[s].neighbors[m] > get<1>(updates[range.first+n])){
           if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
             edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
           }
           n++;
         }
-      }else{
-       int m = 0, n = 0;
-        while(m < NUM_IN_PLACE_NEIGHBORS && n < size){
-          if(vertices[s].neighbors[m] < get<1>(updates[range.first+n])){
-            if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
-              edge_insert_array[new_size++] = vertices[s].neighbors[m];
-            }
-            m++;
-          }
-          else if(vertices[s].neighbors[m] > get<1>(updates[range.first+n])){
-            if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
-              edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
-            }
-            n++;
-          }
-          else{
-            if(new_size == 0 || edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
-              edge_insert_array[new_size++] = vertices[s].neighbors[m];
-            }
-            m++;
-            n++;
+        else{
+          if(new_size == 0 || edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
+            edge_insert_array[new_size++] = vertices[s].neighbors[m];
           }
+          m++;
+          n++;
+        }
+      }
+
+      while(m < degree){
+        if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
+          edge_insert_array[new_size++] = vertices[s].neighbors[m];
         }
+        m++;
+      }
 
-        while(m < NUM_IN_PLACE_NEIGHBORS){
+      while(n < size){
+        if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
+          edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
+        }
+        n++;
+      }
+    }else{
+     int m = 0, n = 0;
+      while(m < NUM_IN_PLACE_NEIGHBORS && n < size){
+        if(vertices[s].neighbors[m] < get<1>(updates[range.first+n])){
           if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
             edge_insert_array[new_size++] = vertices[s].neighbors[m];
           }
           m++;
         }
-
-        while(n < size){
+        else if(vertices[s].neighbors[m] > get<1>(updates[range.first+n])){
           if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
             edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
           }
           n++;
         }
-      //  for (auto j = 0; j < size; j++){
-      //   if(j == 0 || edge_insert_array[new_size-1] != get<1>(updates[range.first+j])){
-      //     edge_insert_array[new_size++] = get<1>(updates[range.first+j]);
-      //   }
-      //  } 
+        else{
+          if(new_size == 0 || edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
+            edge_insert_array[new_size++] = vertices[s].neighbors[m];
+          }
+          m++;
+          n++;
+        }
       }
-      auto final_degree = new_size;
-
-      // print edge_insert_array
-      // for (int j = 0; j < new_size; j++) {
-      //   printf("%d ", edge_insert_array[j]);
-      // }
-      // printf("\n");
 
-      // printf("s: %d, degree: %d, new_size: %d, final_degree: %d, NUM_IN_PLACE_NEIGHBORS: %d\n", s, degree, new_size, final_degree, NUM_IN_PLACE_NEIGHBORS);
+      while(m < NUM_IN_PLACE_NEIGHBORS){
+        if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != vertices[s].neighbors[m]){
+          edge_insert_array[new_size++] = vertices[s].neighbors[m];
+        }
+        m++;
+      }
 
-      if (degree == 0) {
-        // cacheline
-        if (new_size <= NUM_IN_PLACE_NEIGHBORS) {
-           memcpy(vertices[s].neighbors, edge_insert_array, new_size*sizeof(vertex));
-        } else { // HITree
-          fl_container *container = new fl_container();
-          vertices[s].aux_neighbors = container;
-          // // std::pair<uint32_t, uint32_t>* init_data = new std::pair<uint32_t, uint32_t>[size];
-          // // for (int j = 0; j < size; ++j) {
-          // //   init_data[j].first = edge_insert_array[j];
-          // //   init_data[j].second = edge_insert_array[j];
-          // // }
-          // container->bulk_load(edge_insert_array, new_size);
-          // // delete [] init_data;
-          memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex));
-          //HITree
-          container->bulk_load(edge_insert_array + NUM_IN_PLACE_NEIGHBORS, final_degree-NUM_IN_PLACE_NEIGHBORS);
-          // delete [] init_data;
+      while(n < size){
+        if(new_size == 0 || new_size > 0 && edge_insert_array[new_size-1] != get<1>(updates[range.first+n])){
+          edge_insert_array[new_size++] = get<1>(updates[range.first+n]);
         }
-        vertices[s].degree += new_size;
-      } else if (final_degree <= NUM_IN_PLACE_NEIGHBORS) {
-        memcpy(vertices[s].neighbors, edge_insert_array, final_degree * sizeof(vertex));
+        n++;
+      }
+    //  for (auto j = 0; j < size; j++){
+    //   if(j == 0 || edge_insert_array[new_size-1] != get<1>(updates[range.first+j])){
+    //     edge_insert_array[new_size++] = get<1>(updates[range.first+j]);
+    //   }
+    //  } 
+    }
+    auto final_degree = new_size;
+
+    // print edge_insert_array
+    // for (int j = 0; j < new_size; j++) {
+    //   printf("%d ", edge_insert_array[j]);
+    // }
+    // printf("\n");
+
+    // printf("s: %d, degree: %d, new_size: %d, final_degree: %d, NUM_IN_PLACE_NEIGHBORS: %d\n", s, degree, new_size, final_degree, NUM_IN_PLACE_NEIGHBORS);
+
+    if (degree == 0) {
+      // cacheline
+      if (new_size <= NUM_IN_PLACE_NEIGHBORS) {
+         memcpy(vertices[s].neighbors, edge_insert_array, new_size*sizeof(vertex));
+      } else { // HITree
+        fl_container *container = new fl_container();
+        vertices[s].aux_neighbors = container;
+        // // std::pair<uint32_t, uint32_t>* init_data = new std::pair<uint32_t, uint32_t>[size];
+        // // for (int j = 0; j < size; ++j) {
+        // //   init_data[j].first = edge_insert_array[j];
+        // //   init_data[j].second = edge_insert_array[j];
+        // // }
+        // container->bulk_load(edge_insert_array, new_size);
+        // // delete [] init_data;
+        memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex));
+        //HITree
+        container->bulk_load(edge_insert_array + NUM_IN_PLACE_NEIGHBORS, final_degree-NUM_IN_PLACE_NEIGHBORS);
+        // delete [] init_data;
+      }
+      vertices[s].degree += new_size;
+    } else if (degree <= NUM_IN_PLACE_NEIGHBORS && final_degree <= NUM_IN_PLACE_NEIGHBORS) {
+      memcpy(vertices[s].neighbors, edge_insert_array, final_degree * sizeof(vertex));
+      vertices[s].degree = final_degree | LOCK_MASK;
+    } else {
+      // printf("degree: %d, NUM_IN_PLACE_NEIGHBORS: %d\n", degree, NUM_IN_PLACE_NEIGHBORS);
+      if (degree <= NUM_IN_PLACE_NEIGHBORS) {
+        // load_bulk, old+update, merge
+        fl_container *container = new fl_container();
+        vertices[s].aux_neighbors = container;
+        // std::pair<uint32_t, uint32_t>* init_data = new std::pair<uint32_t, uint32_t>[degree+size];
+        // for (int j = 0; j < final_degree; j++){
+        //   init_data[j].first = edge_insert_array[j];
+        //   init_data[j].second = edge_insert_array[j];
+        // }
+        //cache-line
+        memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex));
+        //HITree
+        container->bulk_load(edge_insert_array + NUM_IN_PLACE_NEIGHBORS, final_degree-NUM_IN_PLACE_NEIGHBORS);
+        // delete [] init_data;
         vertices[s].degree = final_degree | LOCK_MASK;
       } else {
-        // printf("degree: %d, NUM_IN_PLACE_NEIGHBORS: %d\n", degree, NUM_IN_PLACE_NEIGHBORS);
-        if (degree <= NUM_IN_PLACE_NEIGHBORS) {
-          // load_bulk, old+update, merge
-          fl_container *container = new fl_container();
-          vertices[s].aux_neighbors = container;
-          // std::pair<uint32_t, uint32_t>* init_data = new std::pair<uint32_t, uint32_t>[degree+size];
-          // for (int j = 0; j < final_degree; j++){
-          //   init_data[j].first = edge_insert_array[j];
-          //   init_data[j].second = edge_insert_array[j];
-          // }
-          //cache-line
-          memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex));
-          //HITree
-          container->bulk_load(edge_insert_array + NUM_IN_PLACE_NEIGHBORS, final_degree-NUM_IN_PLACE_NEIGHBORS);
-          // delete [] init_data;
-          vertices[s].degree = final_degree | LOCK_MASK;
-        } else {
-          fl_container *container = (fl_container*)(vertices[s].aux_neighbors);
-          memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex)); 
-          // printf("s: %d, neighbors[0]: %d\n", s, vertices[s].neighbors[0]);
+        fl_container *container = aux(s);
+        memcpy(vertices[s].neighbors, edge_insert_array, NUM_IN_PLACE_NEIGHBORS * sizeof(vertex)); 
+        // printf("s: %d, neighbors[0]: %d\n", s, vertices[s].neighbors[0]);
 
-          // if (container == nullptr) {
-          //   std::cout << "error container is null" << std::endl;
-          // }
+        // if (container == nullptr) {
+        //   std::cout << "error container is null" << std::endl;
+        // }
+        if (batch_cow) {
+          // a pinned reader may walk the HITree, build the new one aside
+          uint32_t fresh = NUM_IN_PLACE_NEIGHBORS;
+          for (uint32_t j = NUM_IN_PLACE_NEIGHBORS; j < new_size; j++) {
+            if (s != edge_insert_array[j]) {
+              edge_insert_array[fresh++] = edge_insert_array[j];
+            }
+          }
+          std::vector<vertex> keys;
+          keys.reserve(degree - NUM_IN_PLACE_NEIGHBORS);
+          container->print_hitree(keys);
+          std::vector<vertex> merged(keys.size() + fresh - NUM_IN_PLACE_NEIGHBORS);
+          merged.resize(std::set_union(keys.begin(), keys.end(),
+                                       edge_insert_array + NUM_IN_PLACE_NEIGHBORS, edge_insert_array + fresh,
+                                       merged.begin()) - merged.begin());
+          fl_container *copy = new fl_container();
+          copy->bulk_load(merged.data(), merged.size());
+          vertices[s].aux_neighbors = copy;
+          vertices[s].degree = (NUM_IN_PLACE_NEIGHBORS + merged.size()) | LOCK_MASK;
+          retired[getWorkerNum()].push_back(container);
+        } else {
           for (uint32_t j = NUM_IN_PLACE_NEIGHBORS; j < new_size; j++) {
             // if (s != dests[j] && dests[j] != 191487) {
             // if (s != edge_insert_array[j] && s == 32731) {
@@ -483,15 +941,160 @@ class LSGraph {
           }
         }
       }
-      delete [] edge_insert_array;
+    }
+    delete [] edge_insert_array;
+#if ENABLE_LOCK
+    unlock(&vertices[s].degree);
+#endif
+  }
+
+  // Inserts a batch into an out-graph and the matching in-graph. The batch is
+  // sorted once by source and destination (and left so); the in side is a
+  // reversed copy regrouped by a stable sort on the destination alone, which
+  // keeps the sources of a group sorted with half the key bits. The groups of
+  // both sides then go through one parallel loop.
+  void add_edge_batch_bidirectional(LSGraph &gout, LSGraph &gin, parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
+    using edge = std::tuple<uint32_t, uint32_t>;
+    if (edge_count == 0) return;
+    gout.begin_insert();
+    gin.begin_insert();
+
+    // 0. sort by source, regroup by destination
+    sort_updates(updates, edge_count, nn);
+    auto reversed = parlay::tabulate(edge_count, [&] (size_t i) {
+      return edge(get<1>(updates[i]), get<0>(updates[i]));
+    });
+    if (nn <= (edge_count * parlay::log2_up(edge_count))) {
+      parlay::stable_integer_sort_inplace(reversed, [] (edge e) { return (size_t)get<0>(e); });
+    } else {
+      parlay::stable_sort_inplace(reversed, [] (edge a, edge b) { return get<0>(a) < get<0>(b); });
+    }
+
+    // 1. start of the group of every vertex, on both sides
+    auto out_parts = parlay::pack_index<uint32_t>(parlay::delayed_seq<bool>(edge_count, [&] (size_t i) {
+      return i == 0 || get<0>(updates[i]) != get<0>(updates[i-1]);
+    }));
+    auto in_parts = parlay::pack_index<uint32_t>(parlay::delayed_seq<bool>(edge_count, [&] (size_t i) {
+      return i == 0 || get<0>(reversed[i]) != get<0>(reversed[i-1]);
+    }));
+
+    // 2. insert, the out groups first
+    uint32_t out_groups = out_parts.size();
+    uint32_t in_groups = in_parts.size();
+    parallel_for_1 (uint32_t i = 0; i < out_groups + in_groups; i++) {
+      if (i < out_groups) {
+        uint32_t end = (i + 1 < out_groups) ? out_parts[i+1] : edge_count;
+        gout.insert_group(updates, out_parts[i], end);
+      } else {
+        uint32_t j = i - out_groups;
+        uint32_t end = (j + 1 < in_groups) ? in_parts[j+1] : edge_count;
+        gin.insert_group(reversed, in_parts[j], end);
+      }
+    }
+  }
+
+  // Removes a batch of edges. The batch is sorted like an insertion batch, then
+  // every source vertex drops all of its edges in one merge over the in-place
+  // block and the HITree. A HITree losing at least 1/REMOVE_REBUILD_FRACTION of
+  // its keys is rebuilt with bulk_load, smaller groups go through remove().
+  void LSGraph::remove_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
+    if (edge_count == 0) return;
+    begin_in_place();
+
+    // 0. sort update
+    sort_updates(updates, edge_count, nn);
+
+		// 1. start of the group of every source
+    auto parts = parlay::pack_index<uint32_t>(parlay::delayed_seq<bool>(edge_count, [&] (size_t i) {
+      return i == 0 || get<0>(updates[i]) != get<0>(updates[i-1]);
+    }));
+
+    // 2. remove
+		parallel_for_1 (uint32_t i = 0; i < parts.size(); i++) {
+      uint32_t begin = parts[i];
+      uint32_t end = (i + 1 < parts.size()) ? parts[i+1] : edge_count;
+      vertex s = get<0>(updates[begin]);
+
+#if ENABLE_LOCK
+      lock(&vertices[s].degree);
+#endif
+      uint32_t degree = this->degree(s);
+      if (degree == 0) {
+#if ENABLE_LOCK
+        unlock(&vertices[s].degree);
+#endif
+        continue;
+      }
+
+      // in place, keep the neighbors not in the batch
+      uint32_t inplace = std::min(degree, (uint32_t)NUM_IN_PLACE_NEIGHBORS);
+      vertex last = vertices[s].neighbors[inplace-1];
+      uint32_t k = 0, n = begin;
+      for (uint32_t m = 0; m < inplace; ++m) {
+        vertex v = vertices[s].neighbors[m];
+        while (n < end && get<1>(updates[n]) < v) n++;
+        if (n < end && get<1>(updates[n]) == v) continue;
+        vertices[s].neighbors[k++] = v;
+      }
+      while (n < end && get<1>(updates[n]) <= last) n++;
+
+      if (degree > NUM_IN_PLACE_NEIGHBORS) {
+        // HITree, the rest of the batch is bigger than every in place neighbor
+        fl_container *container = aux(s);
+        uint32_t tree_size = degree - NUM_IN_PLACE_NEIGHBORS;
+        if ((end - n) * REMOVE_REBUILD_FRACTION >= tree_size) {
+          std::vector<vertex> keys;
+          keys.reserve(tree_size);
+          container->print_hitree(keys);
+          uint32_t r = 0;
+          for (uint32_t j = 0; j < keys.size(); ++j) {
+            while (n < end && get<1>(updates[n]) < keys[j]) n++;
+            if (n < end && get<1>(updates[n]) == keys[j]) continue;
+            keys[r++] = keys[j];
+          }
+          uint32_t refill = std::min(NUM_IN_PLACE_NEIGHBORS - k, r);
+          memcpy(&vertices[s].neighbors[k], keys.data(), refill * sizeof(vertex));
+          k += refill;
+          delete container;
+          if (r > refill) {
+            container = new fl_container();
+            container->bulk_load(keys.data() + refill, r - refill);
+            vertices[s].aux_neighbors = container;
+          } else {
+            vertices[s].aux_neighbors = nullptr;
+          }
+          degree = k + r - refill;
+        } else {
+          uint32_t remaining = tree_size;
+          for (; n < end; ++n) {
+            if (n > begin && get<1>(updates[n]) == get<1>(updates[n-1])) continue;
+            remaining -= container->remove(get<1>(updates[n]));
+          }
+          // refill the in place block with the smallest keys of the tree
+          while (k < NUM_IN_PLACE_NEIGHBORS && remaining > 0) {
+            vertex bump = container->get_first_key();
+            container->remove(bump);
+            vertices[s].neighbors[k++] = bump;
+            remaining--;
+          }
+          if (remaining == 0) {
+            delete container;
+            vertices[s].aux_neighbors = nullptr;
+          }
+          degree = k + remaining;
+        }
+      } else {
+        degree = k;
+      }
+      vertices[s].degree = degree | LOCK_MASK;
 #if ENABLE_LOCK
 		  unlock(&vertices[s].degree);
 #endif
 		}
-    delete [] parts;
   }
 
   void LSGraph::add_edge_batch_1for(vertex *srcs,vertex *dests, uint32_t edge_count) {
+    begin_in_place();
     struct timeval start, end;
     struct timezone tzp;
 	  gettimeofday(&start, &tzp);
@@ -704,7 +1307,7 @@ class LSGraph {
 
           vertices[s].degree = k | LOCK_MASK;
         } else {
-          fl_container *container = (fl_container*)(vertices[s].aux_neighbors);
+          fl_container *container = aux(s);
           // if (container == nullptr) {
           //   std::cout << "error container is null" << std::endl;
           // }
@@ -810,7 +1413,7 @@ class LSGraph {
       auto degree = vertices[s].degree;
       if(degree <= NUM_IN_PLACE_NEIGHBORS){
       }else if(degree > NUM_IN_PLACE_NEIGHBORS){
-       sum +=  ((fl_container*)(vertices[s].aux_neighbors))->get_index_num();
+       sum +=  aux(s)->get_index_num();
        }
     }
     return sum;
@@ -824,7 +1427,7 @@ class LSGraph {
         std::cout << d << " ";
       }
     }else if(degree > NUM_IN_PLACE_NEIGHBORS){
-      ((fl_container*)(vertices[s].aux_neighbors))->visit_edges();
+      aux(s)->visit_edges();
      }
      //std::cout << std::endl;
   }
@@ -837,14 +1440,14 @@ class LSGraph {
         array.push_back(d);
       }
     }else if(degree > NUM_IN_PLACE_NEIGHBORS){
-      ((fl_container*)(vertices[s].aux_neighbors))->visit_edges_test(array);
+      aux(s)->visit_edges_test(array);
      }
   }
   
   uint64_t LSGraph::collect_conflict(const vertex s){
     auto degree = vertices[s].degree;
     if(degree > NUM_IN_PLACE_NEIGHBORS){
-      auto container = (fl_container*)(vertices[s].aux_neighbors);
+      auto container = aux(s);
       return container->num_confilicts();
     }else{
       return 0;
@@ -858,7 +1461,7 @@ class LSGraph {
         return 1;
     }
     if (vertices[s].degree > NUM_IN_PLACE_NEIGHBORS) {
-      return ((fl_container*)(vertices[s].aux_neighbors))->find(d);
+      return aux(s)->find(d);
     }
     return 0;
   }
@@ -871,7 +1474,7 @@ class LSGraph {
     }
     if (vertices[s].degree > NUM_IN_PLACE_NEIGHBORS) {
       // ((fl_container*)(vertices[s].aux_neighbors))->print_stats();
-      ((fl_container*)(vertices[s].aux_neighbors))->print_hitree(nei);
+      aux(s)->print_hitree(nei);
     }
   }
 
@@ -886,12 +1489,13 @@ class LSGraph {
     }
     if (vertices[s].degree > NUM_IN_PLACE_NEIGHBORS) {
       // ((fl_container*)(vertices[s].aux_neighbors))->print_stats();
-      ((fl_container*)(vertices[s].aux_neighbors))->print_hitree_l(nei, node_id);
+      aux(s)->print_hitree_l(nei, node_id);
     }
   }
 
 	int LSGraph::remove_edge(const vertex s, const vertex d) {
     if(s == d) return -1;
+    check_in_place();
 		uint32_t idx;
 		int ret{0};
 #if ENABLE_LOCK
@@ -916,7 +1520,7 @@ class LSGraph {
 					if (vertices[s].neighbors[idx] < d)
 						continue;
 					else if (vertices[s].neighbors[idx] == d) {
-						memcpy(&vertices[s].neighbors[idx], &vertices[s].neighbors[idx+1],
+						memmove(&vertices[s].neighbors[idx], &vertices[s].neighbors[idx+1],
 									 (degree-idx-1)*sizeof(vertex));
 						goto decr;
 					}
@@ -929,7 +1533,7 @@ class LSGraph {
 				}
 			} else if (d > vertices[s].neighbors[NUM_IN_PLACE_NEIGHBORS-1]) {
 				// only in hitree
-          fl_container *container = (fl_container*)(vertices[s].aux_neighbors);
+          fl_container *container = aux(s);
           if(!container->remove(d)){
             ret = -1;
             goto unlock;
@@ -940,16 +1544,19 @@ class LSGraph {
 					if (vertices[s].neighbors[idx] < d)
 						continue;
 					else if (vertices[s].neighbors[idx] == d) {
-						memcpy(&vertices[s].neighbors[idx], &vertices[s].neighbors[idx+1],
+						memmove(&vertices[s].neighbors[idx], &vertices[s].neighbors[idx+1],
 									 (NUM_IN_PLACE_NEIGHBORS-idx-1)*sizeof(vertex));
 						break;
 					}
-					else
-						break;
+					else {
+						// not in place, and the hitree only has bigger keys
+						ret = -1;
+						goto unlock;
+					}
 				}
 				// remove the smallest from hitree
 				vertex bump{0};
-        fl_container *container = (fl_container*)(vertices[s].aux_neighbors);
+        fl_container *container = aux(s);
         bump = container->get_first_key();
         if (!container->remove(bump)) {
             //delete failed : key not found.
@@ -1078,13 +1685,13 @@ unlock:
 
 
   template <class F, typename VS>
-    void LSGraph::map_sparse(F &f, VS &output_vs, uint32_t self_index, bool output) {
-      uint32_t degree = vertices[self_index].degree;
+    void LSGraph::map_sparse(const vertex_block &block, F &f, VS &output_vs, uint32_t self_index, bool output) {
+      uint32_t degree = block.degree;
       // std::cout << "vertex: " << self_index << " degree: " << degree << '\n';
       uint32_t local_idx = 0;
       if (degree <= NUM_IN_PLACE_NEIGHBORS) {
         while (local_idx < degree) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           if (f.cond(v) == 1 && f.updateAtomic(self_index, v) == 1) {
             if (output) {
               output_vs.insert_sparse(v);
@@ -1094,12 +1701,12 @@ unlock:
         }
       } else {
 #if PREFETCH
-        if (has_aux(self_index)) {
-          __builtin_prefetch(vertices[self_index].aux_neighbors);  
+        if (block.aux_neighbors != nullptr) {
+          __builtin_prefetch(block.aux_neighbors);  
         }
 #endif
         while (local_idx < NUM_IN_PLACE_NEIGHBORS) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           if (f.cond(v) == 1 && f.updateAtomic(self_index, v) == 1) {
             if (output) {
               output_vs.insert_sparse(v);
@@ -1108,14 +1715,14 @@ unlock:
           ++local_idx;
 #if PREFETCH
           if (local_idx == NUM_IN_PLACE_NEIGHBORS/2) {
-        		if (has_aux(self_index)) {
-              __builtin_prefetch(((fl_container*)vertices[self_index].aux_neighbors)->get_root()); 
+        		if (block.aux_neighbors != nullptr) {
+              __builtin_prefetch(aux(block, self_index)->get_root()); 
             }
           }
 #endif
         }
         {
-          fl_container *hitree = (fl_container *)vertices[self_index].aux_neighbors;
+          fl_container *hitree = aux(block, self_index);
           struct HITREE_map<F, VS> update_fn(output_vs, f, output, self_index, hitree);
           hitree->map(update_fn);
         }
@@ -1123,8 +1730,8 @@ unlock:
     }
 
   template <class F, typename VS>
-    void LSGraph::map_dense_vs_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
-      uint32_t degree = vertices[self_index].degree;
+    void LSGraph::map_dense_vs_all(const vertex_block &block, F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+      uint32_t degree = block.degree;
       uint32_t local_idx = 0;
       // if(self_index == 40410836){
       //   printf("map_dense_vs_all\n");
@@ -1132,7 +1739,7 @@ unlock:
       // }
       if (degree <= NUM_IN_PLACE_NEIGHBORS) {
         while (local_idx < degree) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           if (f.update(v, self_index) == 1) {
             if (output) {
               output_vs.insert_dense(self_index);
@@ -1145,12 +1752,12 @@ unlock:
         }
       } else {
 #if PREFETCH
-        if (has_aux(self_index)) {
-          __builtin_prefetch(vertices[self_index].aux_neighbors);  
+        if (block.aux_neighbors != nullptr) {
+          __builtin_prefetch(block.aux_neighbors);  
         }
 #endif
         while (local_idx < NUM_IN_PLACE_NEIGHBORS) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           // if(v == 0){
           //   printf("self_index: %d\n", self_index);
           //   printf("v: %d\n", v);
@@ -1167,14 +1774,14 @@ unlock:
           ++local_idx;
 #if PREFETCH
           if (local_idx == NUM_IN_PLACE_NEIGHBORS/2) {
-        		if (has_aux(self_index)) {
-              __builtin_prefetch(((fl_container*)vertices[self_index].aux_neighbors)->get_root()); 
+        		if (block.aux_neighbors != nullptr) {
+              __builtin_prefetch(aux(block, self_index)->get_root()); 
             }
           }
 #endif
         }
         {
-          fl_container *hitree = (fl_container *)vertices[self_index].aux_neighbors;
+          fl_container *hitree = aux(block, self_index);
           struct HITREE_map_dense<F, VS> update_fn(output_vs, f, output, self_index, hitree);
           hitree->map_dense(update_fn);
         }
@@ -1182,14 +1789,14 @@ unlock:
     }
 
   template <class F, typename VS>
-    void LSGraph::map_dense_vs_not_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+    void LSGraph::map_dense_vs_not_all(const vertex_block &block, F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
       // printf("map_dense_vs_not_all\n");
       // vs.print(10);
-      uint32_t degree = vertices[self_index].degree;
+      uint32_t degree = block.degree;
       uint32_t local_idx = 0;
       if (degree <= NUM_IN_PLACE_NEIGHBORS) {
         while (local_idx < degree) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           if (vs.has_dense_no_all(v) && f.update(v, self_index) == 1) {
             if (output) {
               output_vs.insert_dense(self_index);
@@ -1202,12 +1809,12 @@ unlock:
         }
       } else {
 #if PREFETCH
-        if (has_aux(self_index)) {
-          __builtin_prefetch(vertices[self_index].aux_neighbors);  
+        if (block.aux_neighbors != nullptr) {
+          __builtin_prefetch(block.aux_neighbors);  
         }
 #endif
         while (local_idx < NUM_IN_PLACE_NEIGHBORS) {
-          auto v = vertices[self_index].neighbors[local_idx];
+          auto v = block.neighbors[local_idx];
           if (vs.has_dense_no_all(v) && f.update(v, self_index) == 1) {
             if (output) {
               output_vs.insert_dense(self_index);
@@ -1219,19 +1826,58 @@ unlock:
           ++local_idx;
 #if PREFETCH
           if (local_idx == NUM_IN_PLACE_NEIGHBORS/2) {
-        		if (has_aux(self_index)) {
-              __builtin_prefetch(((fl_container*)vertices[self_index].aux_neighbors)->get_root()); 
+        		if (block.aux_neighbors != nullptr) {
+              __builtin_prefetch(aux(block, self_index)->get_root()); 
             }
           }
 #endif
         }
         {
-          fl_container *hitree = (fl_container *)vertices[self_index].aux_neighbors;
+          fl_container *hitree = aux(block, self_index);
           struct HITREE_map_dense_no_all<F, VS> update_fn(vs, output_vs, f, output, self_index, hitree);
           hitree->map_dense(update_fn);
         }
       }
     }
+
+  // Read-only view of a versioned graph at a pinned version, with the part of
+  // the LSGraph interface the algorithms use.
+  class LSGraphView {
+    public:
+      typedef LSGraph::vertex vertex;
+
+      LSGraphView(LSGraph &graph, uint64_t version) : graph(graph), version(version) {}
+
+      uint32_t degree(const vertex v) const {
+        return graph.read_block(v, version).degree;
+      }
+
+      uint32_t get_num_vertices(void) const {
+        return graph.get_num_vertices();
+      }
+
+      template <class F, typename VS>
+      void map_sparse(F &f, VS &output_vs, uint32_t self_index, bool output) {
+        LSGraph::vertex_block block = graph.read_block(self_index, version);
+        graph.map_sparse(block, f, output_vs, self_index, output);
+      }
+
+      template <class F, typename VS>
+      void map_dense_vs_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+        LSGraph::vertex_block block = graph.read_block(self_index, version);
+        graph.map_dense_vs_all(block, f, vs, output_vs, self_index, output);
+      }
+
+      template <class F, typename VS>
+      void map_dense_vs_not_all(F &f, VS &vs, VS &output_vs, uint32_t self_index, bool output) {
+        LSGraph::vertex_block block = graph.read_block(self_index, version);
+        graph.map_dense_vs_not_all(block, f, vs, output_vs, self_index, output);
+      }
+
+    private:
+      LSGraph &graph;
+      uint64_t version;
+  };
 }
 
 
@@ -463,11 +463,7 @@ public:
       }
     } else {
       if (index_num_ == 0) {
-        for(auto i = 0 ; i < size_; i++){
-          if (compare(keys_[i], key)) {
-            return true;
-          }
-        }
+        return keys_find(keys_, size_, key) < size_;
       } else {
         // uint32_t block_num = keys_[0];
         // for (uint32_t i = 0; i < block_num; ++i) {
@@ -490,11 +486,7 @@ public:
           }
         }
         if (get_bid == false) block_id = block_num-1;
-        for (uint32_t j = 0; j < keys_[grain_kt*(block_id+index_num_)]; j++) {
-          if (compare(keys_[grain_kt*(block_id+index_num_) + j + 1], key)) {
-            return true;
-          }
-        }
+        return block_find(keys_ + grain_kt*(block_id+index_num_), key);
       }
       return false;
     }
@@ -563,38 +555,52 @@ public:
   }
 
   KT get_first_key() {
+    KT key = 0;
+    first_key(key);
+    return key;
+  }
+
+  // smallest key of the subtree, false if it is empty
+  bool first_key(KT& key) {
     auto keys_ = reinterpret_cast<KT*>(entries_);
     auto grain_kt = GRAIN / sizeof(KT);
     if(model_ != nullptr){
       for (auto i = 0; i < capacity_; i++){
         auto type = entry_type(i);
         if (type == Edge){
-          return keys_[i];
+          key = keys_[i];
+          return true;
         }else if (type == Block){
-          auto bsize = keys_[i];
-          for (auto j = 0; j < bsize; j++){
-            return keys_[i+j+1];
+          if (keys_[i] > 0) {
+            key = keys_[i+1];
+            return true;
           }
           i += (GRAIN / sizeof(KT) - 1);
         }else if(type == HTNode){
-          return entries_[i >> 1].child_->get_first_key();
+          // an emptied child is left in place by remove
+          if (entries_[i >> 1].child_->first_key(key)) {
+            return true;
+          }
           i += (GRAIN / sizeof(KT) - 1);
         }
       }
     }else{
       if (index_num_ == 0) {
-        for (auto i = 0; i < size_; i++) {
-          return keys_[i];
+        if (size_ > 0) {
+          key = keys_[0];
+          return true;
         }
       } else {
         uint32_t block_num = keys_[0];
         for (auto i = 0; i < block_num; ++i) {
-          for (auto j = 0; j < keys_[grain_kt * (i + index_num_)]; j++) {
-            return keys_[grain_kt * (i + index_num_) + j + 1];
+          if (keys_[grain_kt * (i + index_num_)] > 0) {
+            key = keys_[grain_kt * (i + index_num_) + 1];
+            return true;
           }
         }
       }
      }
+    return false;
   }
 
   void print_hitree(std::vector<uint32_t>&nei, int level = 0) {
@@ -743,7 +749,7 @@ public:
         uint32_t base = PALIGN_DOWN(idx, grain_kt);
         uint32_t res = block_remove(keys_ + base, key);
         size_sub_tree_ -= res;
-        if(keys_[0] == 0){
+        if(keys_[base] == 0){
           set_entry_grain(base, Unsued, grain_kt);
         }
         return res;
@@ -923,13 +929,17 @@ public:
         uint32_t block_addr = (index_num_ + b) * grain_kt;
         keys_[block_addr] =
             each_size + (b < (size % (be - bs + 1) + bs) ? 1 : 0);
-        keys_[1 + b] = ks[ks_idx];
+        if (keys_[block_addr] > 0) {
+            keys_[1 + b] = ks[ks_idx];
+        } else if (ks_idx > 0) {
+            // empty block, index it right after the keys before it
+            keys_[1 + b] = ks[ks_idx - 1] + 1;
+        }
         for (uint32_t i = 0; i < keys_[block_addr]; ++i) {
             keys_[block_addr + 1 + i] = ks[ks_idx++];
         }
     }
     delete[] ks;
-    size_++;
   }
 
 
@@ -1039,15 +1049,9 @@ public:
       // find
       if (index_num_ == 0) {
         if (size_ < capacity_) {
-          int32_t idx = std::lower_bound(keys_, keys_ + size_, k,
-                      [](const KT& kk, KT k) {
-                        return kk < k;
-                      }) - keys_;
-          
-          for(int32_t i = idx; i < size_; i++){
-            if (compare(keys_[i], k))
-              return;
-          }
+          // small node, a rank over all keys beats the binary search
+          int32_t idx = keys_rank(keys_, size_, k);
+          if (idx < size_ && compare(keys_[idx], k)) return;
           for (int32_t i = size_; i > idx; --i) {
             keys_[i] = keys_[i - 1];
           }
@@ -1088,9 +1092,7 @@ public:
         uint32_t block_addr = (index_num_+block_id) * grain_kt;
         uint32_t data_addr  = block_addr+1;
         uint32_t block_size = keys_[block_addr];
-        for(int32_t i = 0; i < block_size; i++){
-          if(compare(keys_[data_addr + i], k)) return ;
-        }
+        if (block_find(keys_ + block_addr, k)) return ;
         if (block_size < grain_kt-1) { // insert to current block
           bool ink = false;
           for (int32_t i = block_size-1; i >= 0; --i) {
@@ -1204,9 +1206,14 @@ public:
         if (type_i == Block) {
           i += ((GRAIN / sizeof(KT))-1);
         } else if (type_i == HTNode) {
-          if (entries_[i>>1].child_ != nullptr) {
-            delete entries_[i >> 1].child_;
-            entries_[i>>1].child_ = nullptr;
+          TNode<KT, VT>* child = entries_[i>>1].child_;
+          if (child != nullptr) {
+            // a child built over several grains is shared by all of them
+            for (uint32_t j = i; j < capacity_ && entry_type(j) == HTNode
+                 && entries_[j>>1].child_ == child; j += (GRAIN / sizeof(KT))) {
+              entries_[j>>1].child_ = nullptr;
+            }
+            delete child;
           }
           i += ((GRAIN / sizeof(KT))-1);
         }
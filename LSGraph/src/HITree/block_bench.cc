@@ -0,0 +1,118 @@
+// Micro-benchmark of the key search inside HITree blocks: lookups and sorted
+// inserts per block size, the scalar loops against the SIMD overloads of
+// simd.h picked at compile time.
+//
+// ./HITree-Bench [blocks] [rounds]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <set>
+
+#include "HITree.h"
+
+using namespace hitreespace;
+
+typedef uint32_t KT;
+
+const uint32_t kBlockKeys = GRAIN / sizeof(KT);
+
+#if defined(__AVX512F__)
+const char* kSimd = "AVX-512";
+#elif defined(__AVX2__)
+const char* kSimd = "AVX2";
+#else
+const char* kSimd = "none (scalar fallback)";
+#endif
+
+template <class F>
+double mops(uint64_t ops, F f) {
+  auto begin = std::chrono::high_resolution_clock::now();
+  f();
+  auto end = std::chrono::high_resolution_clock::now();
+  return ops / std::chrono::duration<double>(end - begin).count() / 1e6;
+}
+
+int main(int argc, char** argv) {
+  uint32_t num_blocks = argc > 1 ? atoi(argv[1]) : 4096;
+  uint32_t rounds = argc > 2 ? atoi(argv[2]) : 256;
+  uint64_t ops = (uint64_t)num_blocks * rounds;
+  std::mt19937 rng(1);
+
+  printf("SIMD: %s, %u blocks, %u rounds\n", kSimd, num_blocks, rounds);
+  KT* blocks = new(std::align_val_t{GRAIN}) KT[num_blocks * kBlockKeys];
+  KT* queries = new KT[num_blocks];
+
+  // blocks: size, then sorted keys
+  printf("%-6s %12s %12s %12s %12s %12s\n", "block", "find", "find-simd",
+         "rank", "rank-simd", "ins+rm-simd");
+  uint32_t sizes[] = {1, 2, 4, 8, 12, 15};
+  for (uint32_t size : sizes) {
+    for (uint32_t b = 0; b < num_blocks; ++b) {
+      KT* data = blocks + b * kBlockKeys;
+      std::set<KT> keys;
+      while (keys.size() < size) keys.insert(rng() % (size * 4));
+      data[0] = 0;
+      for (KT k : keys) data[++data[0]] = k;
+      // half of the lookups hit
+      queries[b] = (rng() & 1) ? data[1 + rng() % size] : rng() % (size * 4);
+    }
+
+    uint64_t hits[2] = {0, 0}, ranks[2] = {0, 0};
+    double find_s = mops(ops, [&] {
+      for (uint32_t r = 0; r < rounds; ++r)
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+          KT* data = blocks + b * kBlockKeys;
+          hits[0] += keys_find<KT>(data + 1, data[0], queries[b]) < data[0];
+        }
+    });
+    double find_v = mops(ops, [&] {
+      for (uint32_t r = 0; r < rounds; ++r)
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+          KT* data = blocks + b * kBlockKeys;
+          hits[1] += block_find(data, queries[b]);
+        }
+    });
+    double rank_s = mops(ops, [&] {
+      for (uint32_t r = 0; r < rounds; ++r)
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+          KT* data = blocks + b * kBlockKeys;
+          ranks[0] += keys_rank<KT>(data + 1, data[0], queries[b]);
+        }
+    });
+    double rank_v = mops(ops, [&] {
+      for (uint32_t r = 0; r < rounds; ++r)
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+          KT* data = blocks + b * kBlockKeys;
+          ranks[1] += keys_rank(data + 1, data[0], queries[b]);
+        }
+    });
+    // a key of the block goes out and in again, the block ends as it was. Removing
+    // first keeps a full block (15 keys) from rejecting the insert.
+    for (uint32_t b = 0; b < num_blocks; ++b) queries[b] = blocks[b * kBlockKeys + 1 + b % size];
+    uint64_t moved = 0;
+    double insert_v = mops(2 * ops, [&] {
+      for (uint32_t r = 0; r < rounds; ++r)
+        for (uint32_t b = 0; b < num_blocks; ++b) {
+          KT* data = blocks + b * kBlockKeys;
+          moved += block_remove(data, queries[b]);
+          moved += block_insert_sort(data, queries[b]);
+        }
+    });
+    if (hits[0] != hits[1] || ranks[0] != ranks[1]) {
+      printf("block %u: SIMD and scalar results differ\n", size);
+      return 1;
+    }
+    if (moved != 2 * ops) {
+      printf("block %u: %lu of %lu removes and inserts took effect\n", size, moved, 2 * ops);
+      return 1;
+    }
+    printf("%-6u %10.1fM %10.1fM %10.1fM %10.1fM %10.1fM\n", size, find_s, find_v,
+           rank_s, rank_v, insert_v);
+  }
+
+  ::operator delete[](blocks, std::align_val_t{GRAIN});
+  delete [] queries;
+  return 0;
+}
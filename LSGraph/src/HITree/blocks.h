@@ -3,6 +3,7 @@
 
 #include "iterator.h"
 #include "common.h"
+#include "simd.h"
 
 namespace hitreespace {
 
@@ -17,22 +18,15 @@ inline void make_block(KT* data, const KT* ks, uint32_t size) {
 
 template<typename KT>
 bool block_find(KT* data, KT key) {
-  for (uint32_t i = 0; i < data[0]; ++ i) {
-    if (compare(data[i+1], key)) {
-      return true;
-    }
-  }
-  return false;
+  return keys_find(data+1, data[0], key) < data[0];
 }
 
 template<typename KT>
 bool block_insert(KT* data, KT k) {
   uint32_t size = data[0];
   KT* data_ = data+1;
-  for (uint32_t i = 0; i < size; ++i) {
-    if (compare(data_[i], k)) {
-      return true;
-    }
+  if (keys_find(data_, size, k) < size) {
+    return true;
   }
   uint32_t capacity = (GRAIN / sizeof(KT)) - 1;
   if (size < capacity) {
@@ -46,18 +40,11 @@ bool block_insert(KT* data, KT k) {
 
 template<typename KT>
 uint32_t block_remove(KT* data, KT k) {
-  bool copy = false;
   uint32_t size = data[0];
   KT* data_ = data+1;
-  for (uint32_t i = 0; i < size; ++ i) {
-    if (compare(data_[i], k)) {
-      copy = true;
-    }
-    if (copy && i + 1 < size) {
-      data_[i] = data_[i + 1];
-    }
-  }
-  if (copy) {
+  uint32_t i = keys_find(data_, size, k);
+  if (i < size) {
+    memmove(data_ + i, data_ + i + 1, (size - i - 1) * sizeof(KT));
     data[0] --;
     return 1;
   } else {
@@ -71,29 +58,16 @@ bool block_insert_sort(KT* data, KT k) {
 
   uint32_t size = data[0];
   KT* data_ = data+1;
-  // must use int instead of uint32_t
-  for (int i = 0; i < size; ++i) {
-    if (compare(data_[i], k)) {
-      return true;
-    } else if (data_[i] > k) {
-      if (size >= capacity) return false;
-      // printf("%d %d\n", i, size);
-      for (int j = size-1; j >= i; --j){
-        data_[j+1] = data_[j];
-      } 
-      data_[i] = k;
-      data[0]++;
-      return true;
-    }
-  }
-
-  if (size < capacity) {
-    data_[size] = k;
-    data[0] ++;
+  if (keys_find(data_, size, k) < size) {
     return true;
-  } else {
-    return false;
   }
+  if (size >= capacity) return false;
+  // the block is sorted, the rank of k is its position
+  uint32_t i = keys_rank(data_, size, k);
+  memmove(data_ + i + 1, data_ + i, (size - i) * sizeof(KT));
+  data_[i] = k;
+  data[0]++;
+  return true;
 }
 }
 
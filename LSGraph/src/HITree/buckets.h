@@ -3,6 +3,7 @@
 
 #include "iterator.h"
 #include "common.h"
+#include "simd.h"
 
 namespace hitreespace {
 
@@ -34,35 +35,28 @@ public:
   inline uint8_t size() const { return size_; }
 
   ResultIterator<KT, VT> find(KT key) {
-    for (uint32_t i = 0; i < size_; ++ i) {
-      if (compare(data_[i].first, key)) {
-        return {&data_[i]};
-      }
+    uint32_t i = pairs_find(data_, size_, key);
+    if (i < size_) {
+      return {&data_[i]};
     }
     return {};
   }
 
   bool update(KVT kv) {
-    for (uint8_t i = 0; i < size_; ++ i) {
-      if (compare(data_[i].first, kv.first)) {
-        data_[i] = kv;
-        return true;
-      }
+    uint32_t i = pairs_find(data_, size_, kv.first);
+    if (i < size_) {
+      data_[i] = kv;
+      return true;
     }
     return false;
   }
 
   uint32_t remove(KT key) {
-    bool copy = false;
-    for (uint8_t i = 0; i < size_; ++ i) {
-      if (compare(data_[i].first, key)) {
-        copy = true;
-      }
-      if (copy && i + 1 < size_) {
+    uint32_t i = pairs_find(data_, size_, key);
+    if (i < size_) {
+      for (; i + 1 < size_; ++ i) {
         data_[i] = data_[i + 1];
       }
-    }
-    if (copy) {
       size_ --;
       return 1;
     } else {
@@ -71,10 +65,8 @@ public:
   }
 
   bool insert(KVT kv, const uint8_t capacity) {
-    for (uint32_t i = 0; i < size_; ++i) {
-      if (compare(data_[i].first, kv.first)) {
-        return true;
-      }
+    if (pairs_find(data_, size_, kv.first) < size_) {
+      return true;
     }
     if (size_ < capacity) {
       data_[size_] = kv;
@@ -0,0 +1,121 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "common.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace hitreespace {
+
+// Key search over short arrays: blocks, buckets and small dense nodes.
+// The templates are the scalar versions, 32-bit keys get AVX-512 or AVX2
+// overloads when the target has them (-march=native). Masked loads never
+// touch memory past size. Below SIMD_MIN_KEYS keys, and in the buckets (at
+// most kMaxBucketSize pairs), the scalar loop is as fast (see block_bench.cc).
+
+#define SIMD_MIN_KEYS 8
+
+// Position of key in keys[0, size), or size if it is not there
+template<typename KT>
+inline uint32_t keys_find(const KT* keys, uint32_t size, KT key) {
+  for (uint32_t i = 0; i < size; ++ i) {
+    if (compare(keys[i], key)) {
+      return i;
+    }
+  }
+  return size;
+}
+
+// Number of keys smaller than key in keys[0, size)
+template<typename KT>
+inline uint32_t keys_rank(const KT* keys, uint32_t size, KT key) {
+  uint32_t rank = 0;
+  for (uint32_t i = 0; i < size; ++ i) {
+    rank += (keys[i] < key);
+  }
+  return rank;
+}
+
+// Position of the pair with key in kvs[0, size), or size
+template<typename KT, typename VT>
+inline uint32_t pairs_find(const std::pair<KT, VT>* kvs, uint32_t size, KT key) {
+  for (uint32_t i = 0; i < size; ++ i) {
+    if (compare(kvs[i].first, key)) {
+      return i;
+    }
+  }
+  return size;
+}
+
+#if defined(__AVX512F__)
+
+inline __mmask16 simd_valid16(uint32_t left) {
+  return left >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << left) - 1);
+}
+
+inline uint32_t keys_find(const uint32_t* keys, uint32_t size, uint32_t key) {
+  if (size < SIMD_MIN_KEYS) return keys_find<uint32_t>(keys, size, key);
+  const __m512i k = _mm512_set1_epi32(key);
+  for (uint32_t i = 0; i < size; i += 16) {
+    __mmask16 valid = simd_valid16(size - i);
+    __m512i v = _mm512_maskz_loadu_epi32(valid, keys + i);
+    __mmask16 m = _mm512_mask_cmpeq_epi32_mask(valid, v, k);
+    if (m) return i + __builtin_ctz(m);
+  }
+  return size;
+}
+
+inline uint32_t keys_rank(const uint32_t* keys, uint32_t size, uint32_t key) {
+  if (size < SIMD_MIN_KEYS) return keys_rank<uint32_t>(keys, size, key);
+  const __m512i k = _mm512_set1_epi32(key);
+  uint32_t rank = 0;
+  for (uint32_t i = 0; i < size; i += 16) {
+    __mmask16 valid = simd_valid16(size - i);
+    __m512i v = _mm512_maskz_loadu_epi32(valid, keys + i);
+    rank += __builtin_popcount(_mm512_mask_cmplt_epu32_mask(valid, v, k));
+  }
+  return rank;
+}
+
+#elif defined(__AVX2__)
+
+inline __m256i simd_valid8(uint32_t left) {
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(std::min(left, 8u)), lane);
+}
+
+inline uint32_t keys_find(const uint32_t* keys, uint32_t size, uint32_t key) {
+  if (size < SIMD_MIN_KEYS) return keys_find<uint32_t>(keys, size, key);
+  const __m256i k = _mm256_set1_epi32(key);
+  for (uint32_t i = 0; i < size; i += 8) {
+    __m256i valid = simd_valid8(size - i);
+    __m256i v = _mm256_maskload_epi32(reinterpret_cast<const int*>(keys + i), valid);
+    __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi32(v, k), valid);
+    uint32_t m = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+    if (m) return i + __builtin_ctz(m);
+  }
+  return size;
+}
+
+inline uint32_t keys_rank(const uint32_t* keys, uint32_t size, uint32_t key) {
+  if (size < SIMD_MIN_KEYS) return keys_rank<uint32_t>(keys, size, key);
+  const __m256i k = _mm256_set1_epi32(key);
+  uint32_t rank = 0;
+  for (uint32_t i = 0; i < size; i += 8) {
+    __m256i valid = simd_valid8(size - i);
+    __m256i v = _mm256_maskload_epi32(reinterpret_cast<const int*>(keys + i), valid);
+    // unsigned v >= k iff max(v, k) == v
+    __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(v, k), v);
+    __m256i lt = _mm256_andnot_si256(ge, valid);
+    rank += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(lt)));
+  }
+  return rank;
+}
+
+#endif
+
+}
+
+#endif
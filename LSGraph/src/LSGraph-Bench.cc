@@ -65,68 +65,48 @@ long get_rss() {
 struct LSGraphTwoWay {
   LSGraph gin_;
   LSGraph gout_;
+  VersionClock clock_;
+  bool versioned_{false};
 
   LSGraphTwoWay(uint32_t size) : gin_(size), gout_(size) {}
 
-  void add_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
-    using Sequence = parlay::sequence<std::tuple<uint32_t, uint32_t>>;
-    Sequence& batch = updates;
-    
-    // 1. nested for, cilk will shcedule the both loops
-    // Sequence batch_in = batch; // copy, batchs will be sorted concurrently, so must copy
-    // parallel_for_1(size_t j=0; j<2; j++) {
-    //   if(j == 0) {
-    //     graph.add_edge_batch_sort(batch, batch.size(), nn, 2);
-    //   } else {
-    //     graph_in.add_edge_batch_sort(batch_in, batch_in.size(), nn, 2);
-    //   }
-    // }
-
-    // 2. serial, every graph use all threads, no need to copy
-    // Faster, use 2.
-
-    // auto& v = gout_.vertices[12];
-    // if(v.degree > 0 && v.neighbors[0] == 0) {
-    //   printf("(prev)Error: %d\n", v.degree);
-    //   printf("Batch: \n");
-    //   for (size_t i = 0; i < batch.size(); ++i) {
-    //     auto [s, d] = batch[i];
-    //     printf("%d\t%d\n", s, d);
-    //   }
-    //   exit(0);
-    // }
-    // printf("Add edge batch\n");
-    gout_.add_edge_batch_sort(batch, batch.size(), nn);
-    // if(v.degree > 0 && v.neighbors[0] == 0) {
-    //   printf("Error: %d\n", v.degree);
-    //   printf("Batch: \n");
-    //   for (size_t i = 0; i < batch.size(); ++i) {
-    //     auto [s, d] = batch[i];
-    //     printf("%d\t%d\n", s, d);
-    //   }
-    //   exit(0);
-    // }
-
-    // reverse batch
-    parallel_for (size_t i = 0; i < batch.size(); ++i) {
-      auto [s, d] = batch[i];
-      batch[i] = {d, s};
+  // Both graphs at the version pinned on construction, for BFS/PR/CC while
+  // the next batch goes in
+  struct Snapshot {
+    LSGraphTwoWay &graph;
+    uint32_t slot;
+    uint64_t version;
+    LSGraphView gin_;
+    LSGraphView gout_;
+
+    Snapshot(LSGraphTwoWay &graph) : graph(graph), version(graph.clock_.pin(slot)),
+                                     gin_(graph.gin_, version), gout_(graph.gout_, version) {}
+    ~Snapshot() { graph.clock_.unpin(slot); }
+
+    size_t get_num_vertices() {
+      return std::max(gin_.get_num_vertices(), gout_.get_num_vertices());
     }
+    LSGraphView& in() { return gin_; }
+    LSGraphView& out() { return gout_; }
+  };
+
+  // Keep versions for snapshots, cow_always saves them even without readers
+  void set_versioned(bool cow_always) {
+    clock_.cow_always = cow_always;
+    gin_.set_versioned(&clock_);
+    gout_.set_versioned(&clock_);
+    versioned_ = true;
+  }
 
-
-    gin_.add_edge_batch_sort(batch, batch.size(), nn);
-
-
-    // if(v.degree > 0 && v.neighbors[0] == 0) {
-    //   printf("Error: %d\n", v.degree);
-    //   printf("Batch: \n");
-    //   for (size_t i = 0; i < batch.size(); ++i) {
-    //     auto [s, d] = batch[i];
-    //     printf("%d\t%d\n", s, d);
-    //   }
-    //   exit(0);
-    // }
-
+  // one sort and one insertion loop for both graphs
+  void add_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
+    if (versioned_) {
+      clock_.begin_batch();
+    }
+    add_edge_batch_bidirectional(gout_, gin_, updates, edge_count, nn);
+    if (versioned_) {
+      clock_.end_batch();
+    }
   }
 
   size_t get_num_vertices() {
@@ -312,19 +292,48 @@ void run_algorithm(commandLine& P) {
   auto ts_transform = std::chrono::high_resolution_clock::now();
 
   // Batch ingest
+  // -versioned: every batch copies on write, the cost without readers
+  // -overlap: BFS on snapshots runs while the batches go in
   LSGraphTwoWay tgraph(num_nodes);
+  bool versioned = P.getOption("-versioned");
+  bool overlap = P.getOption("-overlap");
+  if (versioned || overlap) {
+    tgraph.set_versioned(versioned);
+  }
 
-  for(size_t i=0; i<batchs; i++) {
-    auto& batch = batch_data[i];
+  auto ingest = [&] {
+    for(size_t i=0; i<batchs; i++) {
+      auto& batch = batch_data[i];
 
-    tgraph.add_edge_batch_sort(batch, batch.size(), num_nodes);
+      tgraph.add_edge_batch_sort(batch, batch.size(), num_nodes);
 
-    if(i % info_batch == 0) {
-      auto ts = std::chrono::high_resolution_clock::now();
-      auto t = std::chrono::duration<double>(ts - ts_transform).count();
-      auto bw = (i+1) * batch_size / t / 1e6;
-      printf("Batch %ld/%ld, time: %.3fs, bandwith: %.2fM Edges/s\n", i+1, batchs, t, bw);
+      if(i % info_batch == 0) {
+        auto ts = std::chrono::high_resolution_clock::now();
+        auto t = std::chrono::duration<double>(ts - ts_transform).count();
+        auto bw = (i+1) * batch_size / t / 1e6;
+        printf("Batch %ld/%ld, time: %.3fs, bandwith: %.2fM Edges/s\n", i+1, batchs, t, bw);
+      }
     }
+  };
+
+  size_t overlap_bfs = 0;
+  if (overlap) {
+    std::atomic<bool> ingesting{true};
+    parallel_for_1 (int side = 0; side < 2; ++side) {
+      if (side == 0) {
+        ingest();
+        ingesting = false;
+      } else {
+        while (ingesting) {
+          LSGraphTwoWay::Snapshot snapshot(tgraph);
+          auto bfs_edge_map = BFS_xpgraph(snapshot, overlap_bfs % num_nodes);
+          delete [] bfs_edge_map;
+          overlap_bfs++;
+        }
+      }
+    }
+  } else {
+    ingest();
   }
   auto ts_ingest = std::chrono::high_resolution_clock::now();
   long rss_ingest = get_rss();
@@ -349,6 +358,9 @@ void run_algorithm(commandLine& P) {
   printf(EXPOUT "Load: %.4f\n", t_load);
   printf("\tTransform time: %.4f\n", t_transfrom);
   printf(EXPOUT "Ingest: %.4f\n", t_ingest);
+  if (overlap) {
+    printf(EXPOUT "Overlap BFS: %ld\n", overlap_bfs);
+  }
 
   printf(EXPOUT "BFS: %.4f\n", t_bfs);
   printf(EXPOUT "PR: %.4f\n", t_pr);
@@ -370,6 +382,6 @@ void run_algorithm(commandLine& P) {
 int main(int argc, char** argv) {
   srand(time(NULL));
   printf("Num workers: %ld\n", getWorkers());
-  commandLine P(argc, argv, "./graph_bm [-t testname -r rounds -f file");
+  commandLine P(argc, argv, "./graph_bm [-t testname -r rounds -f file -bs batch_size -versioned -overlap]");
   run_algorithm(P);
 }
\ No newline at end of file
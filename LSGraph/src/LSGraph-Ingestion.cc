@@ -43,6 +43,7 @@ using namespace graphstore;
 #include <sstream>
 #include <string>
 #include <unistd.h>
+#include <sys/stat.h>
 
 long get_rss() {
     std::ifstream stat_file("/proc/self/stat");
@@ -67,8 +68,27 @@ struct LSGraphTwoWay {
   LSGraph gout_;
 
   LSGraphTwoWay(uint32_t size) : gin_(size), gout_(size) {}
+  LSGraphTwoWay(std::string prefix) : gin_(prefix + ".in"), gout_(prefix + ".out") {}
 
+  void serialize(std::string prefix) {
+    gout_.serialize(prefix + ".out");
+    gin_.serialize(prefix + ".in");
+  }
+
+  void materialize_all() {
+    gout_.materialize_all();
+    gin_.materialize_all();
+  }
+
+  // one sort and one insertion loop for both graphs, the batch is left
+  // sorted by source
   void add_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
+    add_edge_batch_bidirectional(gout_, gin_, updates, edge_count, nn);
+  }
+
+  // baseline of add_edge_batch_sort, the graphs one after the other, the
+  // batch is left reversed
+  void add_edge_batch_twopass(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
     using Sequence = parlay::sequence<std::tuple<uint32_t, uint32_t>>;
     Sequence& batch = updates;
     
@@ -129,6 +149,26 @@ struct LSGraphTwoWay {
 
   }
 
+  // the graphs one after the other, the batch is left reversed
+  void remove_edge_batch_sort(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates, uint32_t edge_count, size_t nn) {
+    auto& batch = updates;
+    gout_.remove_edge_batch_sort(batch, batch.size(), nn);
+    parallel_for (size_t i = 0; i < batch.size(); ++i) {
+      auto [s, d] = batch[i];
+      batch[i] = {d, s};
+    }
+    gin_.remove_edge_batch_sort(batch, batch.size(), nn);
+  }
+
+  // per edge baseline of remove_edge_batch_sort
+  void remove_edges(parlay::sequence<std::tuple<uint32_t, uint32_t>> &updates) {
+    parallel_for (size_t i = 0; i < updates.size(); ++i) {
+      auto [s, d] = updates[i];
+      gout_.remove_edge(s, d);
+      gin_.remove_edge(d, s);
+    }
+  }
+
   size_t get_num_vertices() {
     auto n1 = gin_.get_num_vertices();
     auto n2 = gout_.get_num_vertices();
@@ -275,10 +315,45 @@ double test_bfs(G& GA, commandLine& P, long src) {
 
 #define EXPOUT "[EXPOUT]"
 
+long get_file_size(std::string filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) return 0;
+  return st.st_size;
+}
+
+// Maps a snapshot written by -save, then builds all of its HITrees
+void run_load(commandLine& P, std::string prefix) {
+  auto ts_begin = std::chrono::high_resolution_clock::now();
+  LSGraphTwoWay tgraph(prefix);
+  auto ts_map = std::chrono::high_resolution_clock::now();
+  tgraph.materialize_all();
+  auto ts_materialize = std::chrono::high_resolution_clock::now();
+
+  double t_map = std::chrono::duration<double>(ts_map - ts_begin).count();
+  double t_materialize = std::chrono::duration<double>(ts_materialize - ts_map).count();
+  long bytes = get_file_size(prefix + ".out.lsg") + get_file_size(prefix + ".in.lsg");
+
+  printf(EXPOUT "Snapshot: %s\n", prefix.c_str());
+  printf(EXPOUT "Vertex count: %ld\n", tgraph.get_num_vertices());
+  printf(EXPOUT "Edge count: %u\n", tgraph.out().get_num_edges());
+  printf(EXPOUT "Map: %.4f\n", t_map);
+  printf(EXPOUT "Materialize: %.4f\n", t_materialize);
+  printf("Load bandwidth: %.2fMB/s\n", bytes / (t_map + t_materialize) / 1e6);
+}
+
 void run_algorithm(commandLine& P) {
 	uint32_t num_nodes;
   uint64_t num_edges;
   auto filename = P.getOptionValue("-f", "none");
+  auto load_prefix = P.getOptionValue("-load", "");
+  auto save_prefix = P.getOptionValue("-save", "");
+  auto delete_mode = P.getOptionValue("-delete", ""); // batch or edge
+  bool twopass = P.getOption("-twopass"); // out- then in-graph, each sorting the batch
+
+  if (load_prefix != "") {
+    run_load(P, load_prefix);
+    return;
+  }
 
   auto ts_begin = std::chrono::high_resolution_clock::now();
 
@@ -317,7 +392,11 @@ void run_algorithm(commandLine& P) {
   for(size_t i=0; i<batchs; i++) {
     auto& batch = batch_data[i];
 
-    tgraph.add_edge_batch_sort(batch, batch.size(), num_nodes);
+    if (twopass) {
+      tgraph.add_edge_batch_twopass(batch, batch.size(), num_nodes);
+    } else {
+      tgraph.add_edge_batch_sort(batch, batch.size(), num_nodes);
+    }
 
     if(i % info_batch == 0) {
       auto ts = std::chrono::high_resolution_clock::now();
@@ -341,6 +420,42 @@ void run_algorithm(commandLine& P) {
 
   double bw_ingest = num_edges / t_ingest / 1e6;
   printf("Ingest bandwidth: %.4fM Edges/s\n", bw_ingest);
+
+  if (save_prefix != "") {
+    auto ts_save_begin = std::chrono::high_resolution_clock::now();
+    tgraph.serialize(save_prefix);
+    auto ts_save = std::chrono::high_resolution_clock::now();
+    double t_save = std::chrono::duration<double>(ts_save - ts_save_begin).count();
+    long bytes = get_file_size(save_prefix + ".out.lsg") + get_file_size(save_prefix + ".in.lsg");
+    printf(EXPOUT "Save: %.4f\n", t_save);
+    printf("Save bandwidth: %.2fMB/s\n", bytes / t_save / 1e6);
+    run_load(P, save_prefix);
+  }
+
+  if (delete_mode != "") {
+    // delete every ingested edge again, in the same batches
+    auto ts_delete_begin = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<batchs; i++) {
+      auto& batch = batch_data[i];
+      // the two-pass ingest left the batch reversed
+      if (twopass) {
+        parallel_for (size_t j = 0; j < batch.size(); ++j) {
+          auto [s, d] = batch[j];
+          batch[j] = {d, s};
+        }
+      }
+      if (delete_mode == "edge") {
+        tgraph.remove_edges(batch);
+      } else {
+        tgraph.remove_edge_batch_sort(batch, batch.size(), num_nodes);
+      }
+    }
+    auto ts_delete = std::chrono::high_resolution_clock::now();
+    double t_delete = std::chrono::duration<double>(ts_delete - ts_delete_begin).count();
+    printf(EXPOUT "Delete(%s): %.4f\n", delete_mode.c_str(), t_delete);
+    printf("Delete bandwidth: %.4fM Edges/s\n", num_edges / t_delete / 1e6);
+    printf("Edges left: %u\n", tgraph.out().get_num_edges());
+  }
 }
 
 /* 
@@ -352,6 +467,6 @@ void run_algorithm(commandLine& P) {
 int main(int argc, char** argv) {
   srand(time(NULL));
   printf("Num workers: %ld\n", getWorkers());
-  commandLine P(argc, argv, "./graph_bm [-t testname -r rounds -f file");
+  commandLine P(argc, argv, "./graph_bm [-t testname -r rounds -f file -bs batch_size -save prefix -load prefix -delete batch|edge -twopass]");
   run_algorithm(P);
 }
\ No newline at end of file
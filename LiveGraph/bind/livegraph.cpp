@@ -19,8 +19,13 @@
 using namespace lg;
 namespace impl = livegraph;
 
-Graph::Graph(std::string block_path, std::string wal_path, size_t max_block_size, vertex_t max_vertex_id)
-    : graph(std::make_unique<impl::Graph>(block_path, wal_path, max_block_size, max_vertex_id))
+Graph::Graph(std::string block_path,
+             std::string wal_path,
+             size_t max_block_size,
+             vertex_t max_vertex_id,
+             bool huge_pages,
+             bool numa_aware)
+    : graph(std::make_unique<impl::Graph>(block_path, wal_path, max_block_size, max_vertex_id, huge_pages, numa_aware))
 {
 }
 
@@ -28,8 +33,19 @@ Graph::~Graph() = default;
 
 vertex_t Graph::get_max_vertex_id() const { return graph->get_max_vertex_id(); }
 
+std::pair<size_t, size_t> Graph::get_block_allocation_stats() { return graph->get_block_allocation_stats(); }
+
+void Graph::set_columnar_label(label_t label) { graph->set_columnar_label(label); }
+
+std::pair<size_t, size_t> Graph::get_edge_block_usage(label_t label) { return graph->get_edge_block_usage(label); }
+
 timestamp_t Graph::compact(timestamp_t read_epoch_id) { return graph->compact(read_epoch_id); }
 
+Snapshot Graph::export_snapshot(label_t label, timestamp_t read_epoch_id, bool with_edge_data)
+{
+    return std::make_unique<impl::Snapshot>(graph->export_snapshot(label, read_epoch_id, with_edge_data));
+}
+
 Transaction Graph::begin_transaction() { return std::make_unique<impl::Transaction>(graph->begin_transaction()); }
 
 Transaction Graph::begin_read_only_transaction()
@@ -95,6 +111,11 @@ bool Transaction::del_edge(vertex_t src, label_t label, vertex_t dst)
     }
 }
 
+void Transaction::bulk_put_edges(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges)
+{
+    txn->bulk_put_edges(label, edges, num_edges);
+}
+
 std::string_view Transaction::get_vertex(vertex_t vertex_id) { return txn->get_vertex(vertex_id); }
 
 std::string_view Transaction::get_edge(vertex_t src, label_t label, vertex_t dst)
@@ -122,3 +143,43 @@ void EdgeIterator::next() { iter->next(); }
 vertex_t EdgeIterator::dst_id() const { return iter->dst_id(); }
 
 std::string_view EdgeIterator::edge_data() const { return iter->edge_data(); }
+
+Snapshot::Snapshot(std::unique_ptr<livegraph::Snapshot> _snapshot) : snapshot(std::move(_snapshot)) {}
+
+Snapshot::Snapshot(Snapshot &&) = default;
+
+Snapshot::~Snapshot() = default;
+
+label_t Snapshot::get_label() const { return snapshot->get_label(); }
+
+timestamp_t Snapshot::get_read_epoch_id() const { return snapshot->get_read_epoch_id(); }
+
+vertex_t Snapshot::get_num_vertices() const { return snapshot->get_num_vertices(); }
+
+size_t Snapshot::get_num_edges() const { return snapshot->get_num_edges(); }
+
+size_t Snapshot::get_degree(vertex_t src) const { return snapshot->get_degree(src); }
+
+const size_t *Snapshot::get_offsets() const { return snapshot->get_offsets(); }
+
+const vertex_t *Snapshot::get_dsts() const { return snapshot->get_dsts(); }
+
+SnapshotEdgeIterator Snapshot::get_edges(vertex_t src) const
+{
+    return std::make_unique<impl::SnapshotEdgeIterator>(snapshot->get_edges(src));
+}
+
+SnapshotEdgeIterator::SnapshotEdgeIterator(std::unique_ptr<livegraph::SnapshotEdgeIterator> _iter)
+    : iter(std::move(_iter))
+{
+}
+
+SnapshotEdgeIterator::~SnapshotEdgeIterator() = default;
+
+bool SnapshotEdgeIterator::valid() const { return iter->valid(); }
+
+void SnapshotEdgeIterator::next() { iter->next(); }
+
+vertex_t SnapshotEdgeIterator::dst_id() const { return iter->dst_id(); }
+
+std::string_view SnapshotEdgeIterator::edge_data() const { return iter->edge_data(); }
@@ -20,12 +20,15 @@
 #include <memory>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 
 namespace livegraph
 {
     class Graph;
     class Transaction;
     class EdgeIterator;
+    class Snapshot;
+    class SnapshotEdgeIterator;
 } // namespace livegraph
 
 namespace lg
@@ -36,6 +39,8 @@ namespace lg
     using timestamp_t = int64_t;
 
     class EdgeIterator;
+    class Snapshot;
+    class SnapshotEdgeIterator;
     class Transaction;
 
     class Graph
@@ -44,13 +49,24 @@ namespace lg
         Graph(std::string block_path = "",
               std::string wal_path = "",
               size_t max_block_size = 1ul << 40,
-              vertex_t max_vertex_id = 1ul << 40);
+              vertex_t max_vertex_id = 1ul << 40,
+              bool huge_pages = false,
+              bool numa_aware = false);
         ~Graph();
 
         vertex_t get_max_vertex_id() const;
 
+        std::pair<size_t, size_t> get_block_allocation_stats();
+
+        void set_columnar_label(label_t label);
+        std::pair<size_t, size_t> get_edge_block_usage(label_t label);
+
         timestamp_t compact(timestamp_t read_epoch_id = NO_TRANSACTION);
 
+        Snapshot export_snapshot(label_t label,
+                                 timestamp_t read_epoch_id = NO_TRANSACTION,
+                                 bool with_edge_data = false);
+
         Transaction begin_transaction();
         Transaction begin_read_only_transaction();
         Transaction begin_batch_loader();
@@ -81,6 +97,7 @@ namespace lg
 
         void put_edge(vertex_t src, label_t label, vertex_t dst, std::string_view edge_data, bool force_insert = false);
         bool del_edge(vertex_t src, label_t label, vertex_t dst);
+        void bulk_put_edges(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges);
 
         std::string_view get_vertex(vertex_t vertex_id);
         std::string_view get_edge(vertex_t src, label_t label, vertex_t dst);
@@ -108,4 +125,42 @@ namespace lg
         const std::unique_ptr<livegraph::EdgeIterator> iter;
     };
 
+    class Snapshot
+    {
+    public:
+        Snapshot(std::unique_ptr<livegraph::Snapshot> _snapshot);
+        Snapshot(Snapshot &&);
+        ~Snapshot();
+
+        label_t get_label() const;
+        timestamp_t get_read_epoch_id() const;
+        vertex_t get_num_vertices() const;
+        size_t get_num_edges() const;
+        size_t get_degree(vertex_t src) const;
+
+        // CSR arrays: the edges of src are get_dsts()[get_offsets()[src], get_offsets()[src + 1])
+        const size_t *get_offsets() const;
+        const vertex_t *get_dsts() const;
+
+        SnapshotEdgeIterator get_edges(vertex_t src) const;
+
+    private:
+        std::unique_ptr<livegraph::Snapshot> snapshot;
+    };
+
+    class SnapshotEdgeIterator
+    {
+    public:
+        SnapshotEdgeIterator(std::unique_ptr<livegraph::SnapshotEdgeIterator> _iter);
+        ~SnapshotEdgeIterator();
+
+        bool valid() const;
+        void next();
+        vertex_t dst_id() const;
+        std::string_view edge_data() const;
+
+    private:
+        const std::unique_ptr<livegraph::SnapshotEdgeIterator> iter;
+    };
+
 } // namespace lg
@@ -15,32 +15,51 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
+#include <fstream>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <tbb/enumerable_thread_specific.h>
 
 #include <fcntl.h>
+#include <linux/magic.h>
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #include "types.hpp"
 
 namespace livegraph
 {
+    // Blocks live in one reserved region addressed by offsets. With numa_aware the region is split into one
+    // partition per NUMA node, each bound to its node with its own bump pointer and free lists. A block is taken
+    // from the partition of the block it replaces, so a vertex keeps its blocks on one node, or from the
+    // allocating thread's node for a new vertex. With huge_pages the anonymous region is backed by transparent
+    // huge pages; a file-backed region must live on hugetlbfs to get explicit huge pages.
     class BlockManager
     {
     public:
         constexpr static uintptr_t NULLPOINTER = 0; // UINTPTR_MAX;
 
-        BlockManager(std::string path, size_t _capacity = 1ul << 40)
+        BlockManager(std::string path, size_t _capacity = 1ul << 40, bool huge_pages = false, bool numa_aware = false)
             : capacity(_capacity),
+              num_nodes(numa_aware ? count_usable_nodes(_capacity) : 1),
+              partition_size((capacity / num_nodes) & ~(HUGE_PAGE_SIZE - 1)),
               mutex(),
               free_blocks(std::vector<std::vector<uintptr_t>>(LARGE_BLOCK_THRESHOLD, std::vector<uintptr_t>())),
-              large_free_blocks(MAX_ORDER, std::vector<uintptr_t>())
+              nodes(new Node[num_nodes]),
+              arenas(std::make_pair(NULLPOINTER, NULLPOINTER)),
+              thread_nodes(NO_NODE),
+              allocation_stats(std::make_pair(0ul, 0ul))
         {
             if (path.empty())
             {
@@ -55,6 +74,12 @@ namespace livegraph
                 fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0640);
                 if (fd == EMPTY_FD)
                     throw std::runtime_error("open block file error.");
+                struct statfs fs;
+                if (huge_pages && (fstatfs(fd, &fs) != 0 || fs.f_type != HUGETLBFS_MAGIC))
+                {
+                    close(fd);
+                    throw std::runtime_error("huge pages need an anonymous block region or a hugetlbfs block file.");
+                }
                 if (ftruncate(fd, FILE_TRUNC_SIZE) != 0)
                     throw std::runtime_error("ftruncate block file error.");
                 data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
@@ -65,10 +90,19 @@ namespace livegraph
             if (madvise(data, capacity, MADV_RANDOM) != 0)
                 throw std::runtime_error("madvise block error.");
 
+            if (huge_pages && fd == EMPTY_FD && madvise(data, capacity, MADV_HUGEPAGE) != 0)
+                throw std::runtime_error("madvise huge page error.");
+
+            for (int node = 0; node < num_nodes; node++)
+            {
+                nodes[node].used_size = node * partition_size;
+                if (num_nodes > 1)
+                    bind_to_node(node * partition_size, partition_size, node);
+            }
+
             file_size = FILE_TRUNC_SIZE;
-            used_size = 0;
 
-            null_holder = alloc(LARGE_BLOCK_THRESHOLD);
+            null_holder = bump(1ul << LARGE_BLOCK_THRESHOLD, 0);
         }
 
         ~BlockManager()
@@ -80,53 +114,77 @@ namespace livegraph
                 close(fd);
         }
 
-        uintptr_t alloc(order_t order)
+        // near: the block being replaced, if any; the new block is placed on its node
+        uintptr_t alloc(order_t order, uintptr_t near = NULLPOINTER)
         {
+            auto thread_node = get_thread_node();
+            auto node = near == NULLPOINTER ? thread_node : get_block_node(near);
             uintptr_t pointer = NULLPOINTER;
-            if (order < LARGE_BLOCK_THRESHOLD)
-            {
+            if (order < LARGE_BLOCK_THRESHOLD && node == thread_node)
                 pointer = pop(free_blocks.local(), order);
-            }
-            else
+
+            if (pointer == NULLPOINTER)
             {
-                std::lock_guard<std::mutex> lock(mutex);
-                pointer = pop(large_free_blocks, order);
+                std::lock_guard<std::mutex> lock(nodes[node].mutex);
+                pointer = pop(nodes[node].free_blocks, order);
             }
 
             if (pointer == NULLPOINTER)
+                pointer = bump(1ul << order, node);
+
+            count_allocation(pointer, thread_node);
+
+            return pointer;
+        }
+
+        // Allocate from the calling thread's arena without touching the free lists.
+        // Used by bulk loading, where blocks are sized once and never grow.
+        uintptr_t alloc_from_arena(order_t order)
+        {
+            auto node = get_thread_node();
+            size_t block_size = 1ul << order;
+            if (order >= LARGE_BLOCK_THRESHOLD)
             {
-                size_t block_size = 1ul << order;
-                pointer = used_size.fetch_add(block_size);
+                auto pointer = bump(block_size, node);
+                count_allocation(pointer, node);
+                return pointer;
+            }
 
-                if (pointer + block_size >= file_size)
+            auto &[cursor, end] = arenas.local();
+            if (cursor + block_size > end)
+            {
+                // Recycle the tail of the exhausted arena into the local free lists
+                auto &local_free_blocks = free_blocks.local();
+                for (order_t tail_order = LARGE_BLOCK_THRESHOLD - 1; tail_order >= MIN_ARENA_ORDER; tail_order--)
                 {
-                    auto new_file_size = ((pointer + block_size) / FILE_TRUNC_SIZE + 1) * FILE_TRUNC_SIZE;
-                    std::lock_guard<std::mutex> lock(mutex);
-                    if (new_file_size >= file_size)
+                    while (cursor + (1ul << tail_order) <= end)
                     {
-                        if (fd != EMPTY_FD)
-                        {
-                            if (ftruncate(fd, new_file_size) != 0)
-                                throw std::runtime_error("ftruncate block file error.");
-                        }
-                        file_size = new_file_size;
+                        push(local_free_blocks, tail_order, cursor);
+                        cursor += 1ul << tail_order;
                     }
                 }
+                cursor = bump(ARENA_SIZE, node);
+                end = cursor + ARENA_SIZE;
             }
 
+            auto pointer = cursor;
+            cursor += block_size;
+            count_allocation(pointer, node);
             return pointer;
         }
 
         void free(uintptr_t block, order_t order)
         {
-            if (order < LARGE_BLOCK_THRESHOLD)
+            // Large blocks and blocks of another node go back to the free lists of their node
+            auto node = get_block_node(block);
+            if (order < LARGE_BLOCK_THRESHOLD && node == get_thread_node())
             {
                 push(free_blocks.local(), order, block);
             }
             else
             {
-                std::lock_guard<std::mutex> lock(mutex);
-                push(large_free_blocks, order, block);
+                std::lock_guard<std::mutex> lock(nodes[node].mutex);
+                push(nodes[node].free_blocks, order, block);
             }
         }
 
@@ -137,16 +195,119 @@ namespace livegraph
             return reinterpret_cast<T *>(reinterpret_cast<char *>(data) + block);
         }
 
+        int get_num_nodes() const { return num_nodes; }
+
+        // Allocations served from the allocating thread's node and from other nodes
+        std::pair<size_t, size_t> get_allocation_stats()
+        {
+            size_t local = 0, remote = 0;
+            for (const auto &[thread_local_allocs, thread_remote_allocs] : allocation_stats)
+            {
+                local += thread_local_allocs;
+                remote += thread_remote_allocs;
+            }
+            return {local, remote};
+        }
+
     private:
+        struct Node
+        {
+            std::atomic<size_t> used_size;
+            std::mutex mutex;
+            std::vector<std::vector<uintptr_t>> free_blocks = std::vector<std::vector<uintptr_t>>(MAX_ORDER);
+        };
+
         const size_t capacity;
+        const int num_nodes;
+        const size_t partition_size;
         int fd;
         void *data;
         std::mutex mutex;
         tbb::enumerable_thread_specific<std::vector<std::vector<uintptr_t>>> free_blocks;
-        std::vector<std::vector<uintptr_t>> large_free_blocks;
-        std::atomic<size_t> used_size, file_size;
+        std::unique_ptr<Node[]> nodes;
+        std::atomic<size_t> file_size;
         uintptr_t null_holder;
 
+        tbb::enumerable_thread_specific<std::pair<uintptr_t, uintptr_t>> arenas; // cursor, end
+        tbb::enumerable_thread_specific<int> thread_nodes;
+        tbb::enumerable_thread_specific<std::pair<size_t, size_t>> allocation_stats; // local, remote
+
+        // Online nodes, or a single node when the region is too small to give each node a huge page
+        static int count_usable_nodes(size_t capacity)
+        {
+            // Format: "0" or "0-3"
+            std::ifstream online("/sys/devices/system/node/online");
+            std::string range;
+            if (!std::getline(online, range) || range.empty())
+                return 1;
+            auto dash = range.find_last_of("-,");
+            auto num_nodes = std::max(1, std::stoi(dash == std::string::npos ? range : range.substr(dash + 1)) + 1);
+            return capacity / num_nodes >= HUGE_PAGE_SIZE ? num_nodes : 1;
+        }
+
+        int get_thread_node()
+        {
+            if (num_nodes == 1)
+                return 0;
+            auto &node = thread_nodes.local();
+            if (node == NO_NODE)
+            {
+                unsigned cpu = 0, cpu_node = 0;
+                if (syscall(SYS_getcpu, &cpu, &cpu_node, nullptr) != 0)
+                    cpu_node = 0;
+                node = std::min<int>(cpu_node, num_nodes - 1);
+            }
+            return node;
+        }
+
+        int get_block_node(uintptr_t block) const
+        {
+            return num_nodes == 1 ? 0 : std::min<int>(block / partition_size, num_nodes - 1);
+        }
+
+        void count_allocation(uintptr_t block, int node)
+        {
+            auto &[local, remote] = allocation_stats.local();
+            if (get_block_node(block) == node)
+                local++;
+            else
+                remote++;
+        }
+
+        void bind_to_node(uintptr_t begin, size_t length, int node)
+        {
+            unsigned long nodemask = 1ul << node;
+            if (syscall(SYS_mbind, reinterpret_cast<char *>(data) + begin, length, MPOL_PREFERRED, &nodemask,
+                        sizeof(nodemask) * 8, 0) != 0)
+                throw std::runtime_error("mbind block error.");
+        }
+
+        uintptr_t bump(size_t block_size, int node)
+        {
+            uintptr_t pointer = nodes[node].used_size.fetch_add(block_size);
+
+            auto limit = node + 1 == num_nodes ? capacity : (node + 1) * partition_size;
+            if (pointer + block_size > limit)
+                throw std::runtime_error("Block region exhausted.");
+
+            if (pointer + block_size >= file_size)
+            {
+                auto new_file_size = ((pointer + block_size) / FILE_TRUNC_SIZE + 1) * FILE_TRUNC_SIZE;
+                std::lock_guard<std::mutex> lock(mutex);
+                if (new_file_size >= file_size)
+                {
+                    if (fd != EMPTY_FD)
+                    {
+                        if (ftruncate(fd, new_file_size) != 0)
+                            throw std::runtime_error("ftruncate block file error.");
+                    }
+                    file_size = new_file_size;
+                }
+            }
+
+            return pointer;
+        }
+
         uintptr_t pop(std::vector<std::vector<uintptr_t>> &free_block, order_t order)
         {
             uintptr_t pointer = NULLPOINTER;
@@ -167,6 +328,10 @@ namespace livegraph
         constexpr static order_t MAX_ORDER = 64;
         constexpr static order_t LARGE_BLOCK_THRESHOLD = 20;
         constexpr static size_t FILE_TRUNC_SIZE = 1ul << 30; // 1GB
+        constexpr static size_t ARENA_SIZE = 1ul << 24;      // 16MB
+        constexpr static order_t MIN_ARENA_ORDER = 5;        // smallest block header
+        constexpr static size_t HUGE_PAGE_SIZE = 1ul << 21;  // 2MB
+        constexpr static int NO_NODE = -1;
     };
 
     class BlockManagerLibc
@@ -174,7 +339,7 @@ namespace livegraph
     public:
         constexpr static uintptr_t NULLPOINTER = UINTPTR_MAX;
 
-        uintptr_t alloc(order_t order)
+        uintptr_t alloc(order_t order, uintptr_t near = NULLPOINTER)
         {
             auto p = aligned_alloc(1ul << order, 1ul << order);
             if (!p)
@@ -33,7 +33,8 @@ namespace livegraph
             VERTEX,
             EDGE,
             EDGE_LABEL,
-            SPECIAL
+            SPECIAL,
+            COLUMNAR_EDGE
         };
 
         order_t get_order() const { return order; }
@@ -224,7 +225,8 @@ namespace livegraph
         timestamp_t deletion_time;
     };
 
-    class EdgeBlockHeader : public N2OBlockHeader
+    // Fields shared by the row-wise and the columnar edge block layouts
+    class EdgeBlockCommonHeader : public N2OBlockHeader
     {
     public:
         timestamp_t get_committed_time() const { return committed_time; }
@@ -237,28 +239,17 @@ namespace livegraph
 
         void set_data_length(size_t data_length) { this->tail.data.data_length = data_length; }
 
-        const char *get_data() const { return data; }
-
-        char *get_data() { return data; }
-
         size_t get_num_entries() const { return tail.data.num_entries; }
 
         void set_num_entries(size_t num_entries) { this->tail.data.num_entries = num_entries; }
 
-        const EdgeEntry *get_entries() const
-        {
-            size_t block_size = get_block_size();
-            if (get_order() >= BLOOM_FILTER_THRESHOLD)
-                block_size -= block_size >> BLOOM_FILTER_PORTION;
-            return (EdgeEntry *)((uint8_t *)this + block_size);
-        }
+        bool is_columnar() const { return get_type() == Type::COLUMNAR_EDGE; }
 
-        EdgeEntry *get_entries()
+        size_t get_bloom_filter_size() const
         {
-            size_t block_size = get_block_size();
-            if (get_order() >= BLOOM_FILTER_THRESHOLD)
-                block_size -= block_size >> BLOOM_FILTER_PORTION;
-            return (EdgeEntry *)((uint8_t *)this + block_size);
+            if (get_order() < BLOOM_FILTER_THRESHOLD)
+                return 0;
+            return get_block_size() >> BLOOM_FILTER_PORTION;
         }
 
         const BloomFilter get_bloom_filter() const
@@ -279,6 +270,86 @@ namespace livegraph
             return BloomFilter(get_order() - BLOOM_FILTER_PORTION, ((uint8_t *)this) + block_size - bloom_filter_size);
         }
 
+        void set_num_entries_data_length_atomic(size_t num_entries, size_t data_length)
+        {
+            Int128Union new_val;
+            new_val.data.num_entries = num_entries;
+            new_val.data.data_length = data_length;
+            // _mm_store_si128(&tail.m128i, new_val.m128i);
+            // should be inlined as "lock cmpxchg16b"
+            while (!__sync_bool_compare_and_swap(&tail.int128, tail.int128, new_val.int128))
+                _mm_pause();
+        }
+
+        std::pair<size_t, size_t> get_num_entries_data_length_atomic()
+        {
+            // Int128Union new_val, cur_val;
+            // should be inlined as "lock cmpxchg16b"
+            // cur_val.int128 = __sync_val_compare_and_swap(&tail.int128, new_val.int128, tail.int128);
+            Int128Union cur_val;
+            cur_val.m128i = _mm_load_si128(&tail.m128i);
+            return std::make_pair(cur_val.data.num_entries, cur_val.data.data_length);
+        }
+
+        // Adds the bloom filter to a block holding size bytes of header and entries, returns the order
+        static order_t size_to_order_with_bloom_filter(size_t size)
+        {
+            auto order = size_to_order(size);
+            if (order > BLOOM_FILTER_PORTION &&
+                size + (1ul << (order - BLOOM_FILTER_PORTION)) >= (1ul << BLOOM_FILTER_THRESHOLD))
+            {
+                size += 1ul << (order - BLOOM_FILTER_PORTION);
+            }
+            return size_to_order(size);
+        }
+
+        constexpr static order_t BLOOM_FILTER_THRESHOLD = 10;
+        constexpr static order_t BLOOM_FILTER_PORTION = 4;
+
+    protected:
+        void fill(order_t order,
+                  Type type,
+                  vertex_t vid,
+                  timestamp_t creation_time,
+                  uintptr_t prev_pointer,
+                  timestamp_t committed_time)
+        {
+            N2OBlockHeader::fill(order, type, vid, creation_time, prev_pointer);
+            set_committed_time(committed_time);
+            set_num_entries(0);
+            set_data_length(0);
+            auto filter = get_bloom_filter();
+            if (filter.valid())
+                filter.clear();
+        }
+
+    private:
+        timestamp_t committed_time;
+        union alignas(16) Int128Union {
+            struct
+            {
+                size_t num_entries;
+                size_t data_length;
+            } data;
+            __int128 int128;
+            __m128i m128i;
+        } tail;
+    };
+
+    class EdgeBlockHeader : public EdgeBlockCommonHeader
+    {
+    public:
+        const char *get_data() const { return data; }
+
+        char *get_data() { return data; }
+
+        const EdgeEntry *get_entries() const
+        {
+            return (EdgeEntry *)((uint8_t *)this + get_block_size() - get_bloom_filter_size());
+        }
+
+        EdgeEntry *get_entries() { return (EdgeEntry *)((uint8_t *)this + get_block_size() - get_bloom_filter_size()); }
+
         void clear()
         {
             set_num_entries(0);
@@ -290,14 +361,8 @@ namespace livegraph
 
         bool has_space(EdgeEntry entry, size_t num_entries, size_t data_length) const
         {
-            size_t block_size = get_block_size();
-            size_t bloom_filter_size;
-            if (get_order() < BLOOM_FILTER_THRESHOLD)
-                bloom_filter_size = 0;
-            else
-                bloom_filter_size = block_size >> BLOOM_FILTER_PORTION;
             if (sizeof(*this) + (num_entries + 1) * sizeof(entry) + data_length + entry.get_length() +
-                    bloom_filter_size >
+                    get_bloom_filter_size() >
                 get_block_size())
                 return false;
             else
@@ -340,50 +405,84 @@ namespace livegraph
             return get_entries() - num - 1;
         }
 
-        void set_num_entries_data_length_atomic(size_t num_entries, size_t data_length)
+        void
+        fill(order_t order, vertex_t vid, timestamp_t creation_time, uintptr_t prev_pointer, timestamp_t committed_time)
         {
-            Int128Union new_val;
-            new_val.data.num_entries = num_entries;
-            new_val.data.data_length = data_length;
-            // _mm_store_si128(&tail.m128i, new_val.m128i);
-            // should be inlined as "lock cmpxchg16b"
-            while (!__sync_bool_compare_and_swap(&tail.int128, tail.int128, new_val.int128))
-                _mm_pause();
+            EdgeBlockCommonHeader::fill(order, Type::EDGE, vid, creation_time, prev_pointer, committed_time);
         }
 
-        std::pair<size_t, size_t> get_num_entries_data_length_atomic()
+    private:
+        char data[0];
+    };
+
+    // Edge block for labels without edge data: destinations, creation and deletion times are kept in three
+    // separate arrays, so a scan of a fully visible block only touches the destinations.
+    class ColumnarEdgeBlockHeader : public EdgeBlockCommonHeader
+    {
+    public:
+        // Latest creation time of any entry, committed together with the entries
+        timestamp_t get_max_creation_time() const { return max_creation_time; }
+
+        timestamp_t *get_max_creation_time_pointer() { return &max_creation_time; }
+
+        void set_max_creation_time(timestamp_t max_creation_time) { this->max_creation_time = max_creation_time; }
+
+        // Number of entries that ever had a deletion time set (never decreases)
+        size_t get_num_deleted() const { return __atomic_load_n(&num_deleted, __ATOMIC_ACQUIRE); }
+
+        void add_num_deleted(size_t num = 1) { __atomic_fetch_add(&num_deleted, num, __ATOMIC_RELEASE); }
+
+        size_t get_capacity() const
         {
-            // Int128Union new_val, cur_val;
-            // should be inlined as "lock cmpxchg16b"
-            // cur_val.int128 = __sync_val_compare_and_swap(&tail.int128, new_val.int128, tail.int128);
-            Int128Union cur_val;
-            cur_val.m128i = _mm_load_si128(&tail.m128i);
-            return std::make_pair(cur_val.data.num_entries, cur_val.data.data_length);
+            return (get_block_size() - sizeof(*this) - get_bloom_filter_size()) / ENTRY_SIZE;
+        }
+
+        const vertex_t *get_dsts() const { return columns; }
+
+        vertex_t *get_dsts() { return columns; }
+
+        const timestamp_t *get_creation_times() const { return (const timestamp_t *)(columns + get_capacity()); }
+
+        timestamp_t *get_creation_times() { return (timestamp_t *)(columns + get_capacity()); }
+
+        const timestamp_t *get_deletion_times() const { return get_creation_times() + get_capacity(); }
+
+        timestamp_t *get_deletion_times() { return get_creation_times() + get_capacity(); }
+
+        bool has_space(size_t num_entries) const { return num_entries < get_capacity(); }
+
+        size_t append_without_update_size(
+            vertex_t dst, timestamp_t creation_time, timestamp_t deletion_time, size_t num, BloomFilter &filter)
+        {
+            auto capacity = get_capacity();
+            assert(num < capacity);
+            columns[num] = dst;
+            ((timestamp_t *)(columns + capacity))[num] = creation_time;
+            ((timestamp_t *)(columns + capacity))[capacity + num] = deletion_time;
+            if (filter.valid())
+                filter.insert(dst);
+            return num;
         }
 
         void
         fill(order_t order, vertex_t vid, timestamp_t creation_time, uintptr_t prev_pointer, timestamp_t committed_time)
         {
-            N2OBlockHeader::fill(order, Type::EDGE, vid, creation_time, prev_pointer);
-            set_committed_time(committed_time);
-            clear();
+            EdgeBlockCommonHeader::fill(order, Type::COLUMNAR_EDGE, vid, creation_time, prev_pointer, committed_time);
+            set_max_creation_time(0);
+            num_deleted = 0;
         }
 
-        constexpr static order_t BLOOM_FILTER_THRESHOLD = 10;
-        constexpr static order_t BLOOM_FILTER_PORTION = 4;
+        static order_t entries_to_order(size_t num_entries)
+        {
+            return size_to_order_with_bloom_filter(sizeof(ColumnarEdgeBlockHeader) + num_entries * ENTRY_SIZE);
+        }
+
+        constexpr static size_t ENTRY_SIZE = sizeof(vertex_t) + 2 * sizeof(timestamp_t);
 
     private:
-        timestamp_t committed_time;
-        union alignas(16) Int128Union {
-            struct
-            {
-                size_t num_entries;
-                size_t data_length;
-            } data;
-            __int128 int128;
-            __m128i m128i;
-        } tail;
-        char data[0];
+        timestamp_t max_creation_time;
+        size_t num_deleted;
+        vertex_t columns[0];
     };
 
     static_assert(sizeof(BlockHeader) == 2);
@@ -392,5 +491,7 @@ namespace livegraph
     static_assert(sizeof(EdgeLabelEntry) == 16);
     static_assert(sizeof(EdgeLabelBlockHeader) == 32);
     static_assert(sizeof(EdgeEntry) == 24);
+    static_assert(sizeof(EdgeBlockCommonHeader) == 48);
     static_assert(sizeof(EdgeBlockHeader) == 48);
+    static_assert(sizeof(ColumnarEdgeBlockHeader) == 64);
 } // namespace livegraph
@@ -15,13 +15,23 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <thread>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "types.hpp"
@@ -29,27 +39,45 @@
 namespace livegraph
 {
 
+    // Group commit over a lock-free multi-producer log buffer.
+    //
+    // Committers reserve a range of the ring with one fetch_add, copy their WAL into it and publish the record
+    // by storing its length header. The server thread takes the longest prefix of published records as one
+    // group, writes it with a single pwritev()/fdatasync() and wakes the committers through a futex.
+    //
+    // On-disk layout: a file header of WAL_MAGIC and WAL_FORMAT_VERSION, then the groups. Group layout:
+    // epoch_id, num_txns, then per txn a uint64_t length and the WAL padded to 8 bytes (format version 2; version
+    // 1 had no file header and concatenated the WALs without lengths).
+    //
+    // A failed write or fdatasync() fails its group only: register_commit() throws in the committing threads of
+    // that group, and the next group is written at the same file offset, so the log has no gap.
     class CommitManager
     {
     public:
-        CommitManager(std::string path, std::atomic<timestamp_t> &_global_epoch_id)
+        constexpr static uint64_t WAL_MAGIC = 0x4c41572d474cul; // "LG-WAL" on disk
+        constexpr static uint64_t WAL_FORMAT_VERSION = 2;
+        constexpr static size_t FILE_HEADER_SIZE = 2 * sizeof(uint64_t);
+
+        CommitManager(std::string path, std::atomic<timestamp_t> &_global_epoch_id,
+                      size_t _buffer_size = DEFAULT_LOG_BUFFER_SIZE)
             : fd(EMPTY_FD),
-              seq_front{0, 0},
-              seq_rear{0, 0},
-              mutex(),
-              client_mutex(),
-              cv_server(),
-              cv_client(),
-              global_client_mutex(0),
+              buffer(nullptr),
+              buffer_size(_buffer_size),
+              reserved_size(0),
+              durable_size(0),
+              flush_seq(0),
+              server_sleeping(0),
               used_size(0),
               file_size(0),
               global_epoch_id(_global_epoch_id),
-              writing_epoch_id(global_epoch_id),
-              unfinished_epoch_id(),
-              queue(),
-              closed(false),
-              server_thread([&] { server_loop(); })
+              writing_epoch_id(global_epoch_id.load()),
+              visible_epoch_id(global_epoch_id.load()),
+              latest_epoch_id(global_epoch_id.load()),
+              groups(),
+              closed(false)
         {
+            if (buffer_size < sizeof(uint64_t) || (buffer_size & (buffer_size - 1)))
+                throw std::invalid_argument("commit log buffer size must be a power of two.");
             if (!path.empty())
             {
                 fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0640);
@@ -57,45 +85,64 @@ namespace livegraph
                     throw std::runtime_error("open wal file error.");
                 if (ftruncate(fd, FILE_TRUNC_SIZE) != 0)
                     throw std::runtime_error("ftruncate wal file error.");
+                const uint64_t file_header[2] = {WAL_MAGIC, WAL_FORMAT_VERSION};
+                if (pwrite(fd, file_header, sizeof(file_header), 0) != sizeof(file_header))
+                    throw std::runtime_error("write wal file header error.");
             }
+            used_size = FILE_HEADER_SIZE;
             file_size = FILE_TRUNC_SIZE;
+
+            buffer = static_cast<char *>(mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+            if (buffer == MAP_FAILED)
+                throw std::runtime_error("mmap wal buffer error.");
+
+            server_thread = std::thread([&] { server_loop(); });
         }
 
         ~CommitManager()
         {
             closed.store(true);
-            cv_server.notify_one();
+            wake_server();
             server_thread.join();
+            munmap(buffer, buffer_size);
             if (fd != EMPTY_FD)
                 close(fd);
         }
 
         std::pair<timestamp_t, std::atomic<int> *> register_commit(std::string_view wal)
         {
-            while (true)
-            {
-                auto local_client_mutex = global_client_mutex.load();
-                std::unique_lock<std::mutex> lock(mutex[local_client_mutex]);
-                if (local_client_mutex != global_client_mutex.load())
-                    continue;
+            size_t record_size = record_size_of(wal.size());
+            if (record_size > buffer_size)
+                throw std::runtime_error("wal exceeds the commit log buffer.");
 
-                timestamp_t local_commit_epoch_id;
-                std::atomic<int> *local_num_unfinished;
+            auto offset = reserved_size.fetch_add(record_size, std::memory_order_relaxed);
 
-                queue[local_client_mutex].emplace(wal, &local_commit_epoch_id, &local_num_unfinished);
-                auto my_seq = seq_rear[local_client_mutex]++;
+            // Back-pressure: wait until the server has recycled the part of the ring we are about to overwrite
+            wait_flush([&] {
+                return offset + record_size <= durable_size.load(std::memory_order_acquire) + buffer_size;
+            });
 
-                lock.unlock();
-                cv_server.notify_one();
+            copy_to_buffer(offset + sizeof(uint64_t), wal.data(), wal.size());
+            // The flag tells an empty WAL apart from an unpublished header
+            __atomic_store_n(header_of(offset), PUBLISHED | wal.size(), __ATOMIC_SEQ_CST);
+            wake_server();
 
-                std::unique_lock<std::mutex> client_lock(client_mutex[local_client_mutex]);
-                if (seq_front[local_client_mutex] <= my_seq)
+            wait_flush([&] { return offset + record_size <= durable_size.load(std::memory_order_acquire); });
+
+            // Groups stay in the table until all their commits finished, so ours is still there
+            for (auto epoch_id = latest_epoch_id.load(std::memory_order_acquire);; epoch_id--)
+            {
+                auto &group = groups[epoch_id % MAX_PENDING_GROUPS];
+                if (group.begin <= offset)
                 {
-                    cv_client[local_client_mutex].wait(client_lock,
-                                                       [&]() { return seq_front[local_client_mutex] > my_seq; });
+                    if (group.error)
+                    {
+                        group.num_unfinished.fetch_sub(1);
+                        throw std::runtime_error(std::string("write wal file error: ") + strerror(group.error));
+                    }
+                    return {group.epoch_id, &group.num_unfinished};
                 }
-
-                return {local_commit_epoch_id, local_num_unfinished};
             }
         }
 
@@ -104,132 +151,215 @@ namespace livegraph
             local_num_unfinished->fetch_sub(1);
             while (wait && global_epoch_id < local_commit_epoch_id)
             {
-                cv_server.notify_one();
+                wake_server();
                 std::this_thread::yield();
             }
         }
 
     private:
+        struct Group
+        {
+            timestamp_t epoch_id;
+            size_t begin;
+            int error; // errno of the failed write, 0 if the group is durable
+            std::atomic<int> num_unfinished;
+        };
+
+        using cacheline_padding_t = char[64];
+
+        constexpr static size_t FILE_TRUNC_SIZE = 1ul << 30;  // 1GB
+        constexpr static size_t DEFAULT_LOG_BUFFER_SIZE = 1ul << 26; // 64MB, power of two
+        constexpr static uint64_t PUBLISHED = 1ul << 63;
+        constexpr static size_t MAX_PENDING_GROUPS = 1ul << 12;
+        constexpr static int EMPTY_FD = -1;
+        constexpr static auto SERVER_SPIN_INTERVAL = std::chrono::microseconds(100);
+
         int fd;
-        size_t seq_front[2];                  //(server) increment after fsync() is finished
-        size_t seq_rear[2];                   // (client) increment after push() is finished
-        std::mutex mutex[2];                  // (server/clients) serialize queue operations
-        std::mutex client_mutex[2];           // (clients) wait for fsync() to finish
-        std::condition_variable cv_server;    // (server) wait when the queue is empty
-        std::condition_variable cv_client[2]; // (clients) wait for fsync() to finish
-        std::atomic<int> global_client_mutex;
+        char *buffer;
+        size_t buffer_size;
+        cacheline_padding_t padding0;
+        std::atomic<size_t> reserved_size; // (clients) end of the reserved part of the ring
+        cacheline_padding_t padding1;
+        std::atomic<size_t> durable_size; // (server) end of the flushed part of the ring
+        cacheline_padding_t padding2;
+        std::atomic<int> flush_seq; // (clients) futex, bumped after every flushed group
+        cacheline_padding_t padding3;
+        std::atomic<int> server_sleeping; // (server) futex, set while waiting for records
+        cacheline_padding_t padding4;
         size_t used_size;
         size_t file_size;
         std::atomic<timestamp_t> &global_epoch_id;
         timestamp_t writing_epoch_id;
-        std::queue<std::pair<timestamp_t, std::atomic<int>>> unfinished_epoch_id;
-        std::queue<std::tuple<std::string_view, timestamp_t *, std::atomic<int> **>>
-            queue[2]; // wal, epoch_id, unfinished
+        timestamp_t visible_epoch_id;
+        std::atomic<timestamp_t> latest_epoch_id;
+        Group groups[MAX_PENDING_GROUPS]; // in-flight groups indexed by epoch
         std::atomic<bool> closed;
         std::thread server_thread;
 
-        constexpr static size_t FILE_TRUNC_SIZE = 1ul << 30; // 1GB
-        constexpr static int EMPTY_FD = -1;
-        constexpr static auto SERVER_SPIN_INTERVAL = std::chrono::microseconds(100);
+        inline static int futex(std::atomic<int> *uaddr, int futex_op, int val, const struct timespec *timeout)
+        {
+            return syscall(SYS_futex, reinterpret_cast<int *>(uaddr), futex_op, val, timeout, nullptr, 0);
+        }
 
-        void check_unfinished_epoch_id()
+        static size_t record_size_of(size_t wal_size)
         {
-            while (!unfinished_epoch_id.empty())
-            {
-                auto &[current_epoch_id, num_unfinished] = unfinished_epoch_id.front();
-                if (num_unfinished.load() == 0)
-                {
-                    global_epoch_id = current_epoch_id;
-                    unfinished_epoch_id.pop();
-                }
-                else
-                {
-                    break;
-                }
-            }
+            return (sizeof(uint64_t) + wal_size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
         }
 
-        void server_loop()
+        uint64_t *header_of(size_t offset)
+        {
+            return reinterpret_cast<uint64_t *>(buffer + (offset & (buffer_size - 1)));
+        }
+
+        void copy_to_buffer(size_t offset, const char *data, size_t length)
+        {
+            auto begin = offset & (buffer_size - 1);
+            auto first = std::min(length, buffer_size - begin);
+            memcpy(buffer + begin, data, first);
+            memcpy(buffer, data + first, length - first);
+        }
+
+        // One futex for all waiters: there is a single server thread, so at most one group is in flight, and every
+        // flush must wake the back-pressure waiters anyway. The only extra wakeups are those of committers that
+        // published after the group was cut. They cannot know their epoch before the next cut, so a futex per epoch
+        // would not let them sleep through this flush.
+        template <typename F> void wait_flush(F &&done)
         {
             while (true)
             {
-                check_unfinished_epoch_id();
-                int local_client_mutex = global_client_mutex.load();
-                std::unique_lock<std::mutex> lock(mutex[local_client_mutex]);
-                auto &local_queue = queue[local_client_mutex];
-                while (local_queue.empty() && !closed.load())
-                {
-                    cv_server.wait_for(lock, SERVER_SPIN_INTERVAL, [&]() {
-                        check_unfinished_epoch_id();
-                        return !local_queue.empty() || closed.load();
-                    });
-                    check_unfinished_epoch_id();
-                    cv_client[local_client_mutex ^ 1].notify_all();
-                }
-                std::unique_lock<std::mutex> client_lock(client_mutex[local_client_mutex]);
-
-                global_client_mutex ^= 1;
+                auto seq = flush_seq.load(std::memory_order_acquire);
+                if (done())
+                    return;
+                int ret = futex(&flush_seq, FUTEX_WAIT_PRIVATE, seq, nullptr);
+                if (ret == -1 && errno != EAGAIN && errno != EINTR)
+                    throw std::runtime_error("Futex wait error.");
+            }
+        }
 
-                size_t num_txns = local_queue.size();
+        void wake_server()
+        {
+            if (server_sleeping.load() && server_sleeping.exchange(0))
+                futex(&server_sleeping, FUTEX_WAKE_PRIVATE, 1, nullptr);
+        }
 
-                if (!num_txns)
+        void check_unfinished_epoch_id()
+        {
+            while (visible_epoch_id < writing_epoch_id)
+            {
+                auto &group = groups[(visible_epoch_id + 1) % MAX_PENDING_GROUPS];
+                if (group.num_unfinished.load() != 0)
                     break;
+                global_epoch_id = ++visible_epoch_id;
+            }
+        }
 
-                ++writing_epoch_id;
-
-                unfinished_epoch_id.emplace(writing_epoch_id, 0);
+        // Returns the end of the published prefix starting at durable_size and the number of records in it
+        std::pair<size_t, size_t> collect_group()
+        {
+            auto end = durable_size.load(std::memory_order_relaxed);
+            auto limit = reserved_size.load(std::memory_order_acquire);
+            size_t num_txns = 0;
+            while (end < limit)
+            {
+                auto wal_size = __atomic_load_n(header_of(end), __ATOMIC_ACQUIRE);
+                if (!(wal_size & PUBLISHED))
+                    break;
+                end += record_size_of(wal_size & ~PUBLISHED);
+                num_txns++;
+            }
+            return {end, num_txns};
+        }
 
-                auto &num_unfinished = unfinished_epoch_id.back().second;
+        // Returns 0 or the errno of the failed call
+        int write_group(size_t begin, size_t end, size_t num_txns)
+        {
+            // Strip the publish flags, the file holds plain lengths
+            for (auto pos = begin; pos < end;)
+            {
+                auto header = header_of(pos);
+                *header &= ~PUBLISHED;
+                pos += record_size_of(*header);
+            }
 
-                std::string group_wal;
-                group_wal.append(reinterpret_cast<char *>(&writing_epoch_id), sizeof(writing_epoch_id));
-                group_wal.append(reinterpret_cast<char *>(&num_txns), sizeof(num_txns));
+            struct iovec iov[3];
+            int iovcnt = 0;
+            timestamp_t group_header[2] = {writing_epoch_id, (timestamp_t)num_txns};
+            iov[iovcnt++] = {group_header, sizeof(group_header)};
+
+            auto ring_begin = begin & (buffer_size - 1);
+            auto first = std::min(end - begin, buffer_size - ring_begin);
+            iov[iovcnt++] = {buffer + ring_begin, first};
+            if (end - begin > first)
+                iov[iovcnt++] = {buffer, end - begin - first};
+
+            size_t group_size = sizeof(group_header) + end - begin;
+            auto expected_size = used_size + group_size;
+            int error = 0;
+            if (expected_size > file_size)
+            {
+                size_t new_file_size = (expected_size / FILE_TRUNC_SIZE + 1) * FILE_TRUNC_SIZE;
+                if (fd != EMPTY_FD && ftruncate(fd, new_file_size) != 0)
+                    error = errno;
+                else
+                    file_size = new_file_size;
+            }
 
-                for (size_t i = 0; i < num_txns; i++)
-                {
-                    auto &[wal, ret_epoch_id, ret_num] = local_queue.front();
+            if (!error && fd != EMPTY_FD)
+            {
+                auto written = pwritev(fd, iov, iovcnt, used_size);
+                if (written < 0)
+                    error = errno;
+                else if ((size_t)written != group_size)
+                    error = EIO;
+                else if (fdatasync(fd) != 0)
+                    error = errno;
+            }
 
-                    group_wal.append(wal);
-                    *ret_epoch_id = writing_epoch_id;
-                    *ret_num = &num_unfinished;
-                    ++num_unfinished;
-                    local_queue.pop();
-                }
+            // A failed group is not kept: the next one overwrites whatever part of it reached the file
+            if (!error)
+                used_size += group_size;
 
-                auto expected_size = used_size + group_wal.size();
-                if (expected_size > file_size)
-                {
-                    size_t new_file_size = (expected_size / FILE_TRUNC_SIZE + 1) * FILE_TRUNC_SIZE;
-                    if (fd != EMPTY_FD)
-                    {
-                        if (ftruncate(fd, new_file_size) != 0)
-                            throw std::runtime_error("ftruncate wal file error.");
-                    }
-                    file_size = new_file_size;
-                }
+            // Clear the headers so the ring can be reused
+            for (int i = 1; i < iovcnt; i++)
+                memset(iov[i].iov_base, 0, iov[i].iov_len);
+            return error;
+        }
 
-                used_size += group_wal.size();
+        void server_loop()
+        {
+            const struct timespec timeout = {
+                .tv_sec = 0, .tv_nsec = std::chrono::nanoseconds(SERVER_SPIN_INTERVAL).count()};
+            while (true)
+            {
+                check_unfinished_epoch_id();
 
-                if (fd != EMPTY_FD)
-                {
-                    if ((size_t)write(fd, group_wal.c_str(), group_wal.size()) != group_wal.size())
-                        std::runtime_error("write wal file error.");
-                }
+                auto begin = durable_size.load(std::memory_order_relaxed);
+                auto [end, num_txns] = collect_group();
 
-                if (fd != EMPTY_FD)
+                if (!num_txns || writing_epoch_id - visible_epoch_id >= (timestamp_t)MAX_PENDING_GROUPS)
                 {
-                    if (fdatasync(fd) != 0)
-                        std::runtime_error("fdatasync wal file error.");
+                    if (closed.load() && !num_txns && begin == reserved_size.load())
+                        break;
+                    server_sleeping.store(1);
+                    if (!collect_group().second)
+                        futex(&server_sleeping, FUTEX_WAIT_PRIVATE, 1, &timeout);
+                    server_sleeping.store(0);
+                    continue;
                 }
 
-                ++num_unfinished;
-
-                lock.unlock();
-                seq_front[local_client_mutex] += num_txns;
-                cv_client[local_client_mutex].notify_all();
-                client_lock.unlock();
-
-                --num_unfinished;
+                ++writing_epoch_id;
+                auto error = write_group(begin, end, num_txns);
+
+                auto &group = groups[writing_epoch_id % MAX_PENDING_GROUPS];
+                group.epoch_id = writing_epoch_id;
+                group.begin = begin;
+                group.error = error;
+                group.num_unfinished.store(num_txns);
+                latest_epoch_id.store(writing_epoch_id, std::memory_order_release);
+
+                durable_size.store(end, std::memory_order_release);
+                flush_seq.fetch_add(1, std::memory_order_release);
+                futex(&flush_seq, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
             }
         }
     };
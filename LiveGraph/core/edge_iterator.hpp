@@ -37,7 +37,13 @@ namespace livegraph
               data_length(_data_length),
               read_epoch_id(_read_epoch_id),
               local_txn_id(_local_txn_id),
-              reverse(_reverse)
+              reverse(_reverse),
+              columnar(false),
+              dsts(nullptr),
+              creation_times(nullptr),
+              deletion_times(nullptr),
+              column_cursor(0),
+              all_visible(false)
         {
             if (!reverse)
             {
@@ -80,12 +86,41 @@ namespace livegraph
             }
         }
 
+        EdgeIterator(ColumnarEdgeBlockHeader *block,
+                     size_t _num_entries,
+                     timestamp_t _read_epoch_id,
+                     timestamp_t _local_txn_id,
+                     bool _reverse)
+            : entries(nullptr),
+              data(nullptr),
+              num_entries(_num_entries),
+              data_length(0),
+              read_epoch_id(_read_epoch_id),
+              local_txn_id(_local_txn_id),
+              reverse(_reverse),
+              columnar(true),
+              entries_cursor(nullptr),
+              data_cursor(nullptr),
+              dsts(block->get_dsts()),
+              creation_times(block->get_creation_times()),
+              deletion_times(block->get_deletion_times()),
+              column_cursor(0)
+        {
+            // Without deletions and later insertions every entry is visible, so scans only read dsts
+            all_visible = block->get_num_deleted() == 0 &&
+                          cmp_timestamp(block->get_max_creation_time_pointer(), read_epoch_id, local_txn_id) <= 0;
+            if (valid() && !column_visible())
+                next();
+        }
+
         EdgeIterator(const EdgeIterator &) = default;
 
         EdgeIterator(EdgeIterator &&) = default;
 
         bool valid() const
         {
+            if (columnar)
+                return column_cursor < num_entries;
             if (!reverse)
                 return !(entries_cursor == entries);
             else
@@ -94,6 +129,13 @@ namespace livegraph
 
         void next()
         {
+            if (columnar)
+            {
+                do
+                    column_cursor++;
+                while (valid() && !column_visible());
+                return;
+            }
             if (!reverse)
             {
                 while (valid())
@@ -128,6 +170,8 @@ namespace livegraph
         {
             if (!valid())
                 return Graph::VERTEX_TOMBSTONE;
+            if (columnar)
+                return dsts[column_index()];
             if (!reverse)
                 return entries_cursor->get_dst();
             else
@@ -136,7 +180,7 @@ namespace livegraph
 
         std::string_view edge_data() const
         {
-            if (!valid())
+            if (!valid() || columnar)
                 return std::string_view();
             if (!reverse)
                 return std::string_view(data_cursor - entries_cursor->get_length(), entries_cursor->get_length());
@@ -152,7 +196,25 @@ namespace livegraph
         timestamp_t read_epoch_id;
         timestamp_t local_txn_id;
         bool reverse;
+        bool columnar;
         EdgeEntry *entries_cursor;
         char *data_cursor;
+        const vertex_t *dsts;
+        timestamp_t *creation_times;
+        timestamp_t *deletion_times;
+        size_t column_cursor;
+        bool all_visible;
+
+        // Forward scans return the newest entries first, as with the row layout
+        size_t column_index() const { return reverse ? column_cursor : num_entries - 1 - column_cursor; }
+
+        bool column_visible()
+        {
+            if (all_visible)
+                return true;
+            auto index = column_index();
+            return cmp_timestamp(creation_times + index, read_epoch_id, local_txn_id) <= 0 &&
+                   cmp_timestamp(deletion_times + index, read_epoch_id, local_txn_id) > 0;
+        }
     };
 } // namespace livegraph
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <atomic>
+#include <bitset>
 #include <memory>
 #include <mutex>
 #include <unordered_set>
@@ -31,6 +32,7 @@
 namespace livegraph
 {
     class EdgeIterator;
+    class Snapshot;
     class Transaction;
 
     class Graph
@@ -39,7 +41,9 @@ namespace livegraph
         Graph(std::string block_path = "",
               std::string wal_path = "",
               size_t _max_block_size = 1ul << 40,
-              vertex_t _max_vertex_id = 1ul << 40)
+              vertex_t _max_vertex_id = 1ul << 40,
+              bool huge_pages = false,
+              bool numa_aware = false)
             : mutex(),
               epoch_id(0),
               transaction_id(0),
@@ -49,7 +53,7 @@ namespace livegraph
               recycled_vertex_ids(),
               max_vertex_id(_max_vertex_id),
               array_allocator(),
-              block_manager(block_path, _max_block_size),
+              block_manager(block_path, _max_block_size, huge_pages, numa_aware),
               commit_manager(wal_path, epoch_id)
         {
             auto futex_allocater =
@@ -80,8 +84,29 @@ namespace livegraph
 
         vertex_t get_max_vertex_id() const { return vertex_id; }
 
+        // Block allocations served from the allocating thread's NUMA node and from other nodes
+        std::pair<size_t, size_t> get_block_allocation_stats() { return block_manager.get_allocation_stats(); }
+
+        // Store the edges of a label in columnar blocks (dsts and timestamps in separate arrays).
+        // Such edges carry no data; declare the label before inserting any of its edges.
+        // This saves no memory (entries are 24 bytes either way and the block header is larger); it speeds up full
+        // scans of graphs that do not fit in cache and slows them down on ones that do, see livegraph_bin32_bench
+        // --columnar.
+        void set_columnar_label(label_t label) { columnar_labels.set(label); }
+        bool is_columnar_label(label_t label) const { return columnar_labels.test(label); }
+
+        // Bytes held by the newest edge blocks of a label and the number of entries in them
+        std::pair<size_t, size_t> get_edge_block_usage(label_t label);
+
         timestamp_t compact(timestamp_t read_epoch_id = NO_TRANSACTION);
 
+        // Copies the edges of a label visible at read_epoch_id (default: the latest epoch) into a CSR snapshot.
+        // The epoch is pinned against compaction only while building, so an older read_epoch_id must still be
+        // held by an open transaction.
+        Snapshot export_snapshot(label_t label,
+                                 timestamp_t read_epoch_id = NO_TRANSACTION,
+                                 bool with_edge_data = false);
+
         Transaction begin_transaction();
         Transaction begin_read_only_transaction();
         Transaction begin_batch_loader();
@@ -110,6 +135,8 @@ namespace livegraph
         BlockManager block_manager;
         CommitManager commit_manager;
 
+        std::bitset<1ul << (8 * sizeof(label_t))> columnar_labels;
+
         Futex *vertex_futexes;
         uintptr_t *vertex_ptrs;
         uintptr_t *edge_label_ptrs;
@@ -121,6 +148,12 @@ namespace livegraph
         constexpr static vertex_t VERTEX_TOMBSTONE = UINT64_MAX;
         constexpr static auto TIMEOUT = std::chrono::milliseconds(1);
         constexpr static size_t COMPACT_EDGE_BLOCK_THRESHOLD = 5; // at least compact 20% edges
+        constexpr static vertex_t SNAPSHOT_GRAIN = 1ul << 10;
+
+        EdgeIterator get_edges_at(vertex_t src, label_t label, timestamp_t read_epoch_id);
+
+        // Returns the copied block, or the given one if nothing was compacted
+        uintptr_t compact_columnar_edge_block(uintptr_t pointer, timestamp_t read_epoch_id);
 
         friend class EdgeIterator;
         friend class Transaction;
@@ -17,4 +17,5 @@
 
 #include "edge_iterator.hpp"
 #include "graph.hpp"
+#include "snapshot.hpp"
 #include "transaction.hpp"
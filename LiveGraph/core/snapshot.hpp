@@ -0,0 +1,117 @@
+/* Copyright 2020 Guanyu Feng, Tsinghua University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace livegraph
+{
+    class SnapshotEdgeIterator
+    {
+    public:
+        SnapshotEdgeIterator(const vertex_t *_dsts,
+                             const size_t *_data_offsets,
+                             const char *_data,
+                             size_t _begin,
+                             size_t _end)
+            : dsts(_dsts), data_offsets(_data_offsets), data(_data), cursor(_begin), end(_end)
+        {
+        }
+
+        bool valid() const { return cursor < end; }
+
+        void next() { cursor++; }
+
+        vertex_t dst_id() const { return dsts[cursor]; }
+
+        std::string_view edge_data() const
+        {
+            if (!data_offsets)
+                return std::string_view();
+            return std::string_view(data + data_offsets[cursor], data_offsets[cursor + 1] - data_offsets[cursor]);
+        }
+
+    private:
+        const vertex_t *dsts;
+        const size_t *data_offsets;
+        const char *data;
+        size_t cursor;
+        size_t end;
+    };
+
+    // Immutable CSR copy of the edges of one label visible at a read epoch, built by Graph::export_snapshot().
+    // Edges of a vertex keep their insertion order (the order of get_edges(src, label, true)).
+    class Snapshot
+    {
+    public:
+        Snapshot(label_t _label, timestamp_t _read_epoch_id, vertex_t _num_vertices, bool _with_edge_data)
+            : label(_label),
+              read_epoch_id(_read_epoch_id),
+              num_vertices(_num_vertices),
+              with_edge_data(_with_edge_data),
+              offsets(_num_vertices + 1, 0),
+              dsts(),
+              data_offsets(),
+              data()
+        {
+        }
+
+        Snapshot(const Snapshot &) = delete;
+
+        Snapshot(Snapshot &&) = default;
+
+        label_t get_label() const { return label; }
+
+        timestamp_t get_read_epoch_id() const { return read_epoch_id; }
+
+        vertex_t get_num_vertices() const { return num_vertices; }
+
+        size_t get_num_edges() const { return dsts.size(); }
+
+        bool has_edge_data() const { return with_edge_data; }
+
+        size_t get_degree(vertex_t src) const { return src < num_vertices ? offsets[src + 1] - offsets[src] : 0; }
+
+        // num_vertices + 1 entries, the edges of src are dsts[offsets[src], offsets[src + 1])
+        const size_t *get_offsets() const { return offsets.data(); }
+
+        const vertex_t *get_dsts() const { return dsts.data(); }
+
+        SnapshotEdgeIterator get_edges(vertex_t src) const
+        {
+            if (src >= num_vertices)
+                return SnapshotEdgeIterator(nullptr, nullptr, nullptr, 0, 0);
+            return SnapshotEdgeIterator(dsts.data(), with_edge_data ? data_offsets.data() : nullptr, data.data(),
+                                        offsets[src], offsets[src + 1]);
+        }
+
+    private:
+        const label_t label;
+        const timestamp_t read_epoch_id;
+        const vertex_t num_vertices;
+        const bool with_edge_data;
+        std::vector<size_t> offsets;
+        std::vector<vertex_t> dsts;
+        std::vector<size_t> data_offsets; // num_edges + 1 entries if with_edge_data
+        std::string data;
+
+        friend class Graph;
+    };
+} // namespace livegraph
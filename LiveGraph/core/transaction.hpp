@@ -20,6 +20,7 @@
 #include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "blocks.hpp"
@@ -103,6 +104,11 @@ namespace livegraph
         void put_edge(vertex_t src, label_t label, vertex_t dst, std::string_view edge_data, bool force_insert = false);
         bool del_edge(vertex_t src, label_t label, vertex_t dst);
 
+        // Bulk load edges without properties into a batch loader. Edges must be grouped by src (sorted or
+        // partitioned); every group is written into one exactly-sized edge block without taking vertex locks,
+        // so no other writer may touch these sources concurrently. Duplicates are kept as in force_insert.
+        void bulk_put_edges(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges);
+
         std::string_view get_vertex(vertex_t vertex_id);
         std::string_view get_edge(vertex_t src, label_t label, vertex_t dst);
         EdgeIterator get_edges(vertex_t src, label_t label, bool reverse = false);
@@ -129,7 +135,7 @@ namespace livegraph
         std::unordered_map<vertex_t, uintptr_t> vertex_ptr_cache;
         std::map<std::pair<vertex_t, label_t>, uintptr_t> edge_ptr_cache;
         std::vector<std::pair<uintptr_t, order_t>> block_cache;
-        std::unordered_map<EdgeBlockHeader *, std::pair<size_t, size_t>> edge_block_num_entries_data_length_cache;
+        std::unordered_map<EdgeBlockCommonHeader *, std::pair<size_t, size_t>> edge_block_num_entries_data_length_cache;
         std::vector<vertex_t> new_vertex_cache;
         std::deque<vertex_t> recycled_vertex_cache;
 
@@ -194,7 +200,7 @@ namespace livegraph
             graph.read_epoch_table.local() = Graph::NO_TRANSACTION;
         }
 
-        std::pair<size_t, size_t> get_num_entries_data_length_cache(EdgeBlockHeader *edge_block) const
+        std::pair<size_t, size_t> get_num_entries_data_length_cache(EdgeBlockCommonHeader *edge_block) const
         {
             if (batch_update || !trace_cache)
                 return edge_block->get_num_entries_data_length_atomic();
@@ -205,7 +211,7 @@ namespace livegraph
                 return iter->second;
         }
 
-        void set_num_entries_data_length_cache(EdgeBlockHeader *edge_block, size_t num_entries, size_t data_length)
+        void set_num_entries_data_length_cache(EdgeBlockCommonHeader *edge_block, size_t num_entries, size_t data_length)
         {
             if (batch_update)
                 edge_block->set_num_entries_data_length_atomic(num_entries, data_length);
@@ -216,10 +222,34 @@ namespace livegraph
         std::pair<EdgeEntry *, char *>
         find_edge(vertex_t dst, EdgeBlockHeader *edge_block, size_t num_entries, size_t data_length);
 
+        timestamp_t *find_columnar_edge(vertex_t dst, ColumnarEdgeBlockHeader *edge_block, size_t num_entries);
+
+        bool use_columnar_block(uintptr_t pointer, label_t label);
+
+        uintptr_t put_row_edge(
+            vertex_t src, label_t label, vertex_t dst, uintptr_t pointer, std::string_view edge_data, bool force_insert);
+
+        uintptr_t put_columnar_edge(vertex_t src, label_t label, vertex_t dst, uintptr_t pointer, bool force_insert);
+
+        size_t copy_columnar_entries(ColumnarEdgeBlockHeader *edge_block,
+                                     size_t num_entries,
+                                     ColumnarEdgeBlockHeader *new_edge_block);
+
+        void update_max_creation_time(ColumnarEdgeBlockHeader *edge_block);
+
         uintptr_t locate_edge_block(vertex_t src, label_t label);
 
         void update_edge_label_block(vertex_t src, label_t label, uintptr_t edge_block_pointer);
 
         void ensure_no_confict(vertex_t src, label_t label);
+
+        void bulk_put_edge_group(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges);
+
+        void bulk_put_columnar_edge_group(label_t label,
+                                          const std::pair<vertex_t, vertex_t> *edges,
+                                          size_t num_edges,
+                                          uintptr_t pointer);
+
+        constexpr static size_t BULK_LOAD_GRAIN = 1ul << 12;
     };
 } // namespace livegraph
@@ -385,34 +385,12 @@ size_t run_gapbs_cc(uint32_t num_vertices,
     return components;
 }
 
-inline LiveGraphBenchmarkResult run_livegraph_graph_benchmarks_gapbs(
-    lg::Graph& graph, const LoadedGraph& loaded, const LiveGraphBenchmarkConfig& config) {
+template <typename MakeOutNeighbors, typename MakeInNeighbors>
+LiveGraphBenchmarkResult run_graph_benchmarks_gapbs(const LoadedGraph& loaded,
+                                                    const LiveGraphBenchmarkConfig& config,
+                                                    MakeOutNeighbors&& make_out_neighbors,
+                                                    MakeInNeighbors&& make_in_neighbors) {
     LiveGraphBenchmarkResult result;
-    auto make_out_neighbors = [&graph]() {
-        return [tx = graph.begin_read_only_transaction()](uint32_t src, auto&& fn) mutable {
-            auto it = tx.get_edges(src, 0);
-            while (it.valid()) {
-                const uint32_t dst = static_cast<uint32_t>(it.dst_id());
-                if (!fn(dst)) {
-                    break;
-                }
-                it.next();
-            }
-        };
-    };
-    auto make_in_neighbors = [&graph]() {
-        return [tx = graph.begin_read_only_transaction()](uint32_t dst, auto&& fn) mutable {
-            auto it = tx.get_edges(dst, 1);
-            while (it.valid()) {
-                const uint32_t src = static_cast<uint32_t>(it.dst_id());
-                if (!fn(src)) {
-                    break;
-                }
-                it.next();
-            }
-        };
-    };
-
     for (size_t round = 0; round < config.bfs_rounds; ++round) {
         const uint32_t source =
             loaded.num_vertices == 0 ? 0 : static_cast<uint32_t>(round % loaded.num_vertices);
@@ -469,3 +447,58 @@ inline LiveGraphBenchmarkResult run_livegraph_graph_benchmarks_gapbs(
     result.cc_seconds = seconds_since(cc_begin);
     return result;
 }
+
+inline LiveGraphBenchmarkResult run_livegraph_graph_benchmarks_gapbs(
+    lg::Graph& graph, const LoadedGraph& loaded, const LiveGraphBenchmarkConfig& config) {
+    auto make_out_neighbors = [&graph]() {
+        return [tx = graph.begin_read_only_transaction()](uint32_t src, auto&& fn) mutable {
+            auto it = tx.get_edges(src, 0);
+            while (it.valid()) {
+                const uint32_t dst = static_cast<uint32_t>(it.dst_id());
+                if (!fn(dst)) {
+                    break;
+                }
+                it.next();
+            }
+        };
+    };
+    auto make_in_neighbors = [&graph]() {
+        return [tx = graph.begin_read_only_transaction()](uint32_t dst, auto&& fn) mutable {
+            auto it = tx.get_edges(dst, 1);
+            while (it.valid()) {
+                const uint32_t src = static_cast<uint32_t>(it.dst_id());
+                if (!fn(src)) {
+                    break;
+                }
+                it.next();
+            }
+        };
+    };
+    return run_graph_benchmarks_gapbs(loaded, config, make_out_neighbors, make_in_neighbors);
+}
+
+template <typename Fn>
+inline void for_each_snapshot_neighbor(const lg::Snapshot& snapshot, uint32_t src, Fn&& fn) {
+    const size_t* offsets = snapshot.get_offsets();
+    const lg::vertex_t* dsts = snapshot.get_dsts();
+    for (size_t i = offsets[src], end = offsets[src + 1]; i < end; ++i) {
+        if (!fn(static_cast<uint32_t>(dsts[i]))) {
+            break;
+        }
+    }
+}
+
+// Same suite over CSR snapshots exported from the out (label 0) and in (label 1) edges
+inline LiveGraphBenchmarkResult run_snapshot_graph_benchmarks_gapbs(
+    const lg::Snapshot& out_snapshot,
+    const lg::Snapshot& in_snapshot,
+    const LoadedGraph& loaded,
+    const LiveGraphBenchmarkConfig& config) {
+    auto make_out_neighbors = [&out_snapshot]() {
+        return [&out_snapshot](uint32_t src, auto&& fn) { for_each_snapshot_neighbor(out_snapshot, src, fn); };
+    };
+    auto make_in_neighbors = [&in_snapshot]() {
+        return [&in_snapshot](uint32_t dst, auto&& fn) { for_each_snapshot_neighbor(in_snapshot, dst, fn); };
+    };
+    return run_graph_benchmarks_gapbs(loaded, config, make_out_neighbors, make_in_neighbors);
+}
@@ -13,8 +13,11 @@
 #include <string>
 #include <string_view>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include <tbb/global_control.h>
+
 #include "livegraph.hpp"
 
 namespace fs = std::filesystem;
@@ -46,6 +49,11 @@ struct Options {
     size_t cc_neighbor_rounds = 2;
     int64_t debug_vertex = -1;
     bool reset = false;
+    bool bulk_load = false;
+    bool columnar = false;
+    bool snapshot = false;
+    bool huge_pages = false;
+    bool numa_aware = false;
 };
 
 struct LoadedGraph {
@@ -71,6 +79,11 @@ void print_usage(const char* argv0) {
         << "  --cc-rounds <n>       CC rounds, default 10\n"
         << "  --cc-neighbor-rounds <n>  CC sampled neighbor rounds, default 2\n"
         << "  --debug-vertex <id>   Print out/in neighbors for one vertex and exit after ingest\n"
+        << "  --bulk-load           Ingest all edges with the parallel bulk loader instead of batches\n"
+        << "  --columnar            Store out/in edges in columnar blocks (no edge data)\n"
+        << "  --snapshot            Run the algorithms on CSR snapshots exported after ingest\n"
+        << "  --huge-pages          Back the block region with huge pages (storage dir on hugetlbfs)\n"
+        << "  --numa                Partition the block region per NUMA node\n"
         << "  --reset               Remove existing storage dir before ingest\n";
 }
 
@@ -109,6 +122,16 @@ Options parse_args(int argc, char* argv[]) {
             opts.debug_vertex = std::stoll(require_value("--debug-vertex"));
         } else if (arg == "--reset") {
             opts.reset = true;
+        } else if (arg == "--bulk-load") {
+            opts.bulk_load = true;
+        } else if (arg == "--columnar") {
+            opts.columnar = true;
+        } else if (arg == "--snapshot") {
+            opts.snapshot = true;
+        } else if (arg == "--huge-pages") {
+            opts.huge_pages = true;
+        } else if (arg == "--numa") {
+            opts.numa_aware = true;
         } else if (arg == "-h" || arg == "--help") {
             print_usage(argv[0]);
             std::exit(0);
@@ -208,6 +231,10 @@ void prepare_storage_dir(const fs::path& storage_dir, bool reset) {
 void log_config(const Options& opts) {
     std::printf("[config] dataset=%s\n", opts.input_path.c_str());
     std::printf("[config] storage=%s\n", opts.storage_dir.c_str());
+    std::printf("[config] bulk_load=%d\n", opts.bulk_load ? 1 : 0);
+    std::printf("[config] columnar=%d\n", opts.columnar ? 1 : 0);
+    std::printf("[config] snapshot=%d\n", opts.snapshot ? 1 : 0);
+    std::printf("[config] huge_pages=%d numa=%d\n", opts.huge_pages ? 1 : 0, opts.numa_aware ? 1 : 0);
     std::printf("[config] batch_size=%zu threads=%zu algo_threads=%zu bfs_rounds=%zu pr_iters=%zu pr_epsilon=%.6f cc_rounds=%zu cc_neighbor_rounds=%zu\n",
                 opts.batch_size,
                 opts.num_threads,
@@ -228,7 +255,9 @@ lg::Graph open_graph(const Options& opts, uint32_t num_vertices) {
         block_path.string(),
         wal_path.string(),
         estimated_block_bytes,
-        std::max<lg::vertex_t>(1, num_vertices));
+        std::max<lg::vertex_t>(1, num_vertices),
+        opts.huge_pages,
+        opts.numa_aware);
 }
 
 void ingest_vertices(lg::Graph& graph, uint32_t num_vertices) {
@@ -313,6 +342,58 @@ void ingest_edges(lg::Graph& graph, const LoadedGraph& loaded, const Options& op
     }
 }
 
+std::vector<std::pair<lg::vertex_t, lg::vertex_t>> group_edges(const LoadedGraph& loaded,
+                                                                const std::vector<uint32_t>& degree,
+                                                                bool by_dst,
+                                                                size_t num_threads) {
+    std::vector<size_t> cursor(static_cast<size_t>(loaded.num_vertices) + 1, 0);
+    for (uint32_t v = 0; v < loaded.num_vertices; ++v) {
+        cursor[v + 1] = cursor[v] + degree[v];
+    }
+
+    std::vector<std::pair<lg::vertex_t, lg::vertex_t>> grouped(loaded.edges.size());
+    const int threads = static_cast<int>(clamp_thread_count(num_threads, loaded.edges.size()));
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int64_t i = 0; i < static_cast<int64_t>(loaded.edges.size()); ++i) {
+        const auto& edge = loaded.edges[static_cast<size_t>(i)];
+        const uint32_t key = by_dst ? edge.dst : edge.src;
+        const uint32_t value = by_dst ? edge.src : edge.dst;
+        const size_t pos = __atomic_fetch_add(&cursor[key], 1, __ATOMIC_RELAXED);
+        grouped[pos] = {key, value};
+    }
+    return grouped;
+}
+
+void bulk_ingest_edges(lg::Graph& graph, const LoadedGraph& loaded, const Options& opts) {
+    std::printf("[ingest] bulk loading %zu edges\n", loaded.edges.size());
+    tbb::global_control thread_limit(tbb::global_control::max_allowed_parallelism, opts.num_threads);
+    const auto ingest_begin = std::chrono::steady_clock::now();
+
+    const std::pair<const char*, bool> directions[] = {{"out", false}, {"in", true}};
+    for (lg::label_t label = 0; label < 2; ++label) {
+        const auto [name, by_dst] = directions[label];
+        const auto group_begin = std::chrono::steady_clock::now();
+        const auto grouped =
+            group_edges(loaded, by_dst ? loaded.in_degree : loaded.out_degree, by_dst, opts.num_threads);
+        const double group_seconds = seconds_since(group_begin);
+
+        const auto load_begin = std::chrono::steady_clock::now();
+        auto tx = graph.begin_batch_loader();
+        tx.bulk_put_edges(label, grouped.data(), grouped.size());
+        tx.commit();
+        std::printf("[ingest] bulk %s edges=%zu group_time=%.4f load_time=%.4f\n",
+                    name,
+                    grouped.size(),
+                    group_seconds,
+                    seconds_since(load_begin));
+    }
+
+    const double elapsed = seconds_since(ingest_begin);
+    std::printf("[ingest] bulk done elapsed=%.4f rate=%.4fM edges/s\n",
+                elapsed,
+                elapsed > 0.0 ? static_cast<double>(loaded.edges.size()) / elapsed / 1e6 : 0.0);
+}
+
 LiveGraphBenchmarkConfig make_benchmark_config(const Options& opts) {
     LiveGraphBenchmarkConfig config;
     config.algo_threads = opts.algo_threads;
@@ -324,8 +405,20 @@ LiveGraphBenchmarkConfig make_benchmark_config(const Options& opts) {
     return config;
 }
 
+double edge_block_bytes_per_edge(lg::Graph& graph) {
+    size_t num_bytes = 0;
+    size_t num_entries = 0;
+    for (lg::label_t label : {0, 1}) {
+        const auto usage = graph.get_edge_block_usage(label);
+        num_bytes += usage.first;
+        num_entries += usage.second;
+    }
+    return num_entries > 0 ? static_cast<double>(num_bytes) / static_cast<double>(num_entries) : 0.0;
+}
+
 void print_summary(double load_seconds,
                    double ingest_seconds,
+                   double bytes_per_edge,
                    long rss_ingest,
                    const LiveGraphBenchmarkResult& result,
                    size_t edge_count,
@@ -337,6 +430,7 @@ void print_summary(double load_seconds,
     std::printf(EXPOUT "BFS: %.4f\n", result.bfs_seconds);
     std::printf(EXPOUT "PR: %.4f\n", result.pr_seconds);
     std::printf(EXPOUT "CC: %.4f\n", result.cc_seconds);
+    std::printf(EXPOUT "Bytes_Per_Edge: %.4f\n", bytes_per_edge);
     std::printf(EXPOUT "RSS_Ingest: %ld\n", rss_ingest);
     std::printf(EXPOUT "RSS_BFS: %ld\n", result.rss_bfs);
     std::printf("[result] bfs_checksum=%zu pr_sum=%.8f cc_components=%zu total=%.4f ingest_bw=%.4fM edges/s\n",
@@ -412,23 +506,50 @@ int main(int argc, char* argv[]) {
 
         prepare_storage_dir(opts.storage_dir, opts.reset);
         lg::Graph graph = open_graph(opts, loaded.num_vertices);
+        if (opts.columnar) {
+            graph.set_columnar_label(0);
+            graph.set_columnar_label(1);
+        }
 
         const auto ingest_begin = std::chrono::steady_clock::now();
         ingest_vertices(graph, loaded.num_vertices);
-        ingest_edges(graph, loaded, opts);
+        if (opts.bulk_load) {
+            bulk_ingest_edges(graph, loaded, opts);
+        } else {
+            ingest_edges(graph, loaded, opts);
+        }
         const double ingest_seconds = seconds_since(ingest_begin);
         const long rss_ingest = get_rss();
+        const double bytes_per_edge = edge_block_bytes_per_edge(graph);
+        const auto allocation_stats = graph.get_block_allocation_stats();
+        std::printf(EXPOUT "Local_Allocs: %zu\n", allocation_stats.first);
+        std::printf(EXPOUT "Remote_Allocs: %zu\n", allocation_stats.second);
 
         if (opts.debug_vertex >= 0) {
             print_vertex_neighbors(graph, loaded, static_cast<uint32_t>(opts.debug_vertex));
             return 0;
         }
 
-        const LiveGraphBenchmarkResult result = run_livegraph_graph_benchmarks_gapbs(
-            graph, loaded, make_benchmark_config(opts));
+        LiveGraphBenchmarkResult result;
+        if (opts.snapshot) {
+            const auto export_begin = std::chrono::steady_clock::now();
+            const lg::Snapshot out_snapshot = graph.export_snapshot(0);
+            const lg::Snapshot in_snapshot = graph.export_snapshot(1, out_snapshot.get_read_epoch_id());
+            const double export_seconds = seconds_since(export_begin);
+            std::printf("[snapshot] epoch=%ld out_edges=%zu in_edges=%zu time=%.4f\n",
+                        out_snapshot.get_read_epoch_id(),
+                        out_snapshot.get_num_edges(),
+                        in_snapshot.get_num_edges(),
+                        export_seconds);
+            std::printf(EXPOUT "Snapshot: %.4f\n", export_seconds);
+            result = run_snapshot_graph_benchmarks_gapbs(
+                out_snapshot, in_snapshot, loaded, make_benchmark_config(opts));
+        } else {
+            result = run_livegraph_graph_benchmarks_gapbs(graph, loaded, make_benchmark_config(opts));
+        }
         const double total_seconds = seconds_since(bench_begin);
         print_summary(
-            load_seconds, ingest_seconds, rss_ingest, result, loaded.edges.size(), total_seconds);
+            load_seconds, ingest_seconds, bytes_per_edge, rss_ingest, result, loaded.edges.size(), total_seconds);
         return 0;
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
@@ -13,7 +13,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "core/edge_iterator.hpp"
 #include "core/graph.hpp"
+#include "core/snapshot.hpp"
 #include "core/transaction.hpp"
 
 using namespace livegraph;
@@ -123,6 +131,17 @@ timestamp_t Graph::compact(timestamp_t read_epoch_id)
                         continue;
                     compact_n2o_blocks(pointer);
 
+                    if (edge_block->is_columnar())
+                    {
+                        auto new_pointer = compact_columnar_edge_block(pointer, read_epoch_id);
+                        if (new_pointer != pointer)
+                        {
+                            need_future_compact = true;
+                            label_entry.set_pointer(new_pointer);
+                        }
+                        continue;
+                    }
+
                     size_t new_num_entries = 0;
                     size_t new_data_length = 0;
 
@@ -158,7 +177,7 @@ timestamp_t Graph::compact(timestamp_t read_epoch_id)
                     }
                     order = size_to_order(size);
 
-                    auto new_pointer = block_manager.alloc(order);
+                    auto new_pointer = block_manager.alloc(order, pointer);
 
                     auto new_edge_block = block_manager.convert<EdgeBlockHeader>(new_pointer);
                     new_edge_block->fill(order, vid, read_epoch_id, pointer, edge_block->get_committed_time());
@@ -192,3 +211,204 @@ timestamp_t Graph::compact(timestamp_t read_epoch_id)
 
     return read_epoch_id;
 }
+
+uintptr_t Graph::compact_columnar_edge_block(uintptr_t pointer, timestamp_t read_epoch_id)
+{
+    auto edge_block = block_manager.convert<ColumnarEdgeBlockHeader>(pointer);
+    auto dsts = edge_block->get_dsts();
+    auto creation_times = edge_block->get_creation_times();
+    auto deletion_times = edge_block->get_deletion_times();
+    auto num_entries = edge_block->get_num_entries();
+
+    // Deleted before the minimal epoch or rolled back
+    auto is_garbage = [&](size_t i) {
+        return creation_times[i] == ROLLBACK_TOMBSTONE || cmp_timestamp(deletion_times + i, read_epoch_id) <= 0;
+    };
+
+    size_t new_num_entries = 0;
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        if (!is_garbage(i))
+            new_num_entries++;
+    }
+
+    if (new_num_entries == num_entries)
+        return pointer;
+
+    auto order = ColumnarEdgeBlockHeader::entries_to_order(new_num_entries);
+
+    auto new_pointer = block_manager.alloc(order, pointer);
+
+    auto new_edge_block = block_manager.convert<ColumnarEdgeBlockHeader>(new_pointer);
+    new_edge_block->fill(order, edge_block->get_vertex_id(), read_epoch_id, pointer, edge_block->get_committed_time());
+
+    auto bloom_filter = new_edge_block->get_bloom_filter();
+    size_t num_deleted = 0;
+    timestamp_t max_creation_time = 0;
+    new_num_entries = 0;
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        if (is_garbage(i))
+            continue;
+        new_edge_block->append_without_update_size(
+            dsts[i], creation_times[i], deletion_times[i], new_num_entries++, bloom_filter);
+        if (deletion_times[i] != ROLLBACK_TOMBSTONE)
+            num_deleted++;
+        max_creation_time = std::max(max_creation_time, creation_times[i]);
+    }
+    new_edge_block->add_num_deleted(num_deleted);
+    new_edge_block->set_max_creation_time(max_creation_time);
+    new_edge_block->set_num_entries_data_length_atomic(new_num_entries, 0);
+
+    return new_pointer;
+}
+
+std::pair<size_t, size_t> Graph::get_edge_block_usage(label_t label)
+{
+    size_t num_bytes = 0, num_entries = 0;
+    auto max_vertex_id = vertex_id.load(std::memory_order_relaxed);
+    for (vertex_t vid = 0; vid < max_vertex_id; vid++)
+    {
+        auto edge_label_block = block_manager.convert<EdgeLabelBlockHeader>(edge_label_ptrs[vid]);
+        if (!edge_label_block)
+            continue;
+        for (size_t i = 0; i < edge_label_block->get_num_entries(); i++)
+        {
+            auto label_entry = edge_label_block->get_entries()[i];
+            if (label_entry.get_label() != label)
+                continue;
+            auto edge_block = block_manager.convert<EdgeBlockCommonHeader>(label_entry.get_pointer());
+            if (edge_block)
+            {
+                num_bytes += edge_block->get_block_size();
+                num_entries += edge_block->get_num_entries();
+            }
+        }
+    }
+    return {num_bytes, num_entries};
+}
+
+EdgeIterator Graph::get_edges_at(vertex_t src, label_t label, timestamp_t read_epoch_id)
+{
+    auto edge_label_block = block_manager.convert<EdgeLabelBlockHeader>(edge_label_ptrs[src]);
+    uintptr_t pointer = block_manager.NULLPOINTER;
+    for (size_t i = 0; edge_label_block && i < edge_label_block->get_num_entries(); i++)
+    {
+        auto label_entry = edge_label_block->get_entries()[i];
+        if (label_entry.get_label() == label)
+        {
+            pointer = label_entry.get_pointer();
+            break;
+        }
+    }
+
+    auto edge_block = block_manager.convert<EdgeBlockCommonHeader>(pointer);
+    while (edge_block && cmp_timestamp(edge_block->get_creation_time_pointer(), read_epoch_id) > 0)
+        edge_block = block_manager.convert<EdgeBlockCommonHeader>(edge_block->get_prev_pointer());
+
+    if (!edge_block)
+        return EdgeIterator(nullptr, nullptr, 0, 0, read_epoch_id, RO_TRANSACTION, true);
+
+    auto [num_entries, data_length] = edge_block->get_num_entries_data_length_atomic();
+    if (edge_block->is_columnar())
+        return EdgeIterator(static_cast<ColumnarEdgeBlockHeader *>(edge_block), num_entries, read_epoch_id,
+                            RO_TRANSACTION, true);
+    auto row_block = static_cast<EdgeBlockHeader *>(edge_block);
+    return EdgeIterator(row_block->get_entries(), row_block->get_data(), num_entries, data_length, read_epoch_id,
+                        RO_TRANSACTION, true);
+}
+
+Snapshot Graph::export_snapshot(label_t label, timestamp_t read_epoch_id, bool with_edge_data)
+{
+    auto latest_epoch_id = epoch_id.load(std::memory_order_acquire);
+    if (read_epoch_id == NO_TRANSACTION)
+        read_epoch_id = latest_epoch_id;
+    else if (read_epoch_id < 0 || read_epoch_id > latest_epoch_id)
+        throw std::invalid_argument("The read epoch is invalid.");
+
+    // Keep compaction away from the blocks visible at read_epoch_id while they are copied
+    auto &pinned_epoch_id = read_epoch_table.local();
+    auto prev_pinned_epoch_id = pinned_epoch_id;
+    if (pinned_epoch_id == NO_TRANSACTION || pinned_epoch_id > read_epoch_id)
+        pinned_epoch_id = read_epoch_id;
+
+    auto num_vertices = vertex_id.load(std::memory_order_acquire);
+    Snapshot snapshot(label, read_epoch_id, num_vertices, with_edge_data);
+    auto &offsets = snapshot.offsets;
+    std::vector<size_t> data_offsets(with_edge_data ? num_vertices + 1 : 0, 0);
+
+    try
+    {
+        // Count the visible edges (and data bytes) of each vertex, then fill the arrays at their prefix sums
+        tbb::parallel_for(tbb::blocked_range<vertex_t>(0, num_vertices, SNAPSHOT_GRAIN),
+                          [&](const tbb::blocked_range<vertex_t> &range) {
+                              for (auto src = range.begin(); src < range.end(); src++)
+                              {
+                                  size_t num_edges = 0, data_length = 0;
+                                  for (auto iter = get_edges_at(src, label, read_epoch_id); iter.valid(); iter.next())
+                                  {
+                                      num_edges++;
+                                      if (with_edge_data)
+                                          data_length += iter.edge_data().size();
+                                  }
+                                  offsets[src + 1] = num_edges;
+                                  if (with_edge_data)
+                                      data_offsets[src + 1] = data_length;
+                              }
+                          });
+
+        for (vertex_t src = 0; src < num_vertices; src++)
+        {
+            offsets[src + 1] += offsets[src];
+            if (with_edge_data)
+                data_offsets[src + 1] += data_offsets[src];
+        }
+
+        snapshot.dsts.resize(offsets[num_vertices]);
+        if (with_edge_data)
+        {
+            snapshot.data_offsets.resize(offsets[num_vertices] + 1);
+            snapshot.data_offsets[offsets[num_vertices]] = data_offsets[num_vertices];
+            snapshot.data.resize(data_offsets[num_vertices]);
+        }
+
+        tbb::parallel_for(tbb::blocked_range<vertex_t>(0, num_vertices, SNAPSHOT_GRAIN),
+                          [&](const tbb::blocked_range<vertex_t> &range) {
+                              for (auto src = range.begin(); src < range.end(); src++)
+                              {
+                                  // the slice of src was sized by the count pass: never write past it, and
+                                  // fail if the scan at the same epoch does not find the same edges again
+                                  auto edge = offsets[src];
+                                  auto edge_end = offsets[src + 1];
+                                  auto data_offset = with_edge_data ? data_offsets[src] : 0;
+                                  auto iter = get_edges_at(src, label, read_epoch_id);
+                                  for (; iter.valid() && edge < edge_end; iter.next())
+                                  {
+                                      snapshot.dsts[edge] = iter.dst_id();
+                                      if (with_edge_data)
+                                      {
+                                          auto edge_data = iter.edge_data();
+                                          if (data_offset + edge_data.size() > data_offsets[src + 1])
+                                              throw std::runtime_error("Edges changed while exporting the snapshot.");
+                                          snapshot.data_offsets[edge] = data_offset;
+                                          std::copy(edge_data.begin(), edge_data.end(),
+                                                    snapshot.data.begin() + data_offset);
+                                          data_offset += edge_data.size();
+                                      }
+                                      edge++;
+                                  }
+                                  if (iter.valid() || edge != edge_end)
+                                      throw std::runtime_error("Edges changed while exporting the snapshot.");
+                              }
+                          });
+    }
+    catch (...)
+    {
+        pinned_epoch_id = prev_pinned_epoch_id;
+        throw;
+    }
+
+    pinned_epoch_id = prev_pinned_epoch_id;
+
+    return snapshot;
+}
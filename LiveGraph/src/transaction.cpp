@@ -13,6 +13,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include "core/transaction.hpp"
 #include "core/edge_iterator.hpp"
 #include "core/graph.hpp"
@@ -76,7 +81,7 @@ void Transaction::put_vertex(vertex_t vertex_id, std::string_view data)
 
     auto size = sizeof(VertexBlockHeader) + data.size();
     auto order = size_to_order(size);
-    auto pointer = graph.block_manager.alloc(order);
+    auto pointer = graph.block_manager.alloc(order, prev_pointer);
 
     auto vertex_block = graph.block_manager.convert<VertexBlockHeader>(pointer);
     vertex_block->fill(order, vertex_id, write_epoch_id, prev_pointer, data.data(), data.size());
@@ -133,7 +138,7 @@ bool Transaction::del_vertex(vertex_t vertex_id, bool recycle)
         ret = true;
         auto size = sizeof(VertexBlockHeader);
         auto order = size_to_order(size);
-        auto pointer = graph.block_manager.alloc(order);
+        auto pointer = graph.block_manager.alloc(order, prev_pointer);
 
         auto vertex_block = graph.block_manager.convert<VertexBlockHeader>(pointer);
         vertex_block->fill(order, vertex_id, write_epoch_id, prev_pointer, nullptr, vertex_block->TOMBSTONE);
@@ -250,7 +255,7 @@ uintptr_t Transaction::locate_edge_block(vertex_t src, label_t label)
             auto pointer = label_entry.get_pointer();
             while (pointer != graph.block_manager.NULLPOINTER)
             {
-                auto edge_block = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+                auto edge_block = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
                 if (cmp_timestamp(edge_block->get_creation_time_pointer(), read_epoch_id, local_txn_id) <= 0)
                     break;
                 pointer = edge_block->get_prev_pointer();
@@ -275,7 +280,7 @@ void Transaction::ensure_no_confict(vertex_t src, label_t label)
             auto pointer = label_entry.get_pointer();
             if (pointer != graph.block_manager.NULLPOINTER)
             {
-                auto header = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+                auto header = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
                 if (header && cmp_timestamp(header->get_committed_time_pointer(), read_epoch_id, local_txn_id) > 0)
                     throw RollbackExcept("Write-write confict on: " + std::to_string(src) + ": " +
                                          std::to_string(label) + ".");
@@ -312,7 +317,7 @@ void Transaction::update_edge_label_block(vertex_t src, label_t label, uintptr_t
         auto size = sizeof(EdgeLabelBlockHeader) + (1 + num_entries) * sizeof(EdgeLabelEntry);
         auto order = size_to_order(size);
 
-        auto new_pointer = graph.block_manager.alloc(order);
+        auto new_pointer = graph.block_manager.alloc(order, pointer);
 
         auto new_edge_label_block = graph.block_manager.convert<EdgeLabelBlockHeader>(new_pointer);
         new_edge_label_block->fill(order, src, write_epoch_id, pointer);
@@ -342,6 +347,8 @@ void Transaction::put_edge(vertex_t src, label_t label, vertex_t dst, std::strin
     check_writable();
     check_vertex_id(src);
     check_vertex_id(dst);
+    if (!edge_data.empty() && graph.is_columnar_label(label))
+        throw std::invalid_argument("Columnar labels do not store edge data.");
 
     uintptr_t pointer;
     if (batch_update)
@@ -365,6 +372,33 @@ void Transaction::put_edge(vertex_t src, label_t label, vertex_t dst, std::strin
         }
     }
 
+    if (use_columnar_block(pointer, label))
+        pointer = put_columnar_edge(src, label, dst, pointer, force_insert);
+    else
+        pointer = put_row_edge(src, label, dst, pointer, edge_data, force_insert);
+
+    graph.compact_table.local().emplace(src);
+
+    if (batch_update)
+    {
+        graph.vertex_futexes[src].unlock();
+    }
+    else
+    {
+        edge_ptr_cache[std::make_pair(src, label)] = pointer;
+        ++wal_num_ops();
+        wal_append(OPType::PutEdge);
+        wal_append(src);
+        wal_append(label);
+        wal_append(dst);
+        wal_append(force_insert);
+        wal_append(edge_data);
+    }
+}
+
+uintptr_t Transaction::put_row_edge(
+    vertex_t src, label_t label, vertex_t dst, uintptr_t pointer, std::string_view edge_data, bool force_insert)
+{
     EdgeEntry entry;
     entry.set_length(edge_data.size());
     entry.set_dst(dst);
@@ -379,16 +413,9 @@ void Transaction::put_edge(vertex_t src, label_t label, vertex_t dst, std::strin
     if (!edge_block || !edge_block->has_space(entry, num_entries, data_length))
     {
         auto size = sizeof(EdgeBlockHeader) + (1 + num_entries) * sizeof(EdgeEntry) + data_length + entry.get_length();
-        auto order = size_to_order(size);
+        auto order = EdgeBlockHeader::size_to_order_with_bloom_filter(size);
 
-        if (order > edge_block->BLOOM_FILTER_PORTION &&
-            size + (1ul << (order - edge_block->BLOOM_FILTER_PORTION)) >= (1ul << edge_block->BLOOM_FILTER_THRESHOLD))
-        {
-            size += 1ul << (order - edge_block->BLOOM_FILTER_PORTION);
-        }
-        order = size_to_order(size);
-
-        auto new_pointer = graph.block_manager.alloc(order);
+        auto new_pointer = graph.block_manager.alloc(order, pointer);
 
         auto new_edge_block = graph.block_manager.convert<EdgeBlockHeader>(new_pointer);
         new_edge_block->fill(order, src, write_epoch_id, pointer, write_epoch_id);
@@ -447,23 +474,289 @@ void Transaction::put_edge(vertex_t src, label_t label, vertex_t dst, std::strin
     if (!batch_update)
         timestamps_to_update.emplace_back(edge->get_creation_time_pointer(), Graph::ROLLBACK_TOMBSTONE);
 
-    graph.compact_table.local().emplace(src);
+    return pointer;
+}
+
+uintptr_t Transaction::put_columnar_edge(vertex_t src, label_t label, vertex_t dst, uintptr_t pointer, bool force_insert)
+{
+    auto edge_block = graph.block_manager.convert<ColumnarEdgeBlockHeader>(pointer);
+
+    auto num_entries = edge_block ? get_num_entries_data_length_cache(edge_block).first : 0;
+
+    if (!edge_block || !edge_block->has_space(num_entries))
+    {
+        auto order = ColumnarEdgeBlockHeader::entries_to_order(num_entries + 1);
+
+        auto new_pointer = graph.block_manager.alloc(order, pointer);
+
+        auto new_edge_block = graph.block_manager.convert<ColumnarEdgeBlockHeader>(new_pointer);
+        new_edge_block->fill(order, src, write_epoch_id, pointer, write_epoch_id);
+
+        if (!batch_update)
+        {
+            block_cache.emplace_back(new_pointer, order);
+            timestamps_to_update.emplace_back(new_edge_block->get_creation_time_pointer(), Graph::ROLLBACK_TOMBSTONE);
+        }
+
+        size_t new_num_entries = 0;
+        if (edge_block)
+            new_num_entries = copy_columnar_entries(edge_block, num_entries, new_edge_block);
+        new_edge_block->set_num_entries_data_length_atomic(new_num_entries, 0);
+
+        if (batch_update)
+            update_edge_label_block(src, label, new_pointer);
+
+        pointer = new_pointer;
+        edge_block = new_edge_block;
+        num_entries = new_num_entries;
+    }
+
+    if (!force_insert)
+    {
+        auto prev_deletion_time = find_columnar_edge(dst, edge_block, num_entries);
+
+        if (prev_deletion_time)
+        {
+            edge_block->add_num_deleted();
+            *prev_deletion_time = write_epoch_id;
+            if (!batch_update)
+                timestamps_to_update.emplace_back(prev_deletion_time, Graph::ROLLBACK_TOMBSTONE);
+        }
+    }
+
+    update_max_creation_time(edge_block);
+
+    auto bloom_filter = edge_block->get_bloom_filter();
+    auto index = edge_block->append_without_update_size(
+        dst, write_epoch_id, Graph::ROLLBACK_TOMBSTONE, num_entries, bloom_filter);
+    set_num_entries_data_length_cache(edge_block, num_entries + 1, 0);
+    if (!batch_update)
+        timestamps_to_update.emplace_back(edge_block->get_creation_times() + index, Graph::ROLLBACK_TOMBSTONE);
+
+    return pointer;
+}
 
+size_t Transaction::copy_columnar_entries(ColumnarEdgeBlockHeader *edge_block,
+                                          size_t num_entries,
+                                          ColumnarEdgeBlockHeader *new_edge_block)
+{
+    auto dsts = edge_block->get_dsts();
+    auto creation_times = edge_block->get_creation_times();
+    auto deletion_times = edge_block->get_deletion_times();
+    auto new_creation_times = new_edge_block->get_creation_times();
+
+    auto bloom_filter = new_edge_block->get_bloom_filter();
+    size_t new_num_entries = 0, num_deleted = 0;
+    timestamp_t max_creation_time = 0;
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        // skip deleted edges and rolled back insertions
+        if (creation_times[i] == Graph::ROLLBACK_TOMBSTONE ||
+            cmp_timestamp(deletion_times + i, read_epoch_id, local_txn_id) <= 0)
+            continue;
+        new_edge_block->append_without_update_size(
+            dsts[i], creation_times[i], deletion_times[i], new_num_entries, bloom_filter);
+        if (deletion_times[i] != Graph::ROLLBACK_TOMBSTONE)
+            num_deleted++;
+        if (!batch_update && creation_times[i] == -local_txn_id)
+            timestamps_to_update.emplace_back(new_creation_times + new_num_entries, Graph::ROLLBACK_TOMBSTONE);
+        else
+            max_creation_time = std::max(max_creation_time, creation_times[i]);
+        new_num_entries++;
+    }
+    // Our own uncommitted entries are covered by update_max_creation_time() on the next append
+    new_edge_block->set_max_creation_time(max_creation_time);
+    new_edge_block->add_num_deleted(num_deleted);
+
+    return new_num_entries;
+}
+
+void Transaction::update_max_creation_time(ColumnarEdgeBlockHeader *edge_block)
+{
+    // ROLLBACK_TOMBSTONE marks blocks holding rolled back entries, it sticks until the block is copied
+    auto max_creation_time = edge_block->get_max_creation_time_pointer();
+    if (*max_creation_time == Graph::ROLLBACK_TOMBSTONE)
+        return;
     if (batch_update)
     {
-        graph.vertex_futexes[src].unlock();
+        if (*max_creation_time < write_epoch_id)
+            *max_creation_time = write_epoch_id;
     }
-    else
+    else if (*max_creation_time != write_epoch_id)
     {
-        edge_ptr_cache[std::make_pair(src, label)] = pointer;
-        ++wal_num_ops();
-        wal_append(OPType::PutEdge);
-        wal_append(src);
-        wal_append(label);
-        wal_append(dst);
-        wal_append(force_insert);
-        wal_append(edge_data);
+        timestamps_to_update.emplace_back(max_creation_time, Graph::ROLLBACK_TOMBSTONE);
+        *max_creation_time = write_epoch_id;
+    }
+}
+
+timestamp_t *Transaction::find_columnar_edge(vertex_t dst, ColumnarEdgeBlockHeader *edge_block, size_t num_entries)
+{
+    if (!edge_block)
+        return nullptr;
+
+    auto bloom_filter = edge_block->get_bloom_filter();
+    if (bloom_filter.valid() && !bloom_filter.find(dst))
+        return nullptr;
+
+    auto dsts = edge_block->get_dsts();
+    auto creation_times = edge_block->get_creation_times();
+    auto deletion_times = edge_block->get_deletion_times();
+    for (size_t i = num_entries; i-- > 0;)
+    {
+        if (dsts[i] == dst && cmp_timestamp(creation_times + i, read_epoch_id, local_txn_id) <= 0 &&
+            cmp_timestamp(deletion_times + i, read_epoch_id, local_txn_id) > 0)
+        {
+            return deletion_times + i;
+        }
+    }
+
+    return nullptr;
+}
+
+bool Transaction::use_columnar_block(uintptr_t pointer, label_t label)
+{
+    // Blocks keep their layout until compacted, the label setting only applies to new chains
+    auto edge_block = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
+    if (edge_block)
+        return edge_block->is_columnar();
+    return graph.is_columnar_label(label);
+}
+
+void Transaction::bulk_put_edges(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges)
+{
+    check_valid();
+    check_writable();
+    if (!batch_update)
+        throw std::invalid_argument("Bulk loading requires a batch loader.");
+
+    // Validate everything before the first block is allocated, so a bad edge leaves the graph untouched
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_edges, BULK_LOAD_GRAIN),
+                      [&](const tbb::blocked_range<size_t> &range) {
+                          for (auto i = range.begin(); i < range.end(); i++)
+                          {
+                              check_vertex_id(edges[i].first);
+                              check_vertex_id(edges[i].second);
+                          }
+                      });
+
+    // Each range owns the groups that start inside it, including their tails past the range end
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_edges, BULK_LOAD_GRAIN),
+                      [&](const tbb::blocked_range<size_t> &range) {
+                          auto begin = range.begin();
+                          while (begin < range.end() && begin > 0 && edges[begin].first == edges[begin - 1].first)
+                              begin++;
+                          while (begin < range.end())
+                          {
+                              auto end = begin + 1;
+                              while (end < num_edges && edges[end].first == edges[begin].first)
+                                  end++;
+                              bulk_put_edge_group(label, edges + begin, end - begin);
+                              begin = end;
+                          }
+                      });
+}
+
+void Transaction::bulk_put_edge_group(label_t label, const std::pair<vertex_t, vertex_t> *edges, size_t num_edges)
+{
+    auto src = edges[0].first;
+    auto pointer = locate_edge_block(src, label);
+    if (use_columnar_block(pointer, label))
+    {
+        bulk_put_columnar_edge_group(label, edges, num_edges, pointer);
+        return;
+    }
+
+    auto edge_block = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+    auto [num_entries, data_length] =
+        edge_block ? edge_block->get_num_entries_data_length_atomic() : std::pair<size_t, size_t>{0, 0};
+
+    // The degree is known up front, so the block is sized once instead of doubling per put_edge
+    auto size = sizeof(EdgeBlockHeader) + (num_edges + num_entries) * sizeof(EdgeEntry) + data_length;
+    auto order = size_to_order(size);
+
+    if (order > EdgeBlockHeader::BLOOM_FILTER_PORTION &&
+        size + (1ul << (order - EdgeBlockHeader::BLOOM_FILTER_PORTION)) >=
+            (1ul << EdgeBlockHeader::BLOOM_FILTER_THRESHOLD))
+    {
+        size += 1ul << (order - EdgeBlockHeader::BLOOM_FILTER_PORTION);
+    }
+    order = size_to_order(size);
+
+    auto new_pointer = graph.block_manager.alloc_from_arena(order);
+
+    auto new_edge_block = graph.block_manager.convert<EdgeBlockHeader>(new_pointer);
+    new_edge_block->fill(order, src, write_epoch_id, pointer, write_epoch_id);
+
+    auto bloom_filter = new_edge_block->get_bloom_filter();
+    if (edge_block)
+    {
+        auto entries = edge_block->get_entries();
+        auto data = edge_block->get_data();
+        for (size_t i = 0; i < num_entries; i++)
+        {
+            entries--;
+            if (cmp_timestamp(entries->get_deletion_time_pointer(), read_epoch_id, local_txn_id) > 0)
+                new_edge_block->append(*entries, data, bloom_filter);
+            data += entries->get_length();
+        }
+        graph.compact_table.local().emplace(src);
     }
+
+    std::tie(num_entries, data_length) = new_edge_block->get_num_entries_data_length_atomic();
+    auto entries = new_edge_block->get_entries() - num_entries;
+    for (size_t i = 0; i < num_edges; i++)
+    {
+        entries--;
+        entries->set_length(0);
+        entries->set_dst(edges[i].second);
+        entries->set_creation_time(write_epoch_id);
+        entries->set_deletion_time(Graph::ROLLBACK_TOMBSTONE);
+        if (bloom_filter.valid())
+            bloom_filter.insert(edges[i].second);
+    }
+    compiler_fence();
+    new_edge_block->set_num_entries_data_length_atomic(num_entries + num_edges, data_length);
+
+    update_edge_label_block(src, label, new_pointer);
+}
+
+void Transaction::bulk_put_columnar_edge_group(label_t label,
+                                               const std::pair<vertex_t, vertex_t> *edges,
+                                               size_t num_edges,
+                                               uintptr_t pointer)
+{
+    auto src = edges[0].first;
+    auto edge_block = graph.block_manager.convert<ColumnarEdgeBlockHeader>(pointer);
+    auto num_entries = edge_block ? edge_block->get_num_entries_data_length_atomic().first : 0;
+
+    auto order = ColumnarEdgeBlockHeader::entries_to_order(num_edges + num_entries);
+
+    auto new_pointer = graph.block_manager.alloc_from_arena(order);
+
+    auto new_edge_block = graph.block_manager.convert<ColumnarEdgeBlockHeader>(new_pointer);
+    new_edge_block->fill(order, src, write_epoch_id, pointer, write_epoch_id);
+
+    auto bloom_filter = new_edge_block->get_bloom_filter();
+    num_entries = edge_block ? copy_columnar_entries(edge_block, num_entries, new_edge_block) : 0;
+    if (edge_block)
+        graph.compact_table.local().emplace(src);
+
+    auto dsts = new_edge_block->get_dsts();
+    auto creation_times = new_edge_block->get_creation_times();
+    auto deletion_times = new_edge_block->get_deletion_times();
+    for (size_t i = 0; i < num_edges; i++)
+    {
+        dsts[num_entries + i] = edges[i].second;
+        creation_times[num_entries + i] = write_epoch_id;
+        deletion_times[num_entries + i] = Graph::ROLLBACK_TOMBSTONE;
+        if (bloom_filter.valid())
+            bloom_filter.insert(edges[i].second);
+    }
+    update_max_creation_time(new_edge_block);
+    compiler_fence();
+    new_edge_block->set_num_entries_data_length_atomic(num_entries + num_edges, 0);
+
+    update_edge_label_block(src, label, new_pointer);
 }
 
 bool Transaction::del_edge(vertex_t src, label_t label, vertex_t dst)
@@ -495,19 +788,36 @@ bool Transaction::del_edge(vertex_t src, label_t label, vertex_t dst)
         }
     }
 
-    auto edge_block = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+    auto edge_block = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
 
     if (!edge_block)
+    {
+        if (batch_update)
+            graph.vertex_futexes[src].unlock();
         return false;
+    }
 
     auto [num_entries, data_length] = get_num_entries_data_length_cache(edge_block);
-    auto edge = find_edge(dst, edge_block, num_entries, data_length);
+    timestamp_t *deletion_time = nullptr;
+    if (edge_block->is_columnar())
+    {
+        auto columnar_block = static_cast<ColumnarEdgeBlockHeader *>(edge_block);
+        deletion_time = find_columnar_edge(dst, columnar_block, num_entries);
+        if (deletion_time)
+            columnar_block->add_num_deleted();
+    }
+    else
+    {
+        auto edge = find_edge(dst, static_cast<EdgeBlockHeader *>(edge_block), num_entries, data_length);
+        if (edge.first)
+            deletion_time = edge.first->get_deletion_time_pointer();
+    }
 
-    if (edge.first)
+    if (deletion_time)
     {
-        edge.first->set_deletion_time(write_epoch_id);
+        *deletion_time = write_epoch_id;
         if (!batch_update)
-            timestamps_to_update.emplace_back(edge.first->get_deletion_time_pointer(), Graph::ROLLBACK_TOMBSTONE);
+            timestamps_to_update.emplace_back(deletion_time, Graph::ROLLBACK_TOMBSTONE);
     }
 
     graph.compact_table.local().emplace(src);
@@ -529,10 +839,7 @@ bool Transaction::del_edge(vertex_t src, label_t label, vertex_t dst)
         wal_append(dst);
     }
 
-    if (edge.first != nullptr)
-        return true;
-    else
-        return false;
+    return deletion_time != nullptr;
 }
 
 std::string_view Transaction::get_edge(vertex_t src, label_t label, vertex_t dst)
@@ -561,13 +868,22 @@ std::string_view Transaction::get_edge(vertex_t src, label_t label, vertex_t dst
         }
     }
 
-    auto edge_block = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+    auto edge_block = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
 
     if (!edge_block)
         return std::string_view();
 
     auto [num_entries, data_length] = get_num_entries_data_length_cache(edge_block);
-    auto edge = find_edge(dst, edge_block, num_entries, data_length);
+
+    // Columnar edges carry no data, an empty non-null view tells them apart from missing edges
+    if (edge_block->is_columnar())
+    {
+        if (find_columnar_edge(dst, static_cast<ColumnarEdgeBlockHeader *>(edge_block), num_entries))
+            return std::string_view("");
+        return std::string_view();
+    }
+
+    auto edge = find_edge(dst, static_cast<EdgeBlockHeader *>(edge_block), num_entries, data_length);
 
     if (edge.first)
         return std::string_view(edge.second, edge.first->get_length());
@@ -623,13 +939,18 @@ EdgeIterator Transaction::get_edges(vertex_t src, label_t label, bool reverse)
         }
     }
 
-    auto edge_block = graph.block_manager.convert<EdgeBlockHeader>(pointer);
+    auto common_block = graph.block_manager.convert<EdgeBlockCommonHeader>(pointer);
 
-    if (!edge_block)
+    if (!common_block)
         return EdgeIterator(nullptr, nullptr, 0, 0, read_epoch_id, local_txn_id, reverse);
 
-    auto [num_entries, data_length] = get_num_entries_data_length_cache(edge_block);
+    auto [num_entries, data_length] = get_num_entries_data_length_cache(common_block);
+
+    if (common_block->is_columnar())
+        return EdgeIterator(static_cast<ColumnarEdgeBlockHeader *>(common_block), num_entries, read_epoch_id,
+                            local_txn_id, reverse);
 
+    auto edge_block = static_cast<EdgeBlockHeader *>(common_block);
     return EdgeIterator(edge_block->get_entries(), edge_block->get_data(), num_entries, data_length, read_epoch_id,
                         local_txn_id, reverse);
 }
@@ -14,6 +14,7 @@
  */
 
 #include <doctest/doctest.h>
+#include <cstdio>
 
 #include "blocks.cpp"
 #include "core/block_manager.hpp"
@@ -36,3 +37,50 @@ TEST_CASE("testing the BlockManager")
 
     CHECK(manager.convert<char>(manager.NULLPOINTER) == nullptr);
 }
+
+TEST_CASE("testing the BlockManager with huge pages and NUMA partitions")
+{
+    BlockManager manager("", 1ul << 32, true, true);
+    CHECK(manager.get_num_nodes() >= 1);
+
+    std::vector<std::pair<uintptr_t, order_t>> blocks;
+    for (order_t order = 5; order < 22; order++)
+    {
+        auto pointer = manager.alloc(order);
+        CHECK(pointer != manager.NULLPOINTER);
+        *manager.convert<uint64_t>(pointer) = pointer;
+        blocks.emplace_back(pointer, order);
+    }
+    blocks.emplace_back(manager.alloc_from_arena(10), 10);
+    for (auto [pointer, order] : blocks)
+    {
+        if (order != 10)
+            CHECK(*manager.convert<uint64_t>(pointer) == pointer);
+        manager.free(pointer, order);
+    }
+
+    // Freed blocks are reused by the same thread
+    CHECK(manager.alloc(5) == blocks[0].first);
+
+    auto [local, remote] = manager.get_allocation_stats();
+    CHECK(local + remote == blocks.size() + 1);
+    if (manager.get_num_nodes() == 1)
+        CHECK(remote == 0);
+}
+
+TEST_CASE("testing the BlockManager placement and region checks")
+{
+    // Too small to give every node a huge page: one partition
+    CHECK(BlockManager("", 1ul << 21, false, true).get_num_nodes() == 1);
+
+    // Huge pages are not available on a regular block file
+    CHECK_THROWS_AS(BlockManager("./block_huge.mmap", 1ul << 32, true), std::runtime_error);
+    std::remove("./block_huge.mmap");
+
+    BlockManager manager("", 1ul << 32, false, true);
+    auto vertex = manager.alloc(5);
+    auto large = manager.alloc(22, vertex);
+    manager.free(large, 22);
+    // Large blocks go back to their node and are reused for blocks placed there
+    CHECK(manager.alloc(22, vertex) == large);
+}
@@ -459,3 +459,79 @@ TEST_CASE("testing the EdgeBlockHeader")
         free(buf);
     }
 }
+
+TEST_CASE("testing the ColumnarEdgeBlockHeader")
+{
+    SUBCASE("ColumnarEdgeBlockHeader without BloomFilter")
+    {
+        const order_t log_size = 8; // size = 256 bytes, left 192 bytes, 8 edges
+        auto buf = malloc(1ul << log_size);
+        ColumnarEdgeBlockHeader &header = *(ColumnarEdgeBlockHeader *)buf;
+
+        header.fill(log_size, 233, 1, 0x1122334455667788ul, 2);
+        CHECK(header.is_columnar());
+        CHECK(header.get_type() == BlockHeader::Type::COLUMNAR_EDGE);
+        CHECK(header.get_vertex_id() == 233);
+        CHECK(header.get_creation_time() == 1);
+        CHECK(header.get_prev_pointer() == 0x1122334455667788ul);
+        CHECK(header.get_committed_time() == 2);
+        CHECK(header.get_max_creation_time() == 0);
+        CHECK(header.get_num_deleted() == 0);
+        CHECK(!header.get_bloom_filter().valid());
+        CHECK(header.get_capacity() == 8);
+
+        auto filter = header.get_bloom_filter();
+        for (size_t i = 0; i < header.get_capacity(); i++)
+        {
+            CHECK(header.has_space(i));
+            CHECK(header.append_without_update_size(100 + i, 10 + i, 20 + i, i, filter) == i);
+        }
+        CHECK(!header.has_space(header.get_capacity()));
+        header.set_num_entries_data_length_atomic(header.get_capacity(), 0);
+        CHECK(header.get_num_entries() == 8);
+        CHECK(header.get_data_length() == 0);
+
+        for (size_t i = 0; i < header.get_capacity(); i++)
+        {
+            CHECK(header.get_dsts()[i] == 100 + i);
+            CHECK(header.get_creation_times()[i] == (timestamp_t)(10 + i));
+            CHECK(header.get_deletion_times()[i] == (timestamp_t)(20 + i));
+        }
+        CHECK((char *)(header.get_deletion_times() + header.get_capacity()) <= (char *)buf + (1ul << log_size));
+
+        header.set_max_creation_time(17);
+        CHECK(*header.get_max_creation_time_pointer() == 17);
+        header.add_num_deleted();
+        header.add_num_deleted(2);
+        CHECK(header.get_num_deleted() == 3);
+
+        free(buf);
+    }
+
+    SUBCASE("ColumnarEdgeBlockHeader with BloomFilter")
+    {
+        const order_t log_size = ColumnarEdgeBlockHeader::entries_to_order(100);
+        CHECK(log_size == 12);
+        auto buf = aligned_alloc(1ul << log_size, 1ul << log_size);
+        ColumnarEdgeBlockHeader &header = *(ColumnarEdgeBlockHeader *)buf;
+
+        header.fill(log_size, 0, 1, 0, 1);
+        CHECK(header.get_bloom_filter().valid());
+        CHECK(header.get_bloom_filter_size() == (1ul << log_size) >> ColumnarEdgeBlockHeader::BLOOM_FILTER_PORTION);
+        CHECK(header.get_capacity() >= 100);
+
+        auto filter = header.get_bloom_filter();
+        for (size_t i = 0; i < 100; i++)
+            header.append_without_update_size(i * 3, 1, INT64_MAX, i, filter);
+        for (size_t i = 0; i < 100; i++)
+        {
+            CHECK(filter.find(i * 3));
+            CHECK(header.get_dsts()[i] == i * 3);
+        }
+        // The bloom filter is not overlapped by the columns
+        CHECK((char *)(header.get_deletion_times() + header.get_capacity()) <=
+              (char *)buf + (1ul << log_size) - header.get_bloom_filter_size());
+
+        free(buf);
+    }
+}
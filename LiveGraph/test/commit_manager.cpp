@@ -0,0 +1,147 @@
+/* Copyright 2020 Guanyu Feng, Tsinghua University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+#include "core/commit_manager.hpp"
+
+using namespace livegraph;
+
+TEST_CASE("testing the CommitManager")
+{
+    const size_t num_threads = 8, commits_per_thread = 1ul << 9;
+    // About 160KB of records go through a 4KB ring: it wraps and applies back-pressure many times over
+    const size_t buffer_size = 1ul << 12;
+    const std::string path = "./commit_manager.wal";
+    std::atomic<timestamp_t> global_epoch_id(0);
+    std::vector<size_t> seen(num_threads, 0);
+    size_t num_empty = 0;
+
+    {
+        CommitManager manager(path, global_epoch_id, buffer_size);
+
+        #pragma omp parallel for num_threads(num_threads)
+        for (size_t t = 0; t < num_threads; t++)
+        {
+            timestamp_t last_epoch_id = 0;
+            for (size_t i = 0; i < commits_per_thread; i++)
+            {
+                // Odd lengths exercise the padding, empty WALs must not stall the server
+                std::string wal((t * commits_per_thread + i) % 61, 'a' + t);
+                auto [epoch_id, num_unfinished] = manager.register_commit(wal);
+                CHECK(epoch_id > last_epoch_id);
+                last_epoch_id = epoch_id;
+                manager.finish_commit(epoch_id, num_unfinished, true);
+                CHECK(global_epoch_id.load() >= epoch_id);
+            }
+        }
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::string log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(log.size() >= CommitManager::FILE_HEADER_SIZE);
+    CHECK(reinterpret_cast<const uint64_t *>(log.data())[0] == CommitManager::WAL_MAGIC);
+    CHECK(reinterpret_cast<const uint64_t *>(log.data())[1] == CommitManager::WAL_FORMAT_VERSION);
+    size_t pos = CommitManager::FILE_HEADER_SIZE, num_txns = 0;
+    timestamp_t last_epoch_id = 0;
+    while (pos + 2 * sizeof(uint64_t) <= log.size())
+    {
+        auto epoch_id = *reinterpret_cast<const timestamp_t *>(log.data() + pos);
+        auto group_size = *reinterpret_cast<const uint64_t *>(log.data() + pos + sizeof(uint64_t));
+        if (epoch_id == 0)
+            break;
+        CHECK(epoch_id == last_epoch_id + 1);
+        last_epoch_id = epoch_id;
+        pos += 2 * sizeof(uint64_t);
+        for (size_t i = 0; i < group_size; i++)
+        {
+            auto length = *reinterpret_cast<const uint64_t *>(log.data() + pos);
+            REQUIRE(pos + sizeof(uint64_t) + length <= log.size());
+            auto wal = log.substr(pos + sizeof(uint64_t), length);
+            if (wal.empty())
+                num_empty++;
+            else
+            {
+                CHECK(wal == std::string(length, wal[0]));
+                seen[wal[0] - 'a']++;
+            }
+            num_txns++;
+            pos += (sizeof(uint64_t) + length + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+        }
+    }
+    CHECK(num_txns == num_threads * commits_per_thread);
+    // (t * commits_per_thread + i) % 61 == 0 once every 61 commits
+    CHECK(num_empty == (num_threads * commits_per_thread + 60) / 61);
+    for (size_t t = 0; t < num_threads; t++)
+        CHECK(seen[t] + (t * commits_per_thread + commits_per_thread + 60) / 61 -
+                  (t * commits_per_thread + 60) / 61 ==
+              commits_per_thread);
+    CHECK(global_epoch_id.load() == last_epoch_id);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("testing the CommitManager with a failed write")
+{
+    const std::string path = "./commit_manager_error.wal";
+    std::atomic<timestamp_t> global_epoch_id(0);
+    {
+        CommitManager manager(path, global_epoch_id);
+        auto commit = [&](const std::string &wal) {
+            auto [epoch_id, num_unfinished] = manager.register_commit(wal);
+            manager.finish_commit(epoch_id, num_unfinished, true);
+            return epoch_id;
+        };
+        CHECK(commit("first") == 1);
+
+        // Writes past the file size limit fail with EFBIG instead of raising SIGXFSZ
+        struct rlimit limit;
+        REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+        auto prev_handler = signal(SIGXFSZ, SIG_IGN);
+        struct rlimit no_writes = {0, limit.rlim_max};
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &no_writes) == 0);
+        CHECK_THROWS_AS(commit("lost"), std::runtime_error);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+        signal(SIGXFSZ, prev_handler);
+
+        // Only the failed group reports the error
+        CHECK(commit("second") == 3);
+        CHECK(global_epoch_id.load() == 3);
+    }
+
+    // The file is preallocated, the groups are at its head
+    std::ifstream in(path, std::ios::binary);
+    std::string log(1ul << 10, '\0');
+    in.read(log.data(), log.size());
+    auto group = [&](size_t pos) { return reinterpret_cast<const uint64_t *>(log.data() + pos); };
+    // The second group took the place of the failed one
+    size_t pos = CommitManager::FILE_HEADER_SIZE;
+    CHECK(group(pos)[0] == 1);
+    CHECK(log.substr(pos + 3 * sizeof(uint64_t), 5) == "first");
+    pos += 3 * sizeof(uint64_t) + 8;
+    CHECK(group(pos)[0] == 3);
+    CHECK(log.substr(pos + 3 * sizeof(uint64_t), 6) == "second");
+    std::remove(path.c_str());
+}
@@ -15,11 +15,13 @@
 
 #include <doctest/doctest.h>
 
+#include <atomic>
 #include <cstdio>
 #include <map>
 #include <mutex>
 #include <random>
 #include <string>
+#include <thread>
 
 #include <omp.h>
 
@@ -256,3 +258,122 @@ TEST_CASE_TEMPLATE("testing the Graph", GraphType, livegraph::Graph, lg::Graph)
 
     CHECK(std::remove("./block.mmap") == 0);
 }
+
+TEST_CASE("testing the Graph: export_snapshot")
+{
+    using namespace livegraph;
+    const vertex_t num_vertices = 2048;
+    const label_t label = 0;
+
+    Graph graph;
+    {
+        auto txn = graph.begin_batch_loader();
+        for (vertex_t i = 0; i < num_vertices; i++)
+            txn.new_vertex();
+        for (vertex_t i = 0; i < num_vertices; i++)
+            for (vertex_t j = 0; j < i % 16; j++)
+                txn.put_edge(i, label, (i + j) % num_vertices, std::to_string(j));
+        txn.commit();
+    }
+
+    auto old_txn = graph.begin_read_only_transaction();
+    auto old_epoch_id = old_txn.get_read_epoch_id();
+    {
+        auto txn = graph.begin_transaction();
+        txn.del_edge(1, label, 1);
+        txn.put_edge(0, label, 1, "new");
+        txn.commit();
+    }
+
+    auto check_snapshot = [&](const Snapshot &snapshot, Transaction &txn, bool with_edge_data) {
+        CHECK(snapshot.get_read_epoch_id() == txn.get_read_epoch_id());
+        CHECK(snapshot.get_num_vertices() == num_vertices);
+        size_t num_edges = 0;
+        for (vertex_t src = 0; src < num_vertices; src++)
+        {
+            auto iter = txn.get_edges(src, label, true);
+            auto snapshot_iter = snapshot.get_edges(src);
+            size_t degree = 0;
+            while (iter.valid())
+            {
+                REQUIRE(snapshot_iter.valid());
+                CHECK(snapshot_iter.dst_id() == iter.dst_id());
+                CHECK(snapshot.get_dsts()[snapshot.get_offsets()[src] + degree] == iter.dst_id());
+                if (with_edge_data)
+                    CHECK(snapshot_iter.edge_data() == iter.edge_data());
+                else
+                    CHECK(snapshot_iter.edge_data().empty());
+                iter.next();
+                snapshot_iter.next();
+                degree++;
+            }
+            CHECK(!snapshot_iter.valid());
+            CHECK(snapshot.get_degree(src) == degree);
+            num_edges += degree;
+        }
+        CHECK(snapshot.get_num_edges() == num_edges);
+    };
+
+    {
+        auto snapshot = graph.export_snapshot(label, old_epoch_id, true);
+        CHECK(snapshot.has_edge_data());
+        check_snapshot(snapshot, old_txn, true);
+        CHECK(snapshot.get_degree(0) == 0);
+        CHECK(snapshot.get_degree(1) == 1);
+    }
+    old_txn.abort();
+    {
+        auto txn = graph.begin_read_only_transaction();
+        auto snapshot = graph.export_snapshot(label);
+        CHECK(!snapshot.has_edge_data());
+        check_snapshot(snapshot, txn, false);
+        CHECK(snapshot.get_degree(0) == 1);
+        CHECK(snapshot.get_degree(1) == 0);
+        CHECK(!snapshot.get_edges(num_vertices).valid());
+        CHECK(graph.export_snapshot(label + 1).get_num_edges() == 0);
+    }
+    CHECK_THROWS_AS(graph.export_snapshot(label, 1ul << 40), std::invalid_argument);
+}
+
+TEST_CASE("testing the Graph: export_snapshot with concurrent writers")
+{
+    using namespace livegraph;
+    const vertex_t num_vertices = 256;
+    const label_t label = 0;
+
+    Graph graph;
+    {
+        auto txn = graph.begin_batch_loader();
+        for (vertex_t i = 0; i < num_vertices; i++)
+            txn.new_vertex();
+        txn.commit();
+    }
+
+    // the writer keeps growing the adjacency lists the snapshots are copying
+    std::atomic<bool> stop(false);
+    std::thread writer([&]() {
+        for (vertex_t j = 0; !stop.load(); j++)
+        {
+            auto txn = graph.begin_transaction();
+            for (vertex_t i = 0; i < num_vertices; i++)
+                txn.put_edge(i, label, j % num_vertices, std::string(j % 7, 'x'));
+            txn.commit();
+        }
+    });
+
+    for (int round = 0; round < 32; round++)
+    {
+        auto txn = graph.begin_read_only_transaction();
+        auto snapshot = graph.export_snapshot(label, txn.get_read_epoch_id(), true);
+        for (vertex_t src = 0; src < num_vertices; src += 17)
+        {
+            size_t degree = 0;
+            for (auto iter = txn.get_edges(src, label); iter.valid(); iter.next())
+                degree++;
+            CHECK(snapshot.get_degree(src) == degree);
+        }
+        txn.abort();
+    }
+    stop = true;
+    writer.join();
+}
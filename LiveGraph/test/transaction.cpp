@@ -473,3 +473,221 @@ TEST_CASE("testing the Transaction: put/get/del_edge")
         CHECK_THROWS_AS(txn.get_edge(0, 0, 1), std::invalid_argument);
     }
 }
+
+TEST_CASE("testing the Transaction: del_edge without an edge block")
+{
+    Graph graph;
+
+    {
+        auto txn = graph.begin_batch_loader();
+        CHECK(txn.new_vertex() == 0);
+        CHECK(txn.new_vertex() == 1);
+        // The batch loader locks the source vertex, a miss must release it for the next writer
+        CHECK(!txn.del_edge(0, 0, 1));
+        txn.put_edge(0, 0, 1, "a");
+        CHECK(txn.del_edge(0, 0, 1));
+        txn.commit();
+    }
+}
+
+TEST_CASE("testing the Transaction: bulk_put_edges")
+{
+    Graph graph;
+
+    const vertex_t vertices = 4096;
+    const label_t label = 0;
+
+    {
+        auto txn = graph.begin_batch_loader();
+        for (vertex_t i = 0; i < vertices; i++)
+            CHECK(txn.new_vertex() == i);
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_batch_loader();
+        txn.put_edge(1, label, 0, "");
+        txn.commit();
+    }
+
+    // Vertex i has i % 64 out edges, so both small and bloom filtered blocks are built
+    std::vector<std::pair<vertex_t, vertex_t>> edges;
+    for (vertex_t i = 0; i < vertices; i++)
+        for (vertex_t j = 0; j < i % 64; j++)
+            edges.emplace_back(i, (i + j * 7) % vertices);
+    edges.emplace_back(vertices - 1, 0);
+    edges.emplace_back(vertices - 1, 0);
+
+    {
+        auto txn = graph.begin_batch_loader();
+        txn.bulk_put_edges(label, edges.data(), edges.size());
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        size_t begin = 0;
+        for (vertex_t i = 0; i < vertices; i++)
+        {
+            std::vector<vertex_t> expected;
+            if (i == 1)
+                expected.emplace_back(0);
+            while (begin < edges.size() && edges[begin].first == i)
+                expected.emplace_back(edges[begin++].second);
+            std::vector<vertex_t> loaded;
+            auto iter = txn.get_edges(i, label, true);
+            while (iter.valid())
+            {
+                loaded.emplace_back(iter.dst_id());
+                iter.next();
+            }
+            CHECK(loaded == expected);
+            for (auto dst : expected)
+                CHECK(txn.get_edge(i, label, dst) == "");
+        }
+        CHECK(txn.get_edges(0, label + 1).valid() == false);
+    }
+    {
+        auto txn = graph.begin_transaction();
+        CHECK_THROWS_AS(txn.bulk_put_edges(label, edges.data(), edges.size()), std::invalid_argument);
+        txn.put_edge(2, label, 3, "aaaa");
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        CHECK(txn.get_edge(2, label, 3) == "aaaa");
+        CHECK(txn.get_edge(2, label, 2) == "");
+    }
+    {
+        // The bad endpoint comes last: nothing may be loaded before it is found
+        std::vector<std::pair<vertex_t, vertex_t>> invalid{{3, 0}, {3, 1}, {vertices - 1, vertices}};
+        auto txn = graph.begin_batch_loader();
+        auto degree = [&](vertex_t src) {
+            size_t num_edges = 0;
+            for (auto iter = txn.get_edges(src, label); iter.valid(); iter.next())
+                num_edges++;
+            return num_edges;
+        };
+        auto prev_degree = degree(3);
+        CHECK_THROWS_AS(txn.bulk_put_edges(label, invalid.data(), invalid.size()), std::invalid_argument);
+        CHECK(degree(3) == prev_degree);
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        CHECK_THROWS_AS(txn.bulk_put_edges(label, edges.data(), edges.size()), std::invalid_argument);
+    }
+}
+
+TEST_CASE("testing the Transaction: columnar edges")
+{
+    Graph graph;
+
+    const label_t label = 1;
+    const label_t row_label = 0;
+    graph.set_columnar_label(label);
+    CHECK(graph.is_columnar_label(label));
+    CHECK(!graph.is_columnar_label(row_label));
+
+    const vertex_t vertices = 256;
+    {
+        auto txn = graph.begin_transaction();
+        for (vertex_t i = 0; i < vertices; i++)
+            CHECK(txn.new_vertex() == i);
+        txn.commit();
+    }
+
+    auto collect = [&](Transaction &txn, vertex_t src, bool reverse) {
+        std::vector<vertex_t> dsts;
+        auto iter = txn.get_edges(src, label, reverse);
+        while (iter.valid())
+        {
+            dsts.emplace_back(iter.dst_id());
+            CHECK(iter.edge_data() == "");
+            iter.next();
+        }
+        return dsts;
+    };
+
+    {
+        auto txn = graph.begin_transaction();
+        CHECK_THROWS_AS(txn.put_edge(0, label, 1, "a"), std::invalid_argument);
+        for (vertex_t i = 1; i < vertices; i++)
+            txn.put_edge(0, label, i, "");
+        txn.put_edge(0, row_label, 1, "row");
+        CHECK(txn.get_edge(0, label, 1).data() != nullptr);
+        CHECK(collect(txn, 0, false).size() == vertices - 1);
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        auto dsts = collect(txn, 0, true);
+        CHECK(dsts.size() == vertices - 1);
+        for (vertex_t i = 1; i < vertices; i++)
+        {
+            CHECK(dsts[i - 1] == i);
+            CHECK(txn.get_edge(0, label, i).data() != nullptr);
+        }
+        CHECK(collect(txn, 0, false).front() == vertices - 1);
+        CHECK(txn.get_edge(0, label, 0).data() == nullptr);
+        CHECK(txn.get_edge(0, row_label, 1) == "row");
+
+        auto [num_bytes, num_entries] = graph.get_edge_block_usage(label);
+        CHECK(num_entries == vertices - 1);
+        CHECK(num_bytes >= num_entries * ColumnarEdgeBlockHeader::ENTRY_SIZE);
+    }
+
+    auto snapshot = graph.begin_read_only_transaction();
+    {
+        auto txn = graph.begin_transaction();
+        CHECK(txn.del_edge(0, label, 1));
+        CHECK(!txn.del_edge(0, label, 1));
+        txn.put_edge(0, label, 2, "");
+        CHECK(txn.get_edge(0, label, 1).data() == nullptr);
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_transaction();
+        txn.put_edge(0, label, 0, "");
+        txn.del_edge(0, label, 3);
+        txn.abort();
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        auto dsts = collect(txn, 0, true);
+        CHECK(dsts.size() == vertices - 2);
+        CHECK(dsts.back() == 2);
+        CHECK(txn.get_edge(0, label, 0).data() == nullptr);
+        CHECK(txn.get_edge(0, label, 3).data() != nullptr);
+    }
+    CHECK(collect(snapshot, 0, true).size() == vertices - 1);
+    CHECK(snapshot.get_edge(0, label, 1).data() != nullptr);
+    snapshot.abort();
+
+    graph.compact();
+    {
+        auto txn = graph.begin_read_only_transaction();
+        CHECK(collect(txn, 0, true).size() == vertices - 2);
+        auto [num_bytes, num_entries] = graph.get_edge_block_usage(label);
+        CHECK(num_entries == vertices - 2);
+    }
+
+    {
+        std::vector<std::pair<vertex_t, vertex_t>> edges;
+        for (vertex_t i = 1; i < vertices; i++)
+            for (vertex_t j = 0; j < i % 32; j++)
+                edges.emplace_back(i, j);
+        auto txn = graph.begin_batch_loader();
+        txn.bulk_put_edges(label, edges.data(), edges.size());
+        txn.put_edge(1, label, vertices - 1, "");
+        txn.commit();
+    }
+    {
+        auto txn = graph.begin_read_only_transaction();
+        for (vertex_t i = 1; i < vertices; i++)
+        {
+            auto dsts = collect(txn, i, true);
+            CHECK(dsts.size() == i % 32 + (i == 1));
+            for (vertex_t j = 0; j < i % 32; j++)
+                CHECK(dsts[j] == j);
+        }
+        CHECK(collect(txn, 0, true).size() == vertices - 2);
+    }
+}
@@ -54,54 +54,34 @@ index_t test_bfs(XPGraph* xpgraph, index_t root_count){
             // double start = mywtime();
             #pragma omp parallel reduction(+:frontier)
             {
-                vid_t vid;
-                degree_t nebr_count = 0;
-                degree_t local_degree = 0;
-                vid_t* local_adjlist = 0;
+                nebr_iterator_t iter;
                 
                 if (top_down) {
                     #pragma omp for nowait
                     for (vid_t v = 0; v < v_count; v++) {
                         if (status[v] != level) continue;
                         
-                        nebr_count = xpgraph->get_out_degree(v);
-                        if (0 == nebr_count) continue;
-                        
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_out_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-                        
-                        //traverse the delta adj list
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
+                        //traverse the out-neighbors in place
+                        xpgraph->for_each_out_nebr(v, iter, [&](vid_t vid) {
                             if (status[vid] == 0) {
                                 status[vid] = level + 1;
                                 ++frontier;
                             }
-                        }
-                        delete [] local_adjlist;
+                        });
                     }
                 } else { // bottom up
                     #pragma omp for nowait
                     for (vid_t v = 0; v < v_count; v++) {
                         if (status[v] != 0) continue;
 
-                        nebr_count = xpgraph->get_in_degree(v);
-                        if (0 == nebr_count) continue;
-
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_in_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
-                            if (status[vid] == level) {
-                                status[v] = level + 1;
-                                ++frontier;
-                                break;
-                            }
-                        }
-                        delete [] local_adjlist;
+                        // stop at the first in-neighbor in the frontier
+                        xpgraph->open_in_nebrs(v, iter);
+                        find_nebr(iter, [&](vid_t vid) {
+                            if (status[vid] != level) return false;
+                            status[v] = level + 1;
+                            ++frontier;
+                            return true;
+                        });
                     }
                 }
             }
@@ -156,10 +136,7 @@ index_t test_bfs_numa(XPGraph* xpgraph, index_t root=1){
             auto st = std::chrono::high_resolution_clock::now();
             #pragma omp parallel reduction(+:frontier)
             {
-                vid_t vid;
-                degree_t nebr_count = 0;
-                degree_t local_degree = 0;
-                vid_t* local_adjlist = 0;
+                nebr_iterator_t iter;
 
                 tid_t tid = omp_get_thread_num();
 
@@ -170,23 +147,14 @@ index_t test_bfs_numa(XPGraph* xpgraph, index_t root=1){
                     for (vid_t v = 0; v < v_count; v+=2) {
                         if (status[v] != level) continue;
                         
-                        nebr_count = xpgraph->get_out_degree(v);
-                        if (0 == nebr_count) continue;
-                        
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_out_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-                        
-                        //traverse the delta adj list
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
+                        //traverse the out-neighbors in place
+                        xpgraph->for_each_out_nebr(v, iter, [&](vid_t vid) {
                             if (status[vid] == 0) {
                                 status[vid] = level + 1;
                                 ++frontier;
                                 //cout << " " << sid << endl;
                             }
-                        }
-                        delete [] local_adjlist;
+                        });
                     }
 
                     // Then process vertices in socket 1
@@ -195,23 +163,14 @@ index_t test_bfs_numa(XPGraph* xpgraph, index_t root=1){
                     for (vid_t v = 1; v < v_count; v+=2) {
                         if (status[v] != level) continue;
                         
-                        nebr_count = xpgraph->get_out_degree(v);
-                        if (0 == nebr_count) continue;
-                        
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_out_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-                        
-                        //traverse the delta adj list
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
+                        //traverse the out-neighbors in place
+                        xpgraph->for_each_out_nebr(v, iter, [&](vid_t vid) {
                             if (status[vid] == 0) {
                                 status[vid] = level + 1;
                                 ++frontier;
                                 //cout << " " << sid << endl;
                             }
-                        }
-                        delete [] local_adjlist;
+                        });
                     }
                 } else { // bottom up
                     // First process vertices in socket 0
@@ -220,22 +179,14 @@ index_t test_bfs_numa(XPGraph* xpgraph, index_t root=1){
                     for (vid_t v = 0; v < v_count; v+=2) {
                         if (status[v] != 0) continue;
 
-                        nebr_count = xpgraph->get_in_degree(v);
-                        if (0 == nebr_count) continue;
-
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_in_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
-                            if (status[vid] == level) {
-                                status[v] = level + 1;
-                                ++frontier;
-                                break;
-                            }
-                        }
-                        delete [] local_adjlist;
+                        // stop at the first in-neighbor in the frontier
+                        xpgraph->open_in_nebrs(v, iter);
+                        find_nebr(iter, [&](vid_t vid) {
+                            if (status[vid] != level) return false;
+                            status[v] = level + 1;
+                            ++frontier;
+                            return true;
+                        });
                     }
 
                     // Then process vertices in socket 1
@@ -244,22 +195,14 @@ index_t test_bfs_numa(XPGraph* xpgraph, index_t root=1){
                     for (vid_t v = 1; v < v_count; v+=2) {
                         if (status[v] != 0) continue;
 
-                        nebr_count = xpgraph->get_in_degree(v);
-                        if (0 == nebr_count) continue;
-
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree  = xpgraph->get_in_nebrs(v, local_adjlist);
-                        assert(local_degree  == nebr_count);
-
-                        for (degree_t i = 0; i < local_degree; ++i) {
-                            vid = local_adjlist[i];
-                            if (status[vid] == level) {
-                                status[v] = level + 1;
-                                ++frontier;
-                                break;
-                            }
-                        }
-                        delete [] local_adjlist;
+                        // stop at the first in-neighbor in the frontier
+                        xpgraph->open_in_nebrs(v, iter);
+                        find_nebr(iter, [&](vid_t vid) {
+                            if (status[vid] != level) return false;
+                            status[v] = level + 1;
+                            ++frontier;
+                            return true;
+                        });
                     }
                 }
                 xpgraph->cancel_bind_cpu();
@@ -378,10 +321,7 @@ index_t test_bfs_lsgraph(XPGraph* xpgraph, index_t src){
         size_t next_frontier_count = 0;
         #pragma omp parallel reduction(+:next_frontier_count)
         {
-            vid_t vid;
-            degree_t nebr_count = 0;
-            degree_t local_degree = 0;
-            vid_t* local_adjlist = 0;
+            nebr_iterator_t iter;
         
 
             if (top_down) {
@@ -389,46 +329,29 @@ index_t test_bfs_lsgraph(XPGraph* xpgraph, index_t src){
                 for (vid_t v = 0; v < n; v++) {
                     if(!frontier.get_bit(v)) continue;
                     
-                    nebr_count = xpgraph->get_out_degree(v);
-                    if (0 == nebr_count) continue;
-                    
-                    local_adjlist = new vid_t[nebr_count];
-                    local_degree  = xpgraph->get_out_nebrs(v, local_adjlist);
-                    // assert(local_degree  == nebr_count);
-                    
-                    //traverse the delta adj list
-                    for (degree_t i = 0; i < local_degree; ++i) {
-                        vid = local_adjlist[i];
+                    //traverse the out-neighbors in place
+                    xpgraph->for_each_out_nebr(v, iter, [&](vid_t vid) {
                         if (Parents[vid] == -1) {
                             Parents[vid] = v;
                             next_frontier.set_bit(vid);
                             ++next_frontier_count;
                         }
-                    }
-                    delete [] local_adjlist;
+                    });
                 }
             } else { // bottom up
                 #pragma omp for
                 for (vid_t v = 0; v < n; v++) {
                     if(Parents[v] != -1) continue;
 
-                    nebr_count = xpgraph->get_in_degree(v);
-                    if (0 == nebr_count) continue;
-
-                    local_adjlist = new vid_t[nebr_count];
-                    local_degree  = xpgraph->get_in_nebrs(v, local_adjlist);
-                    // assert(local_degree  == nebr_count);
-
-                    for (degree_t i = 0; i < local_degree; ++i) {
-                        vid = local_adjlist[i];
-                        if(frontier.get_bit(vid)) {
-                            Parents[v] = vid;
-                            next_frontier.set_bit(v);
-                            ++next_frontier_count;
-                            break;
-                        }
-                    }
-                    delete [] local_adjlist;
+                    // stop at the first in-neighbor in the frontier
+                    xpgraph->open_in_nebrs(v, iter);
+                    find_nebr(iter, [&](vid_t vid) {
+                        if (!frontier.get_bit(vid)) return false;
+                        Parents[v] = vid;
+                        next_frontier.set_bit(v);
+                        ++next_frontier_count;
+                        return true;
+                    });
                 }
             }
         }
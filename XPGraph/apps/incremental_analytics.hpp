@@ -0,0 +1,329 @@
+#pragma once
+#include <omp.h>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <libxpgraph.h>
+#include "pr_gapbs.hpp"
+#include "connected_components.hpp"
+
+/*
+Incremental analytics across archive rounds.
+
+Each analytic keeps its results and the snapshot id they were computed at. The next run asks XPGraph for
+the vertices changed since then (see --dirty_rounds) and only recomputes around them:
+ - PageRank: resume from the previous scores, pull only for changed vertices, their out-neighbors and then
+   the out-neighbors of every vertex whose score moved by more than the tolerance.
+ - BFS: relax from the changed vertices that were reached before, depths only shrink under insertions.
+ - CC: link the out-edges of the changed vertices into the previous union-find forest.
+BFS and CC recompute from scratch when deletions happened, as does every analytic when its snapshot is too old.
+Archiving goes on while they run: each pass over the graph holds XPGraph::begin_read(), the rounds go in between.
+*/
+
+inline void set_vertex_bit(uint64_t* bits, vid_t v) {
+    uint64_t bit = 1UL << (v & 63);
+    if (!(bits[v >> 6] & bit)) __sync_fetch_and_or(&bits[v >> 6], bit);
+}
+
+inline bool any_vertex_bit(const std::vector<uint64_t> &bits) {
+    for (uint64_t w : bits) if (w) return true;
+    return false;
+}
+
+// Call f(v) for every vertex set in bits, work-shared by the threads of the enclosing parallel region
+template <typename F>
+inline void for_each_vertex_bit(const std::vector<uint64_t> &bits, vid_t v_count, F f) {
+    #pragma omp for schedule(dynamic, 64)
+    for (index_t w = 0; w < bits.size(); ++w) {
+        uint64_t word = bits[w];
+        while (word) {
+            vid_t v = w * 64 + __builtin_ctzl(word);
+            word &= word - 1;
+            if (v < v_count) f(v);
+        }
+    }
+}
+
+// Keeps archive rounds from moving edges during one pass over the graph, see XPGraph::begin_read()
+class read_guard_t {
+private:
+    XPGraph* xpgraph;
+public:
+    read_guard_t(XPGraph* _xpgraph) : xpgraph(_xpgraph) { xpgraph->begin_read(); }
+    ~read_guard_t() { xpgraph->end_read(); }
+};
+
+// The snapshot the previous results are valid for, and the vertices changed since then
+class inc_analytics_t {
+protected:
+    XPGraph* xpgraph;
+    vid_t v_count;
+    index_t snap;
+    bool valid;
+    std::vector<uint64_t> changed;
+
+    // true if only the vertices in changed have to be recomputed, snap is moved to the current snapshot
+    bool collect_changed(bool allow_del) {
+        index_t to_snap;
+        bool has_del = false;
+        bool incremental = valid && xpgraph->get_changed_vertices(snap, to_snap, changed.data(), has_del);
+        if (!valid) to_snap = xpgraph->get_snapid();
+        snap = to_snap;
+        valid = true;
+        return incremental && (allow_del || !has_del);
+    }
+
+public:
+    inc_analytics_t(XPGraph* _xpgraph) : xpgraph(_xpgraph), v_count(_xpgraph->get_vcount()), snap(0), valid(false),
+        changed((_xpgraph->get_vcount() + 63) / 64, 0) {}
+    index_t get_snapid() { return snap; }
+    void invalidate() { valid = false; }
+};
+
+class inc_pagerank_t : public inc_analytics_t {
+private:
+    double tolerance; // absolute, scaled from the relative tolerance by the average score 1 / v_count
+    std::vector<ScoreT> scores;
+    std::vector<ScoreT> contrib;
+    std::vector<uint64_t> active, next;
+
+public:
+    // _tolerance is relative to the average score, a fixed one would be too loose on large graphs
+    inc_pagerank_t(XPGraph* _xpgraph, double _tolerance = 1e-6) : inc_analytics_t(_xpgraph), tolerance(_tolerance / v_count),
+        scores(v_count), contrib(v_count), active(changed.size()), next(changed.size()) {}
+
+    const ScoreT* get_scores() { return scores.data(); }
+
+    // Returns the number of vertex updates
+    index_t run(int max_iters) {
+        const ScoreT base_score = (1.0f - kDamp) / v_count;
+        index_t updates = 0;
+
+        if (collect_changed(true)) {
+            // changed vertices may have new out-degrees and in-neighbors, active keeps what did not converge last time
+            for (index_t w = 0; w < changed.size(); ++w) active[w] |= changed[w];
+            read_guard_t guard(xpgraph);
+            #pragma omp parallel
+            {
+                nebr_iterator_t iter;
+                for_each_vertex_bit(changed, v_count, [&](vid_t v) {
+                    degree_t out_degree = xpgraph->get_out_degree(v);
+                    contrib[v] = out_degree ? scores[v] / out_degree : 0;
+                    xpgraph->for_each_out_nebr(v, iter, [&](vid_t w) { set_vertex_bit(active.data(), w); });
+                });
+            }
+        } else {
+            const ScoreT init_score = 1.0f / v_count;
+            std::fill(scores.begin(), scores.end(), init_score);
+            std::fill(active.begin(), active.end(), 0);
+            for (vid_t v = 0; v < v_count; v++) active[v >> 6] |= 1UL << (v & 63);
+            read_guard_t guard(xpgraph);
+            #pragma omp parallel for
+            for (vid_t v = 0; v < v_count; v++) {
+                degree_t out_degree = xpgraph->get_out_degree(v);
+                contrib[v] = out_degree ? init_score / out_degree : 0;
+            }
+        }
+
+        for (int iter_count = 0; iter_count < max_iters && any_vertex_bit(active); ++iter_count) {
+            std::fill(next.begin(), next.end(), 0);
+            read_guard_t guard(xpgraph);
+            #pragma omp parallel reduction(+ : updates)
+            {
+                nebr_iterator_t iter;
+                for_each_vertex_bit(active, v_count, [&](vid_t u) {
+                    ScoreT incoming_total = 0;
+                    xpgraph->for_each_in_nebr(u, iter, [&](vid_t v) { incoming_total += contrib[v]; });
+                    ScoreT score = base_score + kDamp * incoming_total;
+                    degree_t out_degree = xpgraph->get_out_degree(u);
+                    if (fabs(score - scores[u]) > tolerance) {
+                        xpgraph->for_each_out_nebr(u, iter, [&](vid_t w) { set_vertex_bit(next.data(), w); });
+                    }
+                    scores[u] = score;
+                    contrib[u] = out_degree ? score / out_degree : 0;
+                    updates++;
+                });
+            }
+            std::swap(active, next);
+        }
+        return updates;
+    }
+};
+
+class inc_bfs_t : public inc_analytics_t {
+private:
+    static const uint32_t UNREACHED = UINT32_MAX;
+    vid_t root;
+    std::vector<uint32_t> depth;
+    std::vector<uint64_t> frontier, next;
+
+public:
+    inc_bfs_t(XPGraph* _xpgraph, vid_t _root) : inc_analytics_t(_xpgraph), root(_root), depth(v_count),
+        frontier(changed.size()), next(changed.size()) {}
+
+    const uint32_t* get_depth() { return depth.data(); }
+
+    // Returns the number of vertices whose depth was set
+    index_t run() {
+        index_t updates = 0;
+        if (collect_changed(false)) {
+            #pragma omp parallel for
+            for (index_t w = 0; w < changed.size(); ++w) frontier[w] = 0;
+            #pragma omp parallel
+            for_each_vertex_bit(changed, v_count, [&](vid_t v) {
+                if (depth[v] != UNREACHED) set_vertex_bit(frontier.data(), v);
+            });
+        } else {
+            std::fill(depth.begin(), depth.end(), UNREACHED);
+            std::fill(frontier.begin(), frontier.end(), 0);
+            depth[root] = 0;
+            set_vertex_bit(frontier.data(), root);
+            updates++;
+        }
+
+        while (any_vertex_bit(frontier)) {
+            std::fill(next.begin(), next.end(), 0);
+            read_guard_t guard(xpgraph);
+            #pragma omp parallel reduction(+ : updates)
+            {
+                nebr_iterator_t iter;
+                for_each_vertex_bit(frontier, v_count, [&](vid_t u) {
+                    uint32_t d = depth[u] + 1;
+                    xpgraph->for_each_out_nebr(u, iter, [&](vid_t w) {
+                        uint32_t old_d = depth[w];
+                        while (d < old_d) {
+                            if (__sync_bool_compare_and_swap(&depth[w], old_d, d)) {
+                                set_vertex_bit(next.data(), w);
+                                updates++;
+                                break;
+                            }
+                            old_d = depth[w];
+                        }
+                    });
+                });
+            }
+            std::swap(frontier, next);
+        }
+        return updates;
+    }
+};
+
+class inc_cc_t : public inc_analytics_t {
+private:
+    std::vector<vid_t> comp;
+
+public:
+    inc_cc_t(XPGraph* _xpgraph) : inc_analytics_t(_xpgraph), comp(v_count) {}
+
+    const vid_t* get_comp() { return comp.data(); }
+
+    // Returns the number of vertices whose edges were linked
+    index_t run() {
+        read_guard_t guard(xpgraph);
+        index_t linked = 0;
+        if (collect_changed(false)) {
+            #pragma omp parallel reduction(+ : linked)
+            {
+                nebr_iterator_t iter;
+                for_each_vertex_bit(changed, v_count, [&](vid_t u) {
+                    xpgraph->for_each_out_nebr(u, iter, [&](vid_t v) { Link(u, v, comp.data()); });
+                    linked++;
+                });
+            }
+        } else {
+            #pragma omp parallel for
+            for (vid_t v = 0; v < v_count; v++) comp[v] = v;
+            #pragma omp parallel reduction(+ : linked)
+            {
+                nebr_iterator_t iter;
+                #pragma omp for schedule(dynamic, 4096) nowait
+                for (vid_t u = 0; u < v_count; u++) {
+                    xpgraph->for_each_out_nebr(u, iter, [&](vid_t v) { Link(u, v, comp.data()); });
+                    linked++;
+                }
+            }
+        }
+        Compress(v_count, comp.data());
+        return linked;
+    }
+};
+
+// Compare the incremental results with PR/BFS/CC computed from scratch on the same graph. BFS depths must be
+// equal, CC must give the same partition and the PageRank scores may differ by pr_error in total (L1) from a
+// converged run (kDamp^100 < 1e-7), so the incremental PageRank needs enough max_iters to converge as well.
+// Returns the number of vertices that differ, plus one if PageRank is off.
+index_t check_incremental_analytics(XPGraph* xpgraph, inc_pagerank_t &pr, inc_bfs_t &bfs, inc_cc_t &cc,
+        vid_t root, double pr_error = 1e-4) {
+    vid_t v_count = xpgraph->get_vcount();
+    inc_pagerank_t pr0(xpgraph, 0);
+    inc_bfs_t bfs0(xpgraph, root);
+    inc_cc_t cc0(xpgraph);
+    pr0.run(100);
+    bfs0.run();
+    cc0.run();
+
+    index_t mismatches = 0;
+    double error = 0;
+    const ScoreT* scores = pr.get_scores();
+    const ScoreT* scores0 = pr0.get_scores();
+    for (vid_t v = 0; v < v_count; v++) error += fabs(scores[v] - scores0[v]);
+    if (error > pr_error) {
+        printf("  PR: L1 distance %g to the scores from scratch\n", error);
+        mismatches++;
+    }
+
+    index_t bfs_mismatches = 0;
+    const uint32_t* depth = bfs.get_depth();
+    const uint32_t* depth0 = bfs0.get_depth();
+    for (vid_t v = 0; v < v_count; v++) bfs_mismatches += (depth[v] != depth0[v]);
+
+    // the labels may differ, the partitions may not: map the labels both ways
+    index_t cc_mismatches = 0;
+    const vid_t* comp = cc.get_comp();
+    const vid_t* comp0 = cc0.get_comp();
+    std::vector<vid_t> to0(v_count, UINT32_MAX), from0(v_count, UINT32_MAX);
+    for (vid_t v = 0; v < v_count; v++) {
+        if (to0[comp[v]] == UINT32_MAX) to0[comp[v]] = comp0[v];
+        if (from0[comp0[v]] == UINT32_MAX) from0[comp0[v]] = comp[v];
+        cc_mismatches += (to0[comp[v]] != comp0[v] || from0[comp0[v]] != comp[v]);
+    }
+
+    if (bfs_mismatches || cc_mismatches) printf("  BFS: %lu depths differ, CC: %lu vertices differ\n", bfs_mismatches, cc_mismatches);
+    return mismatches + bfs_mismatches + cc_mismatches;
+}
+
+// Streaming use case: ingest buf in batches of batch_count edges and refresh PR/BFS/CC after each batch.
+// With check, every refresh is compared with a run from scratch (check_incremental_analytics), and the
+// total number of mismatches is returned. The edge log is not drained first, so both runs overlap archiving.
+index_t test_incremental_analytics(XPGraph* xpgraph, char* buf, size_t size, index_t batch_count, vid_t root = 1,
+        int max_iters = 10, bool check = false) {
+    std::cout << "test_incremental_analytics..." << std::endl;
+    index_t mismatches = 0;
+    inc_pagerank_t pr(xpgraph);
+    inc_bfs_t bfs(xpgraph, root);
+    inc_cc_t cc(xpgraph);
+    index_t edge_count = size / (2 * sizeof(vid_t));
+    for (index_t offset = 0; offset < edge_count; offset += batch_count) {
+        index_t count = std::min(batch_count, edge_count - offset);
+        xpgraph->add_edges(buf + offset * 2 * sizeof(vid_t), count * 2 * sizeof(vid_t), count);
+
+        auto st = std::chrono::high_resolution_clock::now();
+        index_t pr_updates = pr.run(max_iters);
+        auto ts1 = std::chrono::high_resolution_clock::now();
+        index_t bfs_updates = bfs.run();
+        auto ts2 = std::chrono::high_resolution_clock::now();
+        index_t cc_linked = cc.run();
+        auto ts3 = std::chrono::high_resolution_clock::now();
+
+        printf("batch %lu, snap %lu: PR %.3fs (%lu updates), BFS %.3fs (%lu updates), CC %.3fs (%lu linked)\n",
+            offset / batch_count, pr.get_snapid(),
+            std::chrono::duration<double>(ts1 - st).count(), pr_updates,
+            std::chrono::duration<double>(ts2 - ts1).count(), bfs_updates,
+            std::chrono::duration<double>(ts3 - ts2).count(), cc_linked);
+        if (check) mismatches += check_incremental_analytics(xpgraph, pr, bfs, cc, root);
+    }
+    if (check) printf("incremental vs from scratch: %lu mismatches\n", mismatches);
+    return mismatches;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <libxpgraph.h>
+
+/*
+Multi-producer ingest throughput.
+
+producers threads append the edges of buf to the edge log. Chunk i of chunk_count edges goes to producer
+i % producers, so the log stays roughly in file order. chunk_count = 0 appends edge by edge through add_edge(),
+one atomic log reservation per edge; otherwise every chunk goes through add_edges(), one reservation per
+batch of the edge log and non-temporal copies. The logging rate excludes, the total rate includes the wait
+for the archive thread to buffer everything.
+*/
+void test_multi_producer_ingest(XPGraph* xpgraph, char* buf, size_t size, int producers, index_t chunk_count = 0) {
+    std::cout << "test_multi_producer_ingest, producers = " << producers << ", chunk = " << chunk_count << std::endl;
+    vid_t* edges = (vid_t*)buf; // src, dst pairs
+    index_t edge_count = size / (2 * sizeof(vid_t));
+    index_t chunk = chunk_count ? chunk_count : 4096;
+    index_t chunks = (edge_count + chunk - 1) / chunk;
+
+    auto st = std::chrono::high_resolution_clock::now();
+    #pragma omp parallel num_threads(producers)
+    {
+        #pragma omp for schedule(static, 1)
+        for (index_t c = 0; c < chunks; ++c) {
+            index_t offset = c * chunk;
+            index_t count = std::min(chunk, edge_count - offset);
+            if (chunk_count) {
+                xpgraph->add_edges((char*)(edges + 2 * offset), count * 2 * sizeof(vid_t), count);
+            } else {
+                for (index_t i = offset; i < offset + count; ++i) xpgraph->add_edge(edges[2 * i], edges[2 * i + 1]);
+            }
+        }
+    }
+    auto ts1 = std::chrono::high_resolution_clock::now();
+    xpgraph->buffer_all_edges();
+    auto ts2 = std::chrono::high_resolution_clock::now();
+
+    double log_secs = std::chrono::duration<double>(ts1 - st).count();
+    double total_secs = std::chrono::duration<double>(ts2 - st).count();
+    printf("%lu edges: logging %.3fs (%.2f Medges/s), with archiving %.3fs (%.2f Medges/s)\n", edge_count,
+        log_secs, edge_count / log_secs / 1.0E6, total_secs, edge_count / total_secs / 1.0E6);
+}
@@ -102,30 +102,18 @@ void test_pagerank_pull(XPGraph* xpgraph, int iteration_count) {
         // double start1 = mywtime();
         #pragma omp parallel 
         {
+            nebr_iterator_t iter;
             // m.start_time("5.4.3  -do_pagerank");
             #pragma omp for schedule (dynamic, 4096) nowait 
             for (vid_t v = 0; v < v_count; ++v) {
-                sid_t uid;
-                degree_t nebr_count = 0;
-                degree_t local_degree = 0;
-                vid_t* local_adjlist;
-
                 float rank = 0.0f; 
 
-                nebr_count = xpgraph->get_in_degree(v);
-                if (0 == nebr_count) continue;
-                
-                local_adjlist = new vid_t[nebr_count];
-                local_degree = xpgraph->get_in_nebrs(v, local_adjlist);
-                assert(local_degree == nebr_count); // here's the problem
-                
-                // traverse the delta adj list
-                for (index_t j = 0; j < local_degree; ++j){
-                    uid = local_adjlist[j];
+                // traverse the in-neighbors in place
+                degree_t local_degree = xpgraph->for_each_in_nebr(v, iter, [&](vid_t uid) {
                     rank += prior_rank_array[uid];
-                }
+                });
+                if (0 == local_degree) continue;
                 qthread_dincr(rank_array + v, rank);
-                delete [] local_adjlist;
             }
             // m.stop_time("5.4.3  -do_pagerank");
 
@@ -221,27 +209,17 @@ void test_pagerank_push(XPGraph* xpgraph, int iteration_count){
         // double start1 = mywtime();
         #pragma omp parallel 
         {
-            sid_t uid;
-            degree_t nebr_count, local_degree;
-            vid_t* local_adjlist;
+            nebr_iterator_t iter;
             float rank = 0.0f; 
          
             #pragma omp for schedule (dynamic, 4096) nowait 
             for (vid_t v = 0; v < v_count; v++) {
-                nebr_count = xpgraph->get_out_degree(v);
-                if (0 == nebr_count) continue;
-                local_adjlist = new vid_t[nebr_count];
-                local_degree  = xpgraph->get_out_nebrs(v, local_adjlist);
-                // assert(local_degree  == nebr_count);
-                
                 rank = prior_rank_array[v];
                 
-                //traverse the delta adj list
-                for(index_t j = 0; j < local_degree; ++j) {
-                    uid = local_adjlist[j];
+                //traverse the out-neighbors in place
+                xpgraph->for_each_out_nebr(v, iter, [&](vid_t uid) {
                     qthread_dincr(rank_array + uid, rank);
-                }
-                delete [] local_adjlist;
+                });
             }
 
             if (iter_count != iteration_count - 1) {
@@ -357,33 +335,21 @@ void test_pagerank_pull_numa(XPGraph* xpgraph, int iteration_count){
                 tid_t tid = omp_get_thread_num();
                 xpgraph->bind_cpu(tid, id);
 
+                    nebr_iterator_t iter;
                     #pragma omp for schedule (dynamic, 4096) nowait 
                     for (vid_t v = id; v < v_count; v+=NUM_SOCKETS) {
                         // if(v < 16) {
                         //     printf("v = %d\n", v);
                         // }
 
-                        sid_t uid;
-                        degree_t nebr_count = 0;
-                        degree_t local_degree = 0;
-                        vid_t* local_adjlist;
-
                         float rank = 0.0f; 
 
-                        nebr_count = xpgraph->get_in_degree(v);
-                        if (0 == nebr_count) continue;
-
-                        local_adjlist = new vid_t[nebr_count];
-                        local_degree = xpgraph->get_in_nebrs(v, local_adjlist);
-                        assert(local_degree == nebr_count);
-
-                        // traverse the delta adj list
-                        for (index_t j = 0; j < local_degree; ++j){
-                            uid = local_adjlist[j];
+                        // traverse the in-neighbors in place
+                        degree_t local_degree = xpgraph->for_each_in_nebr(v, iter, [&](vid_t uid) {
                             rank += prior_rank_array[uid];
-                        }
+                        });
+                        if (0 == local_degree) continue;
                         qthread_dincr(rank_array + v, rank);
-                        delete [] local_adjlist;
                     }
 
                 xpgraph->cancel_bind_cpu();
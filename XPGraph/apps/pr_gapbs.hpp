@@ -62,6 +62,7 @@ ScoreT* PageRankPullGS(XPGraph* xpgraph, int max_iters, double epsilon=0, bool l
             {
                 tid_t tid = omp_get_thread_num() + id * 40;
                 xpgraph->bind_cpu(tid, id);
+                nebr_iterator_t iter;
 
                 #pragma omp for reduction(+ : error) schedule(dynamic, 4096)
                 for (NodeID u=id; u < v_count; u+=NUM_SOCKETS) {
@@ -71,28 +72,16 @@ ScoreT* PageRankPullGS(XPGraph* xpgraph, int max_iters, double epsilon=0, bool l
 
                     ScoreT incoming_total = 0;
 
-                    degree_t nebr_count = 0;
-                    degree_t local_degree = 0;
-                    vid_t* local_adjlist;
-
-                    nebr_count = xpgraph->get_in_degree(u);
-                    if (0 == nebr_count) continue;
-
-                    local_adjlist = new vid_t[nebr_count];
-                    local_degree = xpgraph->get_in_nebrs(u, local_adjlist);
-                    assert(local_degree == nebr_count);
-
-                    // traverse the delta adj list
-                    for (index_t j = 0; j < local_degree; ++j){
-                        NodeID v = local_adjlist[j];
+                    // traverse the in-neighbors in place
+                    degree_t local_degree = xpgraph->for_each_in_nebr(u, iter, [&](vid_t v) {
                         incoming_total += outgoing_contrib[v];
-                    }
+                    });
+                    if (0 == local_degree) continue;
 
                     ScoreT old_score = scores[u];
                     scores[u] = base_score + kDamp * incoming_total;
                     error += fabs(scores[u] - old_score);
                     outgoing_contrib[u] = scores[u] / xpgraph->get_out_degree(u);
-                    delete [] local_adjlist;
                 }
 
                 xpgraph->cancel_bind_cpu();
@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "libxpgraph.h"
+#include "apps/incremental_analytics.hpp"
+
+// ./bin/incremental -f <dataset> -v <nverts> --dirty_rounds 16 -batch 1048576 -root 1 -iters 100 -check 1 [XPGraph options]
+// Streams the dataset in batches and refreshes PR/BFS/CC incrementally after each one, see
+// apps/incremental_analytics.hpp. -check 1 compares every refresh with a run from scratch, PageRank is compared
+// with a converged run so use -iters 100 with it.
+static const char* get_arg(int argc, const char ** argv, const char* name, const char* default_value)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    return default_value;
+}
+
+int main(int argc, const char ** argv)
+{
+    std::string filepath = get_arg(argc, argv, "-f", "");
+    index_t batch = atol(get_arg(argc, argv, "-batch", "1048576"));
+    vid_t root = atol(get_arg(argc, argv, "-root", "1"));
+    int iters = atoi(get_arg(argc, argv, "-iters", "10"));
+    bool check = atoi(get_arg(argc, argv, "-check", "0"));
+
+    XPGraph *xpgraph = new XPGraph(argc, argv);
+    char* buf = 0;
+    size_t size = xpgraph->load_edgelist(&buf, filepath);
+    index_t mismatches = test_incremental_analytics(xpgraph, buf, size, batch, root, iters, check);
+    delete xpgraph;
+    return mismatches ? 1 : 0;
+}
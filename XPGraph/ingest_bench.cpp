@@ -0,0 +1,31 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "libxpgraph.h"
+#include "apps/ingest_benchmark.hpp"
+
+// ./bin/ingest_bench -f <dataset> -v <nverts> -producers 4 -chunk 65536 [XPGraph options]
+// -chunk 0 appends edge by edge through add_edge(), see apps/ingest_benchmark.hpp.
+static const char* get_arg(int argc, const char ** argv, const char* name, const char* default_value)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    return default_value;
+}
+
+int main(int argc, const char ** argv)
+{
+    std::string filepath = get_arg(argc, argv, "-f", "");
+    int producers = atoi(get_arg(argc, argv, "-producers", "4"));
+    index_t chunk = atol(get_arg(argc, argv, "-chunk", "65536"));
+
+    XPGraph *xpgraph = new XPGraph(argc, argv);
+    char* buf = 0;
+    size_t size = xpgraph->load_edgelist(&buf, filepath);
+    test_multi_producer_ingest(xpgraph, buf, size, producers, chunk);
+    delete xpgraph;
+    return 0;
+}
@@ -30,6 +30,7 @@ XPGraph::XPGraph(int argc, const char ** argv){
 }
 
 XPGraph::~XPGraph(){
+    if (COMPACT_BUDGET) levelgraph->report_block_chains();
     levelgraph->free_graph();
     levelgraph->free_elog();
     delete levelgraph;
@@ -39,7 +40,9 @@ XPGraph::~XPGraph(){
         rm_dir(NVMPATH1.c_str());
     }
     m.stop_time("XPGraph");
+    hot_metrics.merge_into(m);
     metrics_report(m);
+    hot_metrics.dump_json(get_option_string("metrics.reporter.jsonfile", "xpgraph_metrics.json"), m.name);
 }
 
 void XPGraph::config_graph(int argc, const char ** argv) {
@@ -74,9 +77,7 @@ index_t XPGraph::add_edges(char* buf, size_t size, index_t count) {
     edge_t* edges = (edge_t*)buf;
     if(count > 0) edge_count = count;
 
-    for (index_t i = 0; i < edge_count; ++i) {
-        levelgraph->batch_edge(edges[i]);
-    }
+    levelgraph->batch_edges(edges, edge_count);
     return edge_count;   
 }
 
@@ -170,12 +171,12 @@ void XPGraph::import_graph() {
 //     return line;
 // }
 
-// size_t XPGraph::load_edgelist(char** buf, std::string idirname) {
-//     std::string odirname = "";
-//     if(LEBUF_INPM) odirname = NVMPATH0;
-//     size_t total_size = alloc_and_read_dir(idirname, odirname, buf);
-//     return total_size;
-// }
+size_t XPGraph::load_edgelist(char** buf, std::string idirname) {
+    std::string odirname = "";
+    if(LEBUF_INPM && !DRAMONLY) odirname = NVMPATH0;
+    size_t total_size = alloc_and_read_dir(idirname, odirname, buf);
+    return total_size;
+}
 
 /*-------------------------------------------------------------- */
 // Graph save and recover
@@ -279,6 +280,42 @@ degree_t XPGraph::get_in_nebrs_flushed(vid_t vid, vid_t* local_adjlist) {
     return levelgraph->query_nebrs_flushed(local_adjlist, vid, 1);
 }
 
+nebr_iterator_t::nebr_iterator_t(){
+    cursor = new nebr_cursor_t();
+}
+
+nebr_iterator_t::~nebr_iterator_t(){
+    delete cursor;
+}
+
+const vid_t* nebr_iterator_t::next_run(degree_t &count){
+    return cursor->next_run(count);
+}
+
+void XPGraph::open_out_nebrs(vid_t vid, nebr_iterator_t &iter) {
+    levelgraph->open_nebrs(vid, 0, *iter.cursor);
+}
+
+void XPGraph::open_in_nebrs(vid_t vid, nebr_iterator_t &iter) {
+    levelgraph->open_nebrs(vid, 1, *iter.cursor);
+}
+
+index_t XPGraph::get_snapid(){
+    return levelgraph->get_snapid();
+}
+
+bool XPGraph::get_changed_vertices(index_t from_snap, index_t &to_snap, uint64_t* bitmap, bool &has_del){
+    return levelgraph->get_changed_vertices(from_snap, to_snap, bitmap, has_del);
+}
+
+void XPGraph::begin_read(){
+    levelgraph->begin_read();
+}
+
+void XPGraph::end_read(){
+    levelgraph->end_read();
+}
+
 /* -------------------------------------------------------------- */
 // Graph Arrange
 index_t XPGraph::buffer_all_edges(){
@@ -318,6 +355,10 @@ vid_t XPGraph::compact_all_adjs(){
     return levelgraph->compact_all_adjlists();
 }
 
+void XPGraph::report_block_chains(){
+    levelgraph->report_block_chains();
+}
+
 /* -------------------------------------------------------------- */
 // Others
 uint8_t XPGraph::get_socket_num(){
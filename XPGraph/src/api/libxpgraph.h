@@ -41,6 +41,26 @@ class graph_t;
 class edgelog_t;
 class levelgraph_t;
 class metrics;
+class nebr_cursor_t;
+
+/* ---------------------------------------------------------------------- */
+// Zero-copy iterator over the neighbors of one vertex, opened by XPGraph::open_out_nebrs/open_in_nebrs.
+// Each run points directly into a PMEM block or the DRAM vertex buffer (deleted neighbors are skipped),
+// the last run holds the neighbors not archived yet. Reuse one iterator per thread across vertices.
+class nebr_iterator_t{
+private:
+    nebr_cursor_t* cursor;
+    friend class XPGraph;
+
+public:
+    nebr_iterator_t();
+    ~nebr_iterator_t();
+    nebr_iterator_t(const nebr_iterator_t&) = delete;
+    nebr_iterator_t& operator=(const nebr_iterator_t&) = delete;
+
+    // Next run of neighbors and its length, NULL once all neighbors were visited
+    const vid_t* next_run(degree_t &count);
+};
 
 /* ---------------------------------------------------------------------- */
 class XPGraph{
@@ -57,7 +77,7 @@ public:
     XPGraph(int argc, const char ** argv);
     ~XPGraph();
     // index_t set_elog(char* buf, size_t size, index_t count);
-    // size_t load_edgelist(char** buf, std::string idirname);
+    size_t load_edgelist(char** buf, std::string idirname); // read the edge files of a dataset, returns their size in bytes
 
     // Graph Update
     bool add_edge(vid_t src, vid_t dst);
@@ -95,6 +115,21 @@ public:
     degree_t get_in_nebrs_buffered(vid_t vid, vid_t* local_adjlist);
     degree_t get_out_nebrs_flushed(vid_t vid, vid_t* local_adjlist);
     degree_t get_in_nebrs_flushed(vid_t vid, vid_t* local_adjlist);
+    void open_out_nebrs(vid_t vid, nebr_iterator_t &iter);
+    void open_in_nebrs(vid_t vid, nebr_iterator_t &iter);
+    template <typename F> degree_t for_each_out_nebr(vid_t vid, nebr_iterator_t &iter, F f);
+    template <typename F> degree_t for_each_in_nebr(vid_t vid, nebr_iterator_t &iter, F f);
+
+    // Incremental analytics: snapshot id = number of archive rounds so far. bitmap holds (vcount + 63) / 64
+    // words and gets the vertices changed since from_snap, false if that is too old (see --dirty_rounds).
+    index_t get_snapid();
+    bool get_changed_vertices(index_t from_snap, index_t &to_snap, uint64_t* bitmap, bool &has_del);
+
+    // Consistent reads while archiving runs: begin_read() waits for the edges logged so far to be archived, then
+    // until end_read() no archive round moves edges from the log to the adjacency lists, so every neighbor is
+    // seen exactly once. Writers may go on logging, the rounds go on in between.
+    void begin_read();
+    void end_read();
 
     // Graph Arrange
     index_t buffer_all_edges();
@@ -103,6 +138,7 @@ public:
     bool compact_out_adjs(vid_t vid);
     bool compact_in_adjs(vid_t vid);
     vid_t compact_all_adjs();
+    void report_block_chains(); // average pblocks per vertex, before and after --compact_budget compactions
 
     // Others
     uint8_t get_socket_num();
@@ -111,3 +147,41 @@ public:
     void cancel_bind_cpu();
     uint8_t get_query_count();
 };
+
+/* ---------------------------------------------------------------------- */
+// Visit neighbors in place, f(vid_t nebr) is inlined into the traversal loop
+template <typename F>
+inline degree_t for_each_nebr(nebr_iterator_t &iter, F f){
+    const vid_t* run;
+    degree_t run_count, count = 0;
+    while ((run = iter.next_run(run_count))) {
+        for (degree_t i = 0; i < run_count; ++i) f(run[i]);
+        count += run_count;
+    }
+    return count;
+}
+
+// Visit neighbors in place until pred(vid_t nebr) returns true, returns whether one did
+template <typename F>
+inline bool find_nebr(nebr_iterator_t &iter, F pred){
+    const vid_t* run;
+    degree_t run_count;
+    while ((run = iter.next_run(run_count))) {
+        for (degree_t i = 0; i < run_count; ++i) {
+            if (pred(run[i])) return true;
+        }
+    }
+    return false;
+}
+
+template <typename F>
+inline degree_t XPGraph::for_each_out_nebr(vid_t vid, nebr_iterator_t &iter, F f){
+    open_out_nebrs(vid, iter);
+    return for_each_nebr(iter, f);
+}
+
+template <typename F>
+inline degree_t XPGraph::for_each_in_nebr(vid_t vid, nebr_iterator_t &iter, F f){
+    open_in_nebrs(vid, iter);
+    return for_each_nebr(iter, f);
+}
@@ -29,6 +29,8 @@ uint64_t  ELOG_MASK;
 uint64_t  BATCH_CAP;// edge batching in edge log
 uint64_t  BATCH_MASK; // 0xFFFF;
 uint64_t  BUFFER_CAP;// edge buffering size in edge log
+uint32_t  ELOG_INDEX;// batches of unarchived edge log indexed per vertex, 0 for scanning the log
+uint32_t  DIRTY_ROUNDS;// archive rounds whose changed vertices are kept for incremental analytics, 0 for none
 
 /* ---------------------------------------------------------------------- */
 // Leveled buffer config
@@ -63,5 +65,8 @@ size_t PBLK_POOL_SIZE; // Total pblk pool size for all sockets
 // Basic arguments for XPGraph config
 bool BATTERY;
 bool DRAMONLY;
+bool FILEBACKED;
 bool CLWB;
 bool PERSIST;
+uint32_t COMPACT_BUDGET; // microseconds per archive round spent compacting pblock chains, 0 for none
+uint32_t COMPACT_MIN_BLKS; // pblocks appended to a chain before it is queued for compaction
@@ -25,6 +25,8 @@ void print_usage() {
     help += " -numa: Implementation of numa optimization: 0 for closing NUMA optimization, 1 for out/in-graph based implementation, 2 for sub-graph based implementation. Default: 2.\n";
 
     help += " --elogsize: Bits of maximum number of edges in edge log. Default: 30 for 1 billion edges, i.e., edge size equals 8GB.\n";
+    help += " --elog_index: Number of edge log batches ahead of the archiving marker indexed for per-vertex queries, 0 for scanning the log. Default: 0.\n";
+    help += " --dirty_rounds: Number of recent archive rounds whose changed vertices are kept as bitmaps for incremental analytics, 0 for none (incremental analytics then recompute from scratch). Default: 0.\n";
     help += " --leveled_buf: 0 for fixed vertex buffer size setting, 1 for hierarchical vertex buffer size setting. Default: 1.\n";
     help += " --minvbuf: Minimum per-vertex buffer size in bytes. Default: 16.\n";
     help += " --maxvbuf: Maximum per-vertex buffer size in bytes, or fixed per-vertex buffer size when leveled_buf = 0. Default: 256.\n";
@@ -36,6 +38,9 @@ void print_usage() {
 
     help += " --battery: 1 for XPGraph-B by allowing overwritting buffered edges. Default: 0.\n";
     help += " --dram_only: 1 for XPGraph-D by storing all data structure in DRAM and set the per-vertex buffer size as fixed 64B. Default: 0.\n";
+    help += " --file_backed: 1 for mapping the edge log and block pools to regular files under -p0/-p1 (e.g. on NVMe SSD), synced by msync at archive boundaries. Default: 0.\n";
+    help += " --compact_budget: Microseconds of each archive round spent merging long pblock chains into contiguous blocks, 0 for none. Default: 0.\n";
+    help += " --compact_min_blks: Number of pblocks appended to a vertex chain before it becomes a compaction candidate. Default: 4.\n";
     help += "--persist: 1 for saving XPGraph information, used for recovery. Default: 1.\n";
     help += "--recovery: Path of recovery data.\n";
  
@@ -82,6 +87,8 @@ void args_config(int argc, const char ** argv) {
     BATCH_CAP = 1L << BATCH_SHIFT;// edge batching in edge log
     BATCH_MASK = BATCH_CAP - 1; // 0xFFFF;
     BUFFER_CAP = ELOG_CAP - (BATCH_CAP * 64);// edge buffering size in edge log
+    ELOG_INDEX = get_option_int("--elog_index", 0); // Number of edge log batches ahead of the archiving marker indexed for per-vertex queries, 0 for scanning the log. Default: 0.
+    DIRTY_ROUNDS = get_option_int("--dirty_rounds", 0); // Number of recent archive rounds whose changed vertices are kept for incremental analytics, 0 for none. Default: 0.
 
     /* ---------------------------------------------------------------------- */
     // Leveled vertex buffer config
@@ -121,11 +128,15 @@ void args_config(int argc, const char ** argv) {
     CLWB = get_option_int("--clwb", 0); // clwb = 1 for clwb proactively
     PERSIST = get_option_int("--persist", 1); // persist = 1 for saving XPGraph information, used for recovery
     RECYPATH = get_option_string("--recovery", "/mnt/pmem1/wr/Recovery/");  // Path of recovery data.
+    COMPACT_BUDGET = get_option_int("--compact_budget", 0); // Microseconds of each archive round spent merging long pblock chains into contiguous blocks, 0 for none. Default: 0.
+    COMPACT_MIN_BLKS = get_option_int("--compact_min_blks", 4); // Number of pblocks appended to a vertex chain before it becomes a compaction candidate. Default: 4.
+    if(COMPACT_MIN_BLKS < 2) COMPACT_MIN_BLKS = 2;
 
     /* ---------------------------------------------------------------------- */
     // Variant systems
     BATTERY = get_option_int("--battery", 0); // 1 for XPGraph-B by allowing overwritting buffered edges. Default: 0.
     DRAMONLY = get_option_int("--dram_only", 0); // 1 for XPGraph-D by storing all data structure in DRAM and set the per-vertex buffer size as fixed 64B. Default: 0.
+    FILEBACKED = get_option_int("--file_backed", 0); // 1 for mapping the edge log and block pools to regular files, synced by msync at archive boundaries. Default: 0.
     if(DRAMONLY == 1){
         LEVELED_BUF = 0;
         MIN_VBUF_SIZE = MAX_VBUF_SIZE = 64;
@@ -139,6 +150,14 @@ void args_config(int argc, const char ** argv) {
         LEBUF_INPM = 0;
 
         PERSIST = 0;
+        FILEBACKED = 0;
+    }
+    if(FILEBACKED == 1){
+        // page cache is written back by msync, cache line flushes buy nothing
+        CLWB = 0;
+        // staging buffers are not needed for recovery, keep them off the SSD
+        TEDGE_INPM = 0;
+        LEBUF_INPM = 0;
     }
 }
 
@@ -181,6 +200,8 @@ void prinf_config(){
     cout<< "\t - ELOG_CAP = " << ELOG_CAP << ", size = " << ((ELOG_CAP+1) * 8 /GB) << "GB." << endl;
     cout<< "\t - BATCH_CAP = " << BATCH_CAP << ", size = " << ((BATCH_CAP) * 8 / KB) << "KB." << endl;
     cout<< "\t - BUFFER_CAP = " << BUFFER_CAP << ", size = " << ((BUFFER_CAP) * 8 / MB) << "MB." << endl;
+    cout<< "\t - ELOG_INDEX = " << ELOG_INDEX << " batches, size = " << ((ELOG_INDEX * BATCH_CAP * 16) / MB) << "MB." << endl;
+    cout<< "\t - DIRTY_ROUNDS = " << DIRTY_ROUNDS << " rounds, size = " << (((size_t)DIRTY_ROUNDS * ((nverts + 63) / 64) * 8) / MB) << "MB." << endl;
     /* ---------------------------------------------------------------------- */
     // Leveled vertex buffer config
     cout<< "  Vertex buffer: LEVELED_BUF = " << (uint32_t)LEVELED_BUF << endl;
@@ -216,6 +237,8 @@ void prinf_config(){
     cout<< "  Other arguments config: " << endl;
     cout<< "\t - BATTERY = " << (uint32_t)BATTERY << endl;
     cout<< "\t - DRAMONLY = " << (uint32_t)DRAMONLY << endl;
+    cout<< "\t - FILEBACKED = " << (uint32_t)FILEBACKED << endl;
     cout<< "\t - CLWB = " << (uint32_t)CLWB << endl;
     cout<< "\t - PERSIST = " << (uint32_t)PERSIST << endl;
+    cout<< "\t - COMPACT_BUDGET = " << COMPACT_BUDGET << "us per archive round, COMPACT_MIN_BLKS = " << COMPACT_MIN_BLKS << endl;
 }
@@ -97,6 +97,7 @@ public:
     inline blk_deg_t get_nebrcount() { return count;}
 	inline void set_nebrcount(blk_deg_t degree) {count = degree;}
     inline bool is_full(){return count == max_count;}
+    inline size_t get_size() { return max_count * sizeof(vid_t) + sizeof(pblock_t); };
 
     /* -------------------------------------------------------------- */
     // get/update adjlist info
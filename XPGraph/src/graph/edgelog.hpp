@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include "utils/basic_includes.hpp"
 
 class  edge_t {
@@ -40,3 +42,367 @@ public:
         head = marker = tail = efree = capacity = 0;
     }
 };
+
+// Written prefix of the edge log. Writers reserve positions by moving head and store the edges afterwards, so
+// [marker, head) may hold positions still being copied. Once its edges (and their index entries) are stored, a
+// writer adds the number of positions it wrote to the counter of their batch, and the archiving thread moves
+// marker only over batches whose reserved positions are all counted.
+// The counters form a ring of two log capacities worth of batches: a writer waits until efree is less than one
+// capacity behind it, so batch b + slot_count is not written before the counter of batch b was released. Each
+// counter carries the batch it counts for above COUNT_BITS, release() moves it on to the next batch of its slot.
+// Single-edge writers (commit_one) count into a word of their own, which the archiving thread adds to the batch
+// counter when it reads it, and move the count to the shared counter only when they go on to another batch. A
+// late move finds the counter moved on, its batch was archived with the count read from the word.
+class elog_commit_t
+{
+private:
+    static const index_t COUNT_BITS = 20; // counts up to BATCH_CAP
+    static const index_t COUNT_MASK = (1UL << COUNT_BITS) - 1;
+    static const uint32_t MAX_WRITERS = 256; // writers beyond use the shared counters for every edge
+
+    struct writer_t {
+        index_t pending; // batch << COUNT_BITS | positions of the batch stored and not yet in its counter
+        char padding[64 - sizeof(index_t)];
+    };
+
+    index_t* counts;
+    index_t slot_count;
+    index_t released; // counters of the batches below it were reset
+    writer_t* writers;
+    uint32_t writer_count;
+    uint64_t instance_id; // tells the writer slots of a new instance from those of a deleted one
+
+    static uint64_t next_instance_id(){
+        static uint64_t instances = 0;
+        return __sync_add_and_fetch(&instances, 1);
+    }
+
+    // The word of the calling thread, NULL once MAX_WRITERS threads have one.
+    inline index_t* writer_word(){
+        static thread_local uint64_t owner = 0;
+        static thread_local index_t* word = NULL;
+        if (owner != instance_id) {
+            owner = instance_id;
+            uint32_t w = __sync_fetch_and_add(&writer_count, 1);
+            word = (w < MAX_WRITERS) ? &writers[w].pending : NULL;
+        }
+        return word;
+    }
+
+    inline void add(index_t batch_id, index_t n){
+        __sync_fetch_and_add(&counts[batch_id % slot_count], n);
+    }
+
+public:
+    elog_commit_t(index_t capacity):slot_count(2 * (capacity >> BATCH_SHIFT)), released(0), writer_count(0){
+        counts = (index_t*)calloc(slot_count, sizeof(index_t));
+        for (index_t i = 0; i < slot_count; ++i) counts[i] = i << COUNT_BITS;
+        writers = (writer_t*)aligned_alloc(64, MAX_WRITERS * sizeof(writer_t));
+        memset(writers, 0, MAX_WRITERS * sizeof(writer_t));
+        instance_id = next_instance_id();
+    }
+
+    ~elog_commit_t(){
+        free(counts);
+        free(writers);
+    }
+
+    // Count the n positions from index as written, the range may span two batches.
+    inline void commit(index_t index, index_t n){
+        while (n) {
+            index_t batch_id = index >> BATCH_SHIFT;
+            index_t k = std::min(n, ((batch_id + 1) << BATCH_SHIFT) - index);
+            add(batch_id, k);
+            index += k;
+            n -= k;
+        }
+    }
+
+    // Count one position as written, in the word of the calling thread while it stays in the same batch.
+    inline void commit_one(index_t index){
+        index_t* word = writer_word();
+        if (word == NULL) {
+            commit(index, 1);
+            return;
+        }
+        index_t batch_id = index >> BATCH_SHIFT;
+        index_t pending = *word;
+        if ((pending >> COUNT_BITS) == batch_id) {
+            __atomic_store_n(word, pending + 1, __ATOMIC_RELEASE);
+            return;
+        }
+        // Take the count out of the word before it goes to the counter, so the archiving thread never sees it
+        // in both, then drop it if the counter moved on to a later batch.
+        __atomic_store_n(word, batch_id << COUNT_BITS, __ATOMIC_SEQ_CST);
+        index_t old_batch = pending >> COUNT_BITS, n = pending & COUNT_MASK;
+        index_t* count = &counts[old_batch % slot_count];
+        index_t cur = __atomic_load_n(count, __ATOMIC_SEQ_CST);
+        while (n && (cur >> COUNT_BITS) == old_batch
+               && !__atomic_compare_exchange_n(count, &cur, cur + n, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+        __atomic_store_n(word, (batch_id << COUNT_BITS) + 1, __ATOMIC_RELEASE);
+    }
+
+    // End of the written prefix from marker: complete batches, then the last batch if all its reserved positions
+    // are written. A counter is read before the writer words and head, so every position it counts is below that
+    // head and a count moved from a word to it is not read twice.
+    inline index_t written_head(index_t marker, index_t* log_head){
+        index_t pos = marker;
+        while (true) {
+            index_t batch_id = pos >> BATCH_SHIFT;
+            index_t begin = batch_id << BATCH_SHIFT;
+            index_t end = begin + BATCH_CAP;
+            index_t count = __atomic_load_n(&counts[batch_id % slot_count], __ATOMIC_SEQ_CST) & COUNT_MASK;
+            uint32_t nwriters = std::min(__atomic_load_n(&writer_count, __ATOMIC_SEQ_CST), MAX_WRITERS);
+            for (uint32_t w = 0; w < nwriters; ++w) {
+                index_t pending = __atomic_load_n(&writers[w].pending, __ATOMIC_SEQ_CST);
+                if ((pending >> COUNT_BITS) == batch_id) count += pending & COUNT_MASK;
+            }
+            index_t head = std::min(__atomic_load_n(log_head, __ATOMIC_SEQ_CST), end);
+            if (count != head - begin) return pos;
+            if (head < end) return head;
+            pos = end;
+        }
+    }
+
+    // Move the counters of the batches below marker on to the next batch of their slot, called by the archiving
+    // thread after elog->marker moves and before efree does.
+    inline void release(index_t marker){
+        while (((released + 1) << BATCH_SHIFT) <= marker) {
+            __atomic_store_n(&counts[released % slot_count], (released + slot_count) << COUNT_BITS, __ATOMIC_SEQ_CST);
+            released++;
+        }
+    }
+};
+
+// Per-vertex index over the unarchived window [marker, head) of the edge log.
+// Every BATCH_CAP-aligned batch of log positions owns one of slot_count slots. A slot chains the positions
+// of its batch by src (out-graph) and by dst (in-graph): heads[d][vid & BATCH_MASK] holds 1 + offset of the
+// latest position in the bucket and nexts[d][offset] links to the previous one (0 ends the chain).
+// Positions in [batch begin, start) are not chained and have to be scanned, which covers batches that were
+// written before their slot was recycled and any batch more than slot_count batches ahead of the marker.
+// A writer chains its edges before counting them in elog_commit_t, and a slot is recycled only once the marker
+// passed its batch, i.e. after every writer of that batch is done with the slot.
+class elog_index_t
+{
+private:
+    struct slot_t {
+        index_t batch_id; // batch owning this slot
+        index_t start; // positions of the batch before start are not in the chains
+        uint32_t* heads[2];
+        uint32_t* nexts[2];
+    };
+
+    static const index_t INVALID_BATCH = UINT64_MAX;
+
+    slot_t* slots;
+    index_t slot_count;
+    index_t recycled; // batches below it have been released
+
+    inline vid_t key_of(const edge_t& edge, int d){ return d ? edge.dst : edge.src; }
+
+    inline degree_t scan(const edge_t* edges, vid_t* neighbors, degree_t capacity, degree_t degree, vid_t vid, int d, index_t lo, index_t hi){
+        for (index_t i = lo; i < hi; ++i) {
+            const edge_t& edge = edges[i & ELOG_MASK];
+            if (key_of(edge, d) == vid) {
+                if (neighbors && degree < capacity) neighbors[degree] = key_of(edge, 1 - d);
+                degree++;
+            }
+        }
+        return degree;
+    }
+
+public:
+    elog_index_t(index_t _slot_count):slot_count(_slot_count), recycled(0){
+        slots = (slot_t*)calloc(slot_count, sizeof(slot_t));
+        for (index_t i = 0; i < slot_count; ++i) {
+            for (int d = 0; d < 2; ++d) {
+                slots[i].heads[d] = (uint32_t*)calloc(BATCH_CAP, sizeof(uint32_t));
+                slots[i].nexts[d] = (uint32_t*)malloc(BATCH_CAP * sizeof(uint32_t));
+            }
+            slots[i].batch_id = i;
+            slots[i].start = i << BATCH_SHIFT;
+        }
+        logstream(LOG_DEBUG) << "Edgelog index alloced " << slot_count << " batches, size = " << ((slot_count * BATCH_CAP * 16) >> 20) << "MB on DRAM" << std::endl;
+    }
+
+    ~elog_index_t(){
+        for (index_t i = 0; i < slot_count; ++i) {
+            for (int d = 0; d < 2; ++d) {
+                free(slots[i].heads[d]);
+                free(slots[i].nexts[d]);
+            }
+        }
+        free(slots);
+    }
+
+    // Chain the edge written at log position pos, called by writers after the edge is stored.
+    inline void insert(index_t pos, const edge_t& edge){
+        index_t batch_id = pos >> BATCH_SHIFT;
+        slot_t& slot = slots[batch_id % slot_count];
+        if (__atomic_load_n(&slot.batch_id, __ATOMIC_SEQ_CST) != batch_id) return;
+        uint32_t offset = pos & BATCH_MASK;
+        for (int d = 0; d < 2; ++d) {
+            uint32_t* head = slot.heads[d] + (key_of(edge, d) & BATCH_MASK);
+            uint32_t old;
+            do {
+                old = __atomic_load_n(head, __ATOMIC_ACQUIRE);
+                slot.nexts[d][offset] = old;
+            } while (!__sync_bool_compare_and_swap(head, old, offset + 1));
+        }
+    }
+
+    // Release the slots of all batches below marker to the batches slot_count ahead, called by the
+    // archiving thread after elog->marker moves. The marker only passes written positions (elog_commit_t), so
+    // no writer of a released batch can still be inside insert(). Writers of the new batch that got their
+    // position before log_head is read here are covered by start, the later ones see the new batch_id and
+    // chain themselves.
+    inline void recycle(index_t marker, index_t* log_head){
+        while (((recycled + 1) << BATCH_SHIFT) <= marker) {
+            slot_t& slot = slots[recycled % slot_count];
+            index_t batch_id = recycled + slot_count;
+            __atomic_store_n(&slot.batch_id, INVALID_BATCH, __ATOMIC_SEQ_CST);
+            memset(slot.heads[0], 0, BATCH_CAP * sizeof(uint32_t));
+            memset(slot.heads[1], 0, BATCH_CAP * sizeof(uint32_t));
+            __atomic_store_n(&slot.start, UINT64_MAX, __ATOMIC_SEQ_CST);
+            __atomic_store_n(&slot.batch_id, batch_id, __ATOMIC_SEQ_CST);
+            index_t head = __atomic_load_n(log_head, __ATOMIC_SEQ_CST);
+            __atomic_store_n(&slot.start, std::max(head, batch_id << BATCH_SHIFT), __ATOMIC_SEQ_CST);
+            recycled++;
+        }
+    }
+
+    // Collect the neighbors of vid logged in [begin, end) into neighbors (or only count them if neighbors
+    // is NULL), d = 0 for the out-graph and 1 for the in-graph. Returns the number of neighbors found, of
+    // which at most capacity are stored. Cost is proportional to the new edges of
+    // vid plus the unindexed part of the window. Neighbors come batch by batch, each batch in the order
+    // its writers chained them.
+    degree_t query(const edge_t* edges, vid_t* neighbors, vid_t vid, int d, index_t begin, index_t end, degree_t capacity = UINT32_MAX){
+        degree_t degree = 0;
+        if (begin >= end) return 0;
+        for (index_t batch_id = begin >> BATCH_SHIFT; batch_id <= ((end - 1) >> BATCH_SHIFT); ++batch_id) {
+            index_t lo = std::max(begin, batch_id << BATCH_SHIFT);
+            index_t hi = std::min(end, (batch_id + 1) << BATCH_SHIFT);
+            slot_t& slot = slots[batch_id % slot_count];
+            if (__atomic_load_n(&slot.batch_id, __ATOMIC_ACQUIRE) != batch_id) {
+                degree = scan(edges, neighbors, capacity, degree, vid, d, lo, hi);
+                continue;
+            }
+            index_t start = __atomic_load_n(&slot.start, __ATOMIC_ACQUIRE);
+            degree = scan(edges, neighbors, capacity, degree, vid, d, lo, std::min(hi, start));
+            if (start >= hi) continue;
+
+            // walk the chain from the latest position, bounded by the batch size
+            index_t chained_lo = std::max(lo, start);
+            index_t base = batch_id << BATCH_SHIFT;
+            degree_t first = degree;
+            uint32_t next = __atomic_load_n(slot.heads[d] + (vid & BATCH_MASK), __ATOMIC_ACQUIRE);
+            for (index_t steps = 0; next != 0 && steps < BATCH_CAP; ++steps) {
+                index_t pos = base + next - 1;
+                const edge_t& edge = edges[pos & ELOG_MASK];
+                if (pos >= chained_lo && pos < hi && key_of(edge, d) == vid) {
+                    if (neighbors && degree < capacity) neighbors[degree] = key_of(edge, 1 - d);
+                    degree++;
+                }
+                next = slot.nexts[d][next - 1];
+            }
+            if (neighbors && first < capacity) std::reverse(neighbors + first, neighbors + std::min(degree, capacity));
+
+            // the batch was archived and its slot reused meanwhile, its edges are still in the log
+            if (__atomic_load_n(&slot.batch_id, __ATOMIC_ACQUIRE) != batch_id) {
+                degree = scan(edges, neighbors, capacity, first, vid, d, chained_lo, hi);
+            }
+        }
+        return degree;
+    }
+};
+
+// Vertices touched by each of the last round_count archive rounds, one bitmap per snapshot id.
+// An edge marks both its endpoints, so analytics can resume from the results of an older snapshot and
+// recompute only around the changed vertices. A round still being filled, or already recycled, reads as lost.
+class snap_dirty_t
+{
+private:
+    struct round_t {
+        index_t snap_id; // snapshot of this round, INVALID_SNAP while being filled
+        bool has_del; // the round contains deletions
+        uint64_t* bits;
+    };
+    static const index_t INVALID_SNAP = UINT64_MAX;
+
+    vid_t nverts;
+    index_t word_count;
+    uint32_t round_count;
+    round_t* rounds;
+    pthread_mutex_t lock;
+
+public:
+    snap_dirty_t(vid_t _nverts, uint32_t _round_count):nverts(_nverts), round_count(_round_count){
+        word_count = (nverts + 63) / 64;
+        rounds = new round_t[round_count];
+        for(uint32_t i = 0; i < round_count; ++i){
+            rounds[i].snap_id = INVALID_SNAP;
+            rounds[i].has_del = false;
+            rounds[i].bits = (uint64_t*)calloc(word_count, sizeof(uint64_t));
+        }
+        pthread_mutex_init(&lock, 0);
+    }
+    ~snap_dirty_t(){
+        for(uint32_t i = 0; i < round_count; ++i) free(rounds[i].bits);
+        delete [] rounds;
+        pthread_mutex_destroy(&lock);
+    }
+
+    inline index_t get_word_count(){ return word_count; }
+
+    static inline void mark(uint64_t* bits, vid_t vid){
+        uint64_t bit = 1UL << (vid & 63);
+        if(!(bits[vid >> 6] & bit)) __sync_fetch_and_or(&bits[vid >> 6], bit);
+    }
+
+    // Mark the endpoints of log positions [from, to) into bits, returns whether any of them is a deletion
+    bool mark_range(uint64_t* bits, edge_t* edges, index_t from, index_t to){
+        bool has_del = false;
+        #pragma omp parallel for reduction(||:has_del) schedule(static) num_threads(THD_COUNT)
+        for(index_t i = from; i < to; ++i){
+            edge_t edge = edges[i & ELOG_MASK];
+            if(IS_DEL(edge.src)) has_del = true;
+            vid_t src = TO_SID(edge.src), dst = TO_SID(edge.dst);
+            if(src < nverts) mark(bits, src);
+            if(dst < nverts) mark(bits, dst);
+        }
+        return has_del;
+    }
+
+    // Record the round archiving log positions [from, to) as snapshot snap_id
+    void record_round(index_t snap_id, edge_t* edges, index_t from, index_t to){
+        round_t &round = rounds[snap_id % round_count];
+        pthread_mutex_lock(&lock);
+        round.snap_id = INVALID_SNAP;
+        pthread_mutex_unlock(&lock);
+        memset(round.bits, 0, word_count * sizeof(uint64_t));
+        round.has_del = mark_range(round.bits, edges, from, to);
+        pthread_mutex_lock(&lock);
+        round.snap_id = snap_id;
+        pthread_mutex_unlock(&lock);
+    }
+
+    // OR the rounds of snapshots [from_snap, to_snap) into bits, false if one of them is no longer kept
+    bool collect(index_t from_snap, index_t to_snap, uint64_t* bits, bool &has_del){
+        if(to_snap - from_snap > round_count) return false;
+        bool ok = true;
+        pthread_mutex_lock(&lock);
+        for(index_t s = from_snap; s < to_snap && ok; ++s){
+            round_t &round = rounds[s % round_count];
+            if(round.snap_id != s){
+                ok = false;
+                break;
+            }
+            has_del = has_del || round.has_del;
+            uint64_t* rbits = round.bits;
+            #pragma omp parallel for schedule(static) num_threads(THD_COUNT)
+            for(index_t w = 0; w < word_count; ++w) bits[w] |= rbits[w];
+        }
+        pthread_mutex_unlock(&lock);
+        return ok;
+    }
+};
@@ -397,8 +397,10 @@ void edge_shard_t::classify_store_and_divide(vid_t v_count, tid_t thd_count){
     // if(tid < 10) t_str = "0" + std::to_string(tid);
     // else t_str = std::to_string(tid);
     // m.start_time("3.1-3.3  -classify_store_and_divide_t" + t_str);
+    uint64_t start = hm_now();
 
     // m.start_time("3.1  -count_range_edges_t" + t_str);
+    uint64_t phase_start = start;
     vid_t  base_vid = ((v_count -1)/RANGE_COUNT);
     if (base_vid == 0) { base_vid = RANGE_COUNT;}
     //find the number of bits to do shift to find the rid
@@ -423,8 +425,10 @@ void edge_shard_t::classify_store_and_divide(vid_t v_count, tid_t thd_count){
     prefix_sum(global_range_in, thd_ecount_in, thd_count, 1);
 
     // m.stop_time("3.1  -count_range_edges_t" + t_str);
+    hm_stop(HM_COUNT_RANGE_EDGES_T, phase_start);
 
     // m.start_time("3.2  -store_to_global_range_t" + t_str);
+    phase_start = hm_now();
     // m.start_time("3.2.1  -alloc_temp_edges_barrier_t" + t_str);
     index_t total_edge_count = elog->marker - elog->tail;
     #pragma omp single nowait
@@ -457,8 +461,10 @@ void edge_shard_t::classify_store_and_divide(vid_t v_count, tid_t thd_count){
 
     store_to_global_range(bit_shift, ecount_out, ecount_in);
     // m.stop_time("3.2  -store_to_global_range_t" + t_str);
+    hm_stop(HM_STORE_TO_RANGE_T, phase_start);
 
     // m.start_time("3.3  -work_division_t" + t_str);
+    phase_start = hm_now();
     index_t edge_count = (total_edge_count*1.15)/(THD_COUNT)/(num_subgraphs); // --> work_division_GO()
     // index_t edge_count = (total_edge_count*0.85)/(THD_COUNT)/(num_subgraphs); // --> work_division()
 
@@ -482,6 +488,8 @@ void edge_shard_t::classify_store_and_divide(vid_t v_count, tid_t thd_count){
         }
     }
     // m.stop_time("3.1-3.3  -classify_store_and_divide_t" + t_str);
+    hm_stop(HM_WORK_DIVISION_T, phase_start);
+    hm_stop(HM_CLASSIFY_T, start);
 }
 
 // buffer ranged edges to vertex buffers
@@ -498,6 +506,7 @@ index_t edge_shard_t::buffer_ranges(index_t snap_id, graph_t* graph, global_rang
         }
         total_count += count;
     }
+    hm_count(HM_BUFFERED_EDGES, total_count);
     // logstream(LOG_WARNING) << "buffer_ranges: [" << r_start << ", " << r_end << "), total edge count = " << total_count << ", tid = " << tid << ", snap_id = " << snap_id << std::endl;
     return total_count;
     // tid_t tid = omp_get_thread_num();
@@ -516,6 +525,7 @@ void edge_shard_t::classify_and_buffer_d(index_t snap_id, graph_t* out_graph, gr
     // #pragma omp barrier
 
     // m.start_time("3.4  -buffer_ranges_t" + t_str);
+    uint64_t start = hm_now();
     if(NUMA_OPT == 2){ // Sub-graph based NUMA optimization
         rid_t r_start, r_end;
         for(sktid_t sid = 0; sid < num_subgraphs; ++sid){
@@ -585,6 +595,7 @@ void edge_shard_t::classify_and_buffer_d(index_t snap_id, graph_t* out_graph, gr
         cancel_thread_bind();
     }
     // m.stop_time("3.4  -buffer_ranges_t" + t_str);
+    hm_stop(HM_BUFFER_RANGES_T, start);
 
     // m.start_time("3.5  -cleanup" + t_str);
     // #pragma omp barrier 
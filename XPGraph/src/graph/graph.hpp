@@ -1,7 +1,103 @@
 #pragma once
 #include "graph/mem_bulk.hpp"
+#include <algorithm>
 #include <bitset>
 
+// Cursor over the adjacency list of one vertex that hands out runs of neighbors in place: the pblock chain
+// on PMEM first, then the vertex buffer on DRAM, i.e. the order of graph_t::get_nebrs(). When masked, the
+// deletion markers and the positions they delete are skipped on the fly; only the deleted positions are
+// gathered up front, so vertices without deletions are streamed without any copy.
+class adjlist_cursor_t {
+private:
+    pblock_t* next_blk;
+    buffer_t* vbuf;
+    const vid_t* adjlist; // current pblock or vbuf
+    degree_t count; // entries of adjlist
+    degree_t offset; // next entry of adjlist
+    degree_t pos; // position of adjlist[0] in the whole adjacency list
+    bool masked;
+    std::vector<degree_t> del_pos; // sorted positions deleted by markers
+    size_t del_idx;
+
+    inline bool load_next(){
+        pos += count;
+        offset = count = 0;
+        while (next_blk) {
+            adjlist = next_blk->get_adjlist();
+            count = next_blk->get_nebrcount();
+            next_blk = next_blk->get_next();
+            if (count) return true;
+        }
+        if (vbuf) {
+            adjlist = vbuf->get_adjlist();
+            count = vbuf->get_nebrcount();
+            vbuf = 0;
+            if (count) return true;
+        }
+        return false;
+    }
+
+public:
+    adjlist_cursor_t(){ reset(0, false); }
+
+    // Start on vert (NULL for a vertex without edges).
+    inline void reset(vertex_t* vert, bool _masked){
+        // rewind to the same chain, compact_chain() may publish a new one meanwhile
+        pblock_t* first_blk = next_blk = vert ? vert->get_1st_block() : 0;
+        buffer_t* first_vbuf = vbuf = vert ? vert->get_vbuf() : 0;
+        adjlist = 0;
+        count = offset = pos = 0;
+        masked = _masked && vert;
+        del_pos.clear();
+        del_idx = 0;
+        if (!masked) return;
+
+        // gather the deleted positions, then rewind
+        const vid_t* run;
+        degree_t run_count;
+        masked = false;
+        while ((run = next_run(run_count))) {
+            for (degree_t i = 0; i < run_count; ++i) {
+                if (IS_DEL(run[i])) del_pos.push_back(UNDEL_SID(run[i]));
+            }
+        }
+        std::sort(del_pos.begin(), del_pos.end());
+        next_blk = first_blk;
+        vbuf = first_vbuf;
+        count = offset = pos = 0;
+        masked = true;
+    }
+
+    // Next run of neighbors, NULL once the adjacency list is exhausted.
+    inline const vid_t* next_run(degree_t &run_count){
+        while (offset < count || load_next()) {
+            if (!masked) {
+                const vid_t* run = adjlist + offset;
+                run_count = count - offset;
+                offset = count;
+                return run;
+            }
+            // skip markers and deleted positions, then extend the run up to the next one
+            degree_t begin = offset;
+            while (begin < count) {
+                while (del_idx < del_pos.size() && del_pos[del_idx] < pos + begin) del_idx++;
+                if (IS_DEL(adjlist[begin]) || (del_idx < del_pos.size() && del_pos[del_idx] == pos + begin)) begin++;
+                else break;
+            }
+            degree_t end = begin;
+            degree_t limit = (del_idx < del_pos.size() && del_pos[del_idx] < pos + count) ? del_pos[del_idx] - pos : count;
+            while (end < limit && !IS_DEL(adjlist[end])) end++;
+            offset = end;
+            if (end > begin) {
+                run_count = end - begin;
+                return adjlist + begin;
+            }
+        }
+        run_count = 0;
+        return 0;
+    }
+};
+
 class graph_t
 {
 private:
@@ -18,6 +114,13 @@ private:
     mempool_t* snap_pool;
 	thd_mem_t* thd_mem;
 
+    // chain compaction, allocated only when COMPACT_BUDGET is set
+    static const uint16_t CHAIN_COMPACTED = UINT16_MAX;
+    uint16_t* chain_len; // pblocks appended to the chain, CHAIN_COMPACTED once it was compacted
+    uint8_t* read_heat; // saturating count of adjacency list reads, racy on purpose
+    std::vector<vid_t>* compact_pending; // per-thread candidates queued by update_last_block
+    std::vector<std::pair<uint32_t, vid_t>> compact_queue; // (priority, vid) left over from previous rounds
+
     // metric info
     metrics &m;
 
@@ -27,11 +130,22 @@ public:
         vertices = (vertex_t**)calloc(sizeof(vertex_t*), nverts);
         // logstream(LOG_INFO) << "calloc " << ((nverts * sizeof(vertex_t)) >> 20) << "MB in DRAM, for "<< nverts << " vertices of type vertex_t, size of each = " << sizeof(vertex_t) << std::endl;
         thd_mem = new thd_mem_t(vbuf_pool, pblk_pools, vert_pool, snap_pool);
+        chain_len = 0;
+        read_heat = 0;
+        compact_pending = 0;
+        if(COMPACT_BUDGET){
+            chain_len = (uint16_t*)calloc(sizeof(uint16_t), nverts);
+            read_heat = (uint8_t*)calloc(sizeof(uint8_t), nverts);
+            compact_pending = new std::vector<vid_t>[THD_COUNT];
+        }
     }
 
     ~graph_t(){
         delete thd_mem;
         free(vertices);
+        if(chain_len) free(chain_len);
+        if(read_heat) free(read_heat);
+        if(compact_pending) delete [] compact_pending;
     }
 
     inline bool get_is_in_graph(){ return is_in_graph;}
@@ -57,10 +171,36 @@ public:
         }
     }
 
+    // file-backed pools: a pblock written in place is written back by the next sync_pblk_pools()
+    inline void mark_pblk(pblock_t* cur_blk){ if(cur_blk) thd_mem->mark_pblk(cur_blk); }
+    inline void take_dirty_pblks(std::vector<std::pair<char*, char*>> &out){ thd_mem->take_dirty_pblks(out); }
+
     inline void set_pblk_pools(mempool_t** new_pblk_pools) {
         pblk_pools = new_pblk_pools;
         thd_mem->set_pblk_pools(new_pblk_pools);
     }
+
+    // Point cursor to the adjacency list of vid, masked = false also yields the deletion markers
+    inline void open_nebrs(vid_t vid, adjlist_cursor_t &cursor, bool masked = true){
+        vertex_t* vert = vertices[vid];
+        if(read_heat && read_heat[vid] < UINT8_MAX) read_heat[vid]++;
+        snap_t* vsnap = vert ? vert->get_snap() : 0;
+        cursor.reset(vert, masked && vsnap && get_delcount(vsnap->degree));
+    }
+
+    // Apply f to every live neighbor of vid in place, returns the number of neighbors visited
+    template <typename F>
+    inline degree_t for_each_nebr(vid_t vid, F f){
+        adjlist_cursor_t cursor;
+        open_nebrs(vid, cursor);
+        const vid_t* run;
+        degree_t run_count, count = 0;
+        while ((run = cursor.next_run(run_count))) {
+            for (degree_t i = 0; i < run_count; ++i) f(run[i]);
+            count += run_count;
+        }
+        return count;
+    }
     
     void buffer_range_edges(edge_t* edges, index_t count, uint16_t snap_id1);
     void increment_degree(vid_t vid);
@@ -89,6 +229,9 @@ public:
     bool compact_all_vbuf_pblks();
     void compact();
     void compact_nebrs(vid_t vid);
+    void compact_chain(vid_t vid, degree_t &blks_before, degree_t &blks_after);
+    vid_t compact_chains(double deadline, index_t &blks_before, index_t &blks_after);
+    void count_blocks(index_t &vcount, index_t &blocks);
     
 }; // class graph_t
 
@@ -187,6 +330,7 @@ void graph_t::buffer_nebr(vid_t vid, vid_t nebr){
                 pblock_t* cur_blk = vert->get_last_block();
                 cur_blk->assert_valid();
                 cur_blk->add_nebr(nebr);
+                mark_pblk(cur_blk);
                 if(CLWB) clwb_pblk(cur_blk);
                 return;
             }
@@ -224,6 +368,7 @@ void graph_t::delete_nebr(vid_t vid, vid_t nebr) {
                     pblock_t* cur_blk = vert->get_last_block();
                     cur_blk->assert_valid();
                     cur_blk->add_nebr(nebr);
+                    mark_pblk(cur_blk);
                     if(CLWB) clwb_pblk(cur_blk);
                     return;
                 }
@@ -246,18 +391,18 @@ degree_t graph_t::find_nebr(vid_t vid, vid_t nebr) {
     degree_t degree = get_degree(vid);
     if(degree == 0) return INVALID_DEGREE;
 
-    vid_t* neighbors = new vid_t[degree];
-    degree_t count = get_nebrs(vid, neighbors);
-
-    degree_t ret_degree = INVALID_DEGREE;
-    for(index_t i = 0; i < count; ++i) {
-        if(neighbors[i] == nebr) {
-            ret_degree = i;
-            break;
+    // positions count the deletion markers too
+    adjlist_cursor_t cursor;
+    open_nebrs(vid, cursor, false);
+    const vid_t* run;
+    degree_t run_count, pos = 0;
+    while ((run = cursor.next_run(run_count))) {
+        for(degree_t i = 0; i < run_count; ++i) {
+            if(run[i] == nebr) return pos + i;
         }
+        pos += run_count;
     }
-    delete [] neighbors;
-    return ret_degree;
+    return INVALID_DEGREE;
 }
 
 void graph_t::compress() {
@@ -383,7 +528,12 @@ inline pblock_t* graph_t::update_last_block(vid_t vid){
     if(NUMA_OPT == 2) socket_id = GET_SOCKETID(vid);
     else if(NUMA_OPT == 1) socket_id = (uint8_t)is_in_graph; // 0 for out-graph, 1 for in-graph
     pblock_t* cur_blk = thd_mem->alloc_pblk(size, socket_id);
+    mark_pblk(vert->get_last_block()); // its link to the new block
     vert->update_last_block(cur_blk);
+    hm_count(HM_ALLOCATED_PBLKS);
+    if(chain_len && chain_len[vid] < CHAIN_COMPACTED - 1 && ++chain_len[vid] == COMPACT_MIN_BLKS){
+        compact_pending[omp_get_thread_num()].push_back(vid);
+    }
     return cur_blk;
 }
 
@@ -392,18 +542,21 @@ inline void graph_t::archive_nebr(vid_t vid, vid_t nebr){
     if(cur_blk == 0 || cur_blk->is_full()) cur_blk = update_last_block(vid); 
     cur_blk->assert_valid();
     cur_blk->add_nebr(nebr);
+    mark_pblk(cur_blk);
 }
 
 void graph_t::archive_vbuf(vid_t vid){
     buffer_t* vbuf;
     blk_deg_t vbuf_nebrcount;
     if(!(vbuf = vertices[vid]->vbuf) || !(vbuf_nebrcount = vbuf->get_nebrcount())) return ;
+    hm_count(HM_ARCHIVED_VBUFS);
     blk_deg_t vbuf_maxcount = vbuf->get_max_nebrcount();
     // vbuf->assert_valid();
 
     pblock_t* cur_blk = vertices[vid]->get_last_block(); 
     if(cur_blk == 0) cur_blk = update_last_block(vid); 
     cur_blk->assert_valid();
+    mark_pblk(cur_blk);
     blk_deg_t pblk_count = cur_blk->get_nebrcount();
     blk_deg_t pblk_maxcount = cur_blk->get_max_nebrcount();
     blk_deg_t rest_count = pblk_maxcount - pblk_count;
@@ -479,6 +632,7 @@ degree_t graph_t::query_nebrs(vid_t vid){
 
 degree_t graph_t::get_nebrs(vid_t vid, vid_t* neighbors){
     assert(vid < nverts);
+    if(read_heat && read_heat[vid] < UINT8_MAX) read_heat[vid]++;
     degree_t pcount = get_nebrs_from_pblks(vid, neighbors);
     degree_t dcount = get_nebrs_from_vbuf(vid, neighbors+pcount);
     return pcount + dcount;
@@ -488,62 +642,10 @@ degree_t graph_t::get_nebrs(vid_t vid, vid_t* ptr, sdegree_t count) {
     vertex_t* vert = vertices[vid];
     if (vert == 0) return 0;
 
-    degree_t del_count = get_delcount(count);
-    degree_t delta_degree = get_total(count);
+    // live neighbors in place, deleted ones masked out by the cursor
     degree_t total_count = 0;
-    
-    if (del_count == 0) {
-        total_count = get_nebrs(vid, ptr);
-        assert(total_count == delta_degree);
-    } else {
-        degree_t nebr_count = get_actual(count);
-        degree_t other_count = delta_degree - nebr_count;
-        degree_t* del_pos = (degree_t*)calloc(2*del_count, sizeof(degree_t));
-        vid_t* others = (vid_t*)calloc(other_count, sizeof(vid));
-
-        degree_t pos = 0;
-        degree_t idel = 0;
-        degree_t other_pos = 0;
-        bool is_del = false;
-
-        degree_t local_degree = get_degree(vid);
-        vid_t* local_adjlist = new vid_t[local_degree];
-        degree_t degree = get_nebrs(vid, local_adjlist);
-        assert(local_degree == degree);
-
-        for (vid_t i = 0; i < degree; ++i) {
-            is_del = IS_DEL(local_adjlist[i]);
-            if (is_del) {
-                pos = UNDEL_SID(local_adjlist[i]);
-                if (total_count < nebr_count){
-                    del_pos[idel++] = pos;
-                    del_pos[idel++] = total_count;
-                } else {
-                    if (pos < nebr_count) {
-                        del_pos[idel++] = pos;
-                    }
-                }
-            } 
-            if (total_count < nebr_count) { //normal case
-                ptr[total_count++] = local_adjlist[i];
-            } else { //space is full
-                others[other_pos++] = local_adjlist[i];
-                if (is_del && pos >= total_count) {
-                    others[pos-total_count] = local_adjlist[i];
-                }
-            }
-        }
-
-        assert(other_pos <= other_count);
-        assert(idel <= 2*del_count);
-        while (other_pos != 0 && idel !=0) {
-            if (IS_DEL(others[--other_pos])) continue;
-            pos = del_pos[--idel];
-            ptr[pos] = others[other_pos];    
-        }
-        free(del_pos);
-        free(others);
-    }
+    for_each_nebr(vid, [&](vid_t nebr) { ptr[total_count++] = nebr; });
+    assert(total_count == get_actual(count));
     return total_count;
 }
 
@@ -610,6 +712,7 @@ degree_t graph_t::compact_vbuf_pblks(vid_t vid){
             adj_list1 = cur_blk->get_adjlist();
             final_blk->add_nebrs(adj_list1, bv_cnt);
             cur_blk->set_nebrcount(0);
+            mark_pblk(cur_blk);
             count += bv_cnt;
         }
         // TODO --> thd_mem->free_pblk(cur_blk, cur_blk->get_size())
@@ -702,4 +805,118 @@ void graph_t::compact_nebrs(vid_t vid) {
     buffer_t* vbuf = vert->get_vbuf();
     if(vbuf) thd_mem->free_vbuf(vbuf, vbuf->get_size());
     vert->set_vbuf(0);
-}
\ No newline at end of file
+}
+/* -------------------------------------------------------------- */
+// Chain compaction: between archive rounds, rewrite long pblock chains as contiguous right-sized blocks.
+// It runs on the archiving thread, the only writer of adjacency lists, so it needs no locks against
+// buffering or flushing; readers only ever see a complete old or new chain through first_blk.
+
+// Only the pblocks are copied, so the order and positions of the neighbors do not change and the vbuf, the
+// degrees and the deletion positions stay valid for both chains. Vertices with deletions are skipped: dropping
+// the markers would also change the vbuf and the degrees, which cannot be published together with the chain.
+// The old blocks are left in the pool, as by compact_nebrs(): readers may still walk the old chain. So a chain
+// is compacted at most once, which bounds the space left behind by the size of the adjacency lists.
+void graph_t::compact_chain(vid_t vid, degree_t &blks_before, degree_t &blks_after){
+    blks_before = blks_after = 0;
+    vertex_t* vert = vertices[vid];
+    snap_t* vsnap = vert ? vert->get_snap() : 0;
+    if(vsnap == 0) return;
+    for(pblock_t* blk = vert->get_1st_block(); blk; blk = blk->get_next()) blks_before++;
+    read_heat[vid] = 0;
+    if(get_delcount(vsnap->degree) || blks_before < 2){
+        chain_len[vid] = 1;
+        blks_after = blks_before;
+        return;
+    }
+    chain_len[vid] = CHAIN_COMPACTED;
+
+    static thread_local std::vector<vid_t> nebrs;
+    nebrs.clear();
+    for(pblock_t* blk = vert->get_1st_block(); blk; blk = blk->get_next()){
+        nebrs.insert(nebrs.end(), blk->get_adjlist(), blk->get_adjlist() + blk->get_nebrcount());
+    }
+
+    uint8_t socket_id = 0;
+    if(NUMA_OPT == 2) socket_id = GET_SOCKETID(vid);
+    else if(NUMA_OPT == 1) socket_id = (uint8_t)is_in_graph; // 0 for out-graph, 1 for in-graph
+    // keep the 4KB rounding of comp_pblk_size() within blk_deg_t
+    const degree_t max_blk_count = (blk_deg_t)-1 - 4096 / sizeof(vid_t);
+    pblock_t* first_blk = 0;
+    pblock_t* last_blk = 0;
+    degree_t sum_deg = nebrs.size();
+    degree_t index = 0;
+    while(index < sum_deg){
+        degree_t rel_nebrcount = std::min(sum_deg - index, max_blk_count);
+        pblock_t* cur_blk = thd_mem->alloc_pblk(comp_pblk_size(rel_nebrcount), socket_id);
+        rel_nebrcount = std::min(rel_nebrcount, (degree_t)cur_blk->get_max_nebrcount());
+        cur_blk->add_nebrs(nebrs.data() + index, rel_nebrcount);
+        if(CLWB) clwb_pblk(cur_blk);
+        if(last_blk) last_blk->add_next(cur_blk);
+        else first_blk = cur_blk;
+        last_blk = cur_blk;
+        index += rel_nebrcount;
+        blks_after++;
+    }
+    hm_count(HM_ALLOCATED_PBLKS, blks_after);
+
+    // publish the new chain only once it is complete
+    vert->set_last_block(last_blk);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    vert->set_1st_block(first_blk);
+}
+
+// Compact the queued chains, longest and most read first, until omp_get_wtime() reaches deadline. The rest
+// stays queued for the next round. Returns the number of compacted vertices.
+vid_t graph_t::compact_chains(double deadline, index_t &blks_before, index_t &blks_after){
+    blks_before = blks_after = 0;
+    for(tid_t tid = 0; tid < THD_COUNT; tid++){
+        for(vid_t vid : compact_pending[tid]) compact_queue.push_back(std::make_pair(0, vid));
+        compact_pending[tid].clear();
+    }
+    vid_t compacted = 0;
+    const size_t slice = THD_COUNT * 256;
+    while(!compact_queue.empty() && omp_get_wtime() < deadline){
+        // read_heat keeps changing under readers, so rank by a copy of the priorities
+        for(auto &cand : compact_queue) cand.first = (uint32_t)chain_len[cand.second] * (1 + read_heat[cand.second]);
+        size_t count = std::min(compact_queue.size(), slice);
+        std::partial_sort(compact_queue.begin(), compact_queue.begin() + count, compact_queue.end(),
+            [](const std::pair<uint32_t, vid_t> &a, const std::pair<uint32_t, vid_t> &b){ return a.first > b.first; });
+
+        index_t before = 0, after = 0;
+        vid_t done = 0;
+        #pragma omp parallel for num_threads(THD_COUNT) schedule(dynamic, 16) reduction(+:before,after,done)
+        for(size_t i = 0; i < count; ++i){
+            if(omp_get_wtime() >= deadline) continue;
+            degree_t blks0, blks1;
+            compact_chain(compact_queue[i].second, blks0, blks1);
+            before += blks0;
+            after += blks1;
+            done++;
+        }
+        blks_before += before;
+        blks_after += after;
+        compacted += done;
+
+        // compacted vertices are CHAIN_COMPACTED, skipped ones are back to a chain length of 1
+        auto end = std::remove_if(compact_queue.begin(), compact_queue.begin() + count,
+            [&](const std::pair<uint32_t, vid_t> &cand){
+                return chain_len[cand.second] < COMPACT_MIN_BLKS || chain_len[cand.second] == CHAIN_COMPACTED; });
+        compact_queue.erase(end, compact_queue.begin() + count);
+    }
+    return compacted;
+}
+
+// Vertices with at least one pblock and the pblocks they hold
+void graph_t::count_blocks(index_t &vcount, index_t &blocks){
+    index_t vcount1 = 0, blocks1 = 0;
+    #pragma omp parallel for num_threads(THD_COUNT) schedule(dynamic, 4096) reduction(+:vcount1,blocks1)
+    for(vid_t vid = 0; vid < nverts; ++vid){
+        vertex_t* vert = vertices[vid];
+        pblock_t* blk = vert ? vert->get_1st_block() : 0;
+        if(blk == 0) continue;
+        vcount1++;
+        for(; blk; blk = blk->get_next()) blocks1++;
+    }
+    vcount = vcount1;
+    blocks = blocks1;
+}
@@ -33,6 +33,7 @@ void prinf_timecost_breakdown(metrics &m, double time){
     std::ofstream ofs;
     ofs.open(statistic_filename.c_str(), std::ofstream::out | std::ofstream::app );
 
+    hot_metrics.merge_into(m);
     std::map<std::string, metrics_entry> entries = m.entries;
     std::string key2 = "2.2  -buf_and_insert";
     std::string key3 = "3-classify_and_buffer";
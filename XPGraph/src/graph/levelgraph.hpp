@@ -2,13 +2,40 @@
 
 #include "graph/edgeshard.hpp"
 #include "config/args_config.hpp"
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <linux/futex.h>
+
+// Cursor over all neighbors of a vertex: runs of the archived and buffered adjacency list in place, then
+// one run of the neighbors still in the edge log [marker, head), which are gathered into logged.
+class nebr_cursor_t
+{
+public:
+    adjlist_cursor_t adjlist;
+    std::vector<vid_t> logged;
+    bool logged_pending;
+
+    nebr_cursor_t():logged_pending(false){}
+
+    inline const vid_t* next_run(degree_t &run_count){
+        const vid_t* run = adjlist.next_run(run_count);
+        if (run || !logged_pending) return run;
+        logged_pending = false;
+        run_count = logged.size();
+        return run_count ? logged.data() : 0;
+    }
+};
 
 class levelgraph_t
 {
 private:
     // edge log storing new coming edge lists
     edgelog_t* elog;
+    elog_index_t* elog_index; // per-vertex index of [marker, head), NULL to scan the log
+    elog_commit_t* elog_commit; // written prefix of [marker, head), NULL for a preloaded log
     edge_shard_t* edge_shard;
+    snap_dirty_t* snap_dirty; // changed vertices of recent archive rounds, NULL if not tracked
     bool is_finished;
 
     // metadata: vertex and snap info
@@ -19,6 +46,16 @@ private:
     pthread_t       snap_thread;
     pthread_mutex_t snap_mutex;
     pthread_cond_t  snap_condition;
+    bool snap_requested; // guarded by snap_mutex, so no request is lost while archiving
+    pthread_rwlock_t read_lock; // held by begin_read() readers, and exclusively while a round moves edges
+    std::atomic<int> read_waiters; // readers in begin_read() waiting for the logged edges to be archived
+
+    // back-pressure of writers on the unflushed part of the edge log
+    int efree_seq;      // futex, bumped whenever elog->efree advances
+    std::atomic<int> efree_waiters;  // writers blocked until efree advances
+    std::atomic<int> efree_stalled;  // set by writers that blocked since the last flush
+    std::atomic<bool> high_water_informed; // a writer crossed high_water since efree last advanced
+    index_t high_water; // flush once [efree, marker) reaches it, adapted to the stalls
 
     // adjlists of graph
     graph_t* out_graph;
@@ -60,6 +97,8 @@ public:
     void free_vert_pool();
     void alloc_snap_pool();
     void free_snap_pool();
+    void sync_elog(index_t from, index_t to);
+    void sync_pblk_pools();
 
     /* -------------------------------------------------------------- */
     // manage snapshots
@@ -67,6 +106,7 @@ public:
         logstream(LOG_INFO) << "create_snapthread... \t tid = " << omp_get_thread_num() << std::endl;
         pthread_mutex_init(&snap_mutex, 0);
         pthread_cond_init(&snap_condition, 0);
+        snap_requested = false;
         // create new thread to conduct snap_func
         if (0 != pthread_create(&snap_thread, 0, levelgraph_t::snap_func, (void*)this)){
             assert(0);
@@ -76,7 +116,8 @@ public:
         levelgraph_t* ptr = (levelgraph_t*)(arg);
         do {
             pthread_mutex_lock(&ptr->snap_mutex);
-            pthread_cond_wait(&ptr->snap_condition, &ptr->snap_mutex);
+            while (!ptr->snap_requested) pthread_cond_wait(&ptr->snap_condition, &ptr->snap_mutex);
+            ptr->snap_requested = false;
             // struct timespec ts;
             // clock_gettime(CLOCK_REALTIME, &ts);
             // ts.tv_nsec += 100 * 1000000;  //30 is my milliseconds
@@ -91,7 +132,9 @@ public:
     /* -------------------------------------------------------------- */
     // get levelgraph info
     inline vid_t get_vcount(){ return nverts; }
-    inline vid_t get_snapid(){ return snap_id; }
+    inline vid_t get_snapid(){ return __atomic_load_n(&snap_id, __ATOMIC_ACQUIRE); }
+    void begin_read();
+    inline void end_read(){ pthread_rwlock_unlock(&read_lock); }
     inline edgelog_t* get_elog(){ return elog; }  
     inline graph_t* get_out_graph(){ return out_graph; }
     inline graph_t* get_in_graph(){ return in_graph; }
@@ -106,11 +149,18 @@ public:
     // update and query adjacency info
     void batch_edge_no_archive(edge_t edge);
     void batch_edge(edge_t edge);
+    void batch_edges(const edge_t* edges, index_t count);
     bool create_snapshot(index_t marker1 = 0);
     void inform_buffer();
+    void inform_high_water(index_t end);
     void archive_edges_d(index_t count);
     void archive_edges(index_t count);
     void flush_all_bufs(index_t marker1);
+    void wait_efree(index_t index);
+    void advance_efree(index_t marker1);
+    void adapt_high_water();
+    void compact_chains();
+    void report_block_chains();
     void inform_wait_buffer_all();
     degree_t get_degree(vid_t vid, bool is_in_graph); // 0 for out-graph, 1 for in_graph
     degree_t query_nebrs(vid_t* neighbors, vid_t vid, bool is_in_graph);
@@ -118,6 +168,8 @@ public:
     degree_t query_nebrs_logged_st(vid_t* neighbors, vid_t vid, bool is_in_graph);
     degree_t query_nebrs_buffered(vid_t* neighbors, vid_t vid, bool is_in_graph);
     degree_t query_nebrs_flushed(vid_t* neighbors, vid_t vid, bool is_in_graph);
+    void open_nebrs(vid_t vid, bool is_in_graph, nebr_cursor_t &cursor);
+    bool get_changed_vertices(index_t from_snap, index_t &to_snap, uint64_t* bits, bool &has_del);
     bool compact_adjlists(vid_t vid, bool is_in_graph);
     bool compact_all_adjlists();
     void compress_all_graph();
@@ -133,15 +185,21 @@ inline void levelgraph_t::init_elog(){
     m.start_time("1.1  -init_alloc_elog");
     elog = new edgelog_t(); 
     alloc_elog_data();
+    elog_index = ELOG_INDEX ? new elog_index_t(ELOG_INDEX) : NULL;
+    elog_commit = new elog_commit_t(elog->capacity);
     m.stop_time("1.1  -init_alloc_elog");
 }
 inline void levelgraph_t::free_elog(){ 
     if(elog->data) free_elog_data();
     delete elog; 
+    if(elog_index) delete elog_index;
+    elog_index = NULL;
+    if(elog_commit) delete elog_commit;
+    elog_commit = NULL;
 }
 inline void levelgraph_t::reset_elog(char* buf, index_t count){ 
     if(elog) free_elog();
-    elog = new edgelog_t((edge_t*)buf, count); 
+    elog = new edgelog_t((edge_t*)buf, count); // preloaded log, archived by explicit markers without index
 }
 
 inline void levelgraph_t::init_graph(){
@@ -158,9 +216,22 @@ inline void levelgraph_t::init_graph(){
     edge_shard = new edge_shard_t(elog, m);
     out_graph = new graph_t(false, nverts, vbuf_pool, pblk_pools, vert_pool, snap_pool, m);
     in_graph = new graph_t(true, nverts, vbuf_pool, pblk_pools, vert_pool, snap_pool, m);
+    snap_dirty = DIRTY_ROUNDS ? new snap_dirty_t(nverts, DIRTY_ROUNDS) : NULL;
+    // a waiting round goes before new readers, so back-to-back passes do not hold it off
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&read_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
     create_threads(); // create thread to monitor for archive
     is_finished = false;
     snap_id = 0;
+    efree_seq = 0;
+    efree_waiters = 0;
+    efree_stalled = 0;
+    read_waiters = 0;
+    high_water_informed = false;
+    high_water = BUFFER_CAP;
     m.stop_time("1.2  -init_alloc_graph");
 }
 inline void levelgraph_t::free_graph(){
@@ -168,6 +239,9 @@ inline void levelgraph_t::free_graph(){
     delete out_graph;
     delete in_graph;
     delete edge_shard;
+    if(snap_dirty) delete snap_dirty;
+    snap_dirty = NULL;
+    pthread_rwlock_destroy(&read_lock);
     
     if(SNAP_INPM) free_snap_pool();
     if(VERT_INPM) free_vert_pool();
@@ -357,53 +431,197 @@ inline void levelgraph_t::free_snap_pool(){
     delete snap_pool;
 }
 
+/* -------------------------------------------------------------- */
+// write back file-backed elog and pblk pools at archive boundaries
+inline void levelgraph_t::sync_elog(index_t from, index_t to){
+    if(!FILEBACKED || DRAMONLY || to <= from) return;
+    // the range may wrap around the circular log
+    if(to - from >= elog->capacity){
+        file_sync(elog->data, elog->capacity * sizeof(edge_t));
+        return;
+    }
+    index_t begin = from & ELOG_MASK, end = to & ELOG_MASK;
+    if(begin < end){
+        file_sync(elog->data + begin, (end - begin) * sizeof(edge_t));
+    } else {
+        file_sync(elog->data + begin, (elog->capacity - begin) * sizeof(edge_t));
+        file_sync(elog->data, end * sizeof(edge_t));
+    }
+}
+// Write back only the part of each pool between the first and the last pblock allocated or appended to since
+// the last call. One msync per pool: on a file system each msync also commits the journal, so a call per
+// dirty run costs more than the clean pages between the runs.
+inline void levelgraph_t::sync_pblk_pools(){
+    if(!FILEBACKED || DRAMONLY) return;
+    uint64_t start = hm_now();
+    std::vector<std::pair<char*, char*>> ranges;
+    out_graph->take_dirty_pblks(ranges);
+    in_graph->take_dirty_pblks(ranges);
+    const uintptr_t page_mask = PAGE_SIZE - 1;
+    index_t synced = 0;
+    for(uint8_t i = 0; i < NUM_SOCKETS; ++i){
+        char* base = pblk_pools[i]->get_base();
+        char* pool_end = base + pblk_pools[i]->get_used();
+        char* beg = pool_end;
+        char* end = base;
+        for(auto &range : ranges){
+            if(range.first < base || range.first >= pool_end) continue;
+            beg = std::min(beg, range.first);
+            end = std::max(end, range.second);
+        }
+        if(beg >= end) continue;
+        beg = (char*)((uintptr_t)beg & ~page_mask);
+        file_sync(beg, end - beg);
+        synced += end - beg;
+    }
+    hm_count(HM_SYNCED_PBLK_BYTES, synced);
+    hm_stop(HM_SYNC_PBLK_POOLS, start);
+}
+
 /* -------------------------------------------------------------- */
 // write edge log
 void levelgraph_t::batch_edge_no_archive(edge_t edge){
     index_t index = __sync_fetch_and_add(&elog->head, 1L);
     index_t index1 = (index & ELOG_MASK);
     elog->data[index1] = edge;
+    if(elog_index) elog_index->insert(index, edge);
+    if(elog_commit) elog_commit->commit_one(index);
+    hm_count(HM_LOGGED_EDGES);
 }
 
 inline void levelgraph_t::batch_edge(edge_t edge){
     index_t index = __sync_fetch_and_add(&elog->head, 1L);
-    //Check if we are overwritting the unarchived data, if so sleep
+    //Check if we are overwritting the unflushed data, if so block until the archive thread frees it
     // while (index + 1 - elog->tail > elog->capacity) {
-    while (index + 2 - elog->efree > elog->capacity) {
-        m.start_time("2.2.2    -sleep_to_wait_archive");
-        // logstream(LOG_DEBUG) << "Sleeping for edge log, index + 1 = " << index + 1 << ", elog->efree = " << elog->efree << std::endl; sleep(1);
-        usleep(10);
-        m.stop_time("2.2.2    -sleep_to_wait_archive");
+    if (index + 2 - elog->efree > elog->capacity) {
+        wait_efree(index);
     }
     // write edge log to elog_head
     index_t index1 = (index & ELOG_MASK);
     elog->data[index1] = edge; // 这里也许可以加入预取优化？
+    if(elog_index) elog_index->insert(index, edge);
+    if(elog_commit) elog_commit->commit_one(index);
+    hm_count(HM_LOGGED_EDGES);
 
     //inform archive thread if the number of edges reaching the threshold
     index += 1;
     index_t size = ((index - elog->marker) & BATCH_MASK);
     if ((0 == size) && (index != elog->marker)) {
         inform_buffer();
+    } else {
+        inform_high_water(index);
     }
 }
 
+// Append edges with one reservation of log slots per BATCH_CAP edges, copied by non-temporal stores.
+inline void levelgraph_t::batch_edges(const edge_t* edges, index_t count){
+    for (index_t done = 0; done < count; ) {
+        index_t n = std::min(count - done, (index_t)BATCH_CAP);
+        index_t index = __sync_fetch_and_add(&elog->head, n);
+        if (index + n + 1 - elog->efree > elog->capacity) {
+            wait_efree(index + n - 1);
+        }
+        // the reserved range may wrap around the end of the log
+        index_t index1 = (index & ELOG_MASK);
+        index_t first = std::min(n, ELOG_CAP - index1);
+        ntmemcpy((char*)(elog->data + index1), (const char*)(edges + done), first * sizeof(edge_t));
+        if (first < n) ntmemcpy((char*)elog->data, (const char*)(edges + done + first), (n - first) * sizeof(edge_t));
+        sfence();
+        if(elog_index) {
+            for (index_t i = 0; i < n; ++i) elog_index->insert(index + i, edges[done + i]);
+        }
+        // the archive thread skips the range until it is counted here
+        if(elog_commit) elog_commit->commit(index, n);
+        hm_count(HM_LOGGED_EDGES, n);
+
+        // inform archive thread if the range completes a batch or crosses the high-water mark, as batch_edge does per edge
+        index_t end = index + n;
+        index_t marker = elog->marker;
+        if (end > marker && (index < marker || ((end - marker) >> BATCH_SHIFT) != ((index - marker) >> BATCH_SHIFT))) {
+            inform_buffer();
+        } else {
+            inform_high_water(end);
+        }
+        done += n;
+    }
+}
+
+// Inform the archive thread once the unflushed part of the log reaches high_water at end, so it archives and
+// flushes without waiting for a full batch. Only the first writer past the mark informs until efree advances.
+inline void levelgraph_t::inform_high_water(index_t end){
+    if (end - elog->efree >= high_water && !high_water_informed && !high_water_informed.exchange(true)) {
+        inform_buffer();
+    }
+}
+
+// Block a writer until elog->efree passes index, instead of polling it.
+inline void levelgraph_t::wait_efree(index_t index){
+    uint64_t start = hm_now();
+    const struct timespec timeout = {0, 1000000}; // re-inform the archive thread every 1ms
+    efree_waiters++;
+    efree_stalled = 1;
+    inform_buffer();
+    while (true) {
+        int seq = __atomic_load_n(&efree_seq, __ATOMIC_SEQ_CST);
+        if (index + 2 - __atomic_load_n(&elog->efree, __ATOMIC_SEQ_CST) <= elog->capacity) break;
+        if (syscall(SYS_futex, &efree_seq, FUTEX_WAIT_PRIVATE, seq, &timeout, NULL, 0) == -1 && errno == ETIMEDOUT) {
+            inform_buffer();
+        }
+    }
+    efree_waiters--;
+    hm_stop(HM_STALL_TO_WAIT_ARCHIVE, start);
+}
+
+inline void levelgraph_t::advance_efree(index_t marker1){
+    __atomic_store_n(&elog->efree, marker1, __ATOMIC_SEQ_CST);
+    high_water_informed = false;
+    __sync_fetch_and_add(&efree_seq, 1);
+    if (efree_waiters) {
+        syscall(SYS_futex, &efree_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+// Flush earlier after a round in which writers stalled on the log, and move back towards BUFFER_CAP otherwise.
+inline void levelgraph_t::adapt_high_water(){
+    index_t step = elog->capacity >> 4;
+    if (efree_stalled) {
+        if (high_water >= BUFFER_CAP / 2 + step) high_water -= step;
+        logstream(LOG_DEBUG) << "writers stalled on edge log, high_water = " << high_water << endl;
+    } else if (high_water + BATCH_CAP <= BUFFER_CAP) {
+        high_water += BATCH_CAP;
+    }
+    efree_stalled = 0;
+}
+
 /* -------------------------------------------------------------- */
 // create_snapshot and archive
 bool levelgraph_t::create_snapshot(index_t marker1){
-    index_t count = elog->head - elog->marker;
+    // only archive what writers finished storing, reserved positions may still be being copied
+    index_t head = elog_commit ? elog_commit->written_head(elog->marker, &elog->head) : elog->head;
+    index_t count = head - elog->marker;
     if(count == 0) return false;
-    if(count < BATCH_CAP && !is_finished) return false;
-    if(marker1 == 0) marker1 = elog->head;
+    // a partial batch is archived only when writers crossed the high-water mark or are blocked on the log, or readers wait for it
+    if(count < BATCH_CAP && !is_finished && !efree_waiters && !read_waiters && head - elog->efree < high_water) return false;
+    // from the marker move until the edges are in the vbufs and pblocks they are neither in [marker, head) nor in
+    // the adjacency lists, and flushing recycles the vbufs: keep begin_read() readers out of the round. Take
+    // along what was written while they held it, or it would be read from the log until the next round.
+    pthread_rwlock_wrlock(&read_lock);
+    if(elog_commit) head = elog_commit->written_head(elog->marker, &elog->head);
+    else head = elog->head;
+    if(marker1 == 0) marker1 = head;
+    sync_elog(elog->marker, marker1); // one msync per batch instead of flushing every log line
     elog->marker = marker1;
+    if(elog_commit) elog_commit->release(marker1);
+    if(elog_index) elog_index->recycle(marker1, &elog->head);
     count = elog->marker - elog->tail;
     logstream(LOG_INFO) << "creating snapshot " << snap_id << " of range [" << elog->tail << ", " << elog->marker << "), archiving number of edges = " << count << ",  tid = " << omp_get_thread_num()  << std::endl;
-    m.start_time("3-classify_and_buffer");
+    uint64_t start = hm_now();
     // #pragma omp parallel num_threads (THD_COUNT) 
     // {
     //     edge_shard->classify_and_buffer_d(snap_id, out_graph, in_graph);
     // }
 
-    m.start_time("3.1-3 -classify");
+    uint64_t phase_start = hm_now();
     // tid_t thd_count = THD_COUNT > 16? 16: THD_COUNT;
     // #pragma omp parallel num_threads (thd_count) 
     // {
@@ -413,24 +631,28 @@ bool levelgraph_t::create_snapshot(index_t marker1){
     {
         edge_shard->classify_store_and_divide(nverts, THD_COUNT);
     }
-    m.stop_time("3.1-3 -classify");
-    m.start_time("3.4 -buffer");
+    hm_stop(HM_CLASSIFY, phase_start);
+    phase_start = hm_now();
     #pragma omp parallel num_threads (THD_COUNT) 
     {
         edge_shard->classify_and_buffer_d(snap_id, out_graph, in_graph);
     }
-    m.stop_time("3.4 -buffer");
+    hm_stop(HM_BUFFER, phase_start);
+
+    hm_stop(HM_CLASSIFY_AND_BUFFER, start);
 
-    m.stop_time("3-classify_and_buffer");
+    // remember the vertices changed by this round before publishing its snap_id
+    if(snap_dirty) snap_dirty->record_round(snap_id, elog->data, elog->tail, marker1);
 
-    // if overwrite comes soon, then flush all buffer to PMEM
-    if(marker1 - elog->efree >= BUFFER_CAP){
-        logstream(LOG_DEBUG) << "overwriting soon: " << marker1 << " " << elog->efree << " " << BUFFER_CAP << endl;
+    // if overwrite comes soon, or writers are already blocked on it, then flush all buffer to PMEM
+    if(marker1 - elog->efree >= high_water || efree_waiters){
+        logstream(LOG_DEBUG) << "overwriting soon: " << marker1 << " " << elog->efree << " " << high_water << endl;
         if(BATTERY == 0 && DRAMONLY == 0){
             flush_all_bufs(marker1);
         } else {
-            elog->efree = marker1;
+            advance_efree(marker1);
         }
+        adapt_high_water();
     }
 
     // if vbuf_pool fills up soon, then flush all buffer to PMEM
@@ -440,14 +662,47 @@ bool levelgraph_t::create_snapshot(index_t marker1){
             flush_all_bufs(marker1);
         }
     } 
+    pthread_rwlock_unlock(&read_lock);
     
     elog->tail = marker1;
-    snap_id++;
+    __atomic_store_n(&snap_id, snap_id + 1, __ATOMIC_RELEASE);
+
+    // spend the rest of the round on long pblock chains, unless writers are waiting for this thread
+    if(COMPACT_BUDGET && !efree_waiters) compact_chains();
     return true;
 }
 
+// Compact the longest and most read pblock chains of both graphs within COMPACT_BUDGET microseconds.
+inline void levelgraph_t::compact_chains(){
+    uint64_t start = hm_now();
+    double deadline = omp_get_wtime() + COMPACT_BUDGET / 1.0E6;
+    index_t out_before, out_after, in_before, in_after;
+    vid_t count = out_graph->compact_chains(deadline, out_before, out_after);
+    count += in_graph->compact_chains(deadline, in_before, in_after);
+    if(count == 0) return;
+    hm_stop(HM_COMPACT_CHAINS, start);
+    hm_count(HM_COMPACTED_VERTICES, count);
+    hm_count(HM_COMPACT_PBLKS_BEFORE, out_before + in_before);
+    hm_count(HM_COMPACT_PBLKS_AFTER, out_after + in_after);
+    logstream(LOG_DEBUG) << "compacted " << count << " chains, pblocks " << out_before + in_before << " -> " << out_after + in_after << endl;
+}
+
+// Average pblocks per vertex with pblocks, now and as it would be without the compactions so far.
+void levelgraph_t::report_block_chains(){
+    index_t out_vcount, out_blocks, in_vcount, in_blocks;
+    out_graph->count_blocks(out_vcount, out_blocks);
+    in_graph->count_blocks(in_vcount, in_blocks);
+    index_t vcount = out_vcount + in_vcount;
+    index_t blocks = out_blocks + in_blocks;
+    index_t saved = hot_metrics.aggregate(HM_COMPACT_PBLKS_BEFORE).sum - hot_metrics.aggregate(HM_COMPACT_PBLKS_AFTER).sum;
+    double avg = vcount ? (double)blocks / vcount : 0;
+    double avg_before = vcount ? (double)(blocks + saved) / vcount : 0;
+    logstream(LOG_INFO) << "pblocks per vertex: " << avg << " (" << blocks << " pblocks of " << vcount << " vertices), "
+        << avg_before << " without compaction, " << hot_metrics.aggregate(HM_COMPACTED_VERTICES).sum << " chains compacted" << endl;
+}
+
 void levelgraph_t::flush_all_bufs(index_t marker1){
-    m.start_time("4-flush_all_bufs");
+    uint64_t start = hm_now();
     logstream(LOG_WARNING) << "flush_all_vbufs start, elog->efree = " << elog->efree << ", marker1 = " <<marker1 << std::endl;
     if (MEMPOOL) {
         if(vbuf_pool->get_used() > vbuf_pool_max_used) vbuf_pool_max_used = vbuf_pool->get_used();
@@ -458,14 +713,16 @@ void levelgraph_t::flush_all_bufs(index_t marker1){
     {
         edge_shard->archive_all_d(out_graph, in_graph);
     }
+    sync_pblk_pools(); // archived edges must be durable before their log space is freed
     if(MEMPOOL) vbuf_pool->clear();
-    elog->efree = marker1;
+    advance_efree(marker1);
     logstream(LOG_WARNING) << "flush_all_vbufs end, elog->efree = " << elog->efree << ", marker1 = " <<marker1 << std::endl;
-    m.stop_time("4-flush_all_bufs");
+    hm_stop(HM_FLUSH_ALL_BUFS, start);
 }
 
 inline void levelgraph_t::inform_buffer(){
     pthread_mutex_lock(&snap_mutex);
+    snap_requested = true;
     // pthread_cond_signal函数的作用是发送一个信号给另外一个正在处于阻塞等待状态的线程, 使其脱离阻塞状态,继续执行.如果没有线程处在阻塞等待状态,pthread_cond_signal也会成功返回。
     pthread_cond_signal(&snap_condition);
     pthread_mutex_unlock(&snap_mutex);
@@ -483,6 +740,34 @@ inline void levelgraph_t::inform_wait_buffer_all() {
     // flush_all_bufs(0);
 }
 
+// Start a pass over a consistent graph: archive what is logged now, partial batch or not, then keep the rounds
+// out until end_read(). The edges logged meanwhile are read from the log, which stays short that way.
+inline void levelgraph_t::begin_read(){
+    index_t head = elog_commit ? elog_commit->written_head(elog->marker, &elog->head) : elog->head;
+    if(elog->marker < head){
+        read_waiters++;
+        while(__atomic_load_n(&elog->marker, __ATOMIC_ACQUIRE) < head){
+            inform_buffer();
+            usleep(1);
+        }
+        read_waiters--;
+    }
+    pthread_rwlock_rdlock(&read_lock);
+}
+
+// Vertices changed since snapshot from_snap: the archive rounds [from_snap, to_snap) and the edges not archived yet,
+// to_snap is set to the current snapshot. Returns false when a round is no longer kept, so all vertices have to be recomputed.
+inline bool levelgraph_t::get_changed_vertices(index_t from_snap, index_t &to_snap, uint64_t* bits, bool &has_del){
+    to_snap = get_snapid();
+    has_del = false;
+    if(!snap_dirty || from_snap > to_snap) return false;
+    memset(bits, 0, snap_dirty->get_word_count() * sizeof(uint64_t));
+    if(!snap_dirty->collect(from_snap, to_snap, bits, has_del)) return false;
+    // logged edges are visible to queries, they will be marked again by the round archiving them
+    if(snap_dirty->mark_range(bits, elog->data, elog->marker, elog->head)) has_del = true;
+    return true;
+}
+
 inline degree_t levelgraph_t::get_degree(vid_t vid, bool is_in_graph) {
     if(vid >= nverts){
         logstream(LOG_ERROR) << "Invalid vid, as vid: " << vid << " >= nverts:" << nverts << std::endl;
@@ -490,7 +775,10 @@ inline degree_t levelgraph_t::get_degree(vid_t vid, bool is_in_graph) {
     }
 
     degree_t nebr_count = 0;
-    if (elog->head > elog->marker){
+    if (elog_index) {
+        // count from the index of edgelog [marker, head)
+        nebr_count = elog_index->query(elog->data, NULL, vid, is_in_graph, elog->marker, elog->head);
+    } else if (elog->head > elog->marker){
         // query from edgelog from [marker, head)
         edge_t* edges = elog->data;
         #pragma omp parallel for reduction(+:nebr_count) schedule(static)
@@ -549,6 +837,11 @@ inline degree_t levelgraph_t::query_nebrs_logged_mt(vid_t* neighbors, vid_t vid,
         return 0;
     }
 
+    // the indexed lookup is proportional to the new edges of vid, no thread team needed
+    if (elog_index) {
+        return elog_index->query(elog->data, neighbors, vid, is_in_graph, elog->marker, elog->head);
+    }
+
     // query from edgelog from [marker, head) by multi-threads
     degree_t degree = 0;
     if (elog->head > elog->marker){
@@ -586,6 +879,10 @@ inline degree_t levelgraph_t::query_nebrs_logged_st(vid_t* neighbors, vid_t vid,
         return 0;
     }
 
+    if (elog_index) {
+        return elog_index->query(elog->data, neighbors, vid, is_in_graph, elog->marker, elog->head);
+    }
+
     // query from edgelog from [marker, head) by single thread
     degree_t degree = 0;
     index_t i, index;
@@ -640,6 +937,46 @@ inline degree_t levelgraph_t::query_nebrs_flushed(vid_t* neighbors, vid_t vid, b
     return pcount;
 }
 
+// start a zero-copy traversal of the neighbors of vid, only the logged ones are copied
+inline void levelgraph_t::open_nebrs(vid_t vid, bool is_in_graph, nebr_cursor_t &cursor) {
+    cursor.logged.clear();
+    cursor.logged_pending = false;
+    if(vid >= nverts){
+        logstream(LOG_ERROR) << "Invalid vid, as vid: " << vid << " >= nverts:" << nverts << std::endl;
+        cursor.adjlist.reset(0, false);
+        return;
+    }
+
+    if (!is_in_graph) {
+        out_graph->open_nebrs(vid, cursor.adjlist);
+    } else {
+        in_graph->open_nebrs(vid, cursor.adjlist);
+    }
+
+    index_t marker = elog->marker, head = elog->head;
+    if (head <= marker) return;
+    if (elog_index) {
+        // retry with the exact size if writers added neighbors between the two lookups
+        degree_t count = elog_index->query(elog->data, NULL, vid, is_in_graph, marker, head);
+        do {
+            cursor.logged.resize(count);
+            count = elog_index->query(elog->data, cursor.logged.data(), vid, is_in_graph, marker, head, cursor.logged.size());
+        } while (count > cursor.logged.size());
+        cursor.logged.resize(count);
+    } else {
+        edge_t* edges = elog->data;
+        for (index_t i = marker; i < head; ++i) {
+            index_t index = i & ELOG_MASK;
+            if (!is_in_graph) {
+                if (vid == edges[index].src) cursor.logged.push_back(edges[index].dst);
+            } else {
+                if (vid == edges[index].dst) cursor.logged.push_back(edges[index].src);
+            }
+        }
+    }
+    cursor.logged_pending = !cursor.logged.empty();
+}
+
 bool levelgraph_t::compact_adjlists(vid_t vid, bool is_in_graph){
     if(vid >= nverts){
         logstream(LOG_ERROR) << "Invalid vid, as vid: " << vid << " >= nverts:" << nverts << std::endl;
@@ -17,12 +17,18 @@ struct mem_bulk_t{
     free_blocks_t* free_pblks;
 };
 
+// pblock ranges [first, second) written by a thread since the last sync_pblk_pools(), file-backed pools only
+struct alignas(64) dirty_pblks_t{
+    std::vector<std::pair<char*, char*>> ranges;
+};
+
 class thd_mem_t {
     mempool_t* vbuf_pool;
     mempool_t** pblk_pools;
     mempool_t* vert_pool;
     mempool_t* snap_pool;
     mem_bulk_t* mem; 
+    dirty_pblks_t* dirty_pblks;
 
     // used for free vert/snap bulks
     std::vector<vertex_t*> vert_bulk_start;
@@ -47,6 +53,7 @@ class thd_mem_t {
         }
         vert_bulk_start.clear();
         snap_bulk_start.clear();
+        dirty_pblks = new dirty_pblks_t[THD_COUNT];
     }
 
     ~thd_mem_t(){
@@ -69,6 +76,7 @@ class thd_mem_t {
             }
         }
         if(mem) free(mem);
+        delete [] dirty_pblks;
     } 
 
     inline mem_bulk_t* getMemT(tid_t tid){
@@ -81,6 +89,33 @@ class thd_mem_t {
             mem[i].paddr = NULL;
             mem[i].psize = 0;
             mem[i].free_pblks = NULL;
+            dirty_pblks[i].ranges.clear(); // the old pools are going away
+        }
+    }
+
+    /* -------------------------------------------------------------- */
+    // pblocks to write back at the next sync_pblk_pools()
+    inline void mark_pblk(pblock_t* pblk) {
+        if(!FILEBACKED) return;
+        char* beg = (char*)pblk;
+        char* end = beg + pblk->get_size();
+        std::vector<std::pair<char*, char*>> &ranges = dirty_pblks[omp_get_thread_num()].ranges;
+        if(!ranges.empty()){
+            std::pair<char*, char*> &last = ranges.back();
+            if(beg >= last.first && end <= last.second) return; // e.g. appending to the block just allocated
+            if(beg == last.second){ // sequential allocation
+                last.second = end;
+                return;
+            }
+        }
+        ranges.emplace_back(beg, end);
+    }
+
+    // move the ranges of all threads to out, only when no thread is archiving
+    inline void take_dirty_pblks(std::vector<std::pair<char*, char*>> &out) {
+        for (int i = 0; i < THD_COUNT; ++i) {
+            out.insert(out.end(), dirty_pblks[i].ranges.begin(), dirty_pblks[i].ranges.end());
+            dirty_pblks[i].ranges.clear();
         }
     }
 
@@ -243,6 +278,7 @@ class thd_mem_t {
         pblk->add_next((pblock_t*)NULL);
         pblk->set_nebrcount(0); // 当前节点的当前邻接表的已经存储的邻居计数，初始化为0
         pblk->set_max_nebrcount(max_count); // 当前节点的当前邻接表的能够存储的最多邻居数
+        mark_pblk(pblk);
 
         return pblk;
     }
@@ -276,6 +312,7 @@ class thd_mem_t {
         pblk->add_next((pblock_t*)NULL);
         pblk->set_nebrcount(0); // 当前节点的当前邻接表的已经存储的邻居计数，初始化为0
         pblk->set_max_nebrcount(max_count); // 当前节点的当前邻接表的能够存储的最多邻居数
+        mark_pblk(pblk);
 
         return pblk;
     }
@@ -49,6 +49,9 @@ void save_graph_pmem(std::string odirname, levelgraph_t *levelgraph) {
         }
     }
 
+    file_sync(rblks_out, sizeof(rblock_t)*nverts);
+    file_sync(rblks_in, sizeof(rblock_t)*nverts);
+
     FILE* file = fopen((odirname + "info.txt").c_str(), "wb+");
     char* out_paddr_base = levelgraph->get_pblk_pool(0)->get_base();
     char* in_paddr_base = levelgraph->get_pblk_pool(1)->get_base();
@@ -58,6 +61,10 @@ void save_graph_pmem(std::string odirname, levelgraph_t *levelgraph) {
     fwrite(&nverts, sizeof(vid_t), 1, file);
     fwrite(&out_paddr_base, sizeof(char*), 1, file);
     fwrite(&in_paddr_base, sizeof(char*), 1, file);
+    if(FILEBACKED){
+        fflush(file);
+        fdatasync(fileno(file));
+    }
     fclose(file);
 }
 
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <cstring>
 
+#include "config/args.hpp"
+
 /* ---------------------------------------------------------------------- */
 // used for memory usage
 size_t local_buf_size = 0;
@@ -22,7 +24,7 @@ size_t elog_size = 0;
 (!(((unsigned long long)(addr)) & (unsigned long long)(CACHE_LINE_SIZE-1)))
 
 /* -------------------------------------------------------------- */
-// ALLOC -- use pmem_map_file
+// ALLOC -- use pmem_map_file, regular files are accepted in file-backed mode
 static inline void* pmem_alloc(const char* filepath, size_t size){
     size_t mapped_len;
     int is_pmem;
@@ -31,7 +33,7 @@ static inline void* pmem_alloc(const char* filepath, size_t size){
         std::cout << "Could not pmem_map_file for :" << filepath << " error: " << strerror(errno) << std::endl;
         assert(0);
     }
-    if (!is_pmem){
+    if (!is_pmem && !FILEBACKED){
         std::cout << "pmem_map_file for :" << filepath << " error: not in pmem" << std::endl;
         assert(0);
     }
@@ -43,6 +45,16 @@ static inline void* pmem_alloc(const char* filepath, size_t size){
     return addr;
 }
 
+/* -------------------------------------------------------------- */
+// SYNC -- write back a file-backed range, a no-op on pmem and DRAM
+static inline void file_sync(const void* addr, size_t len){
+    if (!FILEBACKED || !len) return;
+    if (pmem_msync(addr, len) != 0) {
+        std::cout << "pmem_msync for " << addr << " error: " << strerror(errno) << std::endl;
+        assert(0);
+    }
+}
+
 /* -------------------------------------------------------------- */
 // FLUSH -- use clwb and sfence
 static inline void clwb(void * addr){ 
@@ -96,6 +108,48 @@ void writeLineMOVNT(char *dest, char *src)
       "memory");
 }
 
+/**
+ * as writeLineMOVNT, for a src line without alignment
+ */
+static inline
+void writeLineMOVNTU(char *dest, const char *src)
+{
+  asm volatile(
+    "movdqu   %4, %%xmm0    \n\t"
+    "movdqu   %5, %%xmm1    \n\t"
+    "movdqu   %6, %%xmm2    \n\t"
+    "movdqu   %7, %%xmm3    \n\t"
+    "movntdq  %%xmm0, %0    \n\t"
+    "movntdq  %%xmm1, %1    \n\t"
+    "movntdq  %%xmm2, %2    \n\t"
+    "movntdq  %%xmm3, %3    \n\t"
+    : "=m"(dest[ 0]), "=m"(dest[16]), "=m"(dest[32]), "=m"(dest[48])
+    :  "m"(src[ 0]),   "m"(src[16]),   "m"(src[32]),   "m"(src[48])
+    : "xmm0", "xmm1", "xmm2", "xmm3",
+      "memory");
+}
+
+/**
+ * copy len bytes, the whole lines of dest by movntdq and the partial ones at both ends by memcpy.
+ * Call sfence() before publishing the copy.
+ */
+static inline
+void ntmemcpy(char *dest, const char *src, size_t len)
+{
+  size_t head = (CACHE_LINE_SIZE - ((unsigned long long)dest & (CACHE_LINE_SIZE-1))) & (CACHE_LINE_SIZE-1);
+  if (head >= len) { memcpy(dest, src, len); return; }
+  memcpy(dest, src, head);
+  dest += head; src += head; len -= head;
+  if (((unsigned long long)src & 15) == 0) {
+    for (; len >= CACHE_LINE_SIZE; dest += CACHE_LINE_SIZE, src += CACHE_LINE_SIZE, len -= CACHE_LINE_SIZE)
+      writeLineMOVNT(dest, (char *)src);
+  } else {
+    for (; len >= CACHE_LINE_SIZE; dest += CACHE_LINE_SIZE, src += CACHE_LINE_SIZE, len -= CACHE_LINE_SIZE)
+      writeLineMOVNTU(dest, src);
+  }
+  memcpy(dest, src, len);
+}
+
 /* -------------------------------------------------------------- */
 // PREFETCH -- use prefetch instructions by default.
 #define prefetcht0(mem_var)     \
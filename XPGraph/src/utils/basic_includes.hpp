@@ -110,6 +110,7 @@ int64_t FIRST_BLOCK_MARK = 0;
 #include "utils/metrics/reps/basic_reporter.hpp"
 #include "utils/metrics/reps/file_reporter.hpp"
 #include "utils/metrics/reps/html_reporter.hpp"       
+#include "utils/metrics/hot_metrics.hpp"
 /**
  * Helper for metrics.
  */
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "utils/logstream.hpp"
+#include "utils/metrics/metrics.hpp"
+
+/* ---------------------------------------------------------------------- */
+// Hot-path metrics. Every metric has an ID fixed at compile time in HOT_METRICS, so recording one is an
+// indexed update of a per-thread slot: no string lookup, no lock and no shared cache line. The slots of all
+// threads are only summed up on demand, by merge_into() for the string-keyed reports or by dump_json().
+//
+// X(id, key, type):
+//   HM_TIME         durations in ticks of hm_now(), with a log2 histogram
+//   HM_THREAD_TIME  as HM_TIME, also reported per thread as key + two-digit thread number
+//   HM_COUNT        plain counter, only the sum is kept
+#define HOT_METRICS(X) \
+    X(LOGGED_EDGES,          "2.2.1    -logged_edges",                  HM_COUNT) \
+    X(STALL_TO_WAIT_ARCHIVE, "2.2.2    -stall_to_wait_archive",         HM_TIME) \
+    X(CLASSIFY_AND_BUFFER,   "3-classify_and_buffer",                   HM_TIME) \
+    X(CLASSIFY,              "3.1-3 -classify",                         HM_TIME) \
+    X(CLASSIFY_T,            "3.1-3.3  -classify_store_and_divide_t",   HM_THREAD_TIME) \
+    X(COUNT_RANGE_EDGES_T,   "3.1  -count_range_edges_t",               HM_THREAD_TIME) \
+    X(STORE_TO_RANGE_T,      "3.2  -store_to_global_range_t",           HM_THREAD_TIME) \
+    X(WORK_DIVISION_T,       "3.3  -work_division_t",                   HM_THREAD_TIME) \
+    X(BUFFER,                "3.4 -buffer",                             HM_TIME) \
+    X(BUFFER_RANGES_T,       "3.4  -buffer_ranges_t",                   HM_THREAD_TIME) \
+    X(BUFFERED_EDGES,        "3.4.1  -buffered_edges",                  HM_COUNT) \
+    X(ARCHIVED_VBUFS,        "3.4.2  -archived_vbufs",                  HM_COUNT) \
+    X(ALLOCATED_PBLKS,       "3.4.3  -allocated_pblks",                 HM_COUNT) \
+    X(FLUSH_ALL_BUFS,        "4-flush_all_bufs",                        HM_TIME) \
+    X(SYNC_PBLK_POOLS,       "4.1  -sync_pblk_pools",                   HM_TIME) \
+    X(SYNCED_PBLK_BYTES,     "4.1.1  -synced_pblk_bytes",               HM_COUNT) \
+    X(COMPACT_CHAINS,        "5-compact_chains",                        HM_TIME) \
+    X(COMPACTED_VERTICES,    "5.1  -compacted_vertices",                HM_COUNT) \
+    X(COMPACT_PBLKS_BEFORE,  "5.2  -compacted_pblks_before",            HM_COUNT) \
+    X(COMPACT_PBLKS_AFTER,   "5.3  -compacted_pblks_after",             HM_COUNT)
+
+enum hm_type_t { HM_TIME, HM_THREAD_TIME, HM_COUNT };
+
+#define HM_ENUM(id, key, type) HM_##id,
+enum hm_id_t { HOT_METRICS(HM_ENUM) HM_NUM_IDS };
+#undef HM_ENUM
+
+#define HM_KEY(id, key, type) key,
+static const char* const hm_keys[HM_NUM_IDS] = { HOT_METRICS(HM_KEY) };
+#undef HM_KEY
+
+#define HM_TYPE(id, key, type) type,
+static const hm_type_t hm_types[HM_NUM_IDS] = { HOT_METRICS(HM_TYPE) };
+#undef HM_TYPE
+
+#define HM_HIST_BUCKETS 48 // bucket b counts samples in [2^(b-1), 2^b) ticks, 0 in bucket 0
+
+struct hm_slot_t {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t hist[HM_HIST_BUCKETS];
+};
+
+struct alignas(64) hm_thread_t {
+    hm_slot_t slots[HM_NUM_IDS];
+};
+
+inline uint64_t hm_now(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#endif
+}
+
+inline double hm_mono_seconds(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0E9;
+}
+
+class hot_metrics_t
+{
+private:
+    std::mutex lock;
+    std::vector<hm_thread_t*> threads; // never freed before exit, the totals of finished threads are kept
+    uint64_t tick0;
+    double mono0;
+
+    void merge_slot(hm_slot_t &to, const hm_slot_t &from){
+        if(from.count == 0) return;
+        if(to.count == 0 || from.min < to.min) to.min = from.min;
+        if(from.max > to.max) to.max = from.max;
+        to.count += from.count;
+        to.sum += from.sum;
+        for(int b = 0; b < HM_HIST_BUCKETS; ++b) to.hist[b] += from.hist[b];
+    }
+
+    double scale(hm_id_t id, double tick_secs){
+        return hm_types[id] == HM_COUNT ? 1.0 : tick_secs;
+    }
+
+    void fill_entry(metrics_entry &ent, const hm_slot_t &slot, double s){
+        ent.count = slot.count;
+        ent.value = ent.cumvalue = slot.sum * s;
+        ent.minvalue = slot.min * s;
+        ent.maxvalue = slot.max * s;
+    }
+
+public:
+    hot_metrics_t():tick0(hm_now()), mono0(hm_mono_seconds()){}
+
+    hm_thread_t* register_thread(){
+        hm_thread_t* t = new hm_thread_t();
+        std::lock_guard<std::mutex> guard(lock);
+        threads.push_back(t);
+        return t;
+    }
+
+    // seconds per tick, calibrated against CLOCK_MONOTONIC over the lifetime of the process
+    double tick_seconds(){
+#if defined(__x86_64__) || defined(__i386__)
+        double elapsed;
+        while((elapsed = hm_mono_seconds() - mono0) < 0.01); // too short to calibrate, only in tiny runs
+        return elapsed / (hm_now() - tick0);
+#else
+        return 1.0E-9;
+#endif
+    }
+
+    // Sum of all threads, approximate while they are still recording.
+    hm_slot_t aggregate(hm_id_t id){
+        hm_slot_t total = {};
+        std::lock_guard<std::mutex> guard(lock);
+        for(hm_thread_t* t: threads) merge_slot(total, t->slots[id]);
+        return total;
+    }
+
+    // Overwrite the string-keyed entries with the current totals, so it can be called more than once.
+    void merge_into(metrics &m){
+        double tick_secs = tick_seconds();
+        std::lock_guard<std::mutex> guard(lock);
+        m.mlock.lock();
+        for(int i = 0; i < HM_NUM_IDS; ++i){
+            hm_id_t id = (hm_id_t)i;
+            hm_slot_t total = {};
+            for(hm_thread_t* t: threads) merge_slot(total, t->slots[id]);
+            if(total.count == 0) continue;
+            double s = scale(id, tick_secs);
+            metrics_entry ent(hm_types[id] == HM_COUNT ? INTEGER : TIME);
+            fill_entry(ent, total, s);
+            m.entries[hm_keys[id]] = ent;
+            if(hm_types[id] != HM_THREAD_TIME) continue;
+            for(size_t t = 0; t < threads.size(); ++t){
+                const hm_slot_t &slot = threads[t]->slots[id];
+                if(slot.count == 0) continue;
+                char tkey[256];
+                snprintf(tkey, sizeof(tkey), "%s%02zu", hm_keys[id], t);
+                metrics_entry tent(TIME);
+                fill_entry(tent, slot, s);
+                m.entries[tkey] = tent;
+            }
+        }
+        m.mlock.unlock();
+    }
+
+    // One JSON object per run: totals, per-thread sums and the non-empty histogram buckets (upper bound in seconds).
+    void dump_json(std::string filename, std::string app){
+        double tick_secs = tick_seconds();
+        FILE* f = fopen(filename.c_str(), "w");
+        if(f == NULL){
+            logstream(LOG_ERROR) << "Could not open metrics dump " << filename << std::endl;
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        fprintf(f, "{\"app\": \"%s\", \"threads\": %zu, \"tick_seconds\": %.6e, \"metrics\": [", app.c_str(), threads.size(), tick_secs);
+        bool first = true;
+        for(int i = 0; i < HM_NUM_IDS; ++i){
+            hm_id_t id = (hm_id_t)i;
+            hm_slot_t total = {};
+            for(hm_thread_t* t: threads) merge_slot(total, t->slots[id]);
+            if(total.count == 0) continue;
+            double s = scale(id, tick_secs);
+            fprintf(f, "%s\n  {\"key\": \"%s\", \"type\": \"%s\", \"count\": %lu, \"sum\": %.9g", first ? "" : ",",
+                hm_keys[id], hm_types[id] == HM_COUNT ? "count" : "time", total.count, total.sum * s);
+            first = false;
+            if(hm_types[id] != HM_COUNT){
+                fprintf(f, ", \"min\": %.9g, \"max\": %.9g, \"hist\": [", total.min * s, total.max * s);
+                bool first_bucket = true;
+                for(int b = 0; b < HM_HIST_BUCKETS; ++b){
+                    if(total.hist[b] == 0) continue;
+                    fprintf(f, "%s[%.9g, %lu]", first_bucket ? "" : ", ", (double)(1UL << b) * s, total.hist[b]);
+                    first_bucket = false;
+                }
+                fprintf(f, "]");
+            }
+            fprintf(f, ", \"per_thread\": [");
+            for(size_t t = 0; t < threads.size(); ++t){
+                fprintf(f, "%s%.9g", t ? ", " : "", threads[t]->slots[id].sum * s);
+            }
+            fprintf(f, "]}");
+        }
+        fprintf(f, "\n]}\n");
+        fclose(f);
+    }
+};
+
+hot_metrics_t hot_metrics;
+thread_local hm_thread_t* hm_local = NULL;
+
+inline hm_slot_t& hm_slot(hm_id_t id){
+    if(__builtin_expect(hm_local == NULL, 0)) hm_local = hot_metrics.register_thread();
+    return hm_local->slots[id];
+}
+
+// record one sample, e.g. a duration hm_now() - start
+inline void hm_record(hm_id_t id, uint64_t value){
+    hm_slot_t &slot = hm_slot(id);
+    if(slot.count == 0 || value < slot.min) slot.min = value;
+    if(value > slot.max) slot.max = value;
+    slot.count++;
+    slot.sum += value;
+    int b = value ? 64 - __builtin_clzl(value) : 0;
+    slot.hist[b < HM_HIST_BUCKETS ? b : HM_HIST_BUCKETS - 1]++;
+}
+
+inline void hm_stop(hm_id_t id, uint64_t start){
+    hm_record(id, hm_now() - start);
+}
+
+inline void hm_count(hm_id_t id, uint64_t n = 1){
+    hm_slot_t &slot = hm_slot(id);
+    slot.count++;
+    slot.sum += n;
+}